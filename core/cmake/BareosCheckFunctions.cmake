@@ -72,6 +72,7 @@ check_function_exists(nanosleep HAVE_NANOSLEEP)
 check_function_exists(openat HAVE_OPENAT)
 check_function_exists(poll HAVE_POLL)
 check_function_exists(posix_fadvise HAVE_POSIX_FADVISE)
+check_function_exists(posix_fallocate HAVE_POSIX_FALLOCATE)
 check_function_exists(prctl HAVE_PRCTL)
 check_function_exists(readdir_r HAVE_READDIR_R)
 check_function_exists(setea HAVE_SETEA)
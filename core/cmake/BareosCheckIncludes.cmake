@@ -1,6 +1,6 @@
 #   BAREOS® - Backup Archiving REcovery Open Sourced
 #
-#   Copyright (C) 2017-2023 Bareos GmbH & Co. KG
+#   Copyright (C) 2017-2024 Bareos GmbH & Co. KG
 #
 #   This program is Free Software; you can redistribute it and/or
 #   modify it under the terms of version three of the GNU Affero General Public
@@ -48,6 +48,7 @@ check_include_file_cxx(cxxabi.h HAVE_CXXABI_H)
 check_include_files(curses.h HAVE_CURSES_H)
 check_include_files(poll.h HAVE_POLL_H)
 check_include_files(sys/poll.h HAVE_SYS_POLL_H)
+check_include_files(sys/epoll.h HAVE_SYS_EPOLL_H)
 check_include_files(sys/statvfs.h HAVE_SYS_STATVFS_H)
 check_include_files(umem.h HAVE_UMEM_H)
 check_include_files(ucontext.h HAVE_UCONTEXT_H)
@@ -0,0 +1,221 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+/* Measures what the file daemon spends per file on collecting ACLs and
+ * xattrs, through the same findlib entry points the backup uses. */
+
+#include <benchmark/benchmark.h>
+#include "include/bareos.h"
+#include "include/filetypes.h"
+#include "include/jcr.h"
+#include "findlib/find.h"
+#include "findlib/xattr.h"
+#include "lib/bsock_tcp.h"
+
+#if defined(HAVE_LINUX_OS)
+#  include <sys/socket.h>
+#  include <sys/xattr.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+
+#  include <cstdlib>
+#  include <string>
+#  include <thread>
+#  include <vector>
+
+namespace bm = benchmark;
+
+namespace {
+constexpr int num_files = 1000;
+
+/* A directory of empty files, like most files of a backup they have no ACL.
+ * With xattrs, every file gets two small user attributes. */
+class TestFiles {
+ public:
+  explicit TestFiles(bool with_xattrs)
+  {
+    char dir[] = "/tmp/acl_xattr_probe.XXXXXX";
+    if (!mkdtemp(dir)) { return; }
+    dir_ = dir;
+    for (int i = 0; i < num_files; ++i) {
+      std::string fname = dir_ + "/file" + std::to_string(i);
+      int fd = open(fname.c_str(), O_CREAT | O_WRONLY, 0644);
+      if (fd < 0) { return; }
+      close(fd);
+      files_.push_back(fname);
+      if (with_xattrs
+          && (setxattr(fname.c_str(), "user.comment", "a comment", 9, 0) != 0
+              || setxattr(fname.c_str(), "user.checksum", "0123456789abcdef",
+                          16, 0)
+                     != 0)) {
+        error_ = "the filesystem does not support user xattrs";
+        return;
+      }
+    }
+  }
+  ~TestFiles()
+  {
+    for (const std::string& fname : files_) { unlink(fname.c_str()); }
+    if (!dir_.empty()) { rmdir(dir_.c_str()); }
+  }
+
+  // Skips the benchmark if the files could not be created
+  bool Usable(bm::State& state) const
+  {
+    if (!error_.empty() || files_.size() != num_files) {
+      state.SkipWithError(error_.empty() ? "cannot create the files"
+                                         : error_.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  const std::vector<std::string>& files() const { return files_; }
+
+ private:
+  std::string dir_;
+  std::vector<std::string> files_;
+  std::string error_;
+};
+
+/* A job whose storage daemon connection is a socket pair; the streams sent
+ * to it are read and dropped by a thread. */
+class Job {
+ public:
+  Job()
+  {
+    jcr_ = new_jcr(nullptr);
+    register_jcr(jcr_);
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) { return; }
+    BareosSocket* sd = new BareosSocketTCP;
+    sd->fd_ = fds[0];
+    sd->SetWho(strdup("Storage daemon"));
+    sd->SetHost(strdup("localhost"));
+    jcr_->store_bsock = sd;
+
+    drain_ = std::thread([fd = fds[1]]() {
+      char buf[4096];
+      while (read(fd, buf, sizeof(buf)) > 0) {}
+      close(fd);
+    });
+  }
+  ~Job()
+  {
+    if (jcr_->store_bsock) {
+      jcr_->store_bsock->close();
+      delete jcr_->store_bsock;
+      jcr_->store_bsock = nullptr;
+    }
+    if (drain_.joinable()) { drain_.join(); }
+    FreeJcr(jcr_);
+  }
+
+  JobControlRecord* jcr() const { return jcr_; }
+  bool Usable(bm::State& state) const
+  {
+    if (!jcr_->store_bsock) {
+      state.SkipWithError("cannot create the socket pair");
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  JobControlRecord* jcr_;
+  std::thread drain_;
+};
+
+// The file packet of the first file, all test files are on its device
+FindFilesPacket MakeFilePacket(const TestFiles& test_files)
+{
+  FindFilesPacket ff_pkt;
+  ff_pkt.type = FT_REG;
+  lstat(test_files.files().front().c_str(), &ff_pkt.statp);
+  return ff_pkt;
+}
+}  // namespace
+
+static void BM_BuildXattrStreams(bm::State& state)
+{
+  TestFiles test_files(state.range(0));
+  if (!test_files.Usable(state)) { return; }
+  Job job;
+  if (!job.Usable(state)) { return; }
+
+  XattrData xattr_data;
+  xattr_data.last_fname = GetPoolMemory(PM_FNAME);
+  xattr_build_data_t build{};
+  build.content = GetPoolMemory(PM_MESSAGE);
+  xattr_data.u.build = &build;
+  FindFilesPacket ff_pkt = MakeFilePacket(test_files);
+
+  for (auto _ : state) {
+    for (const std::string& fname : test_files.files()) {
+      PmStrcpy(xattr_data.last_fname, fname.c_str());
+      if (BuildXattrStreams(job.jcr(), &xattr_data, &ff_pkt)
+          != BxattrExitCode::kSuccess) {
+        state.SkipWithError("BuildXattrStreams failed");
+        break;
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_files);
+
+  FreePoolMemory(build.content);
+  FreePoolMemory(xattr_data.last_fname);
+}
+BENCHMARK(BM_BuildXattrStreams)->Arg(0)->Arg(1)->Unit(bm::kMillisecond);
+
+#  if defined(HAVE_ACL)
+static void BM_BuildAclStreams(bm::State& state)
+{
+  TestFiles test_files(false);
+  if (!test_files.Usable(state)) { return; }
+  Job job;
+  if (!job.Usable(state)) { return; }
+
+  AclData acl_data;
+  acl_data.filetype = FT_REG;
+  acl_data.last_fname = GetPoolMemory(PM_FNAME);
+  acl_build_data_t build{};
+  build.content = GetPoolMemory(PM_MESSAGE);
+  acl_data.u.build = &build;
+  FindFilesPacket ff_pkt = MakeFilePacket(test_files);
+
+  for (auto _ : state) {
+    for (const std::string& fname : test_files.files()) {
+      PmStrcpy(acl_data.last_fname, fname.c_str());
+      if (BuildAclStreams(job.jcr(), &acl_data, &ff_pkt) != bacl_exit_ok) {
+        state.SkipWithError("BuildAclStreams failed");
+        break;
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_files);
+
+  FreePoolMemory(build.content);
+  FreePoolMemory(acl_data.last_fname);
+}
+BENCHMARK(BM_BuildAclStreams)->Unit(bm::kMillisecond);
+#  endif
+#endif
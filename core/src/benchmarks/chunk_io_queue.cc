@@ -0,0 +1,103 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+/* Measures the ordered circular buffer the chunked device uses to pass
+ * chunk flush requests from the device to its io-threads. */
+
+#include <benchmark/benchmark.h>
+#include "include/bareos.h"
+#include "stored/backends/ordered_cbuf.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace storagedaemon;
+namespace bm = benchmark;
+
+struct request {
+  std::string volname;
+  uint32_t chunk;
+};
+
+static int CompareRequest(ocbuf_item* item1, ocbuf_item* item2)
+{
+  auto* r1 = static_cast<request*>(item1->data);
+  auto* r2 = static_cast<request*>(item2->data);
+
+  if (int res = r1->volname.compare(r2->volname); res != 0) { return res; }
+  if (r1->chunk == r2->chunk) { return 0; }
+  return (r1->chunk < r2->chunk) ? -1 : 1;
+}
+
+static void UpdateRequest(void*, void*) {}
+
+static constexpr uint32_t kChunksPerProducer = 2000;
+
+static void Produce(ordered_circbuf& cb, int producer)
+{
+  std::string volname = "Full-" + std::to_string(producer);
+  for (uint32_t chunk = 0; chunk < kChunksPerProducer; ++chunk) {
+    /* Every fourth chunk is queued twice, like a chunk that gets more data
+     * before it was flushed. */
+    for (int copy = 0; copy < ((chunk % 4 == 0) ? 2 : 1); ++copy) {
+      auto* req = new request{volname, chunk};
+      if (cb.enqueue(req, sizeof(request), UpdateRequest) != req) {
+        delete req;
+      }
+    }
+  }
+}
+
+static void Consume(ordered_circbuf& cb)
+{
+  while (void* data = cb.dequeue()) { delete static_cast<request*>(data); }
+}
+
+static void BM_ChunkIoQueue(bm::State& state)
+{
+  const int producers = state.range(0);
+  const int consumers = state.range(1);
+
+  for (auto _ : state) {
+    ordered_circbuf cb(CompareRequest, consumers * OQSIZE);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < consumers; ++i) {
+      threads.emplace_back(Consume, std::ref(cb));
+    }
+
+    std::vector<std::thread> producer_threads;
+    for (int i = 0; i < producers; ++i) {
+      producer_threads.emplace_back(Produce, std::ref(cb), i);
+    }
+    for (auto& thread : producer_threads) { thread.join(); }
+
+    cb.flush();
+    for (auto& thread : threads) { thread.join(); }
+  }
+
+  state.SetItemsProcessed(state.iterations() * producers * kChunksPerProducer);
+}
+BENCHMARK(BM_ChunkIoQueue)
+    ->ArgsProduct({{1, 4, 16}, {2, 8, 32}})
+    ->UseRealTime()
+    ->Unit(bm::kMillisecond);
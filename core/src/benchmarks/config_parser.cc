@@ -0,0 +1,120 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+#include <benchmark/benchmark.h>
+#include "include/bareos.h"
+#include "dird/dird_globals.h"
+#include "dird/dird_conf.h"
+#include "lib/parse_conf.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+namespace bm = benchmark;
+using namespace directordaemon;
+
+/* Writes a director configuration with the given number of Client and Job
+ * resources (one Job per Client) and returns its path. */
+static std::string WriteConfig(int clients)
+{
+  char dir[] = "/tmp/config_parser_benchmark_XXXXXX";
+  if (!mkdtemp(dir)) { return {}; }
+  std::string path = std::string(dir) + "/bareos-dir.conf";
+
+  std::ofstream conf(path);
+  conf << "Director {\n  Name = bareos-dir\n  Password = \"secret\"\n"
+          "  Messages = Standard\n}\n"
+          "Catalog {\n  Name = MyCatalog\n  dbname = bareos\n}\n"
+          "Messages {\n  Name = Standard\n}\n"
+          "Pool {\n  Name = Full\n  Pool Type = Backup\n}\n"
+          "Storage {\n  Name = File\n  Address = localhost\n"
+          "  Password = \"secret\"\n  Device = FileStorage\n"
+          "  Media Type = File\n}\n"
+          "FileSet {\n  Name = LinuxAll\n  Include {\n    File = /\n  }\n}\n"
+          "JobDefs {\n  Name = DefaultJob\n  Type = Backup\n"
+          "  FileSet = LinuxAll\n  Storage = File\n  Pool = Full\n"
+          "  Messages = Standard\n}\n";
+  for (int i = 0; i < clients; ++i) {
+    conf << "Client {\n  Name = client-" << i << "-fd\n  Address = host-" << i
+         << "\n  Password = \"secret\"\n}\n";
+    conf << "Job {\n  Name = backup-client-" << i
+         << "\n  JobDefs = DefaultJob\n  Client = client-" << i << "-fd\n}\n";
+  }
+  return path;
+}
+
+static void RemoveConfig(const std::string& path)
+{
+  unlink(path.c_str());
+  rmdir(path.substr(0, path.rfind('/')).c_str());
+}
+
+static void BM_ParseConfig(bm::State& state)
+{
+  OSDependentInit();
+  std::string path = WriteConfig(state.range(0) / 2);
+
+  for (auto _ : state) {
+    std::unique_ptr<ConfigurationParser> config(
+        InitDirConfig(path.c_str(), M_ERROR_TERM));
+    my_config = config.get();
+    if (!config->ParseConfig()) {
+      state.SkipWithError("could not parse the generated configuration");
+    }
+    my_config = nullptr;
+  }
+
+  RemoveConfig(path);
+}
+BENCHMARK(BM_ParseConfig)
+    ->Arg(2'000)
+    ->Arg(20'000)
+    ->Unit(bm::kMillisecond)
+    ->Iterations(1);
+
+static void BM_GetResWithName(bm::State& state)
+{
+  OSDependentInit();
+  int clients = state.range(0) / 2;
+  std::string path = WriteConfig(clients);
+  std::unique_ptr<ConfigurationParser> config(
+      InitDirConfig(path.c_str(), M_ERROR_TERM));
+  my_config = config.get();
+  config->ParseConfig();
+
+  std::vector<std::string> names;
+  for (int i = 0; i < clients; ++i) {
+    names.push_back("client-" + std::to_string(i) + "-fd");
+  }
+
+  for (auto _ : state) {
+    for (auto& name : names) {
+      bm::DoNotOptimize(config->GetResWithName(R_CLIENT, name.c_str()));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * names.size());
+
+  my_config = nullptr;
+  RemoveConfig(path);
+}
+BENCHMARK(BM_GetResWithName)->Arg(2'000)->Arg(20'000);
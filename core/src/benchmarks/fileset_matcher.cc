@@ -0,0 +1,113 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+#include <benchmark/benchmark.h>
+#include "include/bareos.h"
+#include "findlib/wildcard_set.h"
+
+#include <fnmatch.h>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace bm = benchmark;
+
+/* A fileset with lots of exclude patterns, typically built from a list of
+ * file extensions and directory names. */
+static std::vector<std::string> MakePatterns(std::size_t count)
+{
+  std::vector<std::string> patterns;
+  for (std::size_t i = 0; i < count; ++i) {
+    switch (i % 4) {
+      case 0:
+        patterns.push_back("*.ext" + std::to_string(i));
+        break;
+      case 1:
+        patterns.push_back("/var/cache/dir" + std::to_string(i) + "*");
+        break;
+      case 2:
+        patterns.push_back("/home/user/file" + std::to_string(i));
+        break;
+      default:
+        patterns.push_back("/tmp/*/f" + std::to_string(i) + "?");
+        break;
+    }
+  }
+  return patterns;
+}
+
+static std::vector<std::string> MakePaths(std::size_t count)
+{
+  std::mt19937 gen32;
+  std::vector<std::string> paths;
+  for (std::size_t i = 0; i < count; ++i) {
+    paths.push_back("/srv/data/d" + std::to_string(gen32() % 100) + "/file"
+                    + std::to_string(gen32()) + ".ext"
+                    + std::to_string(gen32() % 2000));
+  }
+  return paths;
+}
+
+static std::vector<const char*> ToPointers(const std::vector<std::string>& v)
+{
+  std::vector<const char*> pointers;
+  for (auto& s : v) { pointers.push_back(s.c_str()); }
+  return pointers;
+}
+
+static void BM_fnmatch_loop(bm::State& state)
+{
+  auto patterns = MakePatterns(state.range(0));
+  auto paths = MakePaths(1000);
+  auto pattern_ptrs = ToPointers(patterns);
+
+  for (auto _ : state) {
+    std::size_t matches = 0;
+    for (auto& path : paths) {
+      for (const char* pattern : pattern_ptrs) {
+        if (fnmatch(pattern, path.c_str(), 0) == 0) {
+          ++matches;
+          break;
+        }
+      }
+    }
+    bm::DoNotOptimize(matches);
+  }
+  state.SetItemsProcessed(state.iterations() * paths.size());
+}
+BENCHMARK(BM_fnmatch_loop)->Arg(10)->Arg(100)->Arg(1000);
+
+static void BM_wildcard_set(bm::State& state)
+{
+  auto patterns = MakePatterns(state.range(0));
+  auto paths = MakePaths(1000);
+  WildcardSet set(ToPointers(patterns), 0);
+
+  for (auto _ : state) {
+    std::size_t matches = 0;
+    for (auto& path : paths) {
+      if (set.Match(path.c_str())) { ++matches; }
+    }
+    bm::DoNotOptimize(matches);
+  }
+  state.SetItemsProcessed(state.iterations() * paths.size());
+}
+BENCHMARK(BM_wildcard_set)->Arg(10)->Arg(100)->Arg(1000);
@@ -0,0 +1,118 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+#include <benchmark/benchmark.h>
+#include "include/bareos.h"
+#include "include/streams.h"
+#include "lib/attribs.h"
+
+#include <sys/stat.h>
+
+namespace bm = benchmark;
+
+static struct stat SampleStat()
+{
+  struct stat statp {};
+  statp.st_dev = 66306;
+  statp.st_ino = 13107581;
+  statp.st_mode = S_IFREG | 0644;
+  statp.st_nlink = 1;
+  statp.st_uid = 1000;
+  statp.st_gid = 1000;
+  statp.st_size = 1234567;
+  statp.st_blksize = 4096;
+  statp.st_blocks = 2416;
+  statp.st_atime = 1700000000;
+  statp.st_mtime = 1700000100;
+  statp.st_ctime = 1700000200;
+  return statp;
+}
+
+// the LStat of every file sent by the file daemon
+static void BM_EncodeStat(bm::State& state)
+{
+  struct stat statp = SampleStat();
+  char buf[200];
+  for (auto _ : state) {
+    EncodeStat(buf, &statp, sizeof(statp), 0, STREAM_UNIX_ATTRIBUTES);
+    bm::DoNotOptimize(buf);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EncodeStat);
+
+// the LStat of every file row when building the restore tree
+static void BM_DecodeStat(bm::State& state)
+{
+  struct stat statp = SampleStat();
+  char buf[200];
+  EncodeStat(buf, &statp, sizeof(statp), 0, STREAM_UNIX_ATTRIBUTES);
+  int32_t LinkFI;
+  for (auto _ : state) {
+    bm::DoNotOptimize(DecodeStat(buf, &statp, sizeof(statp), &LinkFI));
+    bm::DoNotOptimize(statp);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DecodeStat);
+
+// the stat packet of every file sent by a file daemon asked for compact ones
+static void BM_EncodeStatCompact(bm::State& state)
+{
+  struct stat statp = SampleStat();
+  char buf[kMaxLStatLength];
+  for (auto _ : state) {
+    EncodeStatCompact(buf, &statp, sizeof(statp), 0, STREAM_UNIX_ATTRIBUTES);
+    bm::DoNotOptimize(buf);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EncodeStatCompact);
+
+// what the director does before storing a compact stat packet
+static void BM_CompactStatToLStat(bm::State& state)
+{
+  struct stat statp = SampleStat();
+  char compact[kMaxLStatLength];
+  char lstat[kMaxLStatLength];
+  EncodeStatCompact(compact, &statp, sizeof(statp), 0, STREAM_UNIX_ATTRIBUTES);
+  for (auto _ : state) {
+    CompactStatToLStat(compact, lstat);
+    bm::DoNotOptimize(lstat);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CompactStatToLStat);
+
+// a compact stat packet read back from a volume on restore
+static void BM_DecodeStatCompact(bm::State& state)
+{
+  struct stat statp = SampleStat();
+  char buf[kMaxLStatLength];
+  EncodeStatCompact(buf, &statp, sizeof(statp), 0, STREAM_UNIX_ATTRIBUTES);
+  int32_t LinkFI;
+  for (auto _ : state) {
+    bm::DoNotOptimize(DecodeStat(buf, &statp, sizeof(statp), &LinkFI));
+    bm::DoNotOptimize(statp);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DecodeStatCompact);
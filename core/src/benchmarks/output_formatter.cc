@@ -0,0 +1,82 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+/* Compares the memory the output formatter needs for a large json listing
+ * with and without streaming. */
+
+#include <benchmark/benchmark.h>
+#include "include/bareos.h"
+#include "lib/output_formatter.h"
+
+#include <malloc.h>
+
+namespace bm = benchmark;
+
+static size_t HeapInUse() { return mallinfo2().uordblks; }
+
+struct SendContext {
+  size_t heap_at_start{};
+  size_t peak_heap{};
+  size_t bytes_sent{};
+};
+
+static bool CountingSend(void* ctx, const char* fmt, ...)
+{
+  auto* send_ctx = static_cast<SendContext*>(ctx);
+  va_list arg_ptr;
+  va_start(arg_ptr, fmt);
+  send_ctx->bytes_sent += strlen(va_arg(arg_ptr, const char*));
+  va_end(arg_ptr);
+
+  size_t in_use = HeapInUse() - send_ctx->heap_at_start;
+  if (in_use > send_ctx->peak_heap) { send_ctx->peak_heap = in_use; }
+  return true;
+}
+
+static void BM_ListFiles(bm::State& state)
+{
+  const bool stream = state.range(0);
+  const int rows = state.range(1);
+
+  SendContext ctx;
+  for (auto _ : state) {
+    ctx = SendContext{HeapInUse()};
+    OutputFormatter send(CountingSend, &ctx, nullptr, nullptr, API_MODE_JSON);
+    send.SetStreaming(stream);
+
+    send.ArrayStart("filenames");
+    for (int i = 0; i < rows; i++) {
+      send.ObjectStart();
+      send.ObjectKeyValue("filename",
+                          "/var/lib/some/application/data/directory/file");
+      send.ObjectEnd();
+    }
+    send.ArrayEnd("filenames");
+    send.FinalizeResult(true);
+  }
+
+  state.counters["peak_heap_bytes"] = ctx.peak_heap;
+  state.counters["bytes_sent"] = ctx.bytes_sent;
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_ListFiles)
+    ->ArgsProduct({{0, 1}, {1000, 100000, 1000000}})
+    ->Unit(bm::kMillisecond);
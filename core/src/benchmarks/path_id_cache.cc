@@ -0,0 +1,73 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+#include <benchmark/benchmark.h>
+#include "include/bareos.h"
+#include "cats/shared_path_id_cache.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace bm = benchmark;
+
+static std::vector<std::string> MakePaths(std::size_t count)
+{
+  std::vector<std::string> paths;
+  for (std::size_t i = 0; i < count; ++i) {
+    paths.push_back("/srv/data/project-" + std::to_string(i % 97) + "/dir-"
+                    + std::to_string(i) + "/");
+  }
+  return paths;
+}
+
+/* Resolve the paths of an incremental backup, state.range(0) paths that
+ * are all known from earlier jobs. Several jobs insert attributes at the
+ * same time. */
+static void BM_PathIdCacheLookup(bm::State& state)
+{
+  static std::unique_ptr<SharedPathIdCache> cache;
+  static std::vector<std::string> paths;
+  if (state.thread_index() == 0) {
+    paths = MakePaths(state.range(0));
+    cache = std::make_unique<SharedPathIdCache>(paths.size());
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+      cache->Insert(paths[i], i + 1);
+    }
+  }
+
+  std::size_t next = state.thread_index() * 7919;
+  for (auto _ : state) {
+    bm::DoNotOptimize(cache->Lookup(paths[next++ % paths.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    state.counters["hit_rate"] = static_cast<double>(cache->hits())
+                                 / (cache->hits() + cache->misses());
+  }
+}
+BENCHMARK(BM_PathIdCacheLookup)
+    ->Arg(10000)
+    ->Arg(1000000)
+    ->Threads(1)
+    ->Threads(4)
+    ->UseRealTime();
@@ -0,0 +1,137 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+#include <benchmark/benchmark.h>
+#include "include/bareos.h"
+#include "findlib/hole_finder.h"
+#include "lib/zero_block.h"
+
+#include <unistd.h>
+#include <cstdio>
+#include <optional>
+#include <vector>
+
+namespace bm = benchmark;
+
+namespace {
+// the default network buffer size, which is the size of a sparse block
+constexpr std::size_t block_size = 64 * 1024;
+
+// A file of 256MB which only has data in every 16th block, like a disk image
+class SparseFile {
+ public:
+  static constexpr std::size_t blocks = 4096;
+  static constexpr std::uint64_t size = blocks * block_size;
+
+  SparseFile() : file_{tmpfile()}
+  {
+    std::vector<char> data(block_size, 'x');
+    for (std::size_t i = 0; i < blocks; i += 16) {
+      if (pwrite(fileno(file_), data.data(), data.size(), i * block_size)
+          < 0) {
+        perror("pwrite");
+      }
+    }
+    if (ftruncate(fileno(file_), size) < 0) { perror("ftruncate"); }
+  }
+  ~SparseFile() { fclose(file_); }
+
+  int fd() const { return fileno(file_); }
+
+ private:
+  FILE* file_;
+};
+}  // namespace
+
+static void SkipUnsupported(bm::State& state, ZeroCheck check)
+{
+  state.SetLabel(ZeroCheckName(check));
+  if (!ZeroCheckSupported(check)) {
+    state.SkipWithError("not supported by this cpu");
+  }
+}
+
+// A zero block has to be checked completely
+static void BM_IsZeroBlock(bm::State& state)
+{
+  auto check = static_cast<ZeroCheck>(state.range(0));
+  SkipUnsupported(state, check);
+  std::vector<char> buf(block_size, 0);
+
+  for (auto _ : state) {
+    bm::DoNotOptimize(IsZeroBlock(check, buf.data(), buf.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * block_size);
+}
+BENCHMARK(BM_IsZeroBlock)
+    ->Arg(static_cast<int>(ZeroCheck::kPortable))
+    ->Arg(static_cast<int>(ZeroCheck::kSse2))
+    ->Arg(static_cast<int>(ZeroCheck::kAvx2))
+    ->Arg(static_cast<int>(ZeroCheck::kAvx512))
+    ->Arg(static_cast<int>(ZeroCheck::kNeon));
+
+/* Finds the zero blocks of a sparse file the way the file daemon does when
+ * sparse is enabled: read every block and check it with the given check,
+ * optionally skipping the holes first. */
+static void ScanSparseFile(bm::State& state, ZeroCheck check, bool skip_holes)
+{
+  SkipUnsupported(state, check);
+  SparseFile file;
+  std::vector<char> buf(block_size);
+  std::int64_t zero_blocks = 0;
+
+  for (auto _ : state) {
+    std::optional<HoleFinder> holes;
+    if (skip_holes) { holes.emplace(file.fd(), SparseFile::size); }
+
+    std::uint64_t position = 0;
+    if (lseek(file.fd(), 0, SEEK_SET) < 0) {
+      state.SkipWithError("cannot seek");
+      break;
+    }
+    for (;;) {
+      if (holes) { position = holes->SkipHole(position, block_size); }
+      ssize_t len = read(file.fd(), buf.data(), buf.size());
+      if (len <= 0) { break; }
+      if (IsZeroBlock(check, buf.data(), len)) { zero_blocks++; }
+      position += len;
+    }
+  }
+
+  state.counters["zero_blocks_read"] = bm::Counter(
+      static_cast<double>(zero_blocks), bm::Counter::kAvgIterations);
+  state.SetBytesProcessed(state.iterations() * SparseFile::size);
+}
+
+static void BM_ReadSparseFile(bm::State& state)
+{
+  ScanSparseFile(state, static_cast<ZeroCheck>(state.range(0)), false);
+}
+BENCHMARK(BM_ReadSparseFile)
+    ->Arg(static_cast<int>(ZeroCheck::kPortable))
+    ->Arg(static_cast<int>(BestZeroCheck()))
+    ->Unit(bm::kMillisecond);
+
+static void BM_SkipHolesOfSparseFile(bm::State& state)
+{
+  ScanSparseFile(state, BestZeroCheck(), true);
+}
+BENCHMARK(BM_SkipHolesOfSparseFile)->Unit(bm::kMillisecond);
@@ -0,0 +1,103 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+#include <benchmark/benchmark.h>
+#include "include/bareos.h"
+#include "stored/tape_stream_buffer.h"
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace bm = benchmark;
+using namespace std::chrono_literals;
+using storagedaemon::TapeStreamBuffer;
+
+/* A drive that needs 1ms per block and has to reposition for 10ms when it
+ * did not get the next block in time. The job delivers a block every 2ms,
+ * slower than the drive streams. */
+namespace {
+class SimulatedDrive {
+ public:
+  ssize_t Write(const void*, size_t len)
+  {
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_write_ > 1ms) {
+      stops_++;
+      std::this_thread::sleep_for(10ms);
+    }
+    std::this_thread::sleep_for(1ms);
+    last_write_ = std::chrono::steady_clock::now();
+    return static_cast<ssize_t>(len);
+  }
+
+  int64_t stops_{0};
+
+ private:
+  std::chrono::steady_clock::time_point last_write_{};
+};
+
+constexpr std::size_t block_size = 64 * 1024;
+constexpr int blocks_per_job = 100;
+}  // namespace
+
+// Buffer size in blocks, 0 writes every block directly
+static void BM_TapeStreaming(bm::State& state)
+{
+  std::vector<char> block(block_size, 'x');
+  int64_t stops = 0;
+
+  for (auto _ : state) {
+    SimulatedDrive drive;
+    std::unique_ptr<TapeStreamBuffer> buffer;
+    if (state.range(0) > 0) {
+      buffer = std::make_unique<TapeStreamBuffer>(
+          "benchmark", state.range(0) * block_size,
+          [&drive](const void* data, size_t len) {
+            return drive.Write(data, len);
+          });
+    }
+
+    for (int i = 0; i < blocks_per_job; ++i) {
+      std::this_thread::sleep_for(2ms);
+      if (buffer) {
+        buffer->Write(block.data(), block.size());
+      } else {
+        drive.Write(block.data(), block.size());
+      }
+    }
+    if (buffer) { buffer->Drain(); }
+    buffer.reset();
+    stops += drive.stops_;
+  }
+
+  state.counters["stops_per_job"] = bm::Counter(
+      static_cast<double>(stops), bm::Counter::kAvgIterations);
+  state.SetBytesProcessed(state.iterations() * blocks_per_job * block_size);
+}
+BENCHMARK(BM_TapeStreaming)
+    ->Arg(0)
+    ->Arg(16)
+    ->Arg(64)
+    ->Iterations(3)
+    ->Unit(bm::kMillisecond)
+    ->UseRealTime();
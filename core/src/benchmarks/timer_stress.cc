@@ -0,0 +1,92 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+#include <benchmark/benchmark.h>
+#include "include/bareos.h"
+#include "lib/btimers.h"
+#include "lib/timer_thread.h"
+#include "lib/watchdog.h"
+
+#include <chrono>
+#include <vector>
+
+namespace bm = benchmark;
+
+/* Every benchmark keeps state.range(0) timers registered that do not fire,
+ * like the timeouts of many idle connections, and measures how fast further
+ * timers can be started and stopped next to them. */
+
+static void NoOp(TimerThread::Timer*) {}
+
+static void BM_TimerThreadStartStop(bm::State& state)
+{
+  std::vector<TimerThread::Timer*> idle;
+  if (state.thread_index() == 0) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      TimerThread::Timer* t = TimerThread::NewTimer();
+      t->user_callback = NoOp;
+      t->interval = std::chrono::hours(1);
+      TimerThread::RegisterTimer(t);
+      idle.push_back(t);
+    }
+  }
+
+  for (auto _ : state) {
+    TimerThread::Timer* t = TimerThread::NewTimer();
+    t->user_callback = NoOp;
+    t->interval = std::chrono::minutes(2);
+    TimerThread::RegisterTimer(t);
+    TimerThread::UnregisterTimer(t);
+  }
+
+  for (auto* t : idle) { TimerThread::UnregisterTimer(t); }
+}
+BENCHMARK(BM_TimerThreadStartStop)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Threads(1)
+    ->Threads(4)
+    ->UseRealTime();
+
+static void BM_ThreadTimerStartStop(bm::State& state)
+{
+  std::vector<btimer_t*> idle;
+  if (state.thread_index() == 0) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      idle.push_back(start_thread_timer(nullptr, pthread_self(), 3600));
+    }
+  }
+
+  // the same as StartBsockTimer()/StopBsockTimer() around socket operations
+  for (auto _ : state) {
+    StopThreadTimer(start_thread_timer(nullptr, pthread_self(), 120));
+  }
+
+  for (auto* wid : idle) { StopThreadTimer(wid); }
+}
+BENCHMARK(BM_ThreadTimerStartStop)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Threads(1)
+    ->Threads(4)
+    ->UseRealTime();
@@ -0,0 +1,99 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+#include <benchmark/benchmark.h>
+#include "include/bareos.h"
+#include "lib/bsock_tcp.h"
+#include "lib/tls.h"
+
+#include <sys/socket.h>
+#include <memory>
+#include <thread>
+
+namespace bm = benchmark;
+
+static std::unique_ptr<Tls> MakeTls(BareosSocket* bs, utime_t lifetime)
+{
+  std::unique_ptr<Tls> tls{
+      Tls::CreateNewTlsContext(Tls::TlsImplementationType::kTlsOpenSsl)};
+  tls->SetTcpFileDescriptor(bs->fd_);
+  tls->SetTlsSessionLifetime(lifetime);
+  return tls;
+}
+
+static void Serve(BareosSocket* bs, utime_t lifetime)
+{
+  auto tls = MakeTls(bs, lifetime);
+  tls->SetCertfile(CERTDIR "/bareos-dir.bareos.org-cert.pem");
+  tls->SetKeyfile(CERTDIR "/bareos-dir.bareos.org-key.pem");
+  if (!tls->init() || !tls->TlsBsockAccept(bs)) { return; }
+
+  // TLS 1.3 tickets are sent after the handshake, with the first data
+  char byte = 'x';
+  tls->TlsBsockWriten(bs, &byte, 1);
+  tls->TlsBsockShutdown(bs);
+}
+
+static bool Connect(BareosSocket* bs, utime_t lifetime)
+{
+  auto tls = MakeTls(bs, lifetime);
+  tls->SetTlsSessionCacheKey("benchmark");
+  if (!tls->init() || !tls->TlsBsockConnect(bs)) { return false; }
+
+  char byte;
+  bool ok = tls->TlsBsockReadn(bs, &byte, 1) == 1;
+  tls->TlsBsockShutdown(bs);
+  return ok;
+}
+
+// Connections per second, with a full handshake (0) or with resumption
+static void BM_TlsConnect(bm::State& state)
+{
+  utime_t lifetime = state.range(0);
+
+  int64_t connections = 0;
+  for (auto _ : state) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+      state.SkipWithError("socketpair failed");
+      break;
+    }
+    BareosSocketTCP server, client;
+    server.fd_ = fds[0];
+    client.fd_ = fds[1];
+
+    std::thread server_thread(Serve, &server, lifetime);
+    bool ok = Connect(&client, lifetime);
+    server_thread.join();
+    server.close();
+    client.close();
+
+    if (!ok) {
+      state.SkipWithError("tls connection failed");
+      break;
+    }
+    ++connections;
+  }
+
+  state.counters["connections"]
+      = bm::Counter(static_cast<double>(connections), bm::Counter::kIsRate);
+}
+BENCHMARK(BM_TlsConnect)->Arg(0)->Arg(300)->UseRealTime();
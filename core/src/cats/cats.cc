@@ -3,7 +3,7 @@
 
    Copyright (C) 2011-2011 Free Software Foundation Europe e.V.
    Copyright (C) 2011-2016 Planets Communications B.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -31,6 +31,7 @@
 #if HAVE_POSTGRESQL
 
 #  include "cats.h"
+#  include "cats/shared_path_id_cache.h"
 #  include "sql_pooling.h"
 
 #  include "bdb_query_names.inc"
@@ -86,6 +87,20 @@ BareosDb* BareosDb::CloneDatabaseConnection(JobControlRecord* jcr,
   }
 }
 
+/**
+ * Get the path id cache of this database, if the director configured one.
+ * The cache is looked up again only when its configuration changed.
+ */
+SharedPathIdCache* BareosDb::GetPathIdCache()
+{
+  uint64_t generation = SharedPathIdCacheGeneration();
+  if (generation != path_id_cache_generation_) {
+    path_id_cache_ = GetSharedPathIdCache(db_name_, db_address_, db_port_);
+    path_id_cache_generation_ = generation;
+  }
+  return path_id_cache_.get();
+}
+
 const char* BareosDb::GetType(void)
 {
   switch (db_interface_type_) {
@@ -42,6 +42,8 @@
 #include "lib/crypto.h"
 #include "lib/base64.h"
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <stdexcept>
 #include <system_error>
@@ -61,6 +63,7 @@ template <typename T> class dlist;
 #define faddr_t long
 
 struct VolumeSessionInfo;
+class SharedPathIdCache;
 
 // Generic definitions of list types, list handlers and result handlers.
 enum e_list_type
@@ -411,6 +414,20 @@ struct JobStatisticsDbRecord {
   uint64_t JobBytes = 0; /**< Number of Bytes in Job */
 };
 
+/**
+ * Controls how PurgeFiles() removes File records. With a batch_size of 0 the
+ * records of all jobs are removed by a single DELETE statement, otherwise
+ * each job is purged in batches of batch_size records, each of them
+ * committed on its own. As Job.PurgedFiles is only set once all records of a job are
+ * gone, an interrupted purge can simply be started again.
+ */
+struct FilePurgeSettings {
+  uint32_t batch_size = 0;          /**< records per DELETE, 0 = unlimited */
+  uint32_t max_rows_per_second = 0; /**< throttle, 0 = unlimited */
+  /** called after every batch with the File records removed so far */
+  std::function<void(JobId_t jobid, uint64_t purged)> progress;
+};
+
 // Call back context for getting a 32/64 bit value from the database
 class db_int64_ctx {
  public:
@@ -526,6 +543,13 @@ class BareosDb : public BareosDbQueryEnum {
   const char** queries = nullptr;   /**< table of query texts */
   static const char* query_names[]; /**< table of query names */
   int num_rows_ = 0; /**< Number of rows returned by last query */
+  std::shared_ptr<SharedPathIdCache>
+      path_id_cache_; /**< Path ids shared by all connections */
+  uint64_t path_id_cache_generation_ = 0; /**< Configuration of the cache */
+  uint32_t batch_cached_path_ids_ = 0; /**< Batch rows with a known PathId */
+  bool path_id_unverified_ = false; /**< PathId taken from the shared cache */
+
+  SharedPathIdCache* GetPathIdCache();
 
  private:
   int GetFilenameRecord(JobControlRecord* jcr);
@@ -534,8 +558,12 @@ class BareosDb : public BareosDbQueryEnum {
                      FileDbRecord* fdbr);
   bool CreateBatchFileAttributesRecord(JobControlRecord* jcr,
                                        AttributesDbRecord* ar);
+  bool CreateBatchFileAttributesRecords(
+      JobControlRecord* jcr,
+      const std::vector<AttributesDbRecord*>& ars);
   bool CreateFilenameRecord(JobControlRecord* jcr, AttributesDbRecord* ar);
   bool CreateFileRecord(JobControlRecord* jcr, AttributesDbRecord* ar);
+  void FillPathIdCacheFromBatch();
   void CleanupBaseFile(JobControlRecord* jcr);
   void BuildPathHierarchy(JobControlRecord* jcr,
                           pathid_cache& ppathid_cache,
@@ -616,12 +644,16 @@ class BareosDb : public BareosDbQueryEnum {
   bool CreatePoolRecord(JobControlRecord* jcr, PoolDbRecord* pool_dbr);
   int DeleteNullJobmediaRecords(JobControlRecord* jcr, std::uint32_t jobid);
   bool CreateJobmediaRecord(JobControlRecord* jcr, JobMediaDbRecord* jr);
+  bool CreateJobmediaRecords(JobControlRecord* jcr,
+                             const std::vector<JobMediaDbRecord>& jms);
   bool CreateCounterRecord(JobControlRecord* jcr, CounterDbRecord* cr);
   bool CreateDeviceRecord(JobControlRecord* jcr, DeviceDbRecord* dr);
   bool CreateStorageRecord(JobControlRecord* jcr, StorageDbRecord* sr);
   bool CreateMediatypeRecord(JobControlRecord* jcr, MediaTypeDbRecord* mr);
   bool WriteBatchFileRecords(JobControlRecord* jcr);
   bool CreateAttributesRecord(JobControlRecord* jcr, AttributesDbRecord* ar);
+  bool CreateAttributesRecords(JobControlRecord* jcr,
+                               const std::vector<AttributesDbRecord*>& ars);
   bool CreateRestoreObjectRecord(JobControlRecord* jcr,
                                  RestoreObjectDbRecord* ar);
   bool CreateBaseFileAttributesRecord(JobControlRecord* jcr,
@@ -645,8 +677,10 @@ class BareosDb : public BareosDbQueryEnum {
   /* sql_delete.c */
   bool DeletePoolRecord(JobControlRecord* jcr, PoolDbRecord* pool_dbr);
   bool DeleteMediaRecord(JobControlRecord* jcr, MediaDbRecord* mr);
-  void PurgeFiles(const char* jobids);
-  void PurgeJobs(const char* jobids);
+  bool PurgeFiles(const char* jobids, const FilePurgeSettings& settings = {});
+  bool PurgeJobs(const char* jobids, const FilePurgeSettings& settings = {});
+  bool PurgeFilesOfJobInBatches(JobId_t jobid,
+                                const FilePurgeSettings& settings);
 
   /* sql_find.c */
 
@@ -731,6 +765,11 @@ class BareosDb : public BareosDbQueryEnum {
                    bool use_delta,
                    DB_RESULT_HANDLER* ResultHandler,
                    void* ctx);
+  bool GetFileIndexRanges(JobControlRecord* jcr,
+                          const char* jobids,
+                          bool use_delta,
+                          DB_RESULT_HANDLER* ResultHandler,
+                          void* ctx);
   bool GetBaseJobid(JobControlRecord* jcr, JobDbRecord* jr, JobId_t* jobid);
   bool AccurateGetJobids(JobControlRecord* jcr,
                          JobDbRecord* jr,
@@ -794,6 +833,7 @@ class BareosDb : public BareosDbQueryEnum {
                      OutputFormatter* sendit);
   void ListFilesForJob(JobControlRecord* jcr,
                        uint32_t jobid,
+                       const char* range,
                        OutputFormatter* sendit);
   void ListFilesets(JobControlRecord* jcr,
                     JobDbRecord* jr,
@@ -873,6 +913,7 @@ class BareosDb : public BareosDbQueryEnum {
                          e_list_type type);
   void ListBaseFilesForJob(JobControlRecord* jcr,
                            JobId_t jobid,
+                           const char* range,
                            OutputFormatter* sendit);
 
   /* SqlQuery.c */
@@ -994,6 +1035,7 @@ class BareosDb : public BareosDbQueryEnum {
   virtual bool SqlBatchInsertFileTable(JobControlRecord* jcr,
                                        AttributesDbRecord* ar)
       = 0;
+  virtual bool SqlBatchFlushFileTable(JobControlRecord* jcr) = 0;
 };
 
 BareosDb* db_init_database(JobControlRecord* jcr,
@@ -100,6 +100,7 @@ class BareosDbPostgresql : public BareosDb {
   bool SqlBatchEndFileTable(JobControlRecord* jcr, const char* error) override;
   bool SqlBatchInsertFileTable(JobControlRecord* jcr,
                                AttributesDbRecord* ar) override;
+  bool SqlBatchFlushFileTable(JobControlRecord* jcr) override;
   bool SqlCopyStart(const std::string& table_name,
                     const std::vector<std::string>& column_names) override;
   bool SqlCopyInsert(const std::vector<DatabaseField>& data_fields) override;
@@ -123,6 +124,8 @@ class BareosDbPostgresql : public BareosDb {
   PGconn* db_handle_;
   PGresult* result_;
   POOLMEM* buf_; /**< Buffer to manipulate queries */
+  PoolMem batch_rows_{PM_MESSAGE}; /**< Batch rows not sent yet */
+  std::size_t batch_rows_length_ = 0;
   static const char*
       query_definitions[]; /**< table of predefined sql queries */
 };
@@ -3,7 +3,7 @@
 
    Copyright (C) 2003-2011 Free Software Foundation Europe e.V.
    Copyright (C) 2011-2016 Planets Communications B.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -49,7 +49,8 @@ bool BareosDbPostgresql::SqlBatchStartFileTable(JobControlRecord*)
                               "Md5 varchar,"
                               "DeltaSeq smallint,"
                               "Fhinfo NUMERIC(20),"
-                              "Fhnode NUMERIC(20))")) {
+                              "Fhnode NUMERIC(20),"
+                              "PathId int)")) {
     Dmsg0(500, "SqlBatchStartFileTable failed\n");
     return false;
   }
@@ -58,6 +59,7 @@ bool BareosDbPostgresql::SqlBatchStartFileTable(JobControlRecord*)
   num_rows_ = -1;
   row_number_ = -1;
   field_number_ = -1;
+  batch_rows_length_ = 0;
 
   SqlFreeResult();
 
@@ -104,6 +106,8 @@ bool BareosDbPostgresql::SqlBatchEndFileTable(JobControlRecord*,
 
   Dmsg0(500, "SqlBatchEndFileTable started\n");
 
+  SqlBatchFlushFileTable(nullptr);
+
   do {
     res = PQputCopyEnd(db_handle_, error);
   } while (res == 0 && --count > 0);
@@ -197,8 +201,6 @@ static char* pgsql_copy_escape(char* dest, const char* src, size_t len)
 bool BareosDbPostgresql::SqlBatchInsertFileTable(JobControlRecord*,
                                                  AttributesDbRecord* ar)
 {
-  int res;
-  int count = 30;
   size_t len;
   const char* digest;
   char ed1[50], ed2[50], ed3[50];
@@ -215,18 +217,37 @@ bool BareosDbPostgresql::SqlBatchInsertFileTable(JobControlRecord*,
     digest = ar->Digest;
   }
 
-  len = Mmsg(cmd, "%u\t%s\t%s\t%s\t%s\t%s\t%u\t%s\t%s\n", ar->FileIndex,
-             edit_int64(ar->JobId, ed1), esc_path, esc_name, ar->attr, digest,
-             ar->DeltaSeq, edit_uint64(ar->Fhinfo, ed2),
-             edit_uint64(ar->Fhnode, ed3));
+  len = Mmsg(cmd, "%u\t%s\t%s\t%s\t%s\t%s\t%u\t%s\t%s\t%u\n",
+             ar->FileIndex, edit_int64(ar->JobId, ed1), esc_path, esc_name,
+             ar->attr, digest, ar->DeltaSeq, edit_uint64(ar->Fhinfo, ed2),
+             edit_uint64(ar->Fhnode, ed3), ar->PathId);
+
+  // The rows are sent by SqlBatchFlushFileTable()
+  batch_rows_.check_size(batch_rows_length_ + len + 1);
+  memcpy(batch_rows_.c_str() + batch_rows_length_, cmd, len + 1);
+  batch_rows_length_ += len;
+  changes++;
+
+  Dmsg0(500, "SqlBatchInsertFileTable finishing\n");
+
+  return true;
+}
+
+// Send the rows added since the last call in one go
+bool BareosDbPostgresql::SqlBatchFlushFileTable(JobControlRecord*)
+{
+  int res;
+  int count = 30;
+
+  if (batch_rows_length_ == 0) { return true; }
 
   do {
-    res = PQputCopyData(db_handle_, cmd, len);
+    res = PQputCopyData(db_handle_, batch_rows_.c_str(), batch_rows_length_);
   } while (res == 0 && --count > 0);
+  batch_rows_length_ = 0;
 
   if (res == 1) {
     Dmsg0(500, "ok\n");
-    changes++;
     status_ = 1;
   }
 
@@ -238,12 +259,11 @@ bool BareosDbPostgresql::SqlBatchInsertFileTable(JobControlRecord*,
     Dmsg1(500, "failure %s\n", errmsg);
   }
 
-  Dmsg0(500, "SqlBatchInsertFileTable finishing\n");
+  Dmsg0(500, "SqlBatchFlushFileTable finishing\n");
 
   return true;
 }
 
-
 /* ************************************* *
  * ** Generic SQL Copy used by dbcopy ** *
  * ************************************* */
@@ -0,0 +1,141 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Cache of Path -> PathId shared by all connections to a catalog
+ */
+
+#include "include/bareos.h"
+#include "cats/shared_path_id_cache.h"
+
+#include <functional>
+
+SharedPathIdCache::SharedPathIdCache(std::size_t capacity)
+    : capacity_{capacity}
+{
+}
+
+SharedPathIdCache::Shard& SharedPathIdCache::ShardOf(std::string_view path)
+{
+  return shards_[std::hash<std::string_view>{}(path) % num_shards];
+}
+
+uint32_t SharedPathIdCache::Lookup(std::string_view path)
+{
+  Shard& shard = ShardOf(path);
+  std::lock_guard l{shard.mutex};
+
+  auto found = shard.index.find(path);
+  if (found == shard.index.end()) {
+    misses_++;
+    return 0;
+  }
+  shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+  hits_++;
+  return found->second->second;
+}
+
+void SharedPathIdCache::Insert(std::string_view path, uint32_t path_id)
+{
+  Shard& shard = ShardOf(path);
+  std::lock_guard l{shard.mutex};
+
+  auto found = shard.index.find(path);
+  if (found != shard.index.end()) {
+    found->second->second = path_id;
+    shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+    return;
+  }
+
+  /* An empty shard takes the path anyway, so the cache can exceed its
+   * capacity by at most one path per shard. */
+  if (size_ >= capacity_ && !shard.lru.empty()) {
+    shard.index.erase(shard.lru.back().first);
+    shard.lru.pop_back();
+    size_--;
+  }
+  shard.lru.emplace_front(std::string{path}, path_id);
+  shard.index.emplace(shard.lru.front().first, shard.lru.begin());
+  size_++;
+}
+
+void SharedPathIdCache::Erase(std::string_view path)
+{
+  Shard& shard = ShardOf(path);
+  std::lock_guard l{shard.mutex};
+
+  auto found = shard.index.find(path);
+  if (found == shard.index.end()) { return; }
+  auto entry = found->second;
+  shard.index.erase(found);
+  shard.lru.erase(entry);
+  size_--;
+}
+
+static std::mutex caches_mutex;
+static std::unordered_map<std::string, std::shared_ptr<SharedPathIdCache>>
+    caches;
+static std::atomic<uint64_t> caches_generation{1};
+
+static std::string CacheKey(const char* db_name,
+                            const char* db_address,
+                            int db_port)
+{
+  return std::string{db_name ? db_name : ""} + "@"
+         + (db_address ? db_address : "") + ":" + std::to_string(db_port);
+}
+
+void ConfigureSharedPathIdCache(const char* db_name,
+                                const char* db_address,
+                                int db_port,
+                                std::size_t capacity)
+{
+  std::string key = CacheKey(db_name, db_address, db_port);
+  std::lock_guard l{caches_mutex};
+
+  auto found = caches.find(key);
+  if (found != caches.end() && found->second->capacity() == capacity) {
+    return;
+  }
+
+  if (capacity == 0) {
+    caches.erase(key);
+  } else {
+    caches[key] = std::make_shared<SharedPathIdCache>(capacity);
+  }
+  caches_generation++;
+  Dmsg2(100, "Path id cache for %s has %d entries\n", key.c_str(),
+        static_cast<int>(capacity));
+}
+
+std::shared_ptr<SharedPathIdCache> GetSharedPathIdCache(const char* db_name,
+                                                        const char* db_address,
+                                                        int db_port)
+{
+  std::string key = CacheKey(db_name, db_address, db_port);
+  std::lock_guard l{caches_mutex};
+
+  auto found = caches.find(key);
+  if (found == caches.end()) { return nullptr; }
+  return found->second;
+}
+
+uint64_t SharedPathIdCacheGeneration() { return caches_generation; }
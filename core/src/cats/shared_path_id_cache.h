@@ -0,0 +1,95 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Cache of Path -> PathId shared by all connections to a catalog
+ */
+
+#ifndef BAREOS_CATS_SHARED_PATH_ID_CACHE_H_
+#define BAREOS_CATS_SHARED_PATH_ID_CACHE_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+/* A bounded cache of the PathIds of recently used paths. The same directories
+ * are backed up by every job, so most paths can be resolved without asking
+ * the database. The cache is split into shards with their own lock; when
+ * the cache is full, a shard evicts its least recently used path before it
+ * takes a new one. */
+class SharedPathIdCache {
+ public:
+  explicit SharedPathIdCache(std::size_t capacity);
+
+  // Returns the PathId of path or 0 if it is not cached
+  uint32_t Lookup(std::string_view path);
+  void Insert(std::string_view path, uint32_t path_id);
+  // Forget a path whose PathId turned out to be gone
+  void Erase(std::string_view path);
+
+  std::size_t capacity() const { return capacity_; }
+  std::size_t size() const { return size_; }
+  uint64_t hits() const { return hits_; }
+  uint64_t misses() const { return misses_; }
+
+ private:
+  static constexpr std::size_t num_shards = 16;
+
+  struct Shard {
+    mutable std::mutex mutex;
+    // most recently used path first
+    std::list<std::pair<std::string, uint32_t>> lru;
+    // keys point to the strings in lru
+    std::unordered_map<std::string_view,
+                       std::list<std::pair<std::string, uint32_t>>::iterator>
+        index;
+  };
+
+  Shard& ShardOf(std::string_view path);
+
+  std::size_t capacity_;
+  std::array<Shard, num_shards> shards_;
+  std::atomic<std::size_t> size_{0};
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+};
+
+/* The director configures one cache per catalog database; a capacity of 0
+ * removes the cache. Connections fetch the cache of their database with
+ * GetSharedPathIdCache() and have to fetch it again when
+ * SharedPathIdCacheGeneration() changed. */
+void ConfigureSharedPathIdCache(const char* db_name,
+                                const char* db_address,
+                                int db_port,
+                                std::size_t capacity);
+std::shared_ptr<SharedPathIdCache> GetSharedPathIdCache(const char* db_name,
+                                                        const char* db_address,
+                                                        int db_port);
+uint64_t SharedPathIdCacheGeneration();
+
+#endif  // BAREOS_CATS_SHARED_PATH_ID_CACHE_H_
@@ -35,8 +35,11 @@ static const int dbglevel = 100;
 #if HAVE_POSTGRESQL
 
 #  include "cats.h"
+#  include "cats/shared_path_id_cache.h"
 #  include "lib/edit.h"
 
+#  include <map>
+
 /* -----------------------------------------------------------------------
  *
  *   Generic Routines (or almost generic)
@@ -144,6 +147,67 @@ bool BareosDb::CreateJobmediaRecord(JobControlRecord* jcr, JobMediaDbRecord* jm)
   return false;
 }
 
+/**
+ * Create several JobMedia records of one job with a single multi-row INSERT.
+ * The Media records are updated with the EndFile and EndBlock of the last
+ * JobMedia record written to them.
+ */
+bool BareosDb::CreateJobmediaRecords(JobControlRecord* jcr,
+                                     const std::vector<JobMediaDbRecord>& jms)
+{
+  if (jms.empty()) { return true; }
+
+  DbLocker _{this};
+
+  Mmsg(cmd, "SELECT count(*) from JobMedia WHERE JobId=%lu", jms[0].JobId);
+  int count = GetSqlRecordMax(jcr);
+  if (count < 0) { count = 0; }
+
+  PoolMem values(PM_MESSAGE);
+  std::map<DBId_t, const JobMediaDbRecord*> last_per_media;
+  for (const auto& jm : jms) {
+    count++;
+    /* clang-format off */
+    Mmsg(cmd, "%s(%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%llu)",
+         values.c_str()[0] ? "," : "",
+         jm.JobId,
+         jm.MediaId,
+         jm.FirstIndex, jm.LastIndex,
+         jm.StartFile, jm.EndFile,
+         jm.StartBlock, jm.EndBlock,
+         count,
+         jm.JobBytes);
+    /* clang-format on */
+    PmStrcat(values, cmd);
+    last_per_media[jm.MediaId] = &jm;
+  }
+
+  Mmsg(cmd,
+       "INSERT INTO JobMedia (JobId,MediaId,FirstIndex,LastIndex,"
+       "StartFile,EndFile,StartBlock,EndBlock,VolIndex,JobBytes) "
+       "VALUES %s",
+       values.c_str());
+
+  Dmsg0(300, cmd);
+  if (!SqlQuery(cmd) || SqlAffectedRows() != static_cast<int>(jms.size())) {
+    Mmsg2(errmsg, T_("Create JobMedia records %s failed: ERR=%s\n"), cmd,
+          sql_strerror());
+    return false;
+  }
+
+  for (const auto& [media_id, jm] : last_per_media) {
+    Mmsg(cmd, "UPDATE Media SET EndFile=%lu, EndBlock=%lu WHERE MediaId=%lu",
+         jm->EndFile, jm->EndBlock, media_id);
+    if (UPDATE_DB(jcr, cmd) == -1) {
+      Mmsg2(errmsg, T_("Update Media record %s failed: ERR=%s\n"), cmd,
+            sql_strerror());
+      return false;
+    }
+  }
+
+  return true;
+}
+
 /**
  * Create Unique Pool record
  * Returns: false on failure
@@ -551,8 +615,6 @@ bool BareosDb::CreatePathRecord(JobControlRecord* jcr, AttributesDbRecord* ar)
   int num_rows;
 
   errmsg[0] = 0;
-  esc_name = CheckPoolMemorySize(esc_name, 2 * pnl + 2);
-  EscapeString(jcr, esc_name, path, pnl);
 
   if (cached_path_id != 0 && cached_path_len == pnl
       && bstrcmp(cached_path, path)) {
@@ -560,6 +622,18 @@ bool BareosDb::CreatePathRecord(JobControlRecord* jcr, AttributesDbRecord* ar)
     return true;
   }
 
+  /* A PathId of the shared cache may have been deleted meanwhile, e.g. by
+   * bareos-dbcheck, it is checked when the File record is inserted. */
+  SharedPathIdCache* path_id_cache = GetPathIdCache();
+  if (path_id_cache
+      && (ar->PathId = path_id_cache->Lookup(std::string_view(path, pnl)))) {
+    path_id_unverified_ = true;
+    return true;
+  }
+
+  esc_name = CheckPoolMemorySize(esc_name, 2 * pnl + 2);
+  EscapeString(jcr, esc_name, path, pnl);
+
   Mmsg(cmd, "SELECT PathId FROM Path WHERE Path='%s'", esc_name);
 
   if (QUERY_DB(jcr, cmd)) {
@@ -587,6 +661,9 @@ bool BareosDb::CreatePathRecord(JobControlRecord* jcr, AttributesDbRecord* ar)
         cached_path_len = pnl;
         PmStrcpy(cached_path, path);
       }
+      if (path_id_cache) {
+        path_id_cache->Insert(std::string_view(path, pnl), ar->PathId);
+      }
       ASSERT(ar->PathId);
       retval = true;
       goto bail_out;
@@ -610,6 +687,9 @@ bool BareosDb::CreatePathRecord(JobControlRecord* jcr, AttributesDbRecord* ar)
     cached_path_len = pnl;
     PmStrcpy(cached_path, path);
   }
+  if (path_id_cache) {
+    path_id_cache->Insert(std::string_view(path, pnl), ar->PathId);
+  }
   retval = true;
 
 bail_out:
@@ -768,6 +848,39 @@ bool BareosDb::CreateFilesetRecord(JobControlRecord* jcr, FileSetDbRecord* fsr)
  * Returns: false on failure
  *          true on success
  */
+static int PathIdCacheHandler(void* ctx, int, char** row)
+{
+  static_cast<SharedPathIdCache*>(ctx)->Insert(row[1], str_to_uint64(row[0]));
+  return 0;
+}
+
+/**
+ * Remember the PathIds of the paths of the batch that were not in the path
+ * id cache, so the next job can skip looking them up.
+ */
+void BareosDb::FillPathIdCacheFromBatch()
+{
+  SharedPathIdCache* path_id_cache = GetPathIdCache();
+  if (!path_id_cache) { return; }
+
+  char ed1[50], ed2[50], ed3[50];
+  Mmsg(cmd,
+       "SELECT DISTINCT Path.PathId, Path.Path "
+       "FROM batch "
+       "JOIN Path ON (batch.Path = Path.Path) "
+       "WHERE batch.PathId = 0 "
+       "LIMIT %s",
+       edit_uint64(path_id_cache->capacity(), ed1));
+  if (!BigSqlQuery(cmd, PathIdCacheHandler, path_id_cache)) {
+    Dmsg1(50, "Could not fill path id cache: %s\n", errmsg);
+  }
+
+  Dmsg4(50, "Path id cache: %s paths, %s hits, %s misses, used by %u rows\n",
+        edit_uint64(path_id_cache->size(), ed1),
+        edit_uint64(path_id_cache->hits(), ed2),
+        edit_uint64(path_id_cache->misses(), ed3), batch_cached_path_ids_);
+}
+
 bool BareosDb::WriteBatchFileRecords(JobControlRecord* jcr)
 {
   bool retval = false;
@@ -796,6 +909,19 @@ bool BareosDb::WriteBatchFileRecords(JobControlRecord* jcr)
     goto bail_out;
   }
 
+  /* PathIds of the shared cache may have been deleted meanwhile, e.g. by
+   * bareos-dbcheck. Such rows are handled like rows of unknown paths. */
+  if (jcr->db_batch->batch_cached_path_ids_ > 0
+      && !jcr->db_batch->SqlQuery(
+          "UPDATE batch SET PathId = 0 "
+          "WHERE PathId <> 0 "
+          "AND NOT EXISTS (SELECT 1 FROM Path "
+          "WHERE Path.PathId = batch.PathId AND Path.Path = batch.Path)")) {
+    Jmsg1(jcr, M_FATAL, 0, "Check cached PathIds %s\n", errmsg);
+    jcr->db_batch->SqlQuery(SQL_QUERY::batch_unlock_tables_query);
+    goto bail_out;
+  }
+
   if (!jcr->db_batch->SqlQuery(SQL_QUERY::batch_fill_path_query)) {
     Jmsg1(jcr, M_FATAL, 0, "Fill Path table %s\n", errmsg);
     jcr->db_batch->SqlQuery(SQL_QUERY::batch_unlock_tables_query);
@@ -808,17 +934,31 @@ bool BareosDb::WriteBatchFileRecords(JobControlRecord* jcr)
   }
 
   /* clang-format off */
+  if (jcr->db_batch->batch_cached_path_ids_ > 0
+      && !jcr->db_batch->SqlQuery(
+        "INSERT INTO File (FileIndex, JobId, PathId, Name, LStat, MD5, DeltaSeq, Fhinfo, Fhnode) "
+        "SELECT batch.FileIndex, batch.JobId, batch.PathId, "
+        "batch.Name, batch.LStat, batch.MD5, batch.DeltaSeq, batch.Fhinfo, batch.Fhnode "
+        "FROM batch "
+        "WHERE batch.PathId <> 0 ")) {
+     Jmsg1(jcr, M_FATAL, 0, "Fill File table %s\n", errmsg);
+     goto bail_out;
+  }
+
   if (!jcr->db_batch->SqlQuery(
         "INSERT INTO File (FileIndex, JobId, PathId, Name, LStat, MD5, DeltaSeq, Fhinfo, Fhnode) "
         "SELECT batch.FileIndex, batch.JobId, Path.PathId, "
         "batch.Name, batch.LStat, batch.MD5, batch.DeltaSeq, batch.Fhinfo, batch.Fhnode "
         "FROM batch "
-        "JOIN Path ON (batch.Path = Path.Path) ")) {
+        "JOIN Path ON (batch.Path = Path.Path) "
+        "WHERE batch.PathId = 0 ")) {
      Jmsg1(jcr, M_FATAL, 0, "Fill File table %s\n", errmsg);
      goto bail_out;
   }
   /* clang-format on */
 
+  jcr->db_batch->FillPathIdCacheFromBatch();
+
   jcr->setJobStatus(JobStatus); /* reset entry status */
   Jmsg(jcr, M_INFO, 0, "Insert of attributes batch table done\n");
   retval = true;
@@ -828,6 +968,7 @@ bail_out:
   SqlQuery("DROP TABLE IF EXISTS batch");
   jcr->batch_started = false;
   changes = 0;
+  jcr->db_batch->batch_cached_path_ids_ = 0;
 
   return retval;
 }
@@ -851,11 +992,17 @@ bail_out:
 bool BareosDb::CreateBatchFileAttributesRecord(JobControlRecord* jcr,
                                                AttributesDbRecord* ar)
 {
-  ASSERT(ar->FileType != FT_BASE);
-
-  Dmsg1(dbglevel, "Fname=%s\n", ar->fname);
-  Dmsg0(dbglevel, "put_file_into_catalog\n");
+  return CreateBatchFileAttributesRecords(jcr, {ar});
+}
 
+/**
+ * Put several File records into the batch table. The rows are handed to the
+ * batch connection together.
+ */
+bool BareosDb::CreateBatchFileAttributesRecords(
+    JobControlRecord* jcr,
+    const std::vector<AttributesDbRecord*>& ars)
+{
   if (jcr->batch_started && jcr->db_batch->changes > BATCH_FLUSH) {
     jcr->db_batch->WriteBatchFileRecords(jcr);
   }
@@ -871,9 +1018,27 @@ bool BareosDb::CreateBatchFileAttributesRecord(JobControlRecord* jcr,
     jcr->batch_started = true;
   }
 
-  jcr->db_batch->SplitPathAndFile(jcr, ar->fname);
+  SharedPathIdCache* path_id_cache = jcr->db_batch->GetPathIdCache();
+  for (AttributesDbRecord* ar : ars) {
+    ASSERT(ar->FileType != FT_BASE);
+
+    Dmsg1(dbglevel, "Fname=%s\n", ar->fname);
+    Dmsg0(dbglevel, "put_file_into_catalog\n");
+
+    jcr->db_batch->SplitPathAndFile(jcr, ar->fname);
+
+    // rows with a known PathId need no lookup in the Path table
+    ar->PathId = 0;
+    if (path_id_cache) {
+      ar->PathId = path_id_cache->Lookup(
+          std::string_view(jcr->db_batch->path, jcr->db_batch->pnl));
+      if (ar->PathId) { jcr->db_batch->batch_cached_path_ids_++; }
+    }
+
+    if (!jcr->db_batch->SqlBatchInsertFileTable(jcr, ar)) { return false; }
+  }
 
-  return jcr->db_batch->SqlBatchInsertFileTable(jcr, ar);
+  return jcr->db_batch->SqlBatchFlushFileTable(jcr);
 }
 
 /**
@@ -896,11 +1061,24 @@ bool BareosDb::CreateFileAttributesRecord(JobControlRecord* jcr,
   Dmsg0(dbglevel, "put_file_into_catalog\n");
   SplitPathAndFile(jcr, ar->fname);
 
+  path_id_unverified_ = false;
   if (!CreatePathRecord(jcr, ar)) { return false; }
   Dmsg1(dbglevel, "CreatePathRecord: %s\n", esc_name);
 
   /* Now create master File record */
-  if (!CreateFileRecord(jcr, ar)) { return false; }
+  if (!CreateFileRecord(jcr, ar)) {
+    if (!path_id_unverified_) { return false; }
+
+    // The cached PathId is gone, look the path up again
+    Dmsg2(dbglevel, "PathId %u of %s no longer exists\n", ar->PathId, path);
+    if (SharedPathIdCache* path_id_cache = GetPathIdCache()) {
+      path_id_cache->Erase(std::string_view(path, pnl));
+    }
+    path_id_unverified_ = false;
+    if (!CreatePathRecord(jcr, ar) || !CreateFileRecord(jcr, ar)) {
+      return false;
+    }
+  }
   Dmsg0(dbglevel, "CreateFileRecord OK\n");
 
   Dmsg2(dbglevel, "CreateAttributes Path=%s File=%s\n", path, fname);
@@ -933,14 +1111,37 @@ bool BareosDb::CreateFileRecord(JobControlRecord* jcr, AttributesDbRecord* ar)
   }
 
   /* clang-format off */
-  Mmsg(cmd,
-       "INSERT INTO File (FileIndex,JobId,PathId,Name,"
-       "LStat,MD5,DeltaSeq,Fhinfo,Fhnode) VALUES (%u,%u,%u,'%s','%s','%s',%u,%llu,%llu)",
-       ar->FileIndex, ar->JobId, ar->PathId, esc_name,
-       ar->attr, digest, ar->DeltaSeq, ar->Fhinfo, ar->Fhnode);
+  if (path_id_unverified_) {
+    // Only insert the record if the PathId of the shared cache still exists
+    esc_path = CheckPoolMemorySize(esc_path, 2 * pnl + 2);
+    EscapeString(jcr, esc_path, path, pnl);
+    Mmsg(cmd,
+         "INSERT INTO File (FileIndex,JobId,PathId,Name,"
+         "LStat,MD5,DeltaSeq,Fhinfo,Fhnode) SELECT %u,%u,PathId,'%s','%s','%s',%u,%llu,%llu "
+         "FROM Path WHERE PathId=%u AND Path='%s'",
+         ar->FileIndex, ar->JobId, esc_name,
+         ar->attr, digest, ar->DeltaSeq, ar->Fhinfo, ar->Fhnode,
+         ar->PathId, esc_path);
+  } else {
+    Mmsg(cmd,
+         "INSERT INTO File (FileIndex,JobId,PathId,Name,"
+         "LStat,MD5,DeltaSeq,Fhinfo,Fhnode) VALUES (%u,%u,%u,'%s','%s','%s',%u,%llu,%llu)",
+         ar->FileIndex, ar->JobId, ar->PathId, esc_name,
+         ar->attr, digest, ar->DeltaSeq, ar->Fhinfo, ar->Fhnode);
+  }
   /* clang-format on */
 
   ar->FileId = SqlInsertAutokeyRecord(cmd, NT_("File"));
+  if (ar->FileId == 0 && path_id_unverified_ && SqlNumRows() == 0) {
+    return false; /* the caller looks up the path again */
+  }
+  if (path_id_unverified_ && ar->FileId != 0) {
+    // Verified, the next files of the directory can use it right away
+    path_id_unverified_ = false;
+    cached_path_id = ar->PathId;
+    cached_path_len = pnl;
+    PmStrcpy(cached_path, path);
+  }
   if (ar->FileId == 0) {
     Mmsg2(errmsg, T_("Create db File record %s failed. ERR=%s"), cmd,
           sql_strerror());
@@ -996,6 +1197,35 @@ bool BareosDb::CreateAttributesRecord(JobControlRecord* jcr,
   return retval;
 }
 
+/**
+ * Create the attribute records of several files. Where batch insert is used,
+ * all File records are handed to the batch connection at once.
+ * Returns: false if creating any of the records failed
+ */
+bool BareosDb::CreateAttributesRecords(
+    JobControlRecord* jcr,
+    const std::vector<AttributesDbRecord*>& ars)
+{
+  bool retval = true;
+  std::vector<AttributesDbRecord*> batch;
+
+  for (AttributesDbRecord* ar : ars) {
+    if (BatchInsertAvailable() && ar && ar->FileType != FT_BASE
+        && (ar->Stream == STREAM_UNIX_ATTRIBUTES
+            || ar->Stream == STREAM_UNIX_ATTRIBUTES_EX)) {
+      batch.push_back(ar);
+    } else if (!CreateAttributesRecord(jcr, ar)) {
+      retval = false;
+    }
+  }
+
+  if (!batch.empty() && !CreateBatchFileAttributesRecords(jcr, batch)) {
+    retval = false;
+  }
+
+  return retval;
+}
+
 /**
  * Create Base File record in BareosDb
  * Returns: false on failure
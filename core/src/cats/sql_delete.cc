@@ -3,7 +3,7 @@
 
    Copyright (C) 2000-2006 Free Software Foundation Europe e.V.
    Copyright (C) 2011-2016 Planets Communications B.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -33,6 +33,8 @@
 #  include "cats.h"
 #  include "lib/edit.h"
 
+#  include <chrono>
+
 /* -----------------------------------------------------------------------
  *
  *   Generic Routines (or almost generic)
@@ -218,36 +220,134 @@ bool BareosDb::DeleteMediaRecord(JobControlRecord* jcr, MediaDbRecord* mr)
   return DELETE_DB(jcr, cmd) != -1;
 }
 
-void BareosDb::PurgeFiles(const char* jobids)
+struct FileIdBatch {
+  uint64_t count{0};
+  uint64_t last{0};
+};
+
+static int FileIdBatchHandler(void* ctx, int num_fields, char** row)
+{
+  auto* batch = static_cast<FileIdBatch*>(ctx);
+
+  if (num_fields == 2 && row[0] && row[1]) {
+    batch->count = str_to_uint64(row[0]);
+    batch->last = str_to_uint64(row[1]);
+  }
+  return 0;
+}
+
+/**
+ * Delete the File records of one job in batches of settings.batch_size, so
+ * that every DELETE only touches (and locks) a bounded number of rows and
+ * gets committed on its own. Every batch continues after the highest FileId
+ * of the previous one, so gaps in the FileIds of the job cost nothing and an
+ * interrupted purge continues where it stopped.
+ * Returns: false if a DELETE failed, the error is in strerror()
+ */
+bool BareosDb::PurgeFilesOfJobInBatches(JobId_t jobid,
+                                        const FilePurgeSettings& settings)
+{
+  PoolMem query(PM_MESSAGE);
+  uint64_t purged = 0;
+  uint64_t last = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  for (;;) {
+    FileIdBatch batch;
+    Mmsg(query,
+         "WITH batch AS (SELECT FileId FROM File"
+         " WHERE JobId=%u AND FileId>%llu ORDER BY FileId LIMIT %u),"
+         " deleted AS (DELETE FROM File"
+         " WHERE FileId IN (SELECT FileId FROM batch) RETURNING FileId)"
+         " SELECT count(*), max(FileId) FROM deleted",
+         jobid, static_cast<unsigned long long>(last), settings.batch_size);
+    if (!SqlQuery(query.c_str(), FileIdBatchHandler, &batch)) { return false; }
+    if (batch.count == 0) { break; }
+
+    purged += batch.count;
+    last = batch.last;
+    Dmsg3(100, "Purged %llu File records of JobId %u up to FileId %llu\n",
+          static_cast<unsigned long long>(purged), jobid,
+          static_cast<unsigned long long>(last));
+    if (settings.progress) { settings.progress(jobid, purged); }
+
+    if (settings.max_rows_per_second) {
+      auto due = start
+                 + std::chrono::microseconds(purged * 1'000'000
+                                             / settings.max_rows_per_second);
+      auto ahead = std::chrono::duration_cast<std::chrono::microseconds>(
+          due - std::chrono::steady_clock::now());
+      if (ahead.count() > 0) {
+        Bmicrosleep(ahead.count() / 1'000'000, ahead.count() % 1'000'000);
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Delete the File and BaseFiles records of the given jobs and mark them as
+ * purged.
+ * Returns: false if the File records could not be deleted, the error is in
+ *          strerror() and the jobs that were not purged completely keep
+ *          PurgedFiles=0
+ */
+bool BareosDb::PurgeFiles(const char* jobids,
+                          const FilePurgeSettings& settings)
 {
   if (strcmp(jobids, "") == 0) {
     Dmsg0(100, "No jobids to use for purging files\n");
-    return;
+    return true;
   }
 
   PoolMem query(PM_MESSAGE);
 
-  Mmsg(query, "DELETE FROM File WHERE JobId IN (%s)", jobids);
-  SqlQuery(query.c_str());
+  if (settings.batch_size == 0) {
+    Mmsg(query, "DELETE FROM File WHERE JobId IN (%s)", jobids);
+    if (!SqlQuery(query.c_str())) { return false; }
+
+    Mmsg(query, "DELETE FROM BaseFiles WHERE JobId IN (%s)", jobids);
+    SqlQuery(query.c_str());
+
+    Mmsg(query, "UPDATE Job SET PurgedFiles=1 WHERE JobId IN (%s)", jobids);
+    SqlQuery(query.c_str());
+    return true;
+  }
 
   Mmsg(query, "DELETE FROM BaseFiles WHERE JobId IN (%s)", jobids);
   SqlQuery(query.c_str());
 
-  Mmsg(query, "UPDATE Job SET PurgedFiles=1 WHERE JobId IN (%s)", jobids);
-  SqlQuery(query.c_str());
+  for (auto& jobid_str : BStringList(jobids, ',')) {
+    JobId_t jobid = str_to_uint64(jobid_str.c_str());
+    if (!PurgeFilesOfJobInBatches(jobid, settings)) {
+      Dmsg2(100, "Purging the File records of JobId %u failed: %s", jobid,
+            errmsg);
+      return false;
+    }
+
+    Mmsg(query, "UPDATE Job SET PurgedFiles=1 WHERE JobId=%u", jobid);
+    SqlQuery(query.c_str());
+  }
+  return true;
 }
 
-void BareosDb::PurgeJobs(const char* jobids)
+/**
+ * Delete the given jobs and all records associated with them.
+ * Returns: false if the File records could not be deleted. The jobs are kept
+ *          then, so that a later purge can remove the rest of their records.
+ */
+bool BareosDb::PurgeJobs(const char* jobids, const FilePurgeSettings& settings)
 {
   PoolMem query(PM_MESSAGE);
 
   if (strcmp(jobids, "") == 0) {
     Dmsg0(100, "No jobids to purge\n");
-    return;
+    return true;
   }
 
   /* Delete (or purge) records associated with the job */
-  PurgeFiles(jobids);
+  if (!PurgeFiles(jobids, settings)) { return false; }
 
   Mmsg(query, "DELETE FROM JobMedia WHERE JobId IN (%s)", jobids);
   SqlQuery(query.c_str());
@@ -272,5 +372,6 @@ void BareosDb::PurgeJobs(const char* jobids)
   /* Now remove the Job record itself */
   Mmsg(query, "DELETE FROM Job WHERE JobId IN (%s)", jobids);
   SqlQuery(query.c_str());
+  return true;
 }
 #endif /* HAVE_POSTGRESQL */
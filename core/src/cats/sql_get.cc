@@ -1242,6 +1242,57 @@ bool BareosDb::GetFileList(JobControlRecord*,
   return BigSqlQuery(query.c_str(), ResultHandler, ctx);
 }
 
+/**
+ * Same selection of files as GetFileList(), but only returns the
+ * FileIndexes, already compressed into runs of consecutive FileIndexes
+ * by the database:
+ *   row[0]=JobId, row[1]=first FileIndex, row[2]=last FileIndex
+ *
+ * Within a run, FileIndex - DENSE_RANK() is constant, so grouping by it
+ * yields one row per run. Rows are returned by JobTDate of the job and
+ * then by FileIndex, like GetFileList() does.
+ */
+bool BareosDb::GetFileIndexRanges(JobControlRecord*,
+                                  const char* jobids,
+                                  bool use_delta,
+                                  DB_RESULT_HANDLER* ResultHandler,
+                                  void* ctx)
+{
+  PoolMem query(PM_MESSAGE);
+  PoolMem query2(PM_MESSAGE);
+
+  if (!*jobids) {
+    DbLocker _{this};
+    Mmsg(errmsg, T_("ERR=JobIds are empty\n"));
+    return false;
+  }
+
+  if (use_delta) {
+    FillQuery(query2, SQL_QUERY::select_recent_version_with_basejob_and_delta,
+              jobids, jobids, jobids, jobids);
+  } else {
+    FillQuery(query2, SQL_QUERY::select_recent_version_with_basejob, jobids,
+              jobids, jobids, jobids);
+  }
+
+  Mmsg(query,
+       "SELECT T2.JobId, MIN(T2.FileIndex), MAX(T2.FileIndex) "
+       "FROM ( "
+       "SELECT T1.JobId, T1.JobTDate, T1.FileIndex, "
+       "T1.FileIndex - DENSE_RANK() OVER "
+       "(PARTITION BY T1.JobId ORDER BY T1.FileIndex) AS Run "
+       "FROM ( %s ) AS T1 "
+       "WHERE T1.FileIndex > 0 "
+       ") AS T2 "
+       "GROUP BY T2.JobId, T2.Run "
+       "ORDER BY MIN(T2.JobTDate), T2.JobId, 2 ASC",
+       query2.c_str());
+
+  Dmsg1(100, "q=%s\n", query.c_str());
+
+  return BigSqlQuery(query.c_str(), ResultHandler, ctx);
+}
+
 bool BareosDb::GetUsedBaseJobids(JobControlRecord*,
                                  const char* jobids,
                                  db_list_ctx* result)
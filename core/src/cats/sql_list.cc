@@ -638,6 +638,7 @@ void BareosDb::ListJobTotals(JobControlRecord* jcr,
 
 void BareosDb::ListFilesForJob(JobControlRecord* jcr,
                                JobId_t jobid,
+                               const char* range,
                                OutputFormatter* sendit)
 {
   char ed1[50];
@@ -645,17 +646,18 @@ void BareosDb::ListFilesForJob(JobControlRecord* jcr,
 
   DbLocker _{this};
 
+  // pages of the list need a stable order, the whole list does not
   Mmsg(cmd,
        "SELECT Path.Path||Name AS Filename "
-       "FROM (SELECT PathId, Name FROM File WHERE JobId=%s "
+       "FROM (SELECT FileId, PathId, Name FROM File WHERE JobId=%s "
        "UNION ALL "
-       "SELECT PathId, Name "
+       "SELECT File.FileId, PathId, Name "
        "FROM BaseFiles JOIN File "
        "ON (BaseFiles.FileId = File.FileId) "
        "WHERE BaseFiles.JobId = %s"
        ") AS F, Path "
-       "WHERE Path.PathId=F.PathId ",
-       edit_int64(jobid, ed1), ed1);
+       "WHERE Path.PathId=F.PathId %s%s",
+       edit_int64(jobid, ed1), ed1, *range ? "ORDER BY F.FileId" : "", range);
 
   sendit->ArrayStart("filenames");
   if (!BigSqlQuery(cmd, ::ListResult, &lctx)) { return; }
@@ -666,6 +668,7 @@ void BareosDb::ListFilesForJob(JobControlRecord* jcr,
 
 void BareosDb::ListBaseFilesForJob(JobControlRecord* jcr,
                                    JobId_t jobid,
+                                   const char* range,
                                    OutputFormatter* sendit)
 {
   char ed1[50];
@@ -678,8 +681,8 @@ void BareosDb::ListBaseFilesForJob(JobControlRecord* jcr,
        "FROM BaseFiles, File, Path "
        "WHERE BaseFiles.JobId=%s AND BaseFiles.BaseJobId = File.JobId "
        "AND BaseFiles.FileId = File.FileId "
-       "AND Path.PathId=File.PathId ",
-       edit_int64(jobid, ed1));
+       "AND Path.PathId=File.PathId %s%s",
+       edit_int64(jobid, ed1), *range ? "ORDER BY File.FileId" : "", range);
 
   sendit->ArrayStart("files");
   if (!BigSqlQuery(cmd, ::ListResult, &lctx)) { return; }
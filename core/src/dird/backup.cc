@@ -60,8 +60,10 @@
 namespace directordaemon {
 
 /* Commands sent to File daemon */
-static char backupcmd[] = "backup FileIndex=%ld\n";
+static char backupcmd[] = "backup FileIndex=%ld AttributeEncoding=%d\n";
 static char storaddrcmd[] = "storage address=%s port=%d ssl=%d\n";
+static char storaddrv2cmd[]
+    = "storage address=%s port=%d ssl=%d connections=%d\n";
 static char passiveclientcmd[] = "passive client address=%s port=%d ssl=%d\n";
 
 /* Responses received from File daemon */
@@ -409,8 +411,14 @@ static bool ConfigureTlsRequirementsPassiveClient(JobControlRecord* jcr)
 
     connection_target_address = StorageAddressToContact(client, store);
 
-    jcr->file_bsock->fsend(storaddrcmd, connection_target_address,
-                           store->SDport, tls_policy);
+    int32_t connections = jcr->dir_impl->res.job->DataConnections;
+    if (connections > 1) {
+      jcr->file_bsock->fsend(storaddrv2cmd, connection_target_address,
+                             store->SDport, tls_policy, connections);
+    } else {
+      jcr->file_bsock->fsend(storaddrcmd, connection_target_address,
+                             store->SDport, tls_policy);
+    }
     if (!response(jcr, jcr->file_bsock, OKstore, "Storage", DISPLAY_ERROR)) {
       Dmsg0(200, "Error from active client on storeaddrcmd\n");
       TerminateBackupWithError(jcr);
@@ -599,7 +607,9 @@ bool DoNativeBackup(JobControlRecord* jcr)
 
   if (!ConfigureMessageThread(jcr)) { return false; }
 
-  jcr->file_bsock->fsend(backupcmd, jcr->JobFiles);
+  jcr->file_bsock->fsend(
+      backupcmd, jcr->JobFiles,
+      jcr->dir_impl->res.job->CompactAttributes ? AE_COMPACT_V1 : AE_LSTAT);
   Dmsg1(100, ">filed: %s", jcr->file_bsock->msg);
   if (!response(jcr, jcr->file_bsock, OKbackup, "Backup", DISPLAY_ERROR)) {
     TerminateBackupWithError(jcr);
@@ -3,7 +3,7 @@
 
    Copyright (C) 2002-2010 Free Software Foundation Europe e.V.
    Copyright (C) 2011-2016 Planets Communications B.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -62,21 +62,40 @@ RestoreBootstrapRecord::~RestoreBootstrapRecord()
   if (fileregex) { free(fileregex); }
 }
 
-void RestoreBootstrapRecordFileIndex::Add(int32_t findex)
+void RestoreBootstrapRecordFileIndex::AddRange(int32_t first, int32_t last)
 {
-  if (findex == 0) { return; /* probably a dummy directory */ }
-  fileIds_.push_back(findex);
-  sorted_ = false;
+  if (first == 0) { first = 1; /* 0 is probably a dummy directory */ }
+  if (first > last) { return; }
+
+  if (!ranges_.empty()) {
+    auto& back = ranges_.back();
+    if (first >= back.first && first <= int64_t{back.second} + 1) {
+      back.second = std::max(back.second, last);
+      return;
+    }
+    if (first < back.first) { sorted_ = false; }
+  }
+  ranges_.emplace_back(first, last);
 }
 
 void RestoreBootstrapRecordFileIndex::AddAll() { allFiles_ = true; }
+
+// Sort the ranges and merge the ones that overlap or touch
 void RestoreBootstrapRecordFileIndex::Sort()
 {
   if (sorted_) return;
 
-  if (!std::is_sorted(fileIds_.begin(), fileIds_.end())) {
-    std::sort(fileIds_.begin(), fileIds_.end());
+  std::sort(ranges_.begin(), ranges_.end());
+  std::size_t merged = 0;
+  for (std::size_t i = 1; i < ranges_.size(); ++i) {
+    auto& current = ranges_[merged];
+    if (ranges_[i].first <= int64_t{current.second} + 1) {
+      current.second = std::max(current.second, ranges_[i].second);
+    } else {
+      ranges_[++merged] = ranges_[i];
+    }
   }
+  ranges_.resize(merged + 1);
   sorted_ = true;
 }
 
@@ -86,25 +105,11 @@ RestoreBootstrapRecordFileIndex::GetRanges()
   if (allFiles_) {
     return std::vector<std::pair<int32_t, int32_t>>{
         std::make_pair(1, INT32_MAX)};
+  } else if (ranges_.empty()) {
+    return std::vector<std::pair<int32_t, int32_t>>{std::make_pair(0, 0)};
   } else {
     Sort();
-
-    auto ranges = std::vector<std::pair<int32_t, int32_t>>{};
-    auto begin = int32_t{0};
-    auto end = int32_t{0};
-
-    for (auto fileId : fileIds_) {
-      if (begin == 0) {
-        begin = end = fileId;
-      } else if (fileId > end + 1) {
-        ranges.push_back(std::make_pair(begin, end));
-        begin = end = fileId;
-      } else {
-        end = fileId;
-      }
-    }
-    ranges.push_back(std::make_pair(begin, end));
-    return ranges;
+    return ranges_;
   }
 }
 
@@ -527,10 +532,24 @@ void PrintBsr(UaContext* ua, RestoreContext& rx)
  */
 void AddFindex(RestoreBootstrapRecord* bsr, uint32_t JobId, int32_t findex)
 {
-  RestoreBootstrapRecord* nbsr;
-
   if (findex == 0) { return; /* probably a dummy directory */ }
 
+  AddFindexRange(bsr, JobId, findex, findex);
+}
+
+/**
+ * Add the FileIndexes first to last of JobId to the list of BootStrap
+ * records. Returns the record of JobId, so callers adding many ranges of
+ * the same JobId can add them to its fi directly instead of searching the
+ * chain again.
+ */
+RestoreBootstrapRecord* AddFindexRange(RestoreBootstrapRecord* bsr,
+                                       uint32_t JobId,
+                                       int32_t first,
+                                       int32_t last)
+{
+  RestoreBootstrapRecord* nbsr;
+
   if (bsr->fi->Empty()) { /* if no FI yet, jobid is not yet set */
     bsr->JobId = JobId;
   }
@@ -552,7 +571,8 @@ void AddFindex(RestoreBootstrapRecord* bsr, uint32_t JobId, int32_t findex)
     }
   }
 
-  bsr->fi->Add(findex);
+  bsr->fi->AddRange(first, last);
+  return bsr;
 }
 
 /**
@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2002-2010 Free Software Foundation Europe e.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -37,18 +37,22 @@ struct VolumeParameters;
 
 namespace directordaemon {
 
+/* The FileIndexes of one job as a set of intervals. Consecutive indexes
+ * are merged while they are added, so a contiguous run of files takes up
+ * one entry no matter how it was added. */
 class RestoreBootstrapRecordFileIndex {
  private:
-  std::vector<int32_t> fileIds_;
+  std::vector<std::pair<int32_t, int32_t>> ranges_;
   bool allFiles_ = false;
-  bool sorted_ = false;
+  bool sorted_ = true;
   void Sort();
 
  public:
-  void Add(int32_t findex);
+  void Add(int32_t findex) { AddRange(findex, findex); }
+  void AddRange(int32_t first, int32_t last);
   void AddAll();
   std::vector<std::pair<int32_t, int32_t>> GetRanges();
-  bool Empty() const { return !allFiles_ && fileIds_.empty(); }
+  bool Empty() const { return !allFiles_ && ranges_.empty(); }
 };
 
 /**
@@ -92,6 +96,10 @@ uint32_t WriteBsrFile(UaContext* ua, RestoreContext& rx);
 void DisplayBsrInfo(UaContext* ua, RestoreContext& rx);
 uint32_t WriteBsr(UaContext* ua, RestoreContext& rx, std::string& buffer);
 void AddFindex(RestoreBootstrapRecord* bsr, uint32_t JobId, int32_t findex);
+RestoreBootstrapRecord* AddFindexRange(RestoreBootstrapRecord* bsr,
+                                       uint32_t JobId,
+                                       int32_t first,
+                                       int32_t last);
 void AddFindexAll(RestoreBootstrapRecord* bsr, uint32_t JobId);
 RestoreBootstrapRecordFileIndex* new_findex();
 void MakeUniqueRestoreFilename(UaContext* ua, POOLMEM*& fname);
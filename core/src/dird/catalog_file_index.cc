@@ -0,0 +1,102 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * The File records of a job, for comparing files in memory
+ */
+
+#include "include/bareos.h"
+#include "cats/cats.h"
+#include "dird/catalog_file_index.h"
+#include "dird/director_jcr_impl.h"
+#include "lib/edit.h"
+
+namespace directordaemon {
+
+int CatalogFileIndex::LoadHandler(void* ctx, int, char** row)
+{
+  CatalogFileIndex* index = static_cast<CatalogFileIndex*>(ctx);
+  std::string fname{row[0] ? row[0] : ""};
+  fname += row[1] ? row[1] : "";
+  index->Add(std::move(fname), str_to_int32(row[2]), row[3], row[4]);
+  return 0;
+}
+
+bool CatalogFileIndex::Load(JobControlRecord* jcr, JobId_t JobId)
+{
+  PoolMem query(PM_MESSAGE);
+
+  files_.reserve(jcr->dir_impl->previous_jr.JobFiles);
+
+  Mmsg(query,
+       "SELECT Path.Path,File.Name,File.FileIndex,File.LStat,File.MD5 "
+       "FROM File,Path WHERE File.JobId=%u AND File.PathId=Path.PathId",
+       JobId);
+  if (!jcr->db->BigSqlQuery(query.c_str(), LoadHandler, this)) {
+    Jmsg(jcr, M_FATAL, 0, T_("Could not load File records of JobId %u: %s"),
+         JobId, jcr->db->strerror());
+    return false;
+  }
+
+  Dmsg2(100, "Loaded %llu File names of JobId %u\n",
+        static_cast<unsigned long long>(files_.size()), JobId);
+  return true;
+}
+
+void CatalogFileIndex::Add(std::string fname,
+                           int32_t FileIndex,
+                           const char* LStat,
+                           const char* Digest)
+{
+  files_[std::move(fname)].push_back(
+      Entry{FileIndex, false, LStat ? LStat : "", Digest ? Digest : ""});
+}
+
+bool CatalogFileIndex::Find(const char* fname,
+                            int32_t FileIndex,
+                            FileDbRecord* fdbr)
+{
+  auto it = files_.find(fname);
+  if (it == files_.end()) { return false; }
+
+  for (Entry& entry : it->second) {
+    if (match_file_index_ && entry.FileIndex != FileIndex) { continue; }
+
+    entry.seen = true;
+    bstrncpy(fdbr->LStat, entry.LStat.c_str(), sizeof(fdbr->LStat));
+    bstrncpy(fdbr->Digest, entry.Digest.c_str(), sizeof(fdbr->Digest));
+    return true;
+  }
+  return false;
+}
+
+std::vector<std::string> CatalogFileIndex::Missing() const
+{
+  std::vector<std::string> missing;
+  for (auto& [fname, entries] : files_) {
+    for (const Entry& entry : entries) {
+      if (!entry.seen && entry.FileIndex > 0) { missing.push_back(fname); }
+    }
+  }
+  return missing;
+}
+
+}  // namespace directordaemon
@@ -0,0 +1,79 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * The File records of a job, for comparing files in memory
+ */
+
+#ifndef BAREOS_DIRD_CATALOG_FILE_INDEX_H_
+#define BAREOS_DIRD_CATALOG_FILE_INDEX_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class JobControlRecord;
+struct FileDbRecord;
+
+namespace directordaemon {
+
+/* The File records of the job to verify against, loaded with a single query
+ * so that the attributes sent by the File daemon can be compared in memory
+ * instead of looking up every single file in the catalog. */
+class CatalogFileIndex {
+ public:
+  /* With match_file_index a file is only found with the FileIndex of its
+   * record, which tells apart the versions of a file that was backed up
+   * twice in a job, see BareosDb::GetFileRecord(). */
+  explicit CatalogFileIndex(bool match_file_index = false)
+      : match_file_index_{match_file_index}
+  {
+  }
+
+  bool Load(JobControlRecord* jcr, JobId_t JobId);
+  void Add(std::string fname,
+           int32_t FileIndex,
+           const char* LStat,
+           const char* Digest);
+
+  // Look up a file and mark it as seen, the equivalent of MarkFileRecord()
+  bool Find(const char* fname, int32_t FileIndex, FileDbRecord* fdbr);
+
+  // The names of the files that were not seen, except deleted ones
+  std::vector<std::string> Missing() const;
+
+ private:
+  struct Entry {
+    int32_t FileIndex;
+    bool seen;
+    std::string LStat;
+    std::string Digest;
+  };
+
+  static int LoadHandler(void* ctx, int num_fields, char** row);
+
+  bool match_file_index_;
+  std::unordered_map<std::string, std::vector<Entry>> files_;
+};
+
+}  // namespace directordaemon
+
+#endif  // BAREOS_DIRD_CATALOG_FILE_INDEX_H_
@@ -37,15 +37,19 @@
 #include "include/filetypes.h"
 #include "include/streams.h"
 #include "dird.h"
+#include "dird/catreq.h"
 #include "dird/next_vol.h"
 #include "dird/director_jcr_impl.h"
 #include "dird/sd_cmds.h"
 #include "findlib/find.h"
+#include "lib/attribs.h"
 #include "lib/berrno.h"
 #include "lib/edit.h"
 #include "lib/util.h"
 #include "lib/serial.h"
 
+#include <string>
+
 namespace directordaemon {
 
 /*
@@ -69,6 +73,9 @@ static char Create_job_media[]
     = "CatReq Job=%127s CreateJobMedia "
       " FirstIndex=%u LastIndex=%u StartFile=%u EndFile=%u "
       " StartBlock=%u EndBlock=%u Copy=%d Strip=%d MediaId=%lld\n";
+static char Create_job_media_batch[]
+    = "CatReq Job=%127s CreateJobMediaBatch Count=%d Sync=%d\n";
+static char Job_media_entry[] = "%u %u %u %u %u %u %d %d %lld";
 
 static char Update_filelist[] = "Catreq Job=%127s UpdateFileList\n";
 
@@ -112,6 +119,96 @@ static int SendVolumeInfoToStorageDaemon(JobControlRecord* jcr,
   return status;
 }
 
+// sscanf() takes missing or non-numeric fields as 0, so check them first
+static bool IsJobmediaEntry(const std::string& entry)
+{
+  int fields = 0;
+  bool in_field = false;
+  for (char c : entry) {
+    if (B_ISSPACE(c)) {
+      in_field = false;
+    } else if (!B_ISDIGIT(c)) {
+      return false;
+    } else if (!in_field) {
+      fields++;
+      in_field = true;
+    }
+  }
+  return fields == 9;
+}
+
+/**
+ * Parse the JobMedia records of a CreateJobMediaBatch request. Every record
+ * is on a line of its own following the request line. Returns false if the
+ * message does not hold exactly count records.
+ */
+bool ParseJobmediaBatch(const char* msg,
+                        JobId_t JobId,
+                        int count,
+                        std::vector<JobMediaDbRecord>& jms)
+{
+  jms.clear();
+  jms.reserve(count > 0 ? count : 0);
+
+  const char* line = strchr(msg, '\n');
+  while (line && *++line) {
+    const char* end = strchr(line, '\n');
+    std::string entry(line, end ? end - line : strlen(line));
+    JobMediaDbRecord jm;
+    uint32_t Copy, Stripe;
+    uint64_t MediaId;
+    if (!IsJobmediaEntry(entry)
+        || sscanf(entry.c_str(), Job_media_entry, &jm.FirstIndex,
+                  &jm.LastIndex, &jm.StartFile, &jm.EndFile, &jm.StartBlock,
+                  &jm.EndBlock, &Copy, &Stripe, &MediaId)
+               != 9) {
+      return false;
+    }
+    jm.JobId = JobId;
+    jm.MediaId = MediaId;
+    jms.push_back(jm);
+    line = end;
+  }
+
+  return static_cast<int>(jms.size()) == count;
+}
+
+/**
+ * Insert a batch of JobMedia records sent by the Storage daemon. Batches are
+ * only acknowledged when the SD asks for it (sync), which it does at volume
+ * change and job end; the acknowledgement then covers all earlier batches.
+ */
+static void CreateJobmediaBatch(JobControlRecord* jcr,
+                                BareosSocket* bs,
+                                int count,
+                                int sync)
+{
+  JobId_t JobId = jcr->dir_impl->mig_jcr ? jcr->dir_impl->mig_jcr->JobId
+                                         : jcr->JobId;
+  std::vector<JobMediaDbRecord> jms;
+
+  if (!ParseJobmediaBatch(bs->msg, JobId, count, jms)) {
+    Jmsg(jcr, M_FATAL, 0,
+         T_("Invalid JobMedia batch: expected %d records, got %d\n"), count,
+         static_cast<int>(jms.size()));
+    jcr->dir_impl->jobmedia_failed = true;
+  } else if (!jcr->db->CreateJobmediaRecords(jcr, jms)) {
+    Jmsg(jcr, M_FATAL, 0, T_("Catalog error creating JobMedia record. %s\n"),
+         jcr->db->strerror());
+    jcr->dir_impl->jobmedia_failed = true;
+  } else {
+    Dmsg2(400, "%d JobMedia records created for JobId=%d\n", count, JobId);
+  }
+
+  if (sync) {
+    if (jcr->dir_impl->jobmedia_failed) {
+      bs->fsend(T_("1992 Create JobMedia error\n"));
+    } else {
+      bs->fsend(OK_create);
+    }
+  }
+}
+
 void CatalogRequest(JobControlRecord* jcr, BareosSocket* bs)
 {
   MediaDbRecord mr, sdmr;
@@ -126,13 +223,19 @@ void CatalogRequest(JobControlRecord* jcr, BareosSocket* bs)
   utime_t VolFirstWritten;
   utime_t VolLastWritten;
   std::uint32_t jobid;
+  int count, sync;
 
   // Request to find next appendable Volume for this Job
   Dmsg1(100, "catreq %s", bs->msg);
   if (!jcr->db) {
     omsg = GetMemory(bs->message_length + 1);
     PmStrcpy(omsg, bs->msg);
-    bs->fsend(T_("1990 Invalid Catalog Request: %s"), omsg);
+    /* The SD does not wait for an answer to a batch without sync, it would
+     * take one as the answer to its next request. */
+    if (sscanf(bs->msg, Create_job_media_batch, &Job, &count, &sync) != 3
+        || sync) {
+      bs->fsend(T_("1990 Invalid Catalog Request: %s"), omsg);
+    }
     Jmsg1(jcr, M_FATAL, 0, T_("Invalid Catalog request; DB not open: %s"),
           omsg);
     FreeMemory(omsg);
@@ -359,6 +462,9 @@ void CatalogRequest(JobControlRecord* jcr, BareosSocket* bs)
       Dmsg0(400, "JobMedia record created\n");
       bs->fsend(OK_create);
     }
+  } else if (sscanf(bs->msg, Create_job_media_batch, &Job, &count, &sync)
+             == 3) {
+    CreateJobmediaBatch(jcr, bs, count, sync);
   } else if (sscanf(bs->msg, Update_filelist, &Job) == 1) {
     Dmsg0(0, "Updating filelist\n");
 
@@ -408,47 +514,84 @@ void CatalogRequest(JobControlRecord* jcr, BareosSocket* bs)
   return;
 }
 
+namespace {
+/* The attribute records of a FileAttributesBatch message. They are created
+ * in the catalog together once the whole message is handled. */
+class PendingAttributes {
+ public:
+  void Add(const AttributesDbRecord& ar)
+  {
+    Entry& entry = entries_.emplace_back();
+    entry.ar = ar;
+    entry.fname = ar.fname;
+    entry.attr = ar.attr;
+    if (ar.Digest) { entry.digest = ar.Digest; }
+  }
+
+  void Create(JobControlRecord* jcr)
+  {
+    if (entries_.empty()) { return; }
+
+    std::vector<AttributesDbRecord*> ars;
+    for (Entry& entry : entries_) {
+      entry.ar.fname = entry.fname.data();
+      entry.ar.attr = entry.attr.data();
+      entry.ar.Digest = entry.digest.empty() ? nullptr : entry.digest.data();
+      ars.push_back(&entry.ar);
+    }
+    if (!jcr->db->CreateAttributesRecords(jcr, ars)) {
+      Jmsg1(jcr, M_FATAL, 0, T_("Attribute create error: ERR=%s"),
+            jcr->db->strerror());
+    }
+
+    // A digest following later is added to the File record of the last one
+    if (jcr->ar->FileIndex == entries_.back().ar.FileIndex) {
+      jcr->ar->FileId = entries_.back().ar.FileId;
+    }
+    entries_.clear();
+  }
+
+ private:
+  struct Entry {
+    AttributesDbRecord ar;
+    std::string fname;
+    std::string attr;
+    std::string digest;
+  };
+  std::vector<Entry> entries_;
+};
+}  // namespace
+
+// Create the cached attribute record, or queue it with the pending ones
+static void CreateCachedAttribute(JobControlRecord* jcr,
+                                  PendingAttributes* pending)
+{
+  if (pending) {
+    pending->Add(*jcr->ar);
+  } else if (!jcr->db->CreateAttributesRecord(jcr, jcr->ar)) {
+    Jmsg1(jcr, M_FATAL, 0, T_("Attribute create error: ERR=%s"),
+          jcr->db->strerror());
+  }
+  jcr->cached_attribute = false;
+}
+
 /**
  * Note, we receive the whole attribute record, but we select out only the
  * stat packet, VolSessionId, VolSessionTime, FileIndex, file type, and file
  * name to store in the catalog.
+ *
+ * The raw record at p is reclen bytes long and followed by a zero byte.
  */
-static void UpdateAttribute(JobControlRecord* jcr,
-                            char* msg,
-                            int32_t message_length)
+static void UpdateAttributeRecord(JobControlRecord* jcr,
+                                  uint32_t FileIndex,
+                                  int32_t Stream,
+                                  char* p,
+                                  uint32_t reclen,
+                                  PendingAttributes* pending)
 {
-  unser_declare;
-  uint32_t VolSessionId, VolSessionTime;
-  int32_t Stream;
-  uint32_t FileIndex;
-  char* p;
   int len;
   char *fname, *attr;
-  AttributesDbRecord* ar = NULL;
-  uint32_t reclen;
-
-  // Start transaction allocates jcr->attr and jcr->ar if needed
-  jcr->db->StartTransaction(jcr); /* start transaction if not already open */
-  ar = jcr->ar;
-
-  /* Start by scanning directly in the message buffer to get Stream
-   * there may be a cached attr so we cannot yet write into
-   * jcr->attr or jcr->ar */
-  p = msg;
-  SkipNonspaces(&p); /* UpdCat */
-  SkipSpaces(&p);
-  SkipNonspaces(&p); /* Job=nnn */
-  SkipSpaces(&p);
-  SkipNonspaces(&p); /* "FileAttributes" */
-  p += 1;
-
-  UnserBegin(p, 0);
-  unser_uint32(VolSessionId);   /* VolSessionId */
-  unser_uint32(VolSessionTime); /* VolSessionTime */
-  unser_int32(FileIndex);       /* FileIndex */
-  unser_int32(Stream);          /* Stream */
-  unser_uint32(reclen);         /* Record length */
-  p += UnserLength(p);          /* Raw record follows */
+  AttributesDbRecord* ar = jcr->ar;
 
   /* At this point p points to the raw record, which varies according
    *  to what kind of a record (Stream) was sent.  Note, the integer
@@ -476,10 +619,6 @@ static void UpdateAttribute(JobControlRecord* jcr,
    *   Object_name
    *   Binary Object data */
 
-  Dmsg1(400, "UpdCat msg=%s\n", msg);
-  Dmsg5(400, "UpdCat VolSessId=%d VolSessT=%d FI=%d Strm=%d reclen=%d\n",
-        VolSessionId, VolSessionTime, FileIndex, Stream, reclen);
-
   jcr->dir_impl->SDJobBytes
       += reclen; /* update number of bytes transferred for quotas */
 
@@ -488,18 +627,15 @@ static void UpdateAttribute(JobControlRecord* jcr,
     case STREAM_UNIX_ATTRIBUTES_EX:
       if (jcr->cached_attribute) {
         Dmsg2(400, "Cached attr. Stream=%d fname=%s\n", ar->Stream, ar->fname);
-        if (!jcr->db->CreateAttributesRecord(jcr, ar)) {
-          Jmsg1(jcr, M_FATAL, 0, T_("Attribute create error: ERR=%s"),
-                jcr->db->strerror());
-        }
-        jcr->cached_attribute = false;
+        CreateCachedAttribute(jcr, pending);
       }
 
-      // Any cached attr is flushed so we can reuse jcr->attr and jcr->ar
-      jcr->attr = CheckPoolMemorySize(jcr->attr, message_length);
-      memcpy(jcr->attr, msg, message_length);
-      p = jcr->attr - msg + p; /* point p into jcr->attr */
-      SkipNonspaces(&p);       /* skip FileIndex */
+      /* Any cached attr is flushed so we can reuse jcr->attr and jcr->ar.
+       * The LStat text of a compact stat packet goes behind the record. */
+      jcr->attr = CheckPoolMemorySize(jcr->attr, reclen + 1 + kMaxLStatLength);
+      memcpy(jcr->attr, p, reclen + 1);
+      p = jcr->attr;     /* point p into jcr->attr */
+      SkipNonspaces(&p); /* skip FileIndex */
       SkipSpaces(&p);
       ar->FileType = str_to_int32(p);
       SkipNonspaces(&p); /* skip FileType */
@@ -513,11 +649,18 @@ static void UpdateAttribute(JobControlRecord* jcr,
         p = p + strlen(p) + 1;       /* point to extended attributes */
         p = p + strlen(p) + 1;       /* point to delta sequence */
         // Older FDs don't have a delta sequence, so check if it is there
-        if (p - jcr->attr < message_length) {
+        if (p - jcr->attr < static_cast<int64_t>(reclen)) {
           ar->DeltaSeq = str_to_int32(p); /* delta_seq */
         }
       }
 
+      // The catalog stores the LStat text
+      if (IsCompactStat(attr)) {
+        char* lstat = jcr->attr + reclen + 1;
+        CompactStatToLStat(attr, lstat);
+        attr = lstat;
+      }
+
       Dmsg2(400, "dird<stored: stream=%d %s\n", Stream, fname);
       Dmsg1(400, "dird<stored: attr=%s\n", attr);
 
@@ -538,6 +681,7 @@ static void UpdateAttribute(JobControlRecord* jcr,
       ar->Digest = NULL;
       ar->DigestType = CRYPTO_DIGEST_NONE;
       jcr->cached_attribute = true;
+      jcr->job_metrics.files.Add();
 
 
       /* Fhinfo and Fhnode are not sent from the SD,
@@ -654,12 +798,10 @@ static void UpdateAttribute(JobControlRecord* jcr,
                   ar->Stream, ar->fname);
 
             // Update BaseFile table
-            if (!jcr->db->CreateAttributesRecord(jcr, ar)) {
-              Jmsg1(jcr, M_FATAL, 0, T_("attribute create error. %s\n"),
-                    jcr->db->strerror());
-            }
-            jcr->cached_attribute = false;
+            CreateCachedAttribute(jcr, pending);
           } else {
+            // the File record has to exist to add the digest
+            if (pending) { pending->Create(jcr); }
             if (!jcr->db->AddDigestToFileRecord(jcr, ar->FileId, digestbuf,
                                                 type)) {
               Jmsg(jcr, M_ERROR, 0,
@@ -673,6 +815,93 @@ static void UpdateAttribute(JobControlRecord* jcr,
   }
 }
 
+/**
+ * Split a FileAttributes message, which carries a single record, or a
+ * FileAttributesBatch message, which carries several records back to back,
+ * into its records. Returns false if the message is malformed.
+ */
+bool ParseAttributesMessage(char* msg,
+                            int32_t message_length,
+                            std::vector<AttributesMessageRecord>& records)
+{
+  unser_declare;
+  char* end = msg + message_length;
+
+  records.clear();
+  char* p = msg;
+  SkipNonspaces(&p); /* UpdCat */
+  SkipSpaces(&p);
+  SkipNonspaces(&p); /* Job=nnn */
+  SkipSpaces(&p);
+  const bool batch = bstrncmp(p, "FileAttributesBatch ", 20);
+  SkipNonspaces(&p); /* "FileAttributes" */
+  p += 1;
+
+  do {
+    static constexpr std::size_t header_length = 5 * sizeof(uint32_t);
+    if (p > end || static_cast<std::size_t>(end - p) < header_length) {
+      return false;
+    }
+
+    AttributesMessageRecord record;
+    UnserBegin(p, 0);
+    unser_uint32(record.VolSessionId);   /* VolSessionId */
+    unser_uint32(record.VolSessionTime); /* VolSessionTime */
+    unser_int32(record.FileIndex);       /* FileIndex */
+    unser_int32(record.Stream);          /* Stream */
+    unser_uint32(record.reclen);         /* Record length */
+    p += UnserLength(p);                 /* Raw record follows */
+
+    if (record.reclen > static_cast<uint32_t>(end - p)) { return false; }
+    record.data = p;
+    records.push_back(record);
+    p += record.reclen;
+  } while (batch && p < end);
+
+  return true;
+}
+
+// Handle a FileAttributes or a FileAttributesBatch message
+static void UpdateAttribute(JobControlRecord* jcr,
+                            char* msg,
+                            int32_t message_length)
+{
+  std::vector<AttributesMessageRecord> records;
+  PendingAttributes pending_attributes;
+
+  // Start transaction allocates jcr->attr and jcr->ar if needed
+  jcr->db->StartTransaction(jcr); /* start transaction if not already open */
+
+  Dmsg1(400, "UpdCat msg=%s\n", msg);
+
+  /* The records are used directly in the message buffer, there may be a
+   * cached attr so we cannot yet write into jcr->attr or jcr->ar */
+  if (!ParseAttributesMessage(msg, message_length, records)) {
+    Jmsg1(jcr, M_FATAL, 0, T_("Malformed attribute message: %s\n"), msg);
+    return;
+  }
+
+  // Records of a batch go into the catalog together
+  PendingAttributes* pending
+      = records.size() > 1 ? &pending_attributes : nullptr;
+  for (const AttributesMessageRecord& record : records) {
+    if (jcr->IsJobCanceled()) { break; }
+
+    Dmsg5(400, "UpdCat VolSessId=%d VolSessT=%d FI=%d Strm=%d reclen=%d\n",
+          record.VolSessionId, record.VolSessionTime, record.FileIndex,
+          record.Stream, record.reclen);
+
+    // Terminate the record, restore objects rely on it
+    char next = record.data[record.reclen];
+    record.data[record.reclen] = 0;
+    UpdateAttributeRecord(jcr, record.FileIndex, record.Stream, record.data,
+                          record.reclen, pending);
+    record.data[record.reclen] = next;
+  }
+
+  pending_attributes.Create(jcr);
+}
+
 // Update File Attributes in the catalog with data sent by the Storage daemon.
 void CatalogUpdate(JobControlRecord* jcr, BareosSocket* bs)
 {
@@ -1,7 +1,7 @@
 /*
    BAREOS® - Backup Archiving REcovery Open Sourced
 
-   Copyright (C) 2018-2018 Bareos GmbH & Co. KG
+   Copyright (C) 2018-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -22,8 +22,29 @@
 #ifndef BAREOS_DIRD_CATREQ_H_
 #define BAREOS_DIRD_CATREQ_H_
 
+#include "cats/cats.h"
+
+#include <vector>
+
 namespace directordaemon {
 
+// One record of a FileAttributes or FileAttributesBatch message
+struct AttributesMessageRecord {
+  uint32_t VolSessionId{};
+  uint32_t VolSessionTime{};
+  uint32_t FileIndex{};
+  int32_t Stream{};
+  char* data{}; /**< Raw record in the message */
+  uint32_t reclen{};
+};
+
+bool ParseAttributesMessage(char* msg,
+                            int32_t message_length,
+                            std::vector<AttributesMessageRecord>& records);
+bool ParseJobmediaBatch(const char* msg,
+                        JobId_t JobId,
+                        int count,
+                        std::vector<JobMediaDbRecord>& jms);
 void CatalogRequest(JobControlRecord* jcr, BareosSocket* bs);
 void CatalogUpdate(JobControlRecord* jcr, BareosSocket* bs);
 bool DespoolAttributesFromFile(JobControlRecord* jcr, const char* file);
@@ -3,7 +3,7 @@
 
    Copyright (C) 2000-2012 Free Software Foundation Europe e.V.
    Copyright (C) 2011-2016 Planets Communications B.V.
-   Copyright (C) 2019-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2019-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -23,6 +23,7 @@
 
 #include "include/bareos.h"
 #include "cats/cats.h"
+#include "cats/shared_path_id_cache.h"
 #include "dird/check_catalog.h"
 #include "dird/dird.h"
 #include "dird/dird_conf.h"
@@ -85,6 +86,9 @@ bool CheckCatalog(cat_op mode)
       continue;
     }
 
+    ConfigureSharedPathIdCache(catalog->db_name, catalog->db_address,
+                               catalog->db_port, catalog->path_id_cache_size);
+
     /* Loop over all pools, defining/updating them in each database */
     PoolResource* pool;
     foreach_res (pool, R_POOL) {
@@ -1,7 +1,7 @@
 /*
    BAREOS® - Backup Archiving REcovery Open Sourced
 
-   Copyright (C) 2016-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2016-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -154,7 +154,10 @@ static bool ConsolidateJobs(JobControlRecord* jcr)
       if (zero_file_jobs.size() > 0) {
         Jmsg(jcr, M_INFO, 0, "%s: purging empty jobids %s\n",
              job->resource_name_, zero_file_jobs.Join(", ").c_str());
-        jcr->db->PurgeJobs(zero_file_jobs.GetAsString().c_str());
+        if (!jcr->db->PurgeJobs(zero_file_jobs.GetAsString().c_str())) {
+          Jmsg(jcr, M_ERROR, 0, "%s: purging empty jobids failed: ERR=%s\n",
+               job->resource_name_, jcr->db->strerror());
+        }
       }
 
       // all jobs - any empty jobs - the full backup
@@ -43,6 +43,8 @@
 #include "lib/tls_openssl.h"
 #include "lib/bsignal.h"
 #include "lib/daemon.h"
+#include "lib/metrics.h"
+#include "lib/metrics_server.h"
 #include "lib/parse_conf.h"
 #include "lib/thread_specific_data.h"
 #include "lib/util.h"
@@ -360,6 +362,11 @@ int main(int argc, char* argv[])
 
   StartStatisticsThread();
 
+  if (me->metrics_port) {
+    metrics::StartMetricsServer(me->metrics_address, me->metrics_port,
+                                metrics::CollectJobMetrics);
+  }
+
   Dmsg0(200, "Start UA server\n");
   if (!StartSocketServer(me->DIRaddrs)) { TerminateDird(0); }
 
@@ -394,6 +401,7 @@ static
 
   DestroyConfigureUsageString();
   StopSocketServer();
+  metrics::StopMetricsServer();
   StopStatisticsThread();
   StopWatchdog();
   DbSqlPoolDestroy();
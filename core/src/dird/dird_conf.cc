@@ -148,6 +148,18 @@ static ResourceItem dir_items[] = {
   { "SecureEraseCommand", CFG_TYPE_STR, ITEM(res_dir, secure_erase_cmdline), 0, 0, NULL, "15.2.1-",
      "Specify command that will be called when bareos unlinks files." },
   { "LogTimestampFormat", CFG_TYPE_STR, ITEM(res_dir, log_timestamp_format), 0, CFG_ITEM_DEFAULT, "%d-%b %H:%M", "15.2.3-", NULL },
+  { "MetricsPort", CFG_TYPE_PINT32, ITEM(res_dir, metrics_port), 0, CFG_ITEM_DEFAULT, "0", NULL,
+     "TCP port of the OpenMetrics (Prometheus) text endpoint. 0 disables the endpoint." },
+  { "MetricsAddress", CFG_TYPE_STR, ITEM(res_dir, metrics_address), 0, CFG_ITEM_DEFAULT, "127.0.0.1", NULL,
+     "Address the metrics endpoint is bound to." },
+  { "FilePurgeBatchSize", CFG_TYPE_PINT32, ITEM(res_dir, file_purge_batch_size), 0, CFG_ITEM_DEFAULT, "0", NULL,
+     "If set, prune and purge delete the File records of a job in batches of this many records, each committed on its own, instead of using one large transaction. 0 disables batching." },
+  { "FilePurgeMaximumRate", CFG_TYPE_PINT32, ITEM(res_dir, file_purge_max_rate), 0, CFG_ITEM_DEFAULT, "0", NULL,
+     "Maximum number of File records per second removed by a batched purge (see File Purge Batch Size). 0 means unlimited." },
+  { "RestoreTreeSpoolThreshold", CFG_TYPE_PINT32, ITEM(res_dir, restore_tree_spool_threshold), 0, CFG_ITEM_DEFAULT, "0", NULL,
+     "Restore trees of at least this many files are kept in a memory mapped file in the Working Directory instead of in memory. 0 disables this." },
+  { "ConsoleWorkerThreads", CFG_TYPE_PINT32, ITEM(res_dir, console_worker_threads), 0, CFG_ITEM_DEFAULT, "0", NULL,
+     "If set, idle console connections wait for their next command in a single event loop and commands are executed by this many worker threads. A worker waiting for its client is replaced, up to Maximum Console Connections workers in total. 0 keeps one thread per console connection." },
    TLS_COMMON_CONFIG(res_dir),
    TLS_CERT_CONFIG(res_dir),
   {nullptr, 0, 0, nullptr, 0, 0, nullptr, nullptr, nullptr}
@@ -319,6 +331,8 @@ static ResourceItem cat_items[] = {
      "This directive is used by the experimental database pooling functionality. Only use this for non production sites.  This sets the idle time after which a database pool should be shrinked." },
   { "ValidateTimeout", CFG_TYPE_PINT32, ITEM(res_cat, pooling_validate_timeout), 0, CFG_ITEM_DEFAULT, "120", NULL,
      "This directive is used by the experimental database pooling functionality. Only use this for non production sites. This sets the validation timeout after which the database connection is polled to see if its still alive." },
+  { "PathIdCacheSize", CFG_TYPE_PINT32, ITEM(res_cat, path_id_cache_size), 0, CFG_ITEM_DEFAULT, "0", NULL,
+     "Number of paths whose PathId is kept in memory, so attributes of known directories can be stored without looking up their path in the database. 0 disables the cache." },
   {nullptr, 0, 0, nullptr, 0, 0, nullptr, nullptr, nullptr}
 };
 
@@ -359,6 +373,8 @@ ResourceItem job_items[] = {
   { "WriteVerifyList", CFG_TYPE_DIR, ITEM(res_job, WriteVerifyList), 0, 0, NULL, NULL, NULL },
   { "Replace", CFG_TYPE_REPLACE, ITEM(res_job, replace), 0, CFG_ITEM_DEFAULT, "Always", NULL, NULL },
   { "MaximumBandwidth", CFG_TYPE_SPEED, ITEM(res_job, max_bandwidth), 0, 0, NULL, NULL, NULL },
+  { "DataConnections", CFG_TYPE_PINT32, ITEM(res_job, DataConnections), 0, CFG_ITEM_DEFAULT, "1", NULL,
+     "Number of network connections a client opens to the Storage Daemon to send the data of a backup." },
   { "MaxRunSchedTime", CFG_TYPE_TIME, ITEM(res_job, MaxRunSchedTime), 0, 0, NULL, NULL, NULL },
   { "MaxRunTime", CFG_TYPE_TIME, ITEM(res_job, MaxRunTime), 0, 0, NULL, NULL, NULL },
   { "FullMaxRuntime", CFG_TYPE_TIME, ITEM(res_job, FullMaxRunTime), 0, 0, NULL, NULL, NULL },
@@ -396,6 +412,10 @@ ResourceItem job_items[] = {
   { "RunScript", CFG_TYPE_RUNSCRIPT, ITEM(res_job, RunScripts), 0, CFG_ITEM_NO_EQUALS, NULL, NULL, NULL },
   { "SelectionType", CFG_TYPE_MIGTYPE, ITEM(res_job, selection_type), 0, 0, NULL, NULL, NULL },
   { "Accurate", CFG_TYPE_BOOL, ITEM(res_job, accurate), 0, CFG_ITEM_DEFAULT, "false", NULL, NULL },
+  { "VerifyBulkCompare", CFG_TYPE_BOOL, ITEM(res_job, VerifyBulkCompare), 0, CFG_ITEM_DEFAULT, "false", NULL,
+     "Verify jobs load the File records of the job to verify with a single query and compare the files in memory." },
+  { "CompactAttributes", CFG_TYPE_BOOL, ITEM(res_job, CompactAttributes), 0, CFG_ITEM_DEFAULT, "false", NULL,
+     "Backup clients send the attributes of the files in a compact binary encoding, which only clients of this version or later can restore." },
   { "AllowDuplicateJobs", CFG_TYPE_BOOL, ITEM(res_job, AllowDuplicateJobs), 0, CFG_ITEM_DEFAULT, "true", NULL, NULL },
   { "AllowHigherDuplicates", CFG_TYPE_BOOL, ITEM(res_job, AllowHigherDuplicates), 0, CFG_ITEM_DEFAULT, "true", NULL, NULL },
   { "CancelLowerLevelDuplicates", CFG_TYPE_BOOL, ITEM(res_job, CancelLowerLevelDuplicates), 0, CFG_ITEM_DEFAULT, "false", NULL, NULL },
@@ -2513,43 +2533,20 @@ static void StoreActiononpurge(LEX* lc, ResourceItem* item, int index, int)
  * first reference. The details of the resource are obtained
  * later from the SD.
  */
-static void StoreDevice(LEX* lc,
-                        ResourceItem* item,
-                        int index,
-                        int pass,
-                        BareosResource** configuration_resources)
+static void StoreDevice(LEX* lc, ResourceItem* item, int index, int pass)
 {
   int rindex = R_DEVICE;
 
   if (pass == 1) {
     LexGetToken(lc, BCT_NAME);
-    if (!configuration_resources[rindex]) {
+    if (!my_config->GetResWithName(rindex, lc->str, false)) {
       DeviceResource* device_resource = new DeviceResource;
       device_resource->rcode_ = R_DEVICE;
       device_resource->resource_name_ = strdup(lc->str);
-      configuration_resources[rindex] = device_resource; /* store first entry */
-      Dmsg3(900, "Inserting first %s res: %s index=%d\n",
+      my_config->AppendToResourcesChain(device_resource, rindex);
+      Dmsg4(900, "Inserting %s res: %s index=%d pass=%d\n",
             my_config->ResToStr(R_DEVICE), device_resource->resource_name_,
-            rindex);
-    } else {
-      bool found = false;
-      BareosResource* next;
-      for (next = configuration_resources[rindex]; next->next_;
-           next = next->next_) {
-        if (bstrcmp(next->resource_name_, lc->str)) {
-          found = true;  // already defined
-          break;
-        }
-      }
-      if (!found) {
-        DeviceResource* device_resource = new DeviceResource;
-        device_resource->rcode_ = R_DEVICE;
-        device_resource->resource_name_ = strdup(lc->str);
-        next->next_ = device_resource;
-        Dmsg4(900, "Inserting %s res: %s index=%d pass=%d\n",
-              my_config->ResToStr(R_DEVICE), device_resource->resource_name_,
-              rindex, pass);
-      }
+            rindex, pass);
     }
 
     ScanToEol(lc);
@@ -3211,7 +3208,7 @@ static void ParseConfigCb(LEX* lc,
                           ResourceItem* item,
                           int index,
                           int pass,
-                          BareosResource** configuration_resources)
+                          BareosResource**)
 {
   switch (item->type) {
     case CFG_TYPE_AUTOPASSWORD:
@@ -3230,7 +3227,7 @@ static void ParseConfigCb(LEX* lc,
       StoreAuthtype(lc, item, index, pass);
       break;
     case CFG_TYPE_DEVICE:
-      StoreDevice(lc, item, index, pass, configuration_resources);
+      StoreDevice(lc, item, index, pass);
       break;
     case CFG_TYPE_JOBTYPE:
       StoreJobtype(lc, item, index, pass);
@@ -3803,6 +3800,7 @@ static void FreeResource(BareosResource* res, int type)
       if (p->keyencrkey.value) { free(p->keyencrkey.value); }
       if (p->audit_events) { delete p->audit_events; }
       if (p->secure_erase_cmdline) { free(p->secure_erase_cmdline); }
+      if (p->metrics_address) { free(p->metrics_address); }
       if (p->log_timestamp_format) { free(p->log_timestamp_format); }
       delete p;
       break;
@@ -143,6 +143,12 @@ class DirectorResource
                                  erase of file */
   char* log_timestamp_format = nullptr; /* Timestamp format to use in generic
                                  logging messages */
+  uint32_t metrics_port = 0;             /* Port of the metrics endpoint */
+  char* metrics_address = nullptr;       /* Address of the metrics endpoint */
+  uint32_t file_purge_batch_size = 0; /* File records deleted per statement */
+  uint32_t file_purge_max_rate = 0;   /* File records purged per second */
+  uint32_t restore_tree_spool_threshold = 0; /* Files to spool restore tree */
+  uint32_t console_worker_threads = 0; /* Workers of the console event loop */
   s_password keyencrkey;                /* Key Encryption Key */
 };
 
@@ -270,6 +276,8 @@ class CatalogResource : public BareosResource {
   uint32_t pooling_validate_timeout = 0; /**< When using sql pooling set this to
                                         the number of seconds after a idle
                                         connection should be validated */
+  uint32_t path_id_cache_size = 0; /**< Number of PathIds cached for all
+                                    connections to this catalog */
 
   /**< Methods */
   char* display(POOLMEM* dst); /**< Get catalog information */
@@ -448,6 +456,7 @@ class JobResource : public BareosResource {
   int64_t FileHistSize = 0; /**< Hint about the size of the expected File history */
   int32_t MaxConcurrentJobs = 0;   /**< Maximum concurrent jobs */
   int32_t MaxConcurrentCopies = 0; /**< Limit number of concurrent jobs one Copy Job spawns */
+  int32_t DataConnections = 1;     /**< Connections the FD uses to send backup data to the SD */
   int32_t AlwaysIncrementalKeepNumber = 0; /**< Number of incrementals that are always left and not consolidated */
   int32_t MaxFullConsolidations = 0;       /**< Number of consolidate jobs to be started that will include a full */
 
@@ -496,6 +505,8 @@ class JobResource : public BareosResource {
   bool IgnoreDuplicateJobChecking = false; /**< Ignore Duplicate Job Checking */
   bool SaveFileHist = false; /**< Ability to disable File history saving for certain protocols */
   bool AlwaysIncremental = false; /**< Always incremental with regular consolidation */
+  bool VerifyBulkCompare = false; /**< Compare verified files against the catalog in memory */
+  bool CompactAttributes = false; /**< Clients send compact stat packets */
 
   runtime_job_status_t* rjs = nullptr; /**< Runtime Job Status */
 
@@ -167,6 +167,7 @@ struct DirectorJcrImpl {
   bool remote_replicate{};              /**< Replicate data to remote SD */
   bool HasQuota{};                      /**< Client has quota limits */
   bool HasSelectedJobs{};               /**< Migration/Copy Job did actually select some JobIds */
+  bool jobmedia_failed{};               /**< Creating a batch of JobMedia records failed */
   directordaemon::ClientConnectionHandshakeMode connection_handshake_try_{
     directordaemon::ClientConnectionHandshakeMode::kUndefined};
   JobTrigger job_trigger{JobTrigger::kUndefined};
@@ -41,6 +41,7 @@
 #include "dird/msgchan.h"
 #include "dird/quota.h"
 #include "dird/sd_cmds.h"
+#include "include/protocol_types.h"
 #include "lib/berrno.h"
 #include "lib/bnet.h"
 #include "lib/edit.h"
@@ -56,7 +57,7 @@ static char jobcmd[]
       "type=%d level=%d FileSet=%s NoAttr=%d SpoolAttr=%d FileSetMD5=%s "
       "SpoolData=%d PreferMountedVols=%d SpoolSize=%s "
       "rerunning=%d VolSessionId=%d VolSessionTime=%d Quota=%llu "
-      "Protocol=%d BackupFormat=%s\n";
+      "Protocol=%d BackupFormat=%s CatalogCapabilities=%d\n";
 static char use_storage[]
     = "use storage=%s media_type=%s pool_name=%s "
       "pool_type=%s append=%d copy=%d stripe=%d\n";
@@ -362,7 +363,8 @@ bool StartStorageDaemonJob(JobControlRecord* jcr, bool send_bsr)
       jcr->dir_impl->spool_data, jcr->dir_impl->res.job->PreferMountedVolumes,
       edit_int64(jcr->dir_impl->spool_size, ed2), jcr->rerunning,
       jcr->VolSessionId, jcr->VolSessionTime, remainingquota,
-      jcr->getJobProtocol(), backup_format.c_str());
+      jcr->getJobProtocol(), backup_format.c_str(),
+      CC_JOBMEDIA_BATCH | CC_ATTRIBUTES_BATCH);
 
   Dmsg1(100, ">stored: %s", sd_socket->msg);
   if (BgetDirmsg(sd_socket) > 0) {
@@ -32,6 +32,7 @@
 #include "dird.h"
 #include "dird/dird_globals.h"
 #include "dird/fd_cmds.h"
+#include "dird/ua_reactor.h"
 #include "dird/ua_server.h"
 #include "lib/berrno.h"
 #include "lib/bnet_server_tcp.h"
@@ -39,6 +40,7 @@
 #include "lib/thread_specific_data.h"
 #include "lib/try_tls_handshake_as_a_server.h"
 
+#include <algorithm>
 #include <atomic>
 
 namespace directordaemon {
@@ -63,22 +65,18 @@ struct s_addr_port {
 
 // Sanity check for the lengths of the Hello messages.
 #define MIN_MSG_LEN 15
-#define MAX_MSG_LEN (int)sizeof(name) + 25
+#define MAX_MSG_LEN (MAX_NAME_LENGTH + 25)
 
 connection_pool& get_client_connections() { return *client_connections.get(); }
 
-static void* HandleConnectionRequest(ConfigurationParser* config, void* arg)
+// Read the hello of a new connection, which is closed if that fails
+static bool ReceiveHello(ConfigurationParser* config, BareosSocket* bs)
 {
-  BareosSocket* bs = (BareosSocket*)arg;
-  char name[MAX_NAME_LENGTH];
-  char tbuf[MAX_TIME_LENGTH];
-  int fd_protocol_version = 0;
-
   if (!TryTlsHandshakeAsAServer(bs, config)) {
     bs->signal(BNET_TERMINATE);
     bs->close();
     delete bs;
-    return nullptr;
+    return false;
   }
 
   if (bs->recv() <= 0) {
@@ -87,7 +85,7 @@ static void* HandleConnectionRequest(ConfigurationParser* config, void* arg)
     bs->signal(BNET_TERMINATE);
     bs->close();
     delete bs;
-    return nullptr;
+    return false;
   }
 
   // Do a sanity check on the message received
@@ -99,9 +97,62 @@ static void* HandleConnectionRequest(ConfigurationParser* config, void* arg)
     bs->signal(BNET_TERMINATE);
     bs->close();
     delete bs;
-    return nullptr;
+    return false;
+  }
+  return true;
+}
+
+namespace {
+/* A console connection whose hello was already read. The authentication
+ * runs on a worker of the console event loop, which is replaced in the pool
+ * when the client is slow to complete it. The connection passes its socket
+ * on when it is served; an authenticated console session comes back to the
+ * event loop as a connection of its own. */
+class UserAgentConnection : public UaReactorConnection {
+ public:
+  explicit UserAgentConnection(BareosSocket* bs) : bs_{bs} {}
+
+  ~UserAgentConnection()
+  {
+    if (bs_) {
+      bs_->close();
+      delete bs_;
+    }
   }
 
+  int GetFd() const override { return bs_ ? bs_->fd_ : -1; }
+
+  // The hello is the first request and already read
+  bool ReadAvailable() override { return true; }
+
+  bool HandleInput() override
+  {
+    BareosSocket* bs = bs_;
+    bs_ = nullptr;
+    HandleUserAgentClientRequest(bs);
+    return false;
+  }
+
+  // The authentication ends by its own timeouts
+  void Terminate() override {}
+
+ private:
+  BareosSocket* bs_;
+};
+}  // namespace
+
+/* Runs on a thread of the thread list. The hello has to be read here, as
+ * TLS hides it from a peek. File daemon connections stay on this thread,
+ * console connections are handed over to the console event loop. */
+static void* HandleConnectionRequest(ConfigurationParser* config, void* arg)
+{
+  BareosSocket* bs = (BareosSocket*)arg;
+  char name[MAX_NAME_LENGTH];
+  char tbuf[MAX_TIME_LENGTH];
+  int fd_protocol_version = 0;
+
+  if (!ReceiveHello(config, bs)) { return nullptr; }
+
   Dmsg1(110, "Conn: %s", bs->msg);
 
   // See if this is a File daemon connection. If so call FD handler.
@@ -113,7 +164,14 @@ static void* HandleConnectionRequest(ConfigurationParser* config, void* arg)
     return HandleFiledConnection(*client_connections.get(), bs, name,
                                  fd_protocol_version);
   }
-  return HandleUserAgentClientRequest(bs);
+
+  auto* connection = new UserAgentConnection(bs);
+  if (!UaReactorAddConnection(connection)) {
+    // without the event loop the session is served by this thread
+    connection->HandleInput();
+    delete connection;
+  }
+  return nullptr;
 }
 
 static void* UserAgentShutdownCallback(void* bsock)
@@ -179,6 +237,12 @@ bool StartSocketServer(std::vector<s_sockfd>&& bound_sockets)
     if (client_connections) { client_connections.reset(nullptr); }
     return false;
   }
+
+  /* A worker is parked for a session that waits for its client, so there
+   * are not more workers than console connections. */
+  StartUaReactor(me->console_worker_threads,
+                 std::max<std::size_t>(me->console_worker_threads,
+                                       me->MaxConsoleConnections));
   return true;
 }
 
@@ -195,6 +259,7 @@ void StopSocketServer()
     BnetStopAndWaitForThreadServerTcp(tcp_server_tid);
     server_running = false;
   }
+  StopUaReactor();
   if (client_connections) {
     // client_connections can be NULL if the socket server was never started.
     client_connections->clear();
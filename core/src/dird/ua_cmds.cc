@@ -175,7 +175,9 @@ static struct ua_cmdstruct commands[] = {
     {NT_(".actiononpurge"), DotAopCmd, T_("List possible actions on purge"),
      NULL, true, false},
     {NT_(".api"), DotApiCmd, T_("Switch between different api modes"),
-     NT_("[ 0 | 1 | 2 | off | on | json ] [compact=<yes|no>]"), false, false},
+     NT_("[ 0 | 1 | 2 | off | on | json ] [compact=<yes|no>] "
+         "[stream=<yes|no>]"),
+     false, false},
     {NT_(".authorized"), DotAuthorizedCmd, T_("Check for authorization"),
      NT_("job=<job-name> | client=<client-name> | storage=<storage-name | \n"
          "schedule=<schedule-name> | pool=<pool-name> | cmd=<command> | \n"
@@ -982,7 +982,7 @@ bool DotApiCmd(UaContext* ua, const char*)
 {
   if (ua->argc == 1) {
     ua->api = 1;
-  } else if ((ua->argc >= 2) && (ua->argc <= 3)) {
+  } else if ((ua->argc >= 2) && (ua->argc <= 4)) {
     if (Bstrcasecmp(ua->argk[1], "off") || Bstrcasecmp(ua->argk[1], "0")) {
       ua->api = API_MODE_OFF;
       ua->batch = false;
@@ -994,12 +994,12 @@ bool DotApiCmd(UaContext* ua, const char*)
                || Bstrcasecmp(ua->argk[1], "2")) {
       ua->api = API_MODE_JSON;
       ua->batch = true;
-      if ((ua->argc == 3) && (FindArgWithValue(ua, "compact") == 2)) {
-        if (Bstrcasecmp(ua->argv[2], "yes")) {
-          ua->send->SetCompact(true);
-        } else {
-          ua->send->SetCompact(false);
-        }
+      int i;
+      if ((i = FindArgWithValue(ua, "compact")) >= 2) {
+        ua->send->SetCompact(Bstrcasecmp(ua->argv[i], "yes"));
+      }
+      if ((i = FindArgWithValue(ua, "stream")) >= 2) {
+        ua->send->SetStreaming(Bstrcasecmp(ua->argv[i], "yes"));
       }
     } else {
       return false;
@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2001-2010 Free Software Foundation Europe e.V.
-   Copyright (C) 2016-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2016-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -29,6 +29,7 @@
 #include "dird.h"
 #include "dird/ua_input.h"
 #include "dird/ua_cmds.h"
+#include "dird/ua_reactor.h"
 #include "dird/ua_select.h"
 #include "lib/bnet.h"
 #include "lib/edit.h"
@@ -55,6 +56,7 @@ bool GetCmd(UaContext* ua, const char* prompt, bool subprompt)
   if (!subprompt && ua->api) { sock->signal(BNET_TEXT_INPUT); }
   ua->SendMsg("%s", prompt);
   if (!ua->api || subprompt) { sock->signal(BNET_SUB_PROMPT); }
+  UaReactorParkWorker(); /* the answer may take a while */
   for (;;) {
     status = sock->recv();
     if (status == BNET_SIGNAL) { continue; /* ignore signals */ }
@@ -773,7 +773,8 @@ static bool DoListCmd(UaContext* ua, const char* cmd, e_list_type llist)
     // List BASEFILES
     jobid = GetJobidFromCmdline(ua);
     if (jobid > 0) {
-      ua->db->ListBaseFilesForJob(ua->jcr, jobid, ua->send);
+      ua->db->ListBaseFilesForJob(ua->jcr, jobid, query_range.c_str(),
+                                   ua->send);
     } else {
       ua->ErrorMsg(
           T_("jobid not found in db, access to job or client denied by ACL, or "
@@ -783,7 +784,7 @@ static bool DoListCmd(UaContext* ua, const char* cmd, e_list_type llist)
     // List FILES
     jobid = GetJobidFromCmdline(ua);
     if (jobid > 0) {
-      ua->db->ListFilesForJob(ua->jcr, jobid, ua->send);
+      ua->db->ListFilesForJob(ua->jcr, jobid, query_range.c_str(), ua->send);
     } else {
       ua->ErrorMsg(
           T_("jobid not found in db, access to job or client denied by ACL, or "
@@ -3,7 +3,7 @@
 
    Copyright (C) 2002-2012 Free Software Foundation Europe e.V.
    Copyright (C) 2011-2016 Planets Communications B.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -33,6 +33,7 @@
 #include "include/bareos.h"
 #include "cats/sql.h"
 #include "dird.h"
+#include "dird/dird_globals.h"
 #include "dird/director_jcr_impl.h"
 #include "dird/next_vol.h"
 #include "dird/sd_cmds.h"
@@ -398,10 +399,36 @@ static bool PurgeJobsFromClient(UaContext* ua, ClientResource* client)
 }
 
 
+/**
+ * Settings for removing File records as configured in the Director
+ * resource. Batched purges report their progress at most every
+ * progress_interval seconds.
+ */
+static FilePurgeSettings GetFilePurgeSettings(UaContext* ua)
+{
+  static constexpr time_t progress_interval = 30;
+
+  FilePurgeSettings settings;
+  settings.batch_size = me->file_purge_batch_size;
+  settings.max_rows_per_second = me->file_purge_max_rate;
+  settings.progress = [ua, last_report = time(nullptr)](
+                          JobId_t jobid, uint64_t purged) mutable {
+    time_t now = time(nullptr);
+    if (now - last_report < progress_interval) { return; }
+    last_report = now;
+    ua->InfoMsg(T_("Purged %llu File records of JobId %u so far\n"),
+                static_cast<unsigned long long>(purged), jobid);
+  };
+  return settings;
+}
+
 // Remove File records from a list of JobIds
 void PurgeFilesFromJobs(UaContext* ua, const char* jobs)
 {
-  ua->db->PurgeFiles(jobs);
+  if (!ua->db->PurgeFiles(jobs, GetFilePurgeSettings(ua))) {
+    ua->ErrorMsg(T_("Purging the File records failed: ERR=%s\n"),
+                 ua->db->strerror());
+  }
 }
 
 std::string PrepareJobidsTobedeleted(UaContext* ua,
@@ -473,7 +500,10 @@ static bool PurgeQuotaFromClient(UaContext* ua, ClientResource* client)
 // Remove all records from catalog for a list of JobIds
 void PurgeJobsFromCatalog(UaContext* ua, const char* jobs)
 {
-  ua->db->PurgeJobs(jobs);
+  if (!ua->db->PurgeJobs(jobs, GetFilePurgeSettings(ua))) {
+    ua->ErrorMsg(T_("Purging the jobs failed, they are kept: ERR=%s\n"),
+                 ua->db->strerror());
+  }
 }
 
 /**
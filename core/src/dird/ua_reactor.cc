@@ -0,0 +1,388 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Event loop for idle user agent connections
+ */
+
+#include "include/bareos.h"
+#include "dird/ua_reactor.h"
+#include "lib/berrno.h"
+#include "lib/thread_pool.h"
+#include "lib/thread_specific_data.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+#include <vector>
+
+#if defined(HAVE_SYS_EPOLL_H)
+#  include <sys/epoll.h>
+#  include <sys/eventfd.h>
+#  include <unistd.h>
+#endif
+
+namespace directordaemon {
+
+static const int debuglevel = 100;
+
+#if defined(HAVE_SYS_EPOLL_H)
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+/* A worker that is busy with one request for longer, e.g. because it writes
+ * to a client that does not read its output, is replaced in the pool. */
+constexpr auto park_after = std::chrono::milliseconds(500);
+constexpr auto supervise_interval = std::chrono::milliseconds(100);
+
+class UaReactor;
+
+struct Worker {
+  UaReactor* reactor;
+  Clock::time_point busy_since{};
+  bool busy{false};
+  bool parked{false}; /**< ends after its request, no longer in the pool */
+};
+
+thread_local Worker* current_worker = nullptr;
+
+/* Connections are watched with EPOLLONESHOT, so a connection is either
+ * waiting in the epoll set or being handled by exactly one thread. The poll
+ * thread reads the input of a connection until a whole request has arrived
+ * and only then passes it to a worker, so a client that sends a request
+ * slowly does not occupy a worker. Workers re-arm the connection when they
+ * are done with a request.
+ *
+ * A request that waits for its client, like the prompts of a restore, or
+ * that is stuck writing to a client that does not read, parks its worker:
+ * a new worker takes its place in the pool and the parked one ends with the
+ * request. Such a session is not watched again before its output is sent,
+ * so a slow reader slows down only itself. Parked and pooled workers
+ * together are capped; at the cap a waiting request keeps its worker.
+ *
+ * The work queue is bounded; when all workers are busy and the queue is
+ * full, the poll thread blocks and stops reading from further connections
+ * until a worker is free again. */
+class UaReactor {
+ public:
+  UaReactor(int epoll_fd,
+            int wakeup_fd,
+            std::size_t num_workers,
+            std::size_t max_workers)
+      : epoll_fd_{epoll_fd}
+      , wakeup_fd_{wakeup_fd}
+      , max_workers_{max_workers}
+      , work_{num_workers * 2}
+  {
+    {
+      std::lock_guard l{mutex_};
+      for (std::size_t i = 0; i < num_workers; ++i) { StartWorker(); }
+    }
+    supervisor_ = std::thread([this]() { Supervise(); });
+    poller_ = std::thread([this]() { Poll(); });
+  }
+
+  ~UaReactor()
+  {
+    {
+      std::lock_guard l{mutex_};
+      stopping_ = true;
+    }
+    supervise_.notify_one();
+    supervisor_.join();
+
+    uint64_t one = 1;
+    if (write(wakeup_fd_, &one, sizeof(one)) != sizeof(one)) {
+      BErrNo be;
+      Dmsg1(debuglevel, "Could not wake up ua reactor: ERR=%s\n",
+            be.bstrerror());
+    }
+    poller_.join();
+    {
+      std::lock_guard l{mutex_};
+      for (auto* connection : connections_) { connection->Terminate(); }
+    }
+    work_.shutdown();
+
+    // Whatever is left is idle and can be closed
+    std::unique_lock l{mutex_};
+    workers_changed_.wait(l, [this]() { return workers_.empty(); });
+    for (auto* connection : connections_) { delete connection; }
+    close(wakeup_fd_);
+    close(epoll_fd_);
+  }
+
+  bool Add(UaReactorConnection* connection)
+  {
+    {
+      std::lock_guard l{mutex_};
+      if (stopping_) { return false; }
+      connections_.insert(connection);
+    }
+
+    if (connection->ReadAvailable()) {
+      Dispatch(connection);
+    } else {
+      Watch(connection);
+    }
+    return true;
+  }
+
+  void Park(Worker* worker)
+  {
+    std::lock_guard l{mutex_};
+    ParkLocked(worker);
+  }
+
+ private:
+  // (Re-)arm the connection, it is only added to the epoll set once
+  void Watch(UaReactorConnection* connection)
+  {
+    struct epoll_event event {};
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    event.data.ptr = connection;
+    int fd = connection->GetFd();
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) != 0
+        && (errno != ENOENT
+            || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0)) {
+      BErrNo be;
+      Dmsg1(debuglevel, "Could not watch ua connection: ERR=%s\n",
+            be.bstrerror());
+      Remove(connection);
+    }
+  }
+
+  void Remove(UaReactorConnection* connection)
+  {
+    int fd = connection->GetFd();
+    if (fd >= 0) { epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr); }
+    {
+      std::lock_guard l{mutex_};
+      connections_.erase(connection);
+    }
+    delete connection;
+  }
+
+  void Dispatch(UaReactorConnection* connection)
+  {
+    work_.submit([this, connection]() { Run(connection); });
+  }
+
+  void Run(UaReactorConnection* connection)
+  {
+    bool keep = !stopping_ && connection->HandleInput();
+    while (keep && !stopping_ && connection->ReadAvailable()) {
+      keep = connection->HandleInput();
+    }
+
+    if (keep && !stopping_) {
+      Watch(connection);
+    } else {
+      Remove(connection);
+    }
+  }
+
+  // Called with the lock held
+  void StartWorker()
+  {
+    Worker* worker = &workers_.emplace_back(Worker{this});
+    std::thread([this, worker]() { Work(worker); }).detach();
+  }
+
+  // Called with the lock held
+  void ParkLocked(Worker* worker)
+  {
+    if (worker->parked || stopping_) { return; }
+    if (workers_.size() >= max_workers_) {
+      Dmsg0(debuglevel, "Too many console workers, not parking another\n");
+      return;
+    }
+    worker->parked = true;
+    StartWorker();
+    Dmsg0(debuglevel, "Console worker parked, started another one\n");
+  }
+
+  void Work(Worker* worker)
+  {
+    current_worker = worker;
+    SetJcrInThreadSpecificData(nullptr);
+
+    std::unique_lock l{mutex_};
+    while (!worker->parked) {
+      l.unlock();
+      std::optional<task> next = work_.task_out.lock()->get();
+      l.lock();
+      if (!next) { break; }
+
+      worker->busy = true;
+      worker->busy_since = Clock::now();
+      supervise_.notify_one();
+      l.unlock();
+      (*next)();
+      l.lock();
+      worker->busy = false;
+    }
+
+    workers_.remove_if([worker](const Worker& w) { return &w == worker; });
+    workers_changed_.notify_all();
+    supervise_.notify_one();
+  }
+
+  // Park the workers that are busy with one request for too long
+  void Supervise()
+  {
+    std::unique_lock l{mutex_};
+    while (!stopping_) {
+      bool busy = false;
+      Clock::time_point now = Clock::now();
+      for (Worker& worker : workers_) {
+        if (!worker.busy || worker.parked) { continue; }
+        if (now - worker.busy_since >= park_after) {
+          ParkLocked(&worker);
+        } else {
+          busy = true;
+        }
+      }
+      if (busy) {
+        supervise_.wait_for(l, supervise_interval);
+      } else {
+        supervise_.wait(l);
+      }
+    }
+  }
+
+  void Poll()
+  {
+    struct epoll_event wakeup {};
+    wakeup.events = EPOLLIN;
+    wakeup.data.ptr = nullptr;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &wakeup);
+
+    std::vector<struct epoll_event> events(64);
+    while (!stopping_) {
+      int n = epoll_wait(epoll_fd_, events.data(),
+                         static_cast<int>(events.size()), -1);
+      if (n < 0) {
+        if (errno == EINTR) { continue; }
+        BErrNo be;
+        Emsg1(M_ERROR, 0, T_("Console event loop failed: ERR=%s\n"),
+              be.bstrerror());
+        break;
+      }
+      for (int i = 0; i < n && !stopping_; ++i) {
+        auto* connection
+            = static_cast<UaReactorConnection*>(events[i].data.ptr);
+        if (!connection) { continue; }
+        if (connection->ReadAvailable()) {
+          Dispatch(connection);
+        } else {
+          Watch(connection);
+        }
+      }
+    }
+  }
+
+  int epoll_fd_{-1};
+  int wakeup_fd_{-1};
+  std::size_t max_workers_;
+  std::atomic<bool> stopping_{false};
+  std::mutex mutex_;
+  std::condition_variable supervise_;
+  std::condition_variable workers_changed_;
+  std::set<UaReactorConnection*> connections_;
+  std::list<Worker> workers_;
+  work_group work_;
+  std::thread supervisor_;
+  std::thread poller_;
+};
+
+std::unique_ptr<UaReactor> reactor;
+}  // namespace
+
+bool StartUaReactor(std::size_t num_workers, std::size_t max_workers)
+{
+  if (reactor || num_workers == 0) { return false; }
+  max_workers = std::max(num_workers, max_workers);
+
+  int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd < 0) {
+    BErrNo be;
+    Emsg1(M_ERROR, 0, T_("Cannot create console event loop: ERR=%s\n"),
+          be.bstrerror());
+    return false;
+  }
+  int wakeup_fd = eventfd(0, EFD_CLOEXEC);
+  if (wakeup_fd < 0) {
+    BErrNo be;
+    Emsg1(M_ERROR, 0, T_("Cannot create console event loop: ERR=%s\n"),
+          be.bstrerror());
+    close(epoll_fd);
+    return false;
+  }
+
+  reactor = std::make_unique<UaReactor>(epoll_fd, wakeup_fd, num_workers,
+                                        max_workers);
+  Dmsg2(debuglevel, "Console event loop started with %d workers, max %d\n",
+        static_cast<int>(num_workers), static_cast<int>(max_workers));
+  return true;
+}
+
+void StopUaReactor() { reactor.reset(); }
+
+bool UaReactorAddConnection(UaReactorConnection* connection)
+{
+  return reactor && reactor->Add(connection);
+}
+
+void UaReactorParkWorker()
+{
+  if (current_worker) { current_worker->reactor->Park(current_worker); }
+}
+
+#else
+
+bool StartUaReactor(std::size_t num_workers, std::size_t)
+{
+  if (num_workers > 0) {
+    Emsg0(M_WARNING, 0,
+          T_("Console event loop not supported on this platform, every "
+             "console connection uses its own thread.\n"));
+  }
+  return false;
+}
+
+void StopUaReactor() {}
+
+bool UaReactorAddConnection(UaReactorConnection*) { return false; }
+
+void UaReactorParkWorker() {}
+
+#endif /* HAVE_SYS_EPOLL_H */
+
+} /* namespace directordaemon */
@@ -0,0 +1,72 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Event loop for idle user agent connections
+ *
+ * Console, WebUI and API sessions spend most of their time waiting for the
+ * next command. Instead of blocking one thread per session, new connections
+ * are handed to the reactor, which waits for input on all of them with a
+ * single thread and runs the requests on a small pool of workers.
+ */
+
+#ifndef BAREOS_DIRD_UA_REACTOR_H_
+#define BAREOS_DIRD_UA_REACTOR_H_
+
+#include <cstddef>
+
+namespace directordaemon {
+
+class UaReactorConnection {
+ public:
+  virtual ~UaReactorConnection() = default;
+
+  // The socket to wait on, -1 once the connection passed it on
+  virtual int GetFd() const = 0;
+  /* Reads what arrived without blocking. Returns true once the next request
+   * can be handled without waiting for the client, i.e. it was read
+   * completely or the connection was closed. */
+  virtual bool ReadAvailable() = 0;
+  // Handle the next request, returns false when the connection is finished
+  virtual bool HandleInput() = 0;
+  // Make a running HandleInput() return as soon as possible
+  virtual void Terminate() = 0;
+};
+
+/* Starts the reactor with num_workers in its pool. Together with the parked
+ * ones, not more than max_workers are running; when that many are, a
+ * request that waits for its client keeps its worker. */
+bool StartUaReactor(std::size_t num_workers, std::size_t max_workers);
+void StopUaReactor();
+
+/* Hands the connection over to the reactor, which deletes it when it is
+ * finished. Returns false if no reactor is running; the caller then still
+ * owns the connection. */
+bool UaReactorAddConnection(UaReactorConnection* connection);
+
+/* Called by a request that is going to wait for its client, e.g. for the
+ * answer to a prompt. A worker of the reactor is then replaced in the pool
+ * and ends after the request, so waiting dialogs never use up the pool.
+ * Does nothing on other threads. */
+void UaReactorParkWorker();
+
+} /* namespace directordaemon */
+#endif  // BAREOS_DIRD_UA_REACTOR_H_
@@ -1220,8 +1220,14 @@ static bool BuildDirectoryTree(UaContext* ua, RestoreContext* rx)
   bool OK = true;
   char ed1[50];
 
-  // Build the directory tree containing JobIds user selected
-  tree.root = new_tree(rx->TotalFiles);
+  /* Build the directory tree containing JobIds user selected. Large trees
+   * are mapped from a file, so they do not have to fit into memory. */
+  const char* spool_directory = nullptr;
+  if (me->restore_tree_spool_threshold
+      && rx->TotalFiles >= me->restore_tree_spool_threshold) {
+    spool_directory = me->working_directory;
+  }
+  tree.root = new_tree(rx->TotalFiles, spool_directory);
   tree.ua = ua;
   tree.all = rx->all;
 
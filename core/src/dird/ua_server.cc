@@ -3,7 +3,7 @@
 
    Copyright (C) 2000-2007 Free Software Foundation Europe e.V.
    Copyright (C) 2011-2012 Planets Communications B.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -38,13 +38,20 @@
 #include "dird/ua_db.h"
 #include "dird/ua_input.h"
 #include "dird/ua_output.h"
+#include "dird/ua_reactor.h"
 #include "dird/ua_server.h"
 #include "lib/bnet.h"
+#include "lib/bsock_tcp.h"
 #include "lib/parse_conf.h"
+#include "lib/tls.h"
 #include "lib/thread_specific_data.h"
 #include "dird/jcr_util.h"
 #include "console_connection_lease.h"
 
+#include <cstring>
+#include <memory>
+#include <vector>
+
 namespace directordaemon {
 
 /**
@@ -80,64 +87,218 @@ JobControlRecord* new_control_jcr(const char* base_name, int job_type)
   return jcr;
 }
 
+// Execute the command received with status, as returned by recv()
+static void ExecuteUserAgentCommand(UaContext* ua, int status)
+{
+  BareosSocket* user_agent_socket = ua->UA_sock;
+
+  if (status >= 0) {
+    PmStrcpy(ua->cmd, ua->UA_sock->msg);
+    ParseUaArgs(ua);
+    Do_a_command(ua);
+
+    DequeueMessages(ua->jcr);
+
+    if (!ua->quit) {
+      if (console_msg_pending && ua->AclAccessOk(Command_ACL, "messages")) {
+        if (ua->auto_display_messages) {
+          PmStrcpy(ua->cmd, "messages");
+          DotMessagesCmd(ua, ua->cmd);
+          ua->user_notified_msg_pending = false;
+        } else if (!ua->gui && !ua->user_notified_msg_pending
+                   && console_msg_pending) {
+          if (ua->api) {
+            user_agent_socket->signal(BNET_MSGS_PENDING);
+          } else {
+            bsendmsg(ua, T_("You have messages.\n"));
+          }
+          ua->user_notified_msg_pending = true;
+        }
+      }
+      if (!ua->api) {
+        user_agent_socket->signal(BNET_EOD); /* send end of command */
+      }
+    }
+  } else if (IsBnetStop(user_agent_socket)) {
+    ua->quit = true;
+  } else { /* signal */
+    user_agent_socket->signal(BNET_POLL);
+  }
+}
+
+// Read and execute the next command of a user agent
+static void HandleUserAgentCommand(UaContext* ua)
+{
+  ExecuteUserAgentCommand(ua, ua->UA_sock->recv());
+}
+
+namespace {
+/* An authenticated user agent session. In the event loop its next command
+ * is read without blocking until it is complete, then handled like a
+ * command read by recv(). Nothing beyond the command is read, so prompts
+ * within the command still receive their answers with recv(). */
+class UserAgentConnection : public UaReactorConnection {
+ public:
+  explicit UserAgentConnection(BareosSocket* user_agent_socket)
+      : jcr_{new_control_jcr("-Console-", JT_CONSOLE)}
+      , ua_{new_ua_context(jcr_)}
+  {
+    ua_->UA_sock = user_agent_socket;
+  }
+
+  ~UserAgentConnection()
+  {
+    BareosSocket* user_agent_socket = ua_->UA_sock;
+    CloseDb(ua_);
+    FreeUaContext(ua_);
+    FreeJcr(jcr_);
+    delete user_agent_socket;
+  }
+
+  UaContext* GetUa() { return ua_; }
+
+  int GetFd() const override { return ua_->UA_sock->fd_; }
+
+  bool ReadAvailable() override
+  {
+    while (!closed_) {
+      std::size_t missing = Missing();
+      if (missing == 0) { return true; }
+
+      input_.resize(received_ + missing);
+      int nread = Read(input_.data() + received_, missing);
+      if (nread == 0) { return false; }
+      if (nread < 0) {
+        closed_ = true;
+      } else {
+        received_ += nread;
+      }
+    }
+    return true;
+  }
+
+  bool HandleInput() override
+  {
+    SetJcrInThreadSpecificData(nullptr);
+    ExecuteUserAgentCommand(ua_, TakeMessage());
+    if (ua_->quit) { return false; }
+
+    // Prompt for the next command before going back to the event loop
+    if (ua_->api) { ua_->UA_sock->signal(BNET_MAIN_PROMPT); }
+    return true;
+  }
+
+  void Terminate() override { ua_->UA_sock->SetTerminated(); }
+
+ private:
+  static constexpr std::size_t header_length = BareosSocketTCP::header_length;
+
+  int32_t Length() const
+  {
+    int32_t length;
+    memcpy(&length, input_.data(), sizeof(length));
+    return ntohl(length);
+  }
+
+  // Bytes still missing from the next message, 0 once it is complete
+  std::size_t Missing() const
+  {
+    if (received_ < header_length) { return header_length - received_; }
+    int32_t length = Length();
+    if (length <= 0 || length > BareosSocketTCP::max_packet_size) { return 0; }
+    return header_length + length - received_;
+  }
+
+  int Read(char* buf, std::size_t len)
+  {
+    BareosSocket* bs = ua_->UA_sock;
+    if (bs->tls_conn) {
+      return bs->tls_conn->TlsBsockReadAvailable(bs, buf, len);
+    }
+#if defined(HAVE_SYS_EPOLL_H)
+    ssize_t nread = ::recv(bs->fd_, buf, len, MSG_DONTWAIT);
+    if (nread > 0) { return static_cast<int>(nread); }
+    if (nread < 0
+        && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+      return 0;
+    }
+#endif
+    return -1;
+  }
+
+  // Passes the message on like BareosSocket::recv() does
+  int32_t TakeMessage()
+  {
+    BareosSocket* bs = ua_->UA_sock;
+    bs->msg[0] = 0;
+    bs->message_length = 0;
+    if (closed_) {
+      bs->SetTerminated();
+      return BNET_HARDEOF;
+    }
+
+    int32_t length = Length();
+    received_ = 0;
+    if (length > BareosSocketTCP::max_packet_size) {
+      Qmsg3(jcr_, M_FATAL, 0,
+            T_("Packet size too big from \"%s:%s:%d. Terminating "
+               "connection.\n"),
+            bs->who(), bs->host(), bs->port());
+      length = BNET_TERMINATE;
+    }
+    if (length < 0) {
+      if (length == BNET_TERMINATE) { bs->SetTerminated(); }
+      bs->message_length = length;
+      return BNET_SIGNAL;
+    }
+
+    bs->msg = CheckPoolMemorySize(bs->msg, length + 1);
+    memcpy(bs->msg, input_.data() + header_length, length);
+    bs->msg[length] = 0;
+    bs->message_length = length;
+    bs->in_msg_no++;
+    return length;
+  }
+
+  ConsoleConnectionLease lease_;  // obtain lease to count connections
+  JobControlRecord* jcr_;
+  UaContext* ua_;
+  std::vector<char> input_;
+  std::size_t received_{0};
+  bool closed_{false};
+};
+}  // namespace
+
 // Handle Director User Agent commands
 void* HandleUserAgentClientRequest(BareosSocket* user_agent_socket)
 {
   DetachIfNotDetached(pthread_self());
 
-  JobControlRecord* jcr = new_control_jcr("-Console-", JT_CONSOLE);
-
-  UaContext* ua = new_ua_context(jcr);
-  ua->UA_sock = user_agent_socket;
+  auto connection = std::make_unique<UserAgentConnection>(user_agent_socket);
+  UaContext* ua = connection->GetUa();
   SetJcrInThreadSpecificData(nullptr);
 
-  ConsoleConnectionLease lease;  // obtain lease to count connections
   bool success = AuthenticateConsole(ua);
 
   if (!success) { ua->quit = true; }
 
-  while (!ua->quit) {
+  if (!ua->quit) {
     if (ua->api) { user_agent_socket->signal(BNET_MAIN_PROMPT); }
 
-    int status = user_agent_socket->recv();
-    if (status >= 0) {
-      PmStrcpy(ua->cmd, ua->UA_sock->msg);
-      ParseUaArgs(ua);
-      Do_a_command(ua);
-
-      DequeueMessages(ua->jcr);
-
-      if (!ua->quit) {
-        if (console_msg_pending && ua->AclAccessOk(Command_ACL, "messages")) {
-          if (ua->auto_display_messages) {
-            PmStrcpy(ua->cmd, "messages");
-            DotMessagesCmd(ua, ua->cmd);
-            ua->user_notified_msg_pending = false;
-          } else if (!ua->gui && !ua->user_notified_msg_pending
-                     && console_msg_pending) {
-            if (ua->api) {
-              user_agent_socket->signal(BNET_MSGS_PENDING);
-            } else {
-              bsendmsg(ua, T_("You have messages.\n"));
-            }
-            ua->user_notified_msg_pending = true;
-          }
-        }
-        if (!ua->api) {
-          user_agent_socket->signal(BNET_EOD); /* send end of command */
-        }
-      }
-    } else if (IsBnetStop(user_agent_socket)) {
-      ua->quit = true;
-    } else { /* signal */
-      user_agent_socket->signal(BNET_POLL);
+    /* Wait for the next command in the event loop if there is one,
+     * otherwise keep this thread for the whole session. */
+    if (UaReactorAddConnection(connection.get())) {
+      connection.release();
+      return NULL;
     }
-  } /* while (!ua->quit) */
 
-  CloseDb(ua);
-  FreeUaContext(ua);
-  FreeJcr(jcr);
-  delete user_agent_socket;
+    while (!ua->quit) {
+      HandleUserAgentCommand(ua);
+      if (!ua->quit && ua->api) {
+        user_agent_socket->signal(BNET_MAIN_PROMPT);
+      }
+    }
+  }
 
   return NULL;
 }
@@ -512,26 +512,34 @@ void NativeVbackupCleanup(JobControlRecord* jcr, int TermCode, int JobLevel)
   Dmsg0(100, "Leave vbackup_cleanup()\n");
 }
 
+namespace {
+struct BootstrapRangeContext {
+  RestoreBootstrapRecord* bsr{};  /* head of the chain */
+  RestoreBootstrapRecord* last{}; /* record the last range was added to */
+};
+}  // namespace
+
 /**
  * This callback routine is responsible for inserting the
- *  items it gets into the bootstrap structure. For each JobId selected
- *  this routine is called once for each file. We do not allow
- *  duplicate filenames, but instead keep the info from the most
- *  recent file entered (i.e. the JobIds are assumed to be sorted)
+ *  FileIndex ranges it gets into the bootstrap structure. The rows
+ *  come grouped by JobId, so the record of the previous row is
+ *  usually the right one.
  *
- *   See uar_sel_files in sql_cmds.c for query that calls us.
- *      row[0]=Path, row[1]=Filename, row[2]=FileIndex
- *      row[3]=JobId row[4]=LStat
+ *   See GetFileIndexRanges() for the query that calls us.
+ *      row[0]=JobId, row[1]=first FileIndex, row[2]=last FileIndex
  */
-static int InsertBootstrapHandler(void* ctx, int, char** row)
+static int InsertBootstrapRangeHandler(void* ctx, int, char** row)
 {
-  JobId_t JobId;
-  int FileIndex;
-  RestoreBootstrapRecord* bsr = (RestoreBootstrapRecord*)ctx;
+  auto* brc = static_cast<BootstrapRangeContext*>(ctx);
 
-  JobId = str_to_int64(row[3]);
-  FileIndex = str_to_int64(row[2]);
-  AddFindex(bsr, JobId, FileIndex);
+  JobId_t JobId = str_to_int64(row[0]);
+  int32_t first = str_to_int64(row[1]);
+  int32_t last = str_to_int64(row[2]);
+  if (brc->last && brc->last->JobId == JobId) {
+    brc->last->fi->AddRange(first, last);
+  } else {
+    brc->last = AddFindexRange(brc->bsr, JobId, first, last);
+  }
   return 0;
 }
 
@@ -548,9 +556,9 @@ static bool CreateBootstrapFile(JobControlRecord& jcr,
   rx.bsr = std::make_unique<RestoreBootstrapRecord>();
   rx.JobIds = jobids_pm.addr();
 
-  if (!jcr.db_batch->GetFileList(&jcr, rx.JobIds, false /* don't use md5 */,
-                                 true /* use delta */, InsertBootstrapHandler,
-                                 (void*)rx.bsr.get())) {
+  BootstrapRangeContext brc{rx.bsr.get()};
+  if (!jcr.db_batch->GetFileIndexRanges(&jcr, rx.JobIds, true /* use delta */,
+                                        InsertBootstrapRangeHandler, &brc)) {
     Jmsg(&jcr, M_ERROR, 0, "%s", jcr.db_batch->strerror());
   }
 
@@ -38,6 +38,7 @@
 #include "dird/dird_globals.h"
 #include "findlib/find.h"
 #include "dird/backup.h"
+#include "dird/catalog_file_index.h"
 #include "dird/fd_cmds.h"
 #include "dird/getmsg.h"
 #include "dird/director_jcr_impl.h"
@@ -53,6 +54,9 @@
 #include "lib/util.h"
 #include "lib/version.h"
 
+#include <memory>
+#include <string>
+
 namespace directordaemon {
 
 /* Commands sent to File daemon */
@@ -69,6 +73,8 @@ static char OKpassiveclient[] = "2000 OK passive client\n";
 /* Forward referenced functions */
 static void PrtFname(JobControlRecord* jcr);
 static int MissingHandler(void* ctx, int num_fields, char** row);
+static void PrtMissing(JobControlRecord* jcr, const char* path, const char* name);
+
 
 /**
  * Called here before the job is run to do the job
@@ -582,6 +588,16 @@ void GetAttributesAndCompareToCatalog(JobControlRecord* jcr, JobId_t JobId)
   fdbr.JobId = JobId;
   jcr->dir_impl->FileIndex = 0;
 
+  /* Disk to catalog compares against the latest backup of each single file,
+   * which can not be loaded up front. */
+  std::unique_ptr<CatalogFileIndex> catalog_files;
+  if (jcr->dir_impl->res.job->VerifyBulkCompare
+      && jcr->getJobLevel() != L_VERIFY_DISK_TO_CATALOG) {
+    catalog_files = std::make_unique<CatalogFileIndex>(
+        jcr->getJobLevel() == L_VERIFY_VOLUME_TO_CATALOG);
+    if (!catalog_files->Load(jcr, JobId)) { goto bail_out; }
+  }
+
   Dmsg0(20, "dir: waiting to receive file attributes\n");
   /* Get Attributes and Signature from File daemon
    * We expect:
@@ -646,9 +662,16 @@ void GetAttributesAndCompareToCatalog(JobControlRecord* jcr, JobId_t JobId)
 
         // Find equivalent record in the database
         fdbr.FileId = 0;
-        if (!jcr->db->GetFileAttributesRecord(jcr, jcr->dir_impl->fname,
-                                              &jcr->dir_impl->previous_jr,
-                                              &fdbr)) {
+        if (catalog_files) {
+          if (!catalog_files->Find(jcr->dir_impl->fname, file_index, &fdbr)) {
+            Jmsg(jcr, M_INFO, 0, T_("New file: %s\n"), jcr->dir_impl->fname);
+            Dmsg1(020, T_("File not in catalog: %s\n"), jcr->dir_impl->fname);
+            jcr->setJobStatusWithPriorityCheck(JS_Differences);
+            continue;
+          }
+        } else if (!jcr->db->GetFileAttributesRecord(
+                       jcr, jcr->dir_impl->fname, &jcr->dir_impl->previous_jr,
+                       &fdbr)) {
           Jmsg(jcr, M_INFO, 0, T_("New file: %s\n"), jcr->dir_impl->fname);
           Dmsg1(020, T_("File not in catalog: %s\n"), jcr->dir_impl->fname);
           jcr->setJobStatusWithPriorityCheck(JS_Differences);
@@ -817,13 +840,20 @@ void GetAttributesAndCompareToCatalog(JobControlRecord* jcr, JobId_t JobId)
    *  the database where the MarkId != current JobId
    */
   jcr->dir_impl->fn_printed = false;
-  Mmsg(buf,
-       "SELECT Path.Path,File.Name FROM File,Path "
-       "WHERE File.JobId=%d AND File.FileIndex > 0 "
-       "AND File.MarkId!=%d AND File.PathId=Path.PathId ",
-       JobId, jcr->JobId);
-  /* MissingHandler is called for each file found */
-  jcr->db->SqlQuery(buf.c_str(), MissingHandler, (void*)jcr);
+  if (catalog_files) {
+    for (const std::string& missing : catalog_files->Missing()) {
+      if (jcr->IsJobCanceled()) { break; }
+      PrtMissing(jcr, missing.c_str(), "");
+    }
+  } else {
+    Mmsg(buf,
+         "SELECT Path.Path,File.Name FROM File,Path "
+         "WHERE File.JobId=%d AND File.FileIndex > 0 "
+         "AND File.MarkId!=%d AND File.PathId=Path.PathId ",
+         JobId, jcr->JobId);
+    /* MissingHandler is called for each file found */
+    jcr->db->SqlQuery(buf.c_str(), MissingHandler, (void*)jcr);
+  }
   if (jcr->dir_impl->fn_printed) {
     jcr->setJobStatusWithPriorityCheck(JS_Differences);
   }
@@ -843,6 +873,12 @@ static int MissingHandler(void* ctx, int, char** row)
   JobControlRecord* jcr = (JobControlRecord*)ctx;
 
   if (jcr->IsJobCanceled()) { return 1; }
+  PrtMissing(jcr, row[0] ? row[0] : "", row[1] ? row[1] : "");
+  return 0;
+}
+
+static void PrtMissing(JobControlRecord* jcr, const char* path, const char* name)
+{
   if (!jcr->dir_impl->fn_printed) {
     Qmsg(jcr, M_WARNING, 0,
          T_("The following files are in the Catalog but not on %s:\n"),
@@ -850,9 +886,7 @@ static int MissingHandler(void* ctx, int, char** row)
                                                           : "disk");
     jcr->dir_impl->fn_printed = true;
   }
-  Qmsg(jcr, M_INFO, 0, "      %s%s\n", row[0] ? row[0] : "",
-       row[1] ? row[1] : "");
-  return 0;
+  Qmsg(jcr, M_INFO, 0, "      %s%s\n", path, name);
 }
 
 // Print filename for verify
@@ -1208,7 +1208,9 @@ dpl_status_t dpl_posix_stream_put(dpl_ctx_t* ctx,
 
   cur_off = json_object_get_int64(offset_object);
 
-  fd = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0600);
+  /* Only the first put of a stream replaces an existing file, the following
+   * ones append to it. */
+  fd = open(path, O_CREAT | O_WRONLY | (cur_off ? 0 : O_TRUNC), 0600);
   if (-1 == fd) {
     ret = dpl_posix_map_errno();
     perror("open");
@@ -3,7 +3,7 @@
 
    Copyright (C) 2000-2010 Free Software Foundation Europe e.V.
    Copyright (C) 2011-2012 Planets Communications B.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -177,18 +177,23 @@ bool AuthenticateStoragedaemon(JobControlRecord* jcr)
   return result;
 }
 
-// Authenticate with a remote storage daemon.
-bool AuthenticateWithStoragedaemon(JobControlRecord* jcr)
+/* Authenticate an additional data connection with a remote storage daemon,
+ * the session key is kept for the connections that follow. */
+bool AuthenticateDataConnection(JobControlRecord* jcr, BareosSocket* sd)
 {
-  bool result = false;
-  BareosSocket* sd = jcr->store_bsock;
   s_password password;
 
   password.encoding = p_encoding_md5;
   password.value = jcr->sd_auth_key;
-  result = sd->AuthenticateOutboundConnection(
+  return sd->AuthenticateOutboundConnection(
       jcr, my_config->CreateOwnQualifiedNameForNetworkDump(),
       (char*)jcr->client_name, password, me);
+}
+
+// Authenticate with a remote storage daemon.
+bool AuthenticateWithStoragedaemon(JobControlRecord* jcr)
+{
+  bool result = AuthenticateDataConnection(jcr, jcr->store_bsock);
 
   // Destroy session key
   memset(jcr->sd_auth_key, 0, strlen(jcr->sd_auth_key));
@@ -3,7 +3,7 @@
 
    Copyright (C) 2000-2010 Free Software Foundation Europe e.V.
    Copyright (C) 2011-2012 Planets Communications B.V.
-   Copyright (C) 2013-2021 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -31,6 +31,7 @@ bool AuthenticateWithDirector(JobControlRecord* jcr,
                               DirectorResource* director);
 bool AuthenticateStoragedaemon(JobControlRecord* jcr);
 bool AuthenticateWithStoragedaemon(JobControlRecord* jcr);
+bool AuthenticateDataConnection(JobControlRecord* jcr, BareosSocket* sd);
 
 } /* namespace filedaemon */
 
@@ -33,18 +33,24 @@
 #include "filed/filed.h"
 #include "filed/filed_globals.h"
 #include "filed/accurate.h"
+#include "filed/bandwidth_limits.h"
 #include "filed/compression.h"
 #include "filed/crypto.h"
 #include "filed/heartbeat.h"
 #include "filed/backup.h"
 #include "filed/filed_jcr_impl.h"
+#include "filed/data_message.h"
+#include "filed/parallel_file_reader.h"
 #include "include/ch.h"
+#include "include/protocol_types.h"
 #include "findlib/attribs.h"
 #include "findlib/hardlink.h"
 #include "findlib/find_one.h"
+#include "findlib/hole_finder.h"
 #include "lib/attribs.h"
 #include "lib/berrno.h"
 #include "lib/bsock.h"
+#include "lib/bsock_multiplexed.h"
 #include "lib/btimers.h"
 #include "lib/parse_conf.h"
 #include "lib/util.h"
@@ -96,6 +102,52 @@ bool EncodeAndSendAttributes(JobControlRecord* jcr,
 static void CloseVssBackupSession(JobControlRecord* jcr);
 #endif
 
+/* Spread the data over the additional connections to the storage daemon.
+ * The job connection is replaced by a socket that sends over all of them,
+ * which then carries the bandwidth limits of the job. */
+static std::unique_ptr<BareosSocketMultiplexed> StartDataConnections(
+    JobControlRecord* jcr,
+    uint32_t buf_size)
+{
+  BareosSocket* sd = jcr->store_bsock;
+  std::vector<BareosSocket*> connections{sd};
+  for (BareosSocket* connection : jcr->fd_impl->sd_data_connections) {
+    connection->SetBufferSize(buf_size, BNET_SETBUF_WRITE);
+    connections.push_back(connection);
+  }
+
+  auto multiplexed = std::make_unique<BareosSocketMultiplexed>(
+      jcr, std::move(connections), jcr->buf_size);
+  multiplexed->SetBwlimit(jcr->max_bandwidth);
+  if (me->allow_bw_bursting) { multiplexed->SetBwlimitBursting(); }
+  multiplexed->SetBandwidthBucket(GetBandwidthBucket(jcr->fd_impl->director));
+  sd->SetBwlimit(0);
+  sd->SetBandwidthBucket(nullptr);
+
+  jcr->store_bsock = multiplexed.get();
+  return multiplexed;
+}
+
+static bool FinishDataConnections(
+    JobControlRecord* jcr,
+    BareosSocket* sd,
+    std::unique_ptr<BareosSocketMultiplexed> multiplexed)
+{
+  bool ok = multiplexed->Finish();
+  if (!ok && !jcr->IsJobCanceled()) {
+    Jmsg(jcr, M_FATAL, 0, T_("Network send error to SD. ERR=%s\n"),
+         multiplexed->bstrerror());
+  }
+  Dmsg2(100, "Sent %llu blocks over %d connections to SD\n",
+        static_cast<unsigned long long>(multiplexed->BlocksSent()),
+        static_cast<int>(jcr->fd_impl->sd_data_connections.size()) + 1);
+
+  jcr->store_bsock = sd;
+  sd->SetBwlimit(jcr->max_bandwidth);
+  sd->SetBandwidthBucket(GetBandwidthBucket(jcr->fd_impl->director));
+  return ok;
+}
+
 /**
  * Find all the requested files and send them
  * to the Storage daemon.
@@ -153,6 +205,13 @@ bool BlastDataToStorageDaemon(JobControlRecord* jcr, crypto_cipher_t cipher)
 
   auto hb_send = MakeHeartbeatMonitor(jcr);
 
+  BareosSocket* job_connection = sd;
+  std::unique_ptr<BareosSocketMultiplexed> multiplexed;
+  if (!jcr->fd_impl->sd_data_connections.empty()) {
+    multiplexed = StartDataConnections(jcr, buf_size);
+    sd = jcr->store_bsock;
+  }
+
   if (have_acl) {
     jcr->fd_impl->acl_data = std::make_unique<AclData>();
     jcr->fd_impl->acl_data->u.build
@@ -197,6 +256,12 @@ bool BlastDataToStorageDaemon(JobControlRecord* jcr, crypto_cipher_t cipher)
 
   sd->signal(BNET_EOD); /* end of sending data */
 
+  if (multiplexed
+      && !FinishDataConnections(jcr, job_connection, std::move(multiplexed))) {
+    ok = false;
+    jcr->setJobStatusWithPriorityCheck(JS_ErrorTerminated);
+  }
+
   if (have_acl && jcr->fd_impl->acl_data) {
     FreePoolMemory(jcr->fd_impl->acl_data->u.build->content);
     free(jcr->fd_impl->acl_data->u.build);
@@ -955,6 +1020,7 @@ static inline bool SendDataToSd(b_ctx* bctx)
   Dmsg1(130, "Send data to SD len=%d\n", sd->message_length);
   bctx->jcr->JobBytes += sd->message_length; /* count bytes saved possibly
                                                 compressed/encrypted */
+  bctx->jcr->job_metrics.bytes.Add(sd->message_length);
   sd->msg = bctx->msgsave;                   /* restore read buffer */
 
   return true;
@@ -1021,15 +1087,41 @@ bail_out:
 }
 #endif
 
+/* The holes of sparse regular files are skipped without reading them, all
+ * other files have to be read to find their zero blocks. */
+static std::optional<HoleFinder> MakeHoleFinder(
+    [[maybe_unused]] FindFilesPacket* ff_pkt)
+{
+#if !defined(HAVE_WIN32)
+  if (BitIsSet(FO_SPARSE, ff_pkt->flags) && ff_pkt->type == FT_REG
+      && !ff_pkt->bfd.cmd_plugin) {
+    return HoleFinder(ff_pkt->bfd.filedes, ff_pkt->statp.st_size);
+  }
+#endif
+  return std::nullopt;
+}
+
 static inline bool SendPlainDataSerially(b_ctx& bctx)
 {
   bool retval = false;
   BareosSocket* sd = bctx.jcr->store_bsock;
+  std::optional<HoleFinder> holes = MakeHoleFinder(bctx.ff_pkt);
 
   // Read the file data
-  while ((sd->message_length
-          = (uint32_t)bread(&bctx.ff_pkt->bfd, bctx.rbuf, bctx.rsize))
-         > 0) {
+  for (;;) {
+    if (holes) {
+      std::int64_t position = holes->SkipHole(bctx.fileAddr, bctx.rsize);
+      if (position < 0) {
+        bctx.ff_pkt->bfd.BErrNo = errno;
+        sd->message_length = -1;
+        break;
+      }
+      bctx.fileAddr = position;
+    }
+
+    sd->message_length
+        = (uint32_t)bread(&bctx.ff_pkt->bfd, bctx.rbuf, bctx.rsize);
+    if (sd->message_length <= 0) { break; }
     if (!SendDataToSd(&bctx)) { goto bail_out; }
   }
   retval = true;
@@ -1055,108 +1147,25 @@ static result<std::size_t> SendData(BareosSocket* sd,
   return size;
 }
 
-class data_message {
-  /* some data is prefixed by a OFFSET_FADDR_SIZE-byte number -- called header
-   * here, which basically contains the file position to which to write the
-   * following block of data.
-   * The difference between FADDR and OFFSET is that offset may be any value
-   * (given to the core by a plugin), whereas FADDR is computed by the core
-   * itself and is equal to the number of bytes already read from the file
-   * descriptor. */
-  static inline constexpr std::size_t header_size = OFFSET_FADDR_SIZE;
-  /* our bsocket functions assume that they are allowed to overwrite
-   * the four bytes directly preceding the given buffer
-   * To keep the message alignment to 8, we "allocate" full 8 bytes instead
-   * of the required 4. */
-  static inline constexpr std::size_t bnet_size = 8;
-  static inline constexpr std::size_t data_offset = header_size + bnet_size;
-
-  std::vector<char> buffer{};
-  bool has_header{false};
-
- public:
-  data_message(std::size_t data_size)
-  {
-    buffer.resize(data_size + data_offset);
-  }
-  data_message() : data_message(0) {}
-  data_message(const data_message&) = delete;
-  data_message& operator=(const data_message&) = delete;
-  data_message(data_message&&) = default;
-  data_message& operator=(data_message&&) = default;
-
-  // creates a message with the same header -- if any
-  data_message derived() const
-  {
-    data_message derived;
-
-    if (has_header) {
-      derived.has_header = true;
-      std::memcpy(derived.header_ptr(), header_ptr(), header_size);
-    }
-
-    return derived;
-  }
-
-  void set_header(std::uint64_t h)
-  {
-    has_header = true;
-    auto* ptr = header_ptr();
-    network_order::network net{h};  // save in network order
-    std::memcpy(ptr, &net, header_size);
-  }
-
-  void resize(std::size_t new_size) { buffer.resize(data_offset + new_size); }
-
-  char* header_ptr() { return &buffer[bnet_size]; }
-  char* data_ptr() { return &buffer[data_offset]; }
-  const char* header_ptr() const { return &buffer[bnet_size]; }
-  const char* data_ptr() const { return &buffer[data_offset]; }
-
-  std::size_t data_size() const
-  {
-    ASSERT(buffer.size() >= data_offset);
-    return buffer.size() - data_offset;
-  }
-
-  /* important: this is not actually a POOLMEM*; do not pass it to POOLMEM*
-   *            functions, except to pass it to BareosSocket::SendData(). */
-  POOLMEM* as_socket_message()
-  {
-    if (has_header) {
-      return header_ptr();
-    } else {
-      return data_ptr();
-    }
-  }
-
-  std::size_t message_size() const
-  {
-    auto size_with_header = buffer.size() - bnet_size;
-    if (has_header) {
-      return size_with_header;
-    } else {
-      return size_with_header - header_size;
-    }
-  }
-};
-
 using shared_message = std::shared_ptr<data_message>;
 
 static std::future<result<std::size_t>> MakeSendThread(
     thread_pool& pool,
     BareosSocket* sd,
-    channel::output<std::future<result<shared_message>>> out)
+    channel::output<std::future<result<shared_message>>> out,
+    metrics::JobMetrics& job_metrics)
 {
   std::promise<result<std::size_t>> promise;
   std::future fut = promise.get_future();
 
   pool.borrow_thread(
-      [prom = std::move(promise), out = std::move(out), sd]() mutable {
+      [prom = std::move(promise), out = std::move(out), sd,
+       &job_metrics]() mutable {
         std::size_t accumulated = 0;
         for (;;) {
           std::optional out_fut = out.get();
           if (!out_fut) { break; }
+          job_metrics.queue_depth.Sub();
           result p = out_fut->get();
           if (p.holds_error()) {
             prom.set_value(std::move(p.error_unchecked()));
@@ -1177,6 +1186,7 @@ static std::future<result<std::size_t>> MakeSendThread(
           }
 
           accumulated += ret.value_unchecked();
+          job_metrics.bytes.Add(ret.value_unchecked());
         }
         prom.set_value(accumulated);
       });
@@ -1293,7 +1303,8 @@ static inline bool SendPlainData(b_ctx& bctx)
       = channel::CreateBufferedChannel<std::future<result<shared_message>>>(
           num_workers);
 
-  std::future bytes_send_fut = MakeSendThread(threadpool, sd, std::move(out));
+  std::future bytes_send_fut = MakeSendThread(threadpool, sd, std::move(out),
+                                              bctx.jcr->job_metrics);
 
   DIGEST* checksum = bctx.digest;
   DIGEST* signing = bctx.signing_digest;
@@ -1310,12 +1321,78 @@ static inline bool SendPlainData(b_ctx& bctx)
 
   bool read_error = false;
 
+  std::optional<HoleFinder> holes = MakeHoleFinder(bctx.ff_pkt);
+
+#if !defined(HAVE_WIN32)
+  /* Large regular files can be read by several threads at once. Once the
+   * size the file had when it was stat()ed is read, or the file turns out to
+   * be shorter, the rest is read sequentially as usual. The offset header
+   * is taken from the file packet after each read, which the parallel
+   * reader does not update, so such streams are read sequentially. */
+  std::optional<parallel_file_reader> parallel_reader;
+  std::uint64_t parallel_position{0};
+  const std::size_t num_readers = me->MaxReadersPerFile;
+  if (num_readers > 1 && file_type == FT_REG && !bfd.cmd_plugin
+      && !support_offsets
+      && static_cast<std::uint64_t>(file_size)
+             >= kMinBlocksPerReader * num_readers * max_buf_size) {
+    Dmsg2(200, "Reading %s with %d threads\n", bctx.ff_pkt->fname,
+          static_cast<int>(num_readers));
+    parallel_reader.emplace(threadpool, bfd.filedes, num_readers, max_buf_size,
+                            file_size, holes ? &*holes : nullptr);
+  }
+#endif
+
+  auto read_block = [&](data_message& msg) -> ssize_t {
+#if !defined(HAVE_WIN32)
+    if (parallel_reader) {
+      std::optional block = parallel_reader->next();
+      if (block && block->error) {
+        bfd.BErrNo = errno = block->error;
+        return -1;
+      }
+      if (block && block->offset > parallel_position) {
+        // the reader skipped a hole, which counts as read like zero blocks
+        bytes_read += block->offset - parallel_position;
+        parallel_position = block->offset;
+      }
+      if (block && block->msg.data_size() == max_buf_size) {
+        parallel_position += max_buf_size;
+        msg = std::move(block->msg);
+        return max_buf_size;
+      }
+
+      // continue sequentially after the last block that was read in parallel
+      if (block) { parallel_position += block->msg.data_size(); }
+      parallel_reader.reset();
+      if (blseek(&bfd, parallel_position, SEEK_SET) < 0) {
+        bfd.BErrNo = errno;
+        return -1;
+      }
+      if (block && block->msg.data_size() > 0) {
+        msg = std::move(block->msg);
+        return msg.data_size();
+      }
+    }
+#endif
+    if (holes) {
+      std::int64_t position = holes->SkipHole(bytes_read, max_buf_size);
+      if (position < 0) {
+        bfd.BErrNo = errno;
+        return -1;
+      }
+      bytes_read = position;
+    }
+    msg.resize(max_buf_size);
+    return bread(&bfd, msg.data_ptr(), msg.data_size());
+  };
+
   // Read the file data
   for (;;) {
     data_message msg(max_buf_size);
     for (bool skip_block = true; skip_block;) {
       skip_block = false;
-      ssize_t read_bytes = bread(&bfd, msg.data_ptr(), msg.data_size());
+      ssize_t read_bytes = read_block(msg);
       // update offset _before_ sending the header
       offset = bfd.offset;
 
@@ -1345,7 +1422,6 @@ static inline bool SendPlainData(b_ctx& bctx)
           && ((msg.data_size() == max_buf_size
                && (msg.data_size() + max_buf_size < (uint64_t)file_size))
               || unsized_file)
-          // IsBufZero actually requires 8 bytes of alignment
           && IsBufZero(msg.data_ptr(), msg.data_size())) {
         skip_block = true;
       } else if (include_header) {
@@ -1392,7 +1468,11 @@ static inline bool SendPlainData(b_ctx& bctx)
     }
 
     // Send the buffer to the Storage daemon
-    if (!in.emplace(std::move(copy_fut))) { goto bail_out; }
+    bctx.jcr->job_metrics.queue_depth.Add();
+    if (!in.emplace(std::move(copy_fut))) {
+      bctx.jcr->job_metrics.queue_depth.Sub();
+      goto bail_out;
+    }
   }
 end_read_loop:
   retval = true;
@@ -1403,6 +1483,8 @@ bail_out:
   in.close();
   if (update_digest) { update_digest->get(); }
   result sendres = bytes_send_fut.get();
+  // the send thread may have stopped early and left messages unconsumed
+  bctx.jcr->job_metrics.queue_depth.Set(0);
   if (auto* error = sendres.error()) {
     if (!bctx.jcr->IsJobCanceled()) {
       Jmsg1(bctx.jcr, M_FATAL, 0, "%s\n", error->c_str());
@@ -1583,8 +1665,13 @@ bool EncodeAndSendAttributes(JobControlRecord* jcr,
           T_("Invalid file flags, no supported data stream type.\n"));
     return false;
   }
-  EncodeStat(attribs.c_str(), &ff_pkt->statp, sizeof(ff_pkt->statp),
-             ff_pkt->LinkFI, data_stream);
+  if (jcr->fd_impl->attribute_encoding == AE_COMPACT_V1) {
+    EncodeStatCompact(attribs.c_str(), &ff_pkt->statp, sizeof(ff_pkt->statp),
+                      ff_pkt->LinkFI, data_stream);
+  } else {
+    EncodeStat(attribs.c_str(), &ff_pkt->statp, sizeof(ff_pkt->statp),
+               ff_pkt->LinkFI, data_stream);
+  }
 
   /** Now possibly extend the attributes */
   if (IS_FT_OBJECT(ff_pkt->type)) {
@@ -1603,6 +1690,7 @@ bool EncodeAndSendAttributes(JobControlRecord* jcr,
     ff_pkt->FileIndex = jcr->JobFiles; /* return FileIndex */
     PmStrcpy(jcr->fd_impl->last_fname, ff_pkt->fname);
   }
+  jcr->job_metrics.files.Add();
 
   // Debug code: check if we must hangup
   if (hangup && (jcr->JobFiles > (uint32_t)hangup)) {
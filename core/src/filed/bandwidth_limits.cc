@@ -0,0 +1,68 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+#include "include/bareos.h"
+#include "filed/filed.h"
+#include "filed/filed_globals.h"
+#include "filed/bandwidth_limits.h"
+#include "lib/token_bucket.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace filedaemon {
+
+static const char* kDaemonBucketName = "*daemon*";
+
+static std::mutex buckets_mutex;
+static TokenBucket daemon_bucket;
+// the buckets are never freed as sockets may still point to them
+static std::map<std::string, std::unique_ptr<TokenBucket>> director_buckets;
+
+TokenBucket* GetBandwidthBucket(DirectorResource* director)
+{
+  if (!me->max_bandwidth && !director->max_bandwidth) { return nullptr; }
+
+  // pick up changed limits (e.g. after a reload) for new jobs
+  daemon_bucket.SetRate(me->max_bandwidth);
+
+  std::lock_guard l(buckets_mutex);
+  auto& bucket = director_buckets[director->resource_name_];
+  if (!bucket) { bucket = std::make_unique<TokenBucket>(0, &daemon_bucket); }
+  bucket->SetRate(director->max_bandwidth);
+  return bucket.get();
+}
+
+std::vector<BandwidthUsage> GetBandwidthUsage()
+{
+  std::vector<BandwidthUsage> usage;
+  usage.push_back(
+      {kDaemonBucketName, daemon_bucket.GetRate(), daemon_bucket.GetBytes()});
+
+  std::lock_guard l(buckets_mutex);
+  for (auto& [name, bucket] : director_buckets) {
+    usage.push_back({name, bucket->GetRate(), bucket->GetBytes()});
+  }
+  return usage;
+}
+
+} /* namespace filedaemon */
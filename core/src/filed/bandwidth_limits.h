@@ -0,0 +1,53 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * bandwidth limits shared by the jobs of the file daemon
+ */
+
+#ifndef BAREOS_FILED_BANDWIDTH_LIMITS_H_
+#define BAREOS_FILED_BANDWIDTH_LIMITS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class TokenBucket;
+
+namespace filedaemon {
+
+class DirectorResource;
+
+/* The bucket a storage daemon connection of a job started by director has
+ * to draw from. Its parent is the bucket of the whole daemon.
+ * Returns nullptr if neither has a limit configured. */
+TokenBucket* GetBandwidthBucket(DirectorResource* director);
+
+struct BandwidthUsage {
+  std::string name; /* "*daemon*" or the name of the director */
+  int64_t limit;    /* bytes per second, 0 is unlimited */
+  uint64_t bytes;   /* bytes transferred since the daemon started */
+};
+
+std::vector<BandwidthUsage> GetBandwidthUsage();
+
+} /* namespace filedaemon */
+#endif  // BAREOS_FILED_BANDWIDTH_LIMITS_H_
@@ -31,6 +31,7 @@
 #include "filed/filed_globals.h"
 #include "include/ch.h"
 #include "filed/authenticate.h"
+#include "filed/bandwidth_limits.h"
 #include "filed/dir_cmd.h"
 #include "filed/estimate.h"
 #include "filed/evaluate_job_command.h"
@@ -42,6 +43,7 @@
 #include "filed/verify.h"
 #include "findlib/enable_priv.h"
 #include "findlib/shadowing.h"
+#include "findlib/wildcard_set.h"
 #include "lib/berrno.h"
 #include "lib/bget_msg.h"
 #include "lib/bnet.h"
@@ -56,6 +58,7 @@
 #include "lib/watchdog.h"
 #include "lib/util.h"
 #include "filed/backup.h"
+#include "include/protocol_types.h"
 #include "lib/compression.h"
 
 #if defined(WIN32_VSS)
@@ -132,6 +135,7 @@ static bool OpenSdReadSession(JobControlRecord* jcr);
 static void SetStorageAuthKeyAndTlsPolicy(JobControlRecord* jcr,
                                           char* key,
                                           TlsPolicy policy);
+static void CloseDataConnections(JobControlRecord* jcr);
 
 /* Exported functions */
 
@@ -190,6 +194,9 @@ static char setdebugv2cmd[] = "setdebug=%d trace=%d hangup=%d timestamp=%d";
 static char storaddrv0cmd[] = "storage address=%s port=%d ssl=%d";
 static char storaddrv1cmd[]
     = "storage address=%s port=%d ssl=%d Authorization=%100s";
+static char storaddrv2cmd[]
+    = "storage address=%s port=%d ssl=%d connections=%d";
+static char backupcmd_encoding[] = " AttributeEncoding=%d";
 static char sessioncmd[] = "session %127s %ld %ld %ld %ld %ld %ld\n";
 static char restorecmd[] = "restore replace=%c prelinks=%d where=%s\n";
 static char restorecmd1[] = "restore replace=%c prelinks=%d where=\n";
@@ -248,11 +255,13 @@ static char OK_append[] = "3000 OK append data\n";
 // Commands sent to Storage Daemon
 static char append_open[] = "append open session\n";
 static char append_data[] = "append data %d\n";
+static char append_data_multiplexed[] = "append data %d connections=%d\n";
 static char append_end[] = "append end session %d\n";
 static char append_close[] = "append close session %d\n";
 static char read_open[] = "read open session = %s %ld %ld %ld %ld %ld %ld\n";
 static char read_data[] = "read data %d\n";
 static char read_close[] = "read close session %d\n";
+static char data_connection_hello[] = "Hello Data Connection %s %d\n";
 
 // See if we are allowed to execute the command issued.
 static bool ValidateCommand(JobControlRecord* jcr,
@@ -306,6 +315,7 @@ void CleanupFileset(JobControlRecord* jcr)
           regfree((regex_t*)fo->regexfile.get(k));
         }
         if (fo->size_match) { free(fo->size_match); }
+        FreeCompiledWildcards(fo);
         fo->regex.destroy();
         fo->regexdir.destroy();
         fo->regexfile.destroy();
@@ -330,6 +340,7 @@ void CleanupFileset(JobControlRecord* jcr)
       for (int j = 0; j < incexe->opts_list.size(); j++) {
         fo = (findFOPTS*)incexe->opts_list.get(j);
         if (fo->size_match) { free(fo->size_match); }
+        FreeCompiledWildcards(fo);
         fo->regex.destroy();
         fo->regexdir.destroy();
         fo->regexfile.destroy();
@@ -756,6 +767,10 @@ static bool CancelCmd(JobControlRecord* jcr)
           cjcr->store_bsock->SetTimedOut();
           cjcr->store_bsock->SetTerminated();
         }
+        for (BareosSocket* sd : cjcr->fd_impl->sd_data_connections) {
+          sd->SetTimedOut();
+          sd->SetTerminated();
+        }
         cjcr->MyThreadSendSignal(TIMEOUT_SIGNAL);
         cjcr->CancelFinished();
       }
@@ -1418,6 +1433,7 @@ static void SetStorageAuthKeyAndTlsPolicy(JobControlRecord* jcr,
     delete jcr->store_bsock;
     jcr->store_bsock = nullptr;
   }
+  CloseDataConnections(jcr);
 
   /* We can be contacting multiple storage daemons.
    * So, make sure that any old jcr->sd_auth_key is cleaned up. */
@@ -1436,11 +1452,65 @@ static void SetStorageAuthKeyAndTlsPolicy(JobControlRecord* jcr,
   Dmsg1(5, "set sd ssl_policy to %d\n", policy);
 }
 
+/* Open the additional connections of a backup to the storage daemon. They
+ * are opened before the connection of the job, as the storage daemon forgets
+ * the session key as soon as that one is authenticated. When a connection
+ * fails, the data is sent over the connections opened so far. */
+static void OpenDataConnections(JobControlRecord* jcr,
+                                char* stored_addr,
+                                int stored_port,
+                                TlsPolicy tls_policy,
+                                int connections)
+{
+  std::string qualified_resource_name;
+  if (!my_config->GetQualifiedResourceNameTypeConverter()->ResourceToString(
+          jcr->Job, R_JOB, qualified_resource_name)) {
+    return;
+  }
+
+  for (int index = 1; index < connections; index++) {
+    BareosSocket* sd = new BareosSocketTCP;
+    sd->SetSourceAddress(me->FDsrc_addr);
+
+    bool ok = sd->connect(jcr, 10, (int)me->SDConnectTimeout,
+                          me->heartbeat_interval, T_("Storage daemon"),
+                          stored_addr, nullptr, stored_port, 1);
+    if (ok && tls_policy == TlsPolicy::kBnetTlsAuto) {
+      ok = sd->DoTlsHandshake(TlsPolicy::kBnetTlsAuto, me, false,
+                              qualified_resource_name.c_str(),
+                              jcr->sd_auth_key, jcr);
+    }
+    ok = ok && sd->fsend(data_connection_hello, jcr->Job, index)
+         && AuthenticateDataConnection(jcr, sd);
+    if (!ok) {
+      Jmsg(jcr, M_WARNING, 0,
+           T_("Could not open data connection %d to Storage daemon %s:%d, "
+              "sending data over %d connections.\n"),
+           index, stored_addr, stored_port, index);
+      delete sd;
+      break;
+    }
+    jcr->fd_impl->sd_data_connections.push_back(sd);
+  }
+  Dmsg1(110, "Opened %d data connections to SD.\n",
+        static_cast<int>(jcr->fd_impl->sd_data_connections.size()));
+}
+
+static void CloseDataConnections(JobControlRecord* jcr)
+{
+  for (BareosSocket* sd : jcr->fd_impl->sd_data_connections) {
+    sd->close();
+    delete sd;
+  }
+  jcr->fd_impl->sd_data_connections.clear();
+}
+
 // Get address of storage daemon from Director
 static bool StorageCmd(JobControlRecord* jcr)
 {
   int stored_port;      /* storage daemon port */
   TlsPolicy tls_policy; /* enable ssl to sd */
+  int connections = 1;  /* data connections to use for a backup */
   char stored_addr[MAX_NAME_LENGTH];
   PoolMem sd_auth_key(PM_MESSAGE);
   BareosSocket* dir = jcr->dir_bsock;
@@ -1451,8 +1521,12 @@ static bool StorageCmd(JobControlRecord* jcr)
   if (sscanf(dir->msg, storaddrv1cmd, stored_addr, &stored_port, &tls_policy,
              sd_auth_key.c_str())
       != 4) {
-    if (sscanf(dir->msg, storaddrv0cmd, stored_addr, &stored_port, &tls_policy)
-        != 3) {
+    if (sscanf(dir->msg, storaddrv2cmd, stored_addr, &stored_port, &tls_policy,
+               &connections)
+            != 4
+        && sscanf(dir->msg, storaddrv0cmd, stored_addr, &stored_port,
+                  &tls_policy)
+               != 3) {
       PmStrcpy(jcr->errmsg, dir->msg);
       Jmsg(jcr, M_FATAL, 0, T_("Bad storage command: %s\n"), jcr->errmsg);
       goto bail_out;
@@ -1477,6 +1551,13 @@ static bool StorageCmd(JobControlRecord* jcr)
 
   storage_daemon_socket->SetBwlimit(jcr->max_bandwidth);
   if (me->allow_bw_bursting) { storage_daemon_socket->SetBwlimitBursting(); }
+  storage_daemon_socket->SetBandwidthBucket(
+      GetBandwidthBucket(jcr->fd_impl->director));
+
+  if (connections > 1) {
+    OpenDataConnections(jcr, stored_addr, stored_port, tls_policy,
+                        connections);
+  }
 
   // Open command communications with Storage daemon
   if (!storage_daemon_socket->connect(
@@ -1744,6 +1825,14 @@ static bool BackupCmd(JobControlRecord* jcr)
     Dmsg1(100, "JobFiles=%ld\n", jcr->JobFiles);
   }
 
+  // Directors before AttributeEncoding was added do not send it
+  if (const char* encoding = strstr(dir->msg, " AttributeEncoding=")) {
+    int attribute_encoding;
+    if (sscanf(encoding, backupcmd_encoding, &attribute_encoding) == 1) {
+      jcr->fd_impl->attribute_encoding = attribute_encoding;
+    }
+  }
+
   /* Validate some options given to the backup make sense for the compiled in
    * options of this filed. */
 #ifndef HAVE_WIN32
@@ -1808,7 +1897,12 @@ static bool BackupCmd(JobControlRecord* jcr)
   }
 
   // Send Append data command to Storage daemon
-  sd->fsend(append_data, jcr->fd_impl->Ticket);
+  if (jcr->fd_impl->sd_data_connections.empty()) {
+    sd->fsend(append_data, jcr->fd_impl->Ticket);
+  } else {
+    sd->fsend(append_data_multiplexed, jcr->fd_impl->Ticket,
+              static_cast<int>(jcr->fd_impl->sd_data_connections.size()) + 1);
+  }
   Dmsg1(110, ">stored: %s", sd->msg);
 
   // Expect to get OK data
@@ -2366,6 +2460,7 @@ static void FiledFreeJcr(JobControlRecord* jcr)
     delete jcr->store_bsock;
     jcr->store_bsock = nullptr;
   }
+  CloseDataConnections(jcr);
 
   if (jcr->dir_bsock) {
     jcr->dir_bsock->close();
@@ -37,6 +37,8 @@
 #include "lib/cli.h"
 #include "lib/mntent_cache.h"
 #include "lib/daemon.h"
+#include "lib/metrics.h"
+#include "lib/metrics_server.h"
 #include "lib/bnet_network_dump.h"
 #include "lib/bsignal.h"
 #include "lib/parse_conf.h"
@@ -237,6 +239,13 @@ int main(int argc, char* argv[])
     }
   }
 
+#if !defined(HAVE_WIN32)
+  if (me->metrics_port) {
+    metrics::StartMetricsServer(me->metrics_address, me->metrics_port,
+                                metrics::CollectJobMetrics);
+  }
+#endif
+
   // if configured, start threads and connect to Director.
   StartConnectToDirectorThreads();
 
@@ -263,6 +272,9 @@ void TerminateFiled(int sig)
 
   StopConnectToDirectorThreads(true);
   StopSocketServer(true);
+#if !defined(HAVE_WIN32)
+  metrics::StopMetricsServer();
+#endif
 
   UnloadFdPlugins();
   FlushMntentCache();
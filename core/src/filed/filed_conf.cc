@@ -93,6 +93,8 @@ static ResourceItem cli_items[] = {
   {"ScriptsDirectory", CFG_TYPE_DIR, ITEM(res_client, scripts_directory), 0, 0, NULL, NULL, NULL},
   {"MaximumConcurrentJobs", CFG_TYPE_PINT32, ITEM(res_client, MaxConcurrentJobs), 0, CFG_ITEM_DEFAULT, "20", NULL, NULL},
   {"MaximumWorkersPerJob", CFG_TYPE_PINT32, ITEM(res_client, MaxWorkersPerJob), 0, CFG_ITEM_DEFAULT, "2", NULL, NULL},
+  {"MaximumReadersPerFile", CFG_TYPE_PINT32, ITEM(res_client, MaxReadersPerFile), 0, CFG_ITEM_DEFAULT, "0", NULL,
+      "Number of threads that read a large file at the same time. 0 or 1 reads every file sequentially."},
   {"Messages", CFG_TYPE_RES, ITEM(res_client, messages), R_MSGS, 0, NULL, NULL, NULL},
   {"SdConnectTimeout", CFG_TYPE_TIME, ITEM(res_client, SDConnectTimeout), 0, CFG_ITEM_DEFAULT, "1800" /* 30 minutes */, NULL, NULL},
   {"HeartbeatInterval", CFG_TYPE_TIME, ITEM(res_client, heartbeat_interval), 0, CFG_ITEM_DEFAULT, "0", NULL, NULL},
@@ -109,6 +111,8 @@ static ResourceItem cli_items[] = {
       "PKI Cipher used for data encryption."},
   {"VerId", CFG_TYPE_STR, ITEM(res_client, verid), 0, 0, NULL, NULL, NULL},
   {"MaximumBandwidthPerJob", CFG_TYPE_SPEED, ITEM(res_client, max_bandwidth_per_job), 0, 0, NULL, NULL, NULL},
+  {"MaximumBandwidth", CFG_TYPE_SPEED, ITEM(res_client, max_bandwidth), 0, 0, NULL, NULL,
+      "Bandwidth limit shared by all jobs of this client."},
   {"AllowBandwidthBursting", CFG_TYPE_BOOL, ITEM(res_client, allow_bw_bursting), 0, CFG_ITEM_DEFAULT, "false", NULL, NULL},
   {"AllowedScriptDir", CFG_TYPE_ALIST_DIR, ITEM(res_client, allowed_script_dirs), 0, 0, NULL, NULL, NULL},
   {"AllowedJobCommand", CFG_TYPE_ALIST_STR, ITEM(res_client, allowed_job_cmds), 0, 0, NULL, NULL, NULL},
@@ -118,6 +122,10 @@ static ResourceItem cli_items[] = {
   {"SecureEraseCommand", CFG_TYPE_STR, ITEM(res_client, secure_erase_cmdline), 0, 0, NULL, "15.2.1-",
       "Specify command that will be called when bareos unlinks files."},
   {"LogTimestampFormat", CFG_TYPE_STR, ITEM(res_client, log_timestamp_format), 0, CFG_ITEM_DEFAULT, "%d-%b %H:%M", "15.2.3-", NULL},
+  {"MetricsPort", CFG_TYPE_PINT32, ITEM(res_client, metrics_port), 0, CFG_ITEM_DEFAULT, "0", NULL,
+      "TCP port of the OpenMetrics (Prometheus) text endpoint. 0 disables the endpoint."},
+  {"MetricsAddress", CFG_TYPE_STR, ITEM(res_client, metrics_address), 0, CFG_ITEM_DEFAULT, "127.0.0.1", NULL,
+      "Address the metrics endpoint is bound to."},
     TLS_COMMON_CONFIG(res_client),
     TLS_CERT_CONFIG(res_client),
   {nullptr, 0, 0, nullptr, 0, 0, nullptr, nullptr, nullptr}
@@ -137,6 +145,8 @@ static ResourceItem dir_items[] = {
       "false", "16.2.2", "Let the Filedaemon initiate network connections to the Director."},
   {"Monitor", CFG_TYPE_BOOL, ITEM(res_dir, monitor), 0, CFG_ITEM_DEFAULT, "false", NULL, NULL},
   {"MaximumBandwidthPerJob", CFG_TYPE_SPEED, ITEM(res_dir, max_bandwidth_per_job), 0, 0, NULL, NULL, NULL},
+  {"MaximumBandwidth", CFG_TYPE_SPEED, ITEM(res_dir, max_bandwidth), 0, 0, NULL, NULL,
+      "Bandwidth limit shared by all jobs of this director on this client."},
   {"AllowedScriptDir", CFG_TYPE_ALIST_DIR, ITEM(res_dir, allowed_script_dirs), 0, 0, NULL, NULL, NULL},
   {"AllowedJobCommand", CFG_TYPE_ALIST_STR, ITEM(res_dir, allowed_job_cmds), 0, 0, NULL, NULL, NULL},
     TLS_COMMON_CONFIG(res_dir),
@@ -394,6 +404,7 @@ static void FreeResource(BareosResource* res, int type)
       if (p->allowed_script_dirs) { delete p->allowed_script_dirs; }
       if (p->allowed_job_cmds) { delete p->allowed_job_cmds; }
       if (p->secure_erase_cmdline) { free(p->secure_erase_cmdline); }
+      if (p->metrics_address) { free(p->metrics_address); }
       if (p->log_timestamp_format) { free(p->log_timestamp_format); }
       delete p;
       break;
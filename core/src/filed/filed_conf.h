@@ -3,7 +3,7 @@
 
    Copyright (C) 2000-2007 Free Software Foundation Europe e.V.
    Copyright (C) 2011-2012 Planets Communications B.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -77,6 +77,7 @@ class DirectorResource
   alist<const char*>* allowed_job_cmds = nullptr; /* Only allow the following
                               Job commands to be executed */
   uint64_t max_bandwidth_per_job = 0; /* Bandwidth limitation (per director) */
+  uint64_t max_bandwidth = 0; /* Bandwidth shared by the director's jobs */
 
   DirectorResource() = default;
   virtual ~DirectorResource() = default;
@@ -98,6 +99,7 @@ class ClientResource
   MessagesResource* messages = nullptr; /* Daemon message handler */
   uint32_t MaxConcurrentJobs = 0;
   uint32_t MaxWorkersPerJob{0};
+  uint32_t MaxReadersPerFile{0};
   utime_t SDConnectTimeout = {0};       /* Timeout in seconds */
   utime_t heartbeat_interval = {0};     /* Interval to send heartbeats */
   uint32_t max_network_buffer_size = 0; /* Max network buf size */
@@ -128,7 +130,10 @@ class ClientResource
                                   erase of file */
   char* log_timestamp_format = nullptr; /* Timestamp format to use in generic
                                  logging messages */
+  uint32_t metrics_port = 0;             /* Port of the metrics endpoint */
+  char* metrics_address = nullptr;       /* Address of the metrics endpoint */
   uint64_t max_bandwidth_per_job = 0;   /* Bandwidth limitation (global) */
+  uint64_t max_bandwidth = 0;           /* Bandwidth shared by all jobs */
 };
 
 
@@ -29,12 +29,14 @@
 #include "lib/thread_pool.h"
 
 #include <atomic>
+#include <vector>
 
 struct AclData;
 struct XattrData;
 
 namespace filedaemon {
 class BareosAccurateFilelist;
+class VerifyPipeline;
 }
 
 /* clang-format off */
@@ -62,6 +64,7 @@ struct FiledJcrImpl {
   utime_t since_time{};           /**< Begin time for SINCE */
   int listing{};                  /**< Job listing in estimate */
   int32_t Ticket{};               /**< Ticket */
+  int32_t attribute_encoding{};   /**< AttributeEncodings of the stat packets */
   char* big_buf{};                /**< I/O buffer */
   int32_t replace{};              /**< Replace options */
   FindFilesPacket* ff{};          /**< Find Files packet */
@@ -81,6 +84,8 @@ struct FiledJcrImpl {
   filedaemon::BareosAccurateFilelist* file_list{}; /**< Previous file list (accurate mode) */
   uint64_t base_size{};           /**< Compute space saved with base job */
   filedaemon::save_pkt* plugin_sp{}; /**< Plugin save packet */
+  filedaemon::VerifyPipeline* verify_pipeline{}; /**< Digests computed in parallel */
+  std::vector<BareosSocket*> sd_data_connections{}; /**< Additional connections to the SD */
 #ifdef HAVE_WIN32
   VSSClient* pVSSClient{};        /**< VSS Client Instance */
 #endif
@@ -35,6 +35,7 @@
 #include "filed/filed_jcr_impl.h"
 #include "filed/fileset.h"
 #include "findlib/match.h"
+#include "findlib/wildcard_set.h"
 #include "lib/berrno.h"
 #include "lib/edit.h"
 #include "include/ch.h"
@@ -237,6 +238,8 @@ int AddWildToFileset(JobControlRecord* jcr, const char* item, int type)
   } else {
     return state_error;
   }
+  // recompiled with the new pattern on the next match
+  FreeCompiledWildcards(current_opts);
 
   return state_options;
 }
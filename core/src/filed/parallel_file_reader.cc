@@ -0,0 +1,108 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Read a regular file with several threads at once
+ */
+
+#include "include/bareos.h"
+#include "filed/parallel_file_reader.h"
+#include "findlib/hole_finder.h"
+
+#if !defined(HAVE_WIN32)
+#  include <unistd.h>
+#  include <algorithm>
+
+namespace filedaemon {
+
+parallel_file_reader::parallel_file_reader(thread_pool& pool,
+                                           int fd,
+                                           std::size_t num_readers,
+                                           std::size_t block_size,
+                                           std::uint64_t size,
+                                           HoleFinder* holes)
+    : fd_{fd}
+    , block_size_{block_size}
+    , size_{size}
+    , holes_{holes}
+    , readers_{2 * num_readers}
+    , latch_{num_readers}
+{
+  pool.borrow_threads(num_readers, [this] {
+    readers_.work_until_completion();
+
+    *latch_.lock() -= 1;
+    fin_.notify_one();
+  });
+
+  // keep every reader busy while the previous blocks are being processed
+  for (std::size_t i = 0; i < 2 * num_readers; ++i) { SubmitNextRead(); }
+}
+
+parallel_file_reader::~parallel_file_reader()
+{
+  readers_.shutdown();
+  latch_.lock().wait(fin_, [](std::size_t num) { return num == 0; });
+}
+
+std::optional<parallel_file_reader::block> parallel_file_reader::next()
+{
+  if (pending_.empty()) { return std::nullopt; }
+
+  std::future<block> fut = std::move(pending_.front());
+  pending_.pop_front();
+  SubmitNextRead();
+  return fut.get();
+}
+
+void parallel_file_reader::SubmitNextRead()
+{
+  if (next_offset_ >= size_) { return; }
+  if (holes_) {
+    std::int64_t position = holes_->SkipHole(next_offset_, block_size_);
+    if (position > 0) { next_offset_ = position; }
+  }
+
+  std::uint64_t offset = next_offset_;
+  std::size_t length = std::min<std::uint64_t>(block_size_, size_ - offset);
+  next_offset_ += length;
+
+  pending_.push_back(readers_.submit([fd = fd_, offset, length]() {
+    block b{data_message(length), offset};
+    std::size_t done = 0;
+    while (done < length) {
+      ssize_t status
+          = pread(fd, b.msg.data_ptr() + done, length - done, offset + done);
+      if (status < 0) {
+        if (errno == EINTR) { continue; }
+        b.error = errno;
+        break;
+      }
+      if (status == 0) { break; /* the file got shorter */ }
+      done += status;
+    }
+    b.msg.resize(done);
+    return b;
+  }));
+}
+
+} /* namespace filedaemon */
+#endif
@@ -0,0 +1,94 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Read a regular file with several threads at once
+ */
+
+#ifndef BAREOS_FILED_PARALLEL_FILE_READER_H_
+#define BAREOS_FILED_PARALLEL_FILE_READER_H_
+
+#if !defined(HAVE_WIN32)
+#  include "filed/data_message.h"
+#  include "lib/thread_pool.h"
+
+#  include <condition_variable>
+#  include <cstdint>
+#  include <deque>
+#  include <future>
+#  include <optional>
+
+class HoleFinder;
+
+namespace filedaemon {
+
+// Reading in parallel only pays off if every reader gets a few blocks.
+inline constexpr std::size_t kMinBlocksPerReader = 4;
+
+/* Reads the first size bytes of a regular file with several threads at once.
+ * The threads use pread(), so they do not share the file position, and each
+ * reads its own blocks. The blocks are handed out in file order, so the data
+ * stream is exactly the one a sequential read would have produced.
+ *
+ * Only the size passed in is read, even if the file grew since it was
+ * stat()ed. If it got shorter, the block at its new end is short and all
+ * following blocks are empty; the caller has to stop at the first block
+ * that is not full. */
+class parallel_file_reader {
+ public:
+  struct block {
+    data_message msg;
+    std::uint64_t offset{0}; /* of the data in the file */
+    int error{0};            /* errno of a failed read */
+  };
+
+  // Blocks inside of the holes found by holes are not read
+  parallel_file_reader(thread_pool& pool,
+                       int fd,
+                       std::size_t num_readers,
+                       std::size_t block_size,
+                       std::uint64_t size,
+                       HoleFinder* holes = nullptr);
+  parallel_file_reader(const parallel_file_reader&) = delete;
+  parallel_file_reader& operator=(const parallel_file_reader&) = delete;
+  ~parallel_file_reader();
+
+  // Returns the next block or std::nullopt once size bytes were handed out.
+  std::optional<block> next();
+
+ private:
+  void SubmitNextRead();
+
+  int fd_;
+  std::size_t block_size_;
+  std::uint64_t size_;
+  HoleFinder* holes_;
+  std::uint64_t next_offset_{0};
+  std::deque<std::future<block>> pending_;
+  work_group readers_;
+  std::condition_variable fin_;
+  synchronized<std::size_t> latch_;
+};
+
+} /* namespace filedaemon */
+#endif
+
+#endif  // BAREOS_FILED_PARALLEL_FILE_READER_H_
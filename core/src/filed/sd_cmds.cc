@@ -1,7 +1,7 @@
 /*
    BAREOS® - Backup Archiving REcovery Open Sourced
 
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -28,6 +28,7 @@
 #include "filed/filed.h"
 #include "filed/filed_globals.h"
 #include "filed/filed_jcr_impl.h"
+#include "filed/bandwidth_limits.h"
 #include "filed/authenticate.h"
 #include "lib/bnet.h"
 #include "lib/bsock.h"
@@ -100,6 +101,7 @@ void* handle_stored_connection(BareosSocket* sd)
 
   sd->SetBwlimit(jcr->max_bandwidth);
   if (me->allow_bw_bursting) { sd->SetBwlimitBursting(); }
+  sd->SetBandwidthBucket(GetBandwidthBucket(jcr->fd_impl->director));
 
   FreeJcr(jcr);
 
@@ -29,6 +29,7 @@
 
 #include "include/bareos.h"
 #include "filed/filed.h"
+#include "filed/bandwidth_limits.h"
 #include "filed/filed_globals.h"
 #include "filed/filed_jcr_impl.h"
 #include "lib/status_packet.h"
@@ -76,7 +77,7 @@ static void ListStatusHeader(StatusPacket* sp)
   int len;
   char dt[MAX_TIME_LENGTH];
   PoolMem msg(PM_MESSAGE);
-  char b1[32];
+  char b1[32], b2[32];
 
   len = Mmsg(msg, T_("%s Version: %s (%s) %s %s\n"), my_name,
              kBareosVersionStrings.Full, kBareosVersionStrings.Date, VSS,
@@ -133,6 +134,15 @@ static void ListStatusHeader(StatusPacket* sp)
              edit_uint64_with_commas(me->max_bandwidth_per_job / 1024, b1));
   sp->send(msg, len);
 
+  for (auto& usage : GetBandwidthUsage()) {
+    if (!usage.limit && !usage.bytes) { continue; }
+    len = Mmsg(msg, T_(" Bandwidth %s: limit=%skB/s transferred=%s bytes\n"),
+               usage.name.c_str(),
+               edit_uint64_with_commas(usage.limit / 1024, b1),
+               edit_uint64_with_commas(usage.bytes, b2));
+    sp->send(msg, len);
+  }
+
   if (me->secure_erase_cmdline) {
     len = Mmsg(msg, T_(" secure erase command='%s'\n"),
                me->secure_erase_cmdline);
@@ -30,7 +30,9 @@
 #include "include/filetypes.h"
 #include "include/streams.h"
 #include "filed/filed.h"
+#include "filed/filed_globals.h"
 #include "filed/filed_jcr_impl.h"
+#include "filed/verify_pipeline.h"
 #include "findlib/find.h"
 #include "findlib/attribs.h"
 #include "lib/attribs.h"
@@ -40,6 +42,9 @@
 #include "lib/util.h"
 #include "lib/base64.h"
 
+#include <optional>
+#include <string>
+
 namespace filedaemon {
 
 #ifdef HAVE_DARWIN_OS
@@ -52,6 +57,14 @@ static int VerifyFile(JobControlRecord* jcr, FindFilesPacket* ff_pkt, bool);
 static int ReadDigest(BareosFilePacket* bfd,
                       DIGEST* digest,
                       JobControlRecord* jcr);
+static bool ReadDigestData(BareosFilePacket* bfd,
+                           DIGEST* digest,
+                           bool sparse,
+                           int file_type,
+                           uint64_t file_size,
+                           uint64_t* bytes_read);
+static crypto_digest_t GetDigestType(FindFilesPacket* ff_pkt,
+                                     int* digest_stream);
 static bool calculate_file_chksum(JobControlRecord* jcr,
                                   FindFilesPacket* ff_pkt,
                                   DIGEST** digest,
@@ -59,6 +72,53 @@ static bool calculate_file_chksum(JobControlRecord* jcr,
                                   char** digest_buf,
                                   const char** digest_name);
 
+namespace {
+DigestResult ComputeDigest(const DigestRequest& req)
+{
+  DigestResult result;
+
+  DIGEST* digest = crypto_digest_new(nullptr, req.type);
+  if (!digest) {
+    result.init_failed = true;
+    return result;
+  }
+
+  BareosFilePacket bfd;
+  binit(&bfd);
+  if (bopen(&bfd, req.fname.c_str(),
+            O_RDONLY | O_BINARY | (req.noatime ? O_NOATIME : 0), 0, req.rdev)
+      < 0) {
+    BErrNo be;
+    be.SetErrno(bfd.BErrNo);
+    result.error = T_("     Cannot open ") + req.fname + ": ERR="
+                   + be.bstrerror() + ".\n";
+    CryptoDigestFree(digest);
+    return result;
+  }
+
+  // like DigestFile(), a read error still sends the digest read so far
+  if (!ReadDigestData(&bfd, digest, req.sparse, req.file_type, req.file_size,
+                      &result.bytes_read)) {
+    BErrNo be;
+    be.SetErrno(bfd.BErrNo);
+    result.error = T_("Error reading file ") + req.fname + ": ERR="
+                   + be.bstrerror() + "\n";
+  }
+  bclose(&bfd);
+
+  char md[CRYPTO_DIGEST_MAX_SIZE];
+  uint32_t size = sizeof(md);
+  if (CryptoDigestFinalize(digest, (uint8_t*)md, &size)) {
+    result.digest.resize(BASE64_SIZE(size));
+    BinToBase64(result.digest.data(), BASE64_SIZE(size), md, size, true);
+    result.digest.resize(strlen(result.digest.c_str()));
+    result.name = crypto_digest_name(digest);
+  }
+  CryptoDigestFree(digest);
+  return result;
+}
+}  // namespace
+
 /**
  * Find all the requested files and send attributes
  * to the Director.
@@ -74,11 +134,27 @@ void DoVerify(JobControlRecord* jcr)
   }
   SetFindOptions((FindFilesPacket*)jcr->fd_impl->ff, jcr->fd_impl->incremental,
                  jcr->fd_impl->since_time);
+
+  /* Setting maximum worker threads to 0 means that you do not want
+   * multithreading. The HFS+ resource fork is only read serially. */
+  std::optional<VerifyPipeline> pipeline;
+  if (me->MaxWorkersPerJob > 0 && !have_darwin_os) {
+    pipeline.emplace(jcr->fd_impl->threads, me->MaxWorkersPerJob,
+                     ComputeDigest);
+    jcr->fd_impl->verify_pipeline = &pipeline.value();
+  }
+
   Dmsg0(10, "Start find files\n");
   /* Subroutine VerifyFile() is called for each file */
   FindFiles(jcr, (FindFilesPacket*)jcr->fd_impl->ff, VerifyFile, NULL);
   Dmsg0(10, "End find files\n");
 
+  if (pipeline) {
+    if (!jcr->IsJobCanceled()) { pipeline->Flush(jcr); }
+    jcr->fd_impl->verify_pipeline = nullptr;
+    pipeline.reset();
+  }
+
   if (jcr->fd_impl->big_buf) {
     free(jcr->fd_impl->big_buf);
     jcr->fd_impl->big_buf = NULL;
@@ -224,39 +300,64 @@ static int VerifyFile(JobControlRecord* jcr, FindFilesPacket* ff_pkt, bool)
    * slash. For a linked file, link is the link. */
   // Send file attributes to Director (note different format than for Storage)
   Dmsg2(400, "send Attributes inx=%d fname=%s\n", jcr->JobFiles, ff_pkt->fname);
+  PoolMem msg(PM_MESSAGE);
+  int msg_len;
   if (ff_pkt->type == FT_LNK || ff_pkt->type == FT_LNKSAVED) {
-    status = dir->fsend("%d %d %s %s%c%s%c%s%c", jcr->JobFiles,
-                        STREAM_UNIX_ATTRIBUTES, ff_pkt->VerifyOpts,
-                        ff_pkt->fname, 0, attribs.c_str(), 0, ff_pkt->link, 0);
+    msg_len = Mmsg(msg, "%d %d %s %s%c%s%c%s%c", jcr->JobFiles,
+                   STREAM_UNIX_ATTRIBUTES, ff_pkt->VerifyOpts, ff_pkt->fname, 0,
+                   attribs.c_str(), 0, ff_pkt->link, 0);
   } else if (ff_pkt->type == FT_DIREND || ff_pkt->type == FT_REPARSE
              || ff_pkt->type == FT_JUNCTION) {
     // Here link is the canonical filename (i.e. with trailing slash)
-    status = dir->fsend("%d %d %s %s%c%s%c%c", jcr->JobFiles,
-                        STREAM_UNIX_ATTRIBUTES, ff_pkt->VerifyOpts,
-                        ff_pkt->link, 0, attribs.c_str(), 0, 0);
+    msg_len = Mmsg(msg, "%d %d %s %s%c%s%c%c", jcr->JobFiles,
+                   STREAM_UNIX_ATTRIBUTES, ff_pkt->VerifyOpts, ff_pkt->link, 0,
+                   attribs.c_str(), 0, 0);
   } else {
-    status = dir->fsend("%d %d %s %s%c%s%c%c", jcr->JobFiles,
-                        STREAM_UNIX_ATTRIBUTES, ff_pkt->VerifyOpts,
-                        ff_pkt->fname, 0, attribs.c_str(), 0, 0);
+    msg_len = Mmsg(msg, "%d %d %s %s%c%s%c%c", jcr->JobFiles,
+                   STREAM_UNIX_ATTRIBUTES, ff_pkt->VerifyOpts, ff_pkt->fname, 0,
+                   attribs.c_str(), 0, 0);
   }
-  Dmsg2(20, "filed>dir: attribs len=%d: msg=%s\n", dir->message_length,
-        dir->msg);
 
   if (!IS_FT_OBJECT(ff_pkt->type) && ff_pkt->type != FT_DELETED) {
     UnstripPath(ff_pkt);
   }
 
+  bool compute_digest
+      = ff_pkt->type != FT_LNKSAVED && S_ISREG(ff_pkt->statp.st_mode)
+        && (BitIsSet(FO_MD5, ff_pkt->flags) || BitIsSet(FO_SHA1, ff_pkt->flags)
+            || BitIsSet(FO_SHA256, ff_pkt->flags)
+            || BitIsSet(FO_SHA512, ff_pkt->flags)
+            || BitIsSet(FO_XXH128, ff_pkt->flags));
+
+  if (VerifyPipeline* pipeline = jcr->fd_impl->verify_pipeline) {
+    std::optional<DigestRequest> req;
+    if (compute_digest) {
+      req.emplace();
+      req->fname = ff_pkt->fname;
+      req->type = GetDigestType(ff_pkt, &req->stream);
+      req->noatime = BitIsSet(FO_NOATIME, ff_pkt->flags);
+      req->sparse = BitIsSet(FO_SPARSE, ff_pkt->flags);
+      req->file_type = ff_pkt->type;
+      req->file_size = ff_pkt->statp.st_size;
+      req->rdev = ff_pkt->statp.st_rdev;
+    }
+    return pipeline->Queue(jcr, jcr->JobFiles, std::string(msg.c_str(), msg_len),
+                           req ? &req.value() : nullptr)
+               ? 1
+               : 0;
+  }
+
+  status = dir->send(msg.c_str(), msg_len);
+  Dmsg2(20, "filed>dir: attribs len=%d: msg=%s\n", dir->message_length,
+        dir->msg);
+
   if (!status) {
     Jmsg(jcr, M_FATAL, 0, T_("Network error in send to Director: ERR=%s\n"),
          BnetStrerror(dir));
     return 0;
   }
 
-  if (ff_pkt->type != FT_LNKSAVED && S_ISREG(ff_pkt->statp.st_mode)
-      && (BitIsSet(FO_MD5, ff_pkt->flags) || BitIsSet(FO_SHA1, ff_pkt->flags)
-          || BitIsSet(FO_SHA256, ff_pkt->flags)
-          || BitIsSet(FO_SHA512, ff_pkt->flags)
-          || BitIsSet(FO_XXH128, ff_pkt->flags))) {
+  if (compute_digest) {
     int digest_stream = STREAM_NONE;
     DIGEST* digest = NULL;
     char* digest_buf = NULL;
@@ -343,22 +444,56 @@ int DigestFile(JobControlRecord* jcr, FindFilesPacket* ff_pkt, DIGEST* digest)
 static int ReadDigest(BareosFilePacket* bfd,
                       DIGEST* digest,
                       JobControlRecord* jcr)
+{
+  FindFilesPacket* ff_pkt = (FindFilesPacket*)jcr->fd_impl->ff;
+  uint64_t bytes_read = 0;
+
+  Dmsg0(50, "=== ReadDigest\n");
+  bool ok = ReadDigestData(bfd, digest, BitIsSet(FO_SPARSE, ff_pkt->flags),
+                           ff_pkt->type, ff_pkt->statp.st_size, &bytes_read);
+
+  /* Can be used by BaseJobs or with accurate, update only for Verify
+   * jobs
+   */
+  if (jcr->is_JobType(JT_VERIFY)) { jcr->JobBytes += bytes_read; }
+  jcr->ReadBytes += bytes_read;
+
+  if (!ok) {
+    BErrNo be;
+    be.SetErrno(bfd->BErrNo);
+    Dmsg2(100, "Error reading file %s: ERR=%s\n", jcr->fd_impl->last_fname,
+          be.bstrerror());
+    Jmsg(jcr, M_ERROR, 1, T_("Error reading file %s: ERR=%s\n"),
+         jcr->fd_impl->last_fname, be.bstrerror());
+    jcr->JobErrors++;
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Read the whole file and update digest, skipping blocks of zeros if sparse
+ * is set. Does not touch the job, so it can be called on any thread.
+ */
+static bool ReadDigestData(BareosFilePacket* bfd,
+                           DIGEST* digest,
+                           bool sparse,
+                           int file_type,
+                           uint64_t file_size,
+                           uint64_t* bytes_read)
 {
   char buf[DEFAULT_NETWORK_BUFFER_SIZE];
   int64_t n;
   int64_t bufsiz = (int64_t)sizeof(buf);
-  FindFilesPacket* ff_pkt = (FindFilesPacket*)jcr->fd_impl->ff;
   uint64_t fileAddr = 0; /* file address */
 
-
-  Dmsg0(50, "=== ReadDigest\n");
   while ((n = bread(bfd, buf, bufsiz)) > 0) {
     /* Check for sparse blocks */
-    if (BitIsSet(FO_SPARSE, ff_pkt->flags)) {
+    if (sparse) {
       bool allZeros = false;
-      if ((n == bufsiz && fileAddr + n < (uint64_t)ff_pkt->statp.st_size)
-          || ((ff_pkt->type == FT_RAW || ff_pkt->type == FT_FIFO)
-              && (uint64_t)ff_pkt->statp.st_size == 0)) {
+      if ((n == bufsiz && fileAddr + n < file_size)
+          || ((file_type == FT_RAW || file_type == FT_FIFO)
+              && file_size == 0)) {
         allZeros = IsBufZero(buf, bufsiz);
       }
       fileAddr += n; /* update file address */
@@ -367,24 +502,31 @@ static int ReadDigest(BareosFilePacket* bfd,
     }
 
     CryptoDigestUpdate(digest, (uint8_t*)buf, n);
-
-    /* Can be used by BaseJobs or with accurate, update only for Verify
-     * jobs
-     */
-    if (jcr->is_JobType(JT_VERIFY)) { jcr->JobBytes += n; }
-    jcr->ReadBytes += n;
+    *bytes_read += n;
   }
-  if (n < 0) {
-    BErrNo be;
-    be.SetErrno(bfd->BErrNo);
-    Dmsg2(100, "Error reading file %s: ERR=%s\n", jcr->fd_impl->last_fname,
-          be.bstrerror());
-    Jmsg(jcr, M_ERROR, 1, T_("Error reading file %s: ERR=%s\n"),
-         jcr->fd_impl->last_fname, be.bstrerror());
-    jcr->JobErrors++;
-    return -1;
+  return n >= 0;
+}
+
+static crypto_digest_t GetDigestType(FindFilesPacket* ff_pkt,
+                                     int* digest_stream)
+{
+  if (BitIsSet(FO_MD5, ff_pkt->flags)) {
+    *digest_stream = STREAM_MD5_DIGEST;
+    return CRYPTO_DIGEST_MD5;
+  } else if (BitIsSet(FO_SHA1, ff_pkt->flags)) {
+    *digest_stream = STREAM_SHA1_DIGEST;
+    return CRYPTO_DIGEST_SHA1;
+  } else if (BitIsSet(FO_SHA256, ff_pkt->flags)) {
+    *digest_stream = STREAM_SHA256_DIGEST;
+    return CRYPTO_DIGEST_SHA256;
+  } else if (BitIsSet(FO_SHA512, ff_pkt->flags)) {
+    *digest_stream = STREAM_SHA512_DIGEST;
+    return CRYPTO_DIGEST_SHA512;
+  } else if (BitIsSet(FO_XXH128, ff_pkt->flags)) {
+    *digest_stream = STREAM_XXH128_DIGEST;
+    return CRYPTO_DIGEST_XXH128;
   }
-  return 0;
+  return CRYPTO_DIGEST_NONE;
 }
 
 /**
@@ -406,22 +548,8 @@ static bool calculate_file_chksum(JobControlRecord* jcr,
 {
   /* Create our digest context.
    * If this fails, the digest will be set to NULL and not used. */
-  if (BitIsSet(FO_MD5, ff_pkt->flags)) {
-    *digest = crypto_digest_new(jcr, CRYPTO_DIGEST_MD5);
-    *digest_stream = STREAM_MD5_DIGEST;
-  } else if (BitIsSet(FO_SHA1, ff_pkt->flags)) {
-    *digest = crypto_digest_new(jcr, CRYPTO_DIGEST_SHA1);
-    *digest_stream = STREAM_SHA1_DIGEST;
-  } else if (BitIsSet(FO_SHA256, ff_pkt->flags)) {
-    *digest = crypto_digest_new(jcr, CRYPTO_DIGEST_SHA256);
-    *digest_stream = STREAM_SHA256_DIGEST;
-  } else if (BitIsSet(FO_SHA512, ff_pkt->flags)) {
-    *digest = crypto_digest_new(jcr, CRYPTO_DIGEST_SHA512);
-    *digest_stream = STREAM_SHA512_DIGEST;
-  } else if (BitIsSet(FO_XXH128, ff_pkt->flags)) {
-    *digest = crypto_digest_new(jcr, CRYPTO_DIGEST_XXH128);
-    *digest_stream = STREAM_XXH128_DIGEST;
-  }
+  crypto_digest_t type = GetDigestType(ff_pkt, digest_stream);
+  if (type != CRYPTO_DIGEST_NONE) { *digest = crypto_digest_new(jcr, type); }
 
   // compute MD5 or SHA1 hash
   if (*digest) {
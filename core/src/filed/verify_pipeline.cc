@@ -0,0 +1,125 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Compute the digests of a verify job in parallel
+ */
+
+#include "include/bareos.h"
+#include "include/jcr.h"
+#include "filed/verify_pipeline.h"
+#include "findlib/bfile.h"
+#include "lib/bnet.h"
+#include "lib/bsock.h"
+
+#include <chrono>
+
+namespace filedaemon {
+
+VerifyPipeline::VerifyPipeline(thread_pool& pool,
+                               std::size_t num_workers,
+                               ComputeFunction compute)
+    : compute_{std::move(compute)}
+    , max_pending_{num_workers * 4}
+    , compute_group_{num_workers * 3}
+    , latch_{num_workers}
+{
+  pool.borrow_threads(num_workers, [this] {
+    compute_group_.work_until_completion();
+
+    *latch_.lock() -= 1;
+    compute_fin_.notify_one();
+  });
+}
+
+VerifyPipeline::~VerifyPipeline()
+{
+  compute_group_.shutdown();
+  latch_.lock().wait(compute_fin_, [](std::size_t num) { return num == 0; });
+}
+
+bool VerifyPipeline::Queue(JobControlRecord* jcr,
+                           int32_t file_index,
+                           std::string attributes,
+                           const DigestRequest* digest)
+{
+  PendingFile& file = pending_.emplace_back();
+  file.file_index = file_index;
+  file.attributes = std::move(attributes);
+  if (digest) {
+    file.stream = digest->stream;
+    file.digest.emplace(compute_group_.submit(
+        [this, req = *digest]() { return compute_(req); }));
+  }
+  return SendFinished(jcr, max_pending_);
+}
+
+// Send files in order as long as they are done or too many are pending
+bool VerifyPipeline::SendFinished(JobControlRecord* jcr,
+                                  std::size_t max_pending)
+{
+  while (!pending_.empty()) {
+    PendingFile& file = pending_.front();
+    if (file.digest && pending_.size() <= max_pending
+        && file.digest->wait_for(std::chrono::seconds(0))
+               != std::future_status::ready) {
+      break;
+    }
+    if (!Send(jcr, file)) { return false; }
+    pending_.pop_front();
+  }
+  return true;
+}
+
+bool VerifyPipeline::Send(JobControlRecord* jcr, PendingFile& file)
+{
+  BareosSocket* dir = jcr->dir_bsock;
+
+  if (!dir->send(file.attributes.data(), file.attributes.size())) {
+    Jmsg(jcr, M_FATAL, 0, T_("Network error in send to Director: ERR=%s\n"),
+         BnetStrerror(dir));
+    return false;
+  }
+  if (!file.digest) { return true; }
+
+  DigestResult result = file.digest->get();
+  if (jcr->is_JobType(JT_VERIFY)) { jcr->JobBytes += result.bytes_read; }
+  jcr->ReadBytes += result.bytes_read;
+
+  if (result.init_failed) {
+    Jmsg(jcr, M_WARNING, 0, T_("%s digest initialization failed\n"),
+         stream_to_ascii(file.stream));
+    return true;
+  }
+  if (!result.error.empty()) {
+    Jmsg(jcr, M_ERROR, 1, "%s", result.error.c_str());
+    jcr->JobErrors++;
+  }
+  if (!result.digest.empty()) {
+    Dmsg3(400, "send inx=%d %s=%s\n", file.file_index, result.name,
+          result.digest.c_str());
+    dir->fsend("%d %d %s *%s-%d*", file.file_index, file.stream,
+               result.digest.c_str(), result.name, file.file_index);
+  }
+  return true;
+}
+
+} /* namespace filedaemon */
@@ -0,0 +1,113 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Compute the digests of a verify job in parallel
+ */
+
+#ifndef BAREOS_FILED_VERIFY_PIPELINE_H_
+#define BAREOS_FILED_VERIFY_PIPELINE_H_
+
+#include "include/streams.h"
+#include "lib/crypto.h"
+#include "lib/thread_pool.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <optional>
+#include <string>
+
+class JobControlRecord;
+
+namespace filedaemon {
+
+/* Everything needed to compute the digest of a file, as the FindFilesPacket
+ * is already reused for the next file when the digest gets computed. */
+struct DigestRequest {
+  std::string fname;
+  crypto_digest_t type{CRYPTO_DIGEST_NONE};
+  int stream{STREAM_NONE};
+  bool noatime{false};
+  bool sparse{false};
+  int file_type{0};
+  uint64_t file_size{0};
+  dev_t rdev{0};
+};
+
+struct DigestResult {
+  bool init_failed{false};
+  std::string digest; /**< base64 encoded, empty on error */
+  const char* name{nullptr};
+  uint64_t bytes_read{0};
+  std::string error; /**< why the file could not be read */
+};
+
+/* Computes the digests of several files at the same time on the job's
+ * thread pool. The attributes and digests are still sent to the Director in
+ * the order the files were found, as it expects the digest of a file right
+ * after its attributes. */
+class VerifyPipeline {
+ public:
+  using ComputeFunction = std::function<DigestResult(const DigestRequest&)>;
+
+  // compute is called on the worker threads
+  VerifyPipeline(thread_pool& pool,
+                 std::size_t num_workers,
+                 ComputeFunction compute);
+  VerifyPipeline(const VerifyPipeline&) = delete;
+  VerifyPipeline& operator=(const VerifyPipeline&) = delete;
+  // Waits for the digests being computed, files not yet sent are dropped
+  ~VerifyPipeline();
+
+  /* Sends the attributes of the file once the digest is computed. Returns
+   * false if sending to the Director failed. */
+  bool Queue(JobControlRecord* jcr,
+             int32_t file_index,
+             std::string attributes,
+             const DigestRequest* digest);
+  // Sends all files still queued
+  bool Flush(JobControlRecord* jcr) { return SendFinished(jcr, 0); }
+
+ private:
+  struct PendingFile {
+    int32_t file_index{0};
+    int stream{STREAM_NONE};
+    std::string attributes; /**< complete attribute message */
+    std::optional<std::future<DigestResult>> digest;
+  };
+
+  bool SendFinished(JobControlRecord* jcr, std::size_t max_pending);
+  bool Send(JobControlRecord* jcr, PendingFile& file);
+
+  ComputeFunction compute_;
+  std::size_t max_pending_;
+  std::deque<PendingFile> pending_;
+  work_group compute_group_;
+  std::condition_variable compute_fin_;
+  synchronized<std::size_t> latch_;
+};
+
+} /* namespace filedaemon */
+
+#endif  // BAREOS_FILED_VERIFY_PIPELINE_H_
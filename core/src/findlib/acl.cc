@@ -1138,27 +1138,50 @@ static bacl_exit_code (*os_parse_acl_streams)(JobControlRecord* jcr,
     = freebsd_parse_acl_streams;
 
 #      elif defined(HAVE_LINUX_OS)
+#        include <sys/xattr.h>
+
 // Define the supported ACL streams
 static int os_access_acl_streams[1] = {STREAM_ACL_LINUX_ACCESS_ACL};
 static int os_default_acl_streams[1] = {STREAM_ACL_LINUX_DEFAULT_ACL};
 
+/**
+ * On Linux acl_get_file() reads the ACL from an extended attribute. When the
+ * file has no such attribute it stat()s the file to make up a trivial ACL
+ * from the permission bits, which we then throw away again. As this is the
+ * case for almost every file, first probe for the extended attribute with a
+ * single syscall. Any error other than ENODATA (e.g. no ACL support on the
+ * filesystem) is left to acl_get_file() to handle.
+ */
+static bool AclXattrPresent(const char* fname, bacl_type acltype)
+{
+  const char* name = (acltype == BACL_TYPE_DEFAULT) ? "system.posix_acl_default"
+                                                    : "system.posix_acl_access";
+
+  // Like acl_get_file() this follows symbolic links.
+  if (getxattr(fname, name, NULL, 0) >= 0) { return true; }
+  return errno != ENODATA;
+}
+
 static bacl_exit_code generic_build_acl_streams(JobControlRecord* jcr,
                                                 AclData* acl_data,
                                                 FindFilesPacket*)
 {
   // Read access ACLs for files, dirs and links
-  if (generic_get_acl_from_os(jcr, acl_data, BACL_TYPE_ACCESS)
-      == bacl_exit_fatal)
-    return bacl_exit_fatal;
-
-  if (acl_data->u.build->content_length > 0) {
-    if (SendAclStream(jcr, acl_data, os_access_acl_streams[0])
+  if (AclXattrPresent(acl_data->last_fname, BACL_TYPE_ACCESS)) {
+    if (generic_get_acl_from_os(jcr, acl_data, BACL_TYPE_ACCESS)
         == bacl_exit_fatal)
       return bacl_exit_fatal;
+
+    if (acl_data->u.build->content_length > 0) {
+      if (SendAclStream(jcr, acl_data, os_access_acl_streams[0])
+          == bacl_exit_fatal)
+        return bacl_exit_fatal;
+    }
   }
 
   // Directories can have default ACLs too
-  if (acl_data->filetype == FT_DIREND) {
+  if (acl_data->filetype == FT_DIREND
+      && AclXattrPresent(acl_data->last_fname, BACL_TYPE_DEFAULT)) {
     if (generic_get_acl_from_os(jcr, acl_data, BACL_TYPE_DEFAULT)
         == bacl_exit_fatal)
       return bacl_exit_fatal;
@@ -36,6 +36,7 @@
 #include "include/jcr.h"
 #include "find.h"
 #include "findlib/find_one.h"
+#include "findlib/wildcard_set.h"
 #include "lib/util.h"
 
 #if defined(HAVE_DARWIN_OS)
@@ -241,22 +242,20 @@ bool AcceptFile(FindFilesPacket* ff)
   const char* basename;
   findFILESET* fileset = ff->fileset;
   findIncludeExcludeItem* incexe = fileset->incexe;
-  int (*match_func)(const char* pattern, const char* string, int flags);
 
   Dmsg1(debuglevel, "enter AcceptFile: fname=%s\n", ff->fname);
   if (BitIsSet(FO_ENHANCEDWILD, ff->flags)) {
-    match_func = fnmatch;
     if ((basename = last_path_separator(ff->fname)) != NULL)
       basename++;
     else
       basename = ff->fname;
   } else {
-    match_func = fnmatch;
     basename = ff->fname;
   }
 
   for (j = 0; j < incexe->opts_list.size(); j++) {
     findFOPTS* fo;
+    const char* pattern;
 
     fo = (findFOPTS*)incexe->opts_list.get(j);
     CopyBits(FO_MAX, fo->flags, ff->flags);
@@ -268,57 +267,48 @@ bool AcceptFile(FindFilesPacket* ff)
     fnm_flags = BitIsSet(FO_IGNORECASE, ff->flags) ? FNM_CASEFOLD : 0;
     fnm_flags |= BitIsSet(FO_ENHANCEDWILD, ff->flags) ? FNM_PATHNAME : 0;
 
+    /* The flags only depend on the options block, so its wildcards get
+     * compiled once and are reused for all following files. */
+    const CompiledWildcards* wildcards
+        = CompileWildcards(fo, fnmode | fnm_flags);
+
     if (S_ISDIR(ff->statp.st_mode)) {
-      for (k = 0; k < fo->wilddir.size(); k++) {
-        if (match_func((char*)fo->wilddir.get(k), ff->fname, fnmode | fnm_flags)
-            == 0) {
-          if (BitIsSet(FO_EXCLUDE, ff->flags)) {
-            Dmsg2(debuglevel, "Exclude wilddir: %s file=%s\n",
-                  (char*)fo->wilddir.get(k), ff->fname);
-            return false; /* reject dir */
-          }
-          return true; /* accept dir */
+      if ((pattern = wildcards->wilddir.Match(ff->fname))) {
+        if (BitIsSet(FO_EXCLUDE, ff->flags)) {
+          Dmsg2(debuglevel, "Exclude wilddir: %s file=%s\n", pattern,
+                ff->fname);
+          return false; /* reject dir */
         }
+        return true; /* accept dir */
       }
     } else {
-      for (k = 0; k < fo->wildfile.size(); k++) {
-        if (match_func((char*)fo->wildfile.get(k), ff->fname,
-                       fnmode | fnm_flags)
-            == 0) {
-          if (BitIsSet(FO_EXCLUDE, ff->flags)) {
-            Dmsg2(debuglevel, "Exclude wildfile: %s file=%s\n",
-                  (char*)fo->wildfile.get(k), ff->fname);
-            return false; /* reject file */
-          }
-          return true; /* accept file */
-        }
-      }
-
-      for (k = 0; k < fo->wildbase.size(); k++) {
-        if (match_func((char*)fo->wildbase.get(k), basename, fnmode | fnm_flags)
-            == 0) {
-          if (BitIsSet(FO_EXCLUDE, ff->flags)) {
-            Dmsg2(debuglevel, "Exclude wildbase: %s file=%s\n",
-                  (char*)fo->wildbase.get(k), basename);
-            return false; /* reject file */
-          }
-          return true; /* accept file */
+      if ((pattern = wildcards->wildfile.Match(ff->fname))) {
+        if (BitIsSet(FO_EXCLUDE, ff->flags)) {
+          Dmsg2(debuglevel, "Exclude wildfile: %s file=%s\n", pattern,
+                ff->fname);
+          return false; /* reject file */
         }
+        return true; /* accept file */
       }
-    }
 
-    for (k = 0; k < fo->wild.size(); k++) {
-      if (match_func((char*)fo->wild.get(k), ff->fname, fnmode | fnm_flags)
-          == 0) {
+      if ((pattern = wildcards->wildbase.Match(basename))) {
         if (BitIsSet(FO_EXCLUDE, ff->flags)) {
-          Dmsg2(debuglevel, "Exclude wild: %s file=%s\n",
-                (char*)fo->wild.get(k), ff->fname);
+          Dmsg2(debuglevel, "Exclude wildbase: %s file=%s\n", pattern,
+                basename);
           return false; /* reject file */
         }
         return true; /* accept file */
       }
     }
 
+    if ((pattern = wildcards->wild.Match(ff->fname))) {
+      if (BitIsSet(FO_EXCLUDE, ff->flags)) {
+        Dmsg2(debuglevel, "Exclude wild: %s file=%s\n", pattern, ff->fname);
+        return false; /* reject file */
+      }
+      return true; /* accept file */
+    }
+
     if (S_ISDIR(ff->statp.st_mode)) {
       for (k = 0; k < fo->regexdir.size(); k++) {
         if (regexec((regex_t*)fo->regexdir.get(k), ff->fname, 0, NULL, 0)
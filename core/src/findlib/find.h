@@ -143,6 +143,7 @@ struct findFOPTS {
   alist<const char*> base;       /**< List of base names */
   alist<const char*> fstype;     /**< File system type limitation */
   alist<const char*> Drivetype;  /**< Drive type limitation */
+  struct CompiledWildcards* compiled_wildcards{}; /**< See wildcard_set.h */
 };
 
 // This is either an include item or an exclude item
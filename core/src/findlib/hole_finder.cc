@@ -0,0 +1,80 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Find the holes of sparse files without reading them
+ */
+
+#include "include/bareos.h"
+#include "findlib/hole_finder.h"
+#include "lib/berrno.h"
+
+#include <unistd.h>
+#include <algorithm>
+
+static const int debuglevel = 200;
+
+HoleFinder::HoleFinder(int fd, std::uint64_t file_size)
+    : fd_{fd}, file_size_{file_size}
+{
+}
+
+std::int64_t HoleFinder::SkipHole(std::uint64_t position,
+                                  [[maybe_unused]] std::size_t block_size)
+{
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+  if (!usable_ || position < data_end_ || position >= file_size_) {
+    return position;
+  }
+
+  off_t data = lseek(fd_, position, SEEK_DATA);
+  if (data < 0 && errno == ENXIO) {
+    data = file_size_; /* only a hole follows */
+  } else if (data < 0) {
+    BErrNo be;
+    Dmsg1(debuglevel, "Cannot look up holes, reading all data. ERR=%s\n",
+          be.bstrerror());
+    usable_ = false;
+    return lseek(fd_, position, SEEK_SET);
+  }
+
+  // the file may have changed since it was stat()ed
+  std::uint64_t data_start
+      = std::min(static_cast<std::uint64_t>(data), file_size_);
+  data_end_ = file_size_;
+  if (data_start < file_size_) {
+    off_t hole = lseek(fd_, data_start, SEEK_HOLE);
+    if (hole > 0) { data_end_ = static_cast<std::uint64_t>(hole); }
+  }
+
+  std::uint64_t skip = (data_start - position) / block_size * block_size;
+  if (skip > 0 && position + skip >= file_size_) { skip -= block_size; }
+  if (skip > 0) {
+    Dmsg2(debuglevel, "Skipping hole of %llu bytes at %llu\n",
+          static_cast<unsigned long long>(skip),
+          static_cast<unsigned long long>(position));
+    skipped_ += skip;
+  }
+  return lseek(fd_, position + skip, SEEK_SET);
+#else
+  return position;
+#endif
+}
@@ -0,0 +1,60 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Find the holes of sparse files without reading them
+ */
+
+#ifndef BAREOS_FINDLIB_HOLE_FINDER_H_
+#define BAREOS_FINDLIB_HOLE_FINDER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/* Asks the filesystem with lseek(SEEK_DATA/SEEK_HOLE) where the holes of a
+ * file are. A file read in blocks can then skip the blocks lying in a hole,
+ * which would only be read to find out that they are zero.
+ *
+ * Where the filesystem or the platform does not support this, the whole file
+ * is reported as data. The same is done once a lookup fails, reading the
+ * blocks is always correct. */
+class HoleFinder {
+ public:
+  HoleFinder(int fd, std::uint64_t file_size);
+
+  /* Returns the position the block at position has to be read from. Whole
+   * blocks of a hole are skipped, except the last block of the file, which
+   * is needed to restore the size of the file. Positions have to be
+   * passed in increasing order. The file offset is set to the returned
+   * position, -1 is returned if that fails. */
+  std::int64_t SkipHole(std::uint64_t position, std::size_t block_size);
+
+  std::uint64_t SkippedBytes() const { return skipped_; }
+
+ private:
+  int fd_;
+  std::uint64_t file_size_;
+  std::uint64_t data_end_{0}; /**< of the data around the last position */
+  std::uint64_t skipped_{0};
+  bool usable_{true};
+};
+
+#endif  // BAREOS_FINDLIB_HOLE_FINDER_H_
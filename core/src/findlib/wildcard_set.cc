@@ -0,0 +1,174 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+#include "include/bareos.h"
+#include "find.h"
+#include "findlib/wildcard_set.h"
+
+#include <algorithm>
+
+// Flags we know to handle without calling fnmatch()
+static constexpr int kSupportedFnmFlags = FNM_CASEFOLD | FNM_PATHNAME;
+
+static bool HasWildcards(std::string_view s)
+{
+  return s.find_first_of("*?[\\") != std::string_view::npos;
+}
+
+/* Only for plain ASCII case folding is a simple tolower(), in all other cases
+ * leave it to fnmatch() to deal with the locale. */
+static bool IsAscii(std::string_view s)
+{
+  return std::all_of(s.begin(), s.end(),
+                     [](char c) { return static_cast<unsigned char>(c) < 0x80; });
+}
+
+static std::string ToLower(std::string_view s)
+{
+  std::string lowered{s};
+  for (auto& c : lowered) {
+    if (c >= 'A' && c <= 'Z') { c = c - 'A' + 'a'; }
+  }
+  return lowered;
+}
+
+WildcardSet::WildcardSet(const std::vector<const char*>& patterns,
+                         int fnm_flags)
+    : fnm_flags_(fnm_flags)
+    , casefold_(fnm_flags & FNM_CASEFOLD)
+    , pathname_(fnm_flags & FNM_PATHNAME)
+    , patterns_(patterns)
+{
+  if (fnm_flags & ~kSupportedFnmFlags) {
+    others_ = patterns;
+    return;
+  }
+
+  for (const char* pattern : patterns) {
+    std::string_view p{pattern};
+    if (casefold_ && !IsAscii(p)) {
+      others_.push_back(pattern);
+      continue;
+    }
+
+    LiteralMap* map;
+    std::string_view literal;
+    if (!HasWildcards(p)) {
+      map = &exact_;
+      literal = p;
+    } else if (p.front() == '*' && !HasWildcards(p.substr(1))) {
+      literal = p.substr(1);
+      map = &suffixes_[literal.size()];
+    } else if (p.back() == '*' && !HasWildcards(p.substr(0, p.size() - 1))) {
+      literal = p.substr(0, p.size() - 1);
+      map = &prefixes_[literal.size()];
+    } else {
+      others_.push_back(pattern);
+      continue;
+    }
+
+    const std::string& key = literals_.emplace_back(
+        casefold_ ? ToLower(literal) : std::string{literal});
+    map->emplace(key, pattern);
+  }
+}
+
+const char* WildcardSet::MatchLiterals(std::string_view str) const
+{
+  if (auto it = exact_.find(str); it != exact_.end()) { return it->second; }
+
+  // a '*' never matches a '/' when FNM_PATHNAME is given
+  for (auto& [length, map] : suffixes_) {
+    if (length > str.size()) { break; }
+    std::size_t rest = str.size() - length;
+    auto it = map.find(str.substr(rest));
+    if (it != map.end()
+        && !(pathname_
+             && str.substr(0, rest).find('/') != std::string_view::npos)) {
+      return it->second;
+    }
+  }
+
+  for (auto& [length, map] : prefixes_) {
+    if (length > str.size()) { break; }
+    auto it = map.find(str.substr(0, length));
+    if (it != map.end()
+        && !(pathname_
+             && str.substr(length).find('/') != std::string_view::npos)) {
+      return it->second;
+    }
+  }
+
+  return nullptr;
+}
+
+const char* WildcardSet::MatchWithFnmatch(const char* str) const
+{
+  for (const char* pattern : patterns_) {
+    if (fnmatch(pattern, str, fnm_flags_) == 0) { return pattern; }
+  }
+  return nullptr;
+}
+
+const char* WildcardSet::Match(const char* str) const
+{
+  if (patterns_.empty()) { return nullptr; }
+
+  std::string_view s{str};
+  std::string lowered;
+  if (casefold_) {
+    if (!IsAscii(s)) { return MatchWithFnmatch(str); }
+    lowered = ToLower(s);
+    s = lowered;
+  }
+
+  if (const char* pattern = MatchLiterals(s)) { return pattern; }
+
+  for (const char* pattern : others_) {
+    if (fnmatch(pattern, str, fnm_flags_) == 0) { return pattern; }
+  }
+  return nullptr;
+}
+
+static std::vector<const char*> ToVector(alist<const char*>& list)
+{
+  std::vector<const char*> patterns;
+  for (int i = 0; i < list.size(); i++) { patterns.push_back(list.get(i)); }
+  return patterns;
+}
+
+CompiledWildcards* CompileWildcards(findFOPTS* fo, int fnm_flags)
+{
+  if (!fo->compiled_wildcards) {
+    fo->compiled_wildcards = new CompiledWildcards{
+        WildcardSet(ToVector(fo->wild), fnm_flags),
+        WildcardSet(ToVector(fo->wilddir), fnm_flags),
+        WildcardSet(ToVector(fo->wildfile), fnm_flags),
+        WildcardSet(ToVector(fo->wildbase), fnm_flags)};
+  }
+  return fo->compiled_wildcards;
+}
+
+void FreeCompiledWildcards(findFOPTS* fo)
+{
+  delete fo->compiled_wildcards;
+  fo->compiled_wildcards = nullptr;
+}
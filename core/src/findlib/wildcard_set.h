@@ -0,0 +1,91 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * precompiled set of fnmatch() patterns
+ */
+
+#ifndef BAREOS_FINDLIB_WILDCARD_SET_H_
+#define BAREOS_FINDLIB_WILDCARD_SET_H_
+
+#include <deque>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct findFOPTS;
+
+/**
+ * Answers whether any of a list of fnmatch() patterns matches a string.
+ *
+ * Literal patterns and patterns of the form "*literal" and "literal*" (e.g.
+ * "*.o" or "core.*") are looked up in hash tables, so their number does not
+ * matter anymore. Only the remaining patterns are still tried one after
+ * another with fnmatch(). The result is always the same as calling fnmatch()
+ * with each pattern in turn.
+ */
+class WildcardSet {
+ public:
+  WildcardSet() = default;
+  WildcardSet(const std::vector<const char*>& patterns, int fnm_flags);
+  // the hash tables point into literals_
+  WildcardSet(const WildcardSet&) = delete;
+  WildcardSet& operator=(const WildcardSet&) = delete;
+  WildcardSet(WildcardSet&&) = default;
+  WildcardSet& operator=(WildcardSet&&) = default;
+
+  /* Returns one of the patterns matching str (not necessarily the first one
+   * in list order) or nullptr if none matches. */
+  const char* Match(const char* str) const;
+  bool empty() const { return patterns_.empty(); }
+
+ private:
+  // literal text of a pattern -> the pattern itself
+  using LiteralMap = std::unordered_map<std::string_view, const char*>;
+
+  const char* MatchLiterals(std::string_view str) const;
+  const char* MatchWithFnmatch(const char* str) const;
+
+  int fnm_flags_{0};
+  bool casefold_{false};
+  bool pathname_{false};
+  std::vector<const char*> patterns_;
+  std::deque<std::string> literals_; /**< storage for the LiteralMap keys */
+  LiteralMap exact_;
+  std::map<std::size_t, LiteralMap> suffixes_; /**< by length of literal */
+  std::map<std::size_t, LiteralMap> prefixes_; /**< by length of literal */
+  std::vector<const char*> others_;
+};
+
+// The wildcard lists of one Options block compiled into WildcardSets
+struct CompiledWildcards {
+  WildcardSet wild;
+  WildcardSet wilddir;
+  WildcardSet wildfile;
+  WildcardSet wildbase;
+};
+
+CompiledWildcards* CompileWildcards(findFOPTS* fo, int fnm_flags);
+void FreeCompiledWildcards(findFOPTS* fo);
+
+#endif  // BAREOS_FINDLIB_WILDCARD_SET_H_
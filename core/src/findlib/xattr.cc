@@ -685,8 +685,17 @@ static BxattrExitCode generic_build_xattr_streams(JobControlRecord* jcr,
   alist<xattr_t*>* xattr_value_list = NULL;
   BxattrExitCode retval = BxattrExitCode::kError;
 
-  // First get the length of the available list with extended attributes.
-  xattr_list_len = llistxattr(xattr_data->last_fname, NULL, 0);
+  /* Most files have no or only a few extended attributes, so first try to
+   * get the whole list in one go and only ask for the length of the list
+   * when it doesn't fit. */
+  char list_buf[XATTR_BUFSIZ];
+  bool list_complete = true;
+  xattr_list_len
+      = llistxattr(xattr_data->last_fname, list_buf, sizeof(list_buf));
+  if (xattr_list_len == -1 && errno == ERANGE) {
+    list_complete = false;
+    xattr_list_len = llistxattr(xattr_data->last_fname, NULL, 0);
+  }
   switch (xattr_list_len) {
     case -1: {
       BErrNo be;
@@ -729,8 +738,12 @@ static BxattrExitCode generic_build_xattr_streams(JobControlRecord* jcr,
   memset(xattr_list, 0, xattr_list_len + 1);
 
   // Get the actual list of extended attributes names for a file.
-  xattr_list_len
-      = llistxattr(xattr_data->last_fname, xattr_list, xattr_list_len);
+  if (list_complete) {
+    memcpy(xattr_list, list_buf, xattr_list_len);
+  } else {
+    xattr_list_len
+        = llistxattr(xattr_data->last_fname, xattr_list, xattr_list_len);
+  }
   switch (xattr_list_len) {
     case -1: {
       BErrNo be;
@@ -788,8 +801,16 @@ static BxattrExitCode generic_build_xattr_streams(JobControlRecord* jcr,
       continue;
     }
 
-    // First see how long the value is for the extended attribute.
-    xattr_value_len = lgetxattr(xattr_data->last_fname, bp, NULL, 0);
+    /* Again try to get the value in one go and only ask how long the value
+     * is for the extended attribute when it doesn't fit. */
+    char value_buf[XATTR_BUFSIZ];
+    bool value_complete = true;
+    xattr_value_len
+        = lgetxattr(xattr_data->last_fname, bp, value_buf, sizeof(value_buf));
+    if (xattr_value_len == -1 && errno == ERANGE) {
+      value_complete = false;
+      xattr_value_len = lgetxattr(xattr_data->last_fname, bp, NULL, 0);
+    }
     switch (xattr_value_len) {
       case -1: {
         BErrNo be;
@@ -836,8 +857,12 @@ static BxattrExitCode generic_build_xattr_streams(JobControlRecord* jcr,
         current_xattr->value = (char*)malloc(xattr_value_len);
         memset(current_xattr->value, 0, xattr_value_len);
 
-        xattr_value_len = lgetxattr(xattr_data->last_fname, bp,
-                                    current_xattr->value, xattr_value_len);
+        if (value_complete) {
+          memcpy(current_xattr->value, value_buf, xattr_value_len);
+        } else {
+          xattr_value_len = lgetxattr(xattr_data->last_fname, bp,
+                                      current_xattr->value, xattr_value_len);
+        }
         if (xattr_value_len < 0) {
           BErrNo be;
 
@@ -47,6 +47,7 @@
 #include "lib/path_list.h"
 #include "lib/guid_to_name.h"
 #include "lib/jcr.h"
+#include "lib/metrics.h"
 
 #include <atomic>
 
@@ -181,6 +182,7 @@ class JobControlRecord {
   uint64_t JobBytes{};          /**< Number of bytes processed this job */
   uint64_t LastJobBytes{};      /**< Last sample number bytes */
   uint64_t ReadBytes{};         /**< Bytes read -- before compression */
+  metrics::JobMetrics job_metrics; /**< Lock-free counters for the metrics endpoint */
   FileId_t FileId{};            /**< Last FileId used */
   int32_t JobPriority{};        /**< Job priority */
   bool allow_mixed_priority{};  /**< Allow jobs with higher priority concurrently with this */
@@ -3,7 +3,7 @@
 
    Copyright (C) 2000-2012 Free Software Foundation Europe e.V.
    Copyright (C) 2011-2012 Planets Communications B.V.
-   Copyright (C) 2013-2021 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -31,4 +31,22 @@ enum ProtocolTypes
   PT_NDMP_NATIVE
 };
 
+/* Catalog requests of the Storage daemon that a Director understands in
+ * addition to the basic ones. The Director announces them in the job command,
+ * older Directors announce none. */
+enum CatalogCapabilities
+{
+  CC_JOBMEDIA_BATCH = 0x01,  /* CreateJobMediaBatch */
+  CC_ATTRIBUTES_BATCH = 0x02 /* FileAttributesBatch */
+};
+
+/* Encodings of the stat packet in the File attributes. The Director asks the
+ * File daemon for one in the backup command, older Directors do not ask and
+ * get AE_LSTAT. */
+enum AttributeEncodings
+{
+  AE_LSTAT = 0,     /* base64 text, as stored in the catalog */
+  AE_COMPACT_V1 = 1 /* EncodeStatCompact() */
+};
+
 #endif  // BAREOS_INCLUDE_PROTOCOL_TYPES_H_
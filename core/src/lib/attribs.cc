@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2002-2011 Free Software Foundation Europe e.V.
-   Copyright (C) 2016-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2016-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -29,6 +29,71 @@
 #include "lib/scan.h"
 #include "lib/base64.h"
 
+/* The fields of an LStat in the order they are encoded. Clients of old
+ * versions do not send the fields from the LinkFI on. */
+enum LStatField
+{
+  kLStatDev,
+  kLStatIno,
+  kLStatMode,
+  kLStatNlink,
+  kLStatUid,
+  kLStatGid,
+  kLStatRdev,
+  kLStatSize,
+  kLStatBlksize,
+  kLStatBlocks,
+  kLStatAtime,
+  kLStatMtime,
+  kLStatCtime,
+  kLStatLinkFI,
+  kLStatFlags,
+  kLStatDataStream,
+  kNumLStatFields
+};
+
+// Fills the fields of an LStat from a stat structure
+static void StatToFields(int64_t* fields,
+                         struct stat* statp,
+                         int stat_size,
+                         int32_t LinkFI,
+                         int data_stream)
+{
+  /* We read the stat packet so make sure the caller's conception
+   *  is the same as ours.  They can be different if LARGEFILE is not
+   *  the same when compiling this library and the calling program. */
+  ASSERT(stat_size == (int)sizeof(struct stat));
+
+  /*  Encode a stat packet.  I should have done this more intelligently
+   *   with a length so that it could be easily expanded. */
+  fields[kLStatDev] = statp->st_dev;
+  fields[kLStatIno] = statp->st_ino;
+  fields[kLStatMode] = statp->st_mode;
+  fields[kLStatNlink] = statp->st_nlink;
+  fields[kLStatUid] = statp->st_uid;
+  fields[kLStatGid] = statp->st_gid;
+  fields[kLStatRdev] = statp->st_rdev;
+  fields[kLStatSize] = statp->st_size;
+#ifndef HAVE_MINGW
+  fields[kLStatBlksize] = statp->st_blksize;
+  fields[kLStatBlocks] = statp->st_blocks;
+#else
+  fields[kLStatBlksize] = 0; /* output place holder */
+  fields[kLStatBlocks] = 0;  /* output place holder */
+#endif
+  fields[kLStatAtime] = statp->st_atime;
+  fields[kLStatMtime] = statp->st_mtime;
+  fields[kLStatCtime] = statp->st_ctime;
+  fields[kLStatLinkFI] = LinkFI;
+#ifdef HAVE_CHFLAGS
+  /* FreeBSD function */
+  fields[kLStatFlags] = statp->st_flags;
+#else
+  fields[kLStatFlags] = 0; /* output place holder */
+#endif
+  fields[kLStatDataStream] = data_stream;
+}
+
 /**
  * Encode a stat structure into a base64 character string
  *   All systems must create such a structure.
@@ -46,61 +111,92 @@ void EncodeStat(char* buf,
                 int32_t LinkFI,
                 int data_stream)
 {
-  char* p = buf;
+  int64_t fields[kNumLStatFields];
 
-  /* We read the stat packet so make sure the caller's conception
-   *  is the same as ours.  They can be different if LARGEFILE is not
-   *  the same when compiling this library and the calling program. */
-  ASSERT(stat_size == (int)sizeof(struct stat));
+  StatToFields(fields, statp, stat_size, LinkFI, data_stream);
+  ToBase64List(fields, kNumLStatFields, buf);
+}
 
-  /*  Encode a stat packet.  I should have done this more intelligently
-   *   with a length so that it could be easily expanded. */
-  p += ToBase64((int64_t)statp->st_dev, p);
-  *p++ = ' '; /* separate fields with a space */
-  p += ToBase64((int64_t)statp->st_ino, p);
-  *p++ = ' ';
-  p += ToBase64((int64_t)statp->st_mode, p);
-  *p++ = ' ';
-  p += ToBase64((int64_t)statp->st_nlink, p);
-  *p++ = ' ';
-  p += ToBase64((int64_t)statp->st_uid, p);
-  *p++ = ' ';
-  p += ToBase64((int64_t)statp->st_gid, p);
-  *p++ = ' ';
-  p += ToBase64((int64_t)statp->st_rdev, p);
-  *p++ = ' ';
-  p += ToBase64((int64_t)statp->st_size, p);
-  *p++ = ' ';
-#ifndef HAVE_MINGW
-  p += ToBase64((int64_t)statp->st_blksize, p);
-  *p++ = ' ';
-  p += ToBase64((int64_t)statp->st_blocks, p);
-  *p++ = ' ';
-#else
-  p += ToBase64((int64_t)0, p); /* output place holder */
-  *p++ = ' ';
-  p += ToBase64((int64_t)0, p); /* output place holder */
-  *p++ = ' ';
-#endif
-  p += ToBase64((int64_t)statp->st_atime, p);
-  *p++ = ' ';
-  p += ToBase64((int64_t)statp->st_mtime, p);
-  *p++ = ' ';
-  p += ToBase64((int64_t)statp->st_ctime, p);
-  *p++ = ' ';
-  p += ToBase64((int64_t)LinkFI, p);
-  *p++ = ' ';
+/* A compact stat packet is the version byte followed by the number of fields
+ * and the fields themselves, all of them as compact numbers. The fields are
+ * zigzag encoded first, so that small negative values stay short.
+ *
+ * A compact number holds 7 bits in every byte but the last one, with the
+ * high bit set, and the remaining 6 bits in the last byte, with bit 6 set.
+ * So no byte is below 0x40, which keeps zero bytes and white space out. */
+static constexpr char kCompactStatV1 = 0x01;
 
-#ifdef HAVE_CHFLAGS
-  /* FreeBSD function */
-  p += ToBase64((int64_t)statp->st_flags, p); /* output st_flags */
-#else
-  p += ToBase64((int64_t)0, p); /* output place holder */
-#endif
-  *p++ = ' ';
-  p += ToBase64((int64_t)data_stream, p);
+static char* PutCompactNumber(uint64_t value, char* p)
+{
+  while (value >= 0x40) {
+    *p++ = static_cast<char>(0x80 | (value & 0x7f));
+    value >>= 7;
+  }
+  *p++ = static_cast<char>(0x40 | value);
+  return p;
+}
+
+// Returns nullptr if there is no valid number at p
+static const char* GetCompactNumber(uint64_t* value, const char* p)
+{
+  uint64_t result = 0;
+  unsigned int shift = 0;
+  for (; static_cast<uint8_t>(*p) & 0x80; ++p, shift += 7) {
+    if (shift > 63) { return nullptr; }
+    result |= static_cast<uint64_t>(*p & 0x7f) << shift;
+  }
+  if (!(static_cast<uint8_t>(*p) & 0x40) || shift > 63) { return nullptr; }
+  *value = result | static_cast<uint64_t>(*p & 0x3f) << shift;
+  return p + 1;
+}
+
+void EncodeStatCompact(char* buf,
+                       struct stat* statp,
+                       int stat_size,
+                       int32_t LinkFI,
+                       int data_stream)
+{
+  int64_t fields[kNumLStatFields];
+
+  StatToFields(fields, statp, stat_size, LinkFI, data_stream);
+  char* p = buf;
+  *p++ = kCompactStatV1;
+  p = PutCompactNumber(kNumLStatFields, p);
+  for (int64_t field : fields) {
+    uint64_t zigzag = (static_cast<uint64_t>(field) << 1)
+                      ^ static_cast<uint64_t>(field >> 63);
+    p = PutCompactNumber(zigzag, p);
+  }
   *p = 0;
-  return;
+}
+
+bool IsCompactStat(const char* buf) { return buf[0] == kCompactStatV1; }
+
+/* Decodes up to count fields of a compact stat packet. Fields of newer
+ * versions are skipped. Returns the number of fields found. */
+static int FromCompactList(int64_t* fields, int count, const char* buf)
+{
+  uint64_t num_fields;
+  const char* p = GetCompactNumber(&num_fields, buf + 1);
+  if (!p) { return 0; }
+
+  int found = 0;
+  for (; found < count && static_cast<uint64_t>(found) < num_fields;
+       ++found) {
+    uint64_t zigzag;
+    if (!(p = GetCompactNumber(&zigzag, p))) { break; }
+    fields[found] = static_cast<int64_t>(zigzag >> 1)
+                    ^ -static_cast<int64_t>(zigzag & 1);
+  }
+  return found;
+}
+
+void CompactStatToLStat(const char* compact, char* lstat)
+{
+  int64_t fields[kNumLStatFields] = {};
+
+  int num_fields = FromCompactList(fields, kNumLStatFields, compact);
+  ToBase64List(fields, num_fields, lstat);
 }
 
 /* Do casting according to unknown type to keep compiler happy */
@@ -109,11 +205,10 @@ template <typename T> static void plug(T& st, uint64_t val)
   st = static_cast<T>(val);
 }
 
-// Decode a stat packet from base64 characters
+// Decode a stat packet from base64 characters or its compact encoding
 int DecodeStat(char* buf, struct stat* statp, int stat_size, int32_t* LinkFI)
 {
-  char* p = buf;
-  int64_t val;
+  int64_t fields[kNumLStatFields] = {};
 
   /* We store into the stat packet so make sure the caller's conception
    *  is the same as ours.  They can be different if LARGEFILE is not
@@ -121,81 +216,38 @@ int DecodeStat(char* buf, struct stat* statp, int stat_size, int32_t* LinkFI)
   ASSERT(stat_size == (int)sizeof(struct stat));
   memset(statp, 0, stat_size);
 
-  p += FromBase64(&val, p);
-  plug(statp->st_dev, val);
-  p++;
-  p += FromBase64(&val, p);
-  plug(statp->st_ino, val);
-  p++;
-  p += FromBase64(&val, p);
-  plug(statp->st_mode, val);
-  p++;
-  p += FromBase64(&val, p);
-  plug(statp->st_nlink, val);
-  p++;
-  p += FromBase64(&val, p);
-  plug(statp->st_uid, val);
-  p++;
-  p += FromBase64(&val, p);
-  plug(statp->st_gid, val);
-  p++;
-  p += FromBase64(&val, p);
-  plug(statp->st_rdev, val);
-  p++;
-  p += FromBase64(&val, p);
-  plug(statp->st_size, val);
-  p++;
+  int num_fields = IsCompactStat(buf)
+                       ? FromCompactList(fields, kNumLStatFields, buf)
+                       : FromBase64List(fields, kNumLStatFields, buf);
+
+  plug(statp->st_dev, fields[kLStatDev]);
+  plug(statp->st_ino, fields[kLStatIno]);
+  plug(statp->st_mode, fields[kLStatMode]);
+  plug(statp->st_nlink, fields[kLStatNlink]);
+  plug(statp->st_uid, fields[kLStatUid]);
+  plug(statp->st_gid, fields[kLStatGid]);
+  plug(statp->st_rdev, fields[kLStatRdev]);
+  plug(statp->st_size, fields[kLStatSize]);
 #ifndef HAVE_MINGW
-  p += FromBase64(&val, p);
-  plug(statp->st_blksize, val);
-  p++;
-  p += FromBase64(&val, p);
-  plug(statp->st_blocks, val);
-  p++;
-#else
-  p += FromBase64(&val, p);
-  //   plug(statp->st_blksize, val);
-  p++;
-  p += FromBase64(&val, p);
-  //   plug(statp->st_blocks, val);
-  p++;
+  plug(statp->st_blksize, fields[kLStatBlksize]);
+  plug(statp->st_blocks, fields[kLStatBlocks]);
 #endif
-  p += FromBase64(&val, p);
-  plug(statp->st_atime, val);
-  p++;
-  p += FromBase64(&val, p);
-  plug(statp->st_mtime, val);
-  p++;
-  p += FromBase64(&val, p);
-  plug(statp->st_ctime, val);
+  plug(statp->st_atime, fields[kLStatAtime]);
+  plug(statp->st_mtime, fields[kLStatMtime]);
+  plug(statp->st_ctime, fields[kLStatCtime]);
 
   /* Optional FileIndex of hard linked file data */
-  if (*p == ' ' || (*p != 0 && *(p + 1) == ' ')) {
-    p++;
-    p += FromBase64(&val, p);
-    *LinkFI = (uint32_t)val;
-  } else {
+  if (num_fields <= kLStatLinkFI) {
     *LinkFI = 0;
     return 0;
   }
+  *LinkFI = (uint32_t)fields[kLStatLinkFI];
 
   /* FreeBSD user flags */
-  if (*p == ' ' || (*p != 0 && *(p + 1) == ' ')) {
-    p++;
-    p += FromBase64(&val, p);
 #ifdef HAVE_CHFLAGS
-    plug(statp->st_flags, val);
-  } else {
-    statp->st_flags = 0;
+  plug(statp->st_flags, fields[kLStatFlags]);
 #endif
-  }
 
-  /* Look for data stream id */
-  if (*p == ' ' || (*p != 0 && *(p + 1) == ' ')) {
-    p++;
-    p += FromBase64(&val, p);
-  } else {
-    val = 0;
-  }
-  return (int)val;
+  /* Data stream id, 0 if not present */
+  return (int)fields[kLStatDataStream];
 }
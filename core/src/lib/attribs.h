@@ -1,7 +1,7 @@
 /*
    BAREOS® - Backup Archiving REcovery Open Sourced
 
-   Copyright (C) 2018-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2018-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -21,11 +21,31 @@
 #ifndef BAREOS_LIB_ATTRIBS_H_
 #define BAREOS_LIB_ATTRIBS_H_
 
+/* Room for any LStat text: 16 fields of at most 12 characters, separated by
+ * spaces and terminated by a zero */
+inline constexpr int kMaxLStatLength = 16 * 13;
+
 void EncodeStat(char* buf,
                 struct stat* statp,
                 int stat_size,
                 int32_t LinkFI,
                 int data_stream);
+
+/* Encodes the same fields as EncodeStat() as variable length binary numbers,
+ * which is shorter and faster to produce. The result contains neither zero
+ * bytes nor white space, so it fits wherever an LStat is passed, and starts
+ * with a version byte that no LStat starts with. */
+void EncodeStatCompact(char* buf,
+                       struct stat* statp,
+                       int stat_size,
+                       int32_t LinkFI,
+                       int data_stream);
+bool IsCompactStat(const char* buf);
+
+// Converts a compact stat packet into the LStat text the catalog stores
+void CompactStatToLStat(const char* compact, char* lstat);
+
+// Decodes both an LStat and a compact stat packet
 int DecodeStat(char* buf, struct stat* statp, int stat_size, int32_t* LinkFI);
 
 #endif  // BAREOS_LIB_ATTRIBS_H_
@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2000-2007 Free Software Foundation Europe e.V.
-   Copyright (C) 2016-2019 Bareos GmbH & Co. KG
+   Copyright (C) 2016-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -27,37 +27,31 @@
 
 #include "include/bareos.h"
 
-static uint8_t const base64_digits[64]
+#include <array>
+
+static constexpr uint8_t base64_digits[64]
     = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
        'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
        'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm',
        'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'};
 
-static int base64_inited = 0;
-static uint8_t base64_map[256];
-
-/* Initialize the Base 64 conversion routines */
-void Base64Init(void)
+/* Value of each base64 digit, characters that are no base64 digit count as
+ * 0. The table is built at compile time, so it needs no initialization. */
+static constexpr std::array<uint8_t, 256> MakeBase64Map()
 {
-  int i;
-  memset(base64_map, 0, sizeof(base64_map));
-  for (i = 0; i < 64; i++) base64_map[(uint8_t)base64_digits[i]] = i;
-  base64_inited = 1;
+  std::array<uint8_t, 256> map{};
+  for (uint8_t i = 0; i < 64; i++) { map[base64_digits[i]] = i; }
+  return map;
 }
 
-/* Convert a value to base64 characters.
- * The result is stored in where, which
- * must be at least 8 characters long.
- *
- * Returns the number of characters
- * stored (not including the EOS).
- */
-int ToBase64(int64_t value, char* where)
+static constexpr std::array<uint8_t, 256> base64_map = MakeBase64Map();
+
+/* Store the base64 digits of value at where, without EOS.
+ * Returns the number of characters stored. */
+static inline int PutBase64(int64_t value, char* where)
 {
-  uint64_t val;
   int i = 0;
-  int n;
 
   /* Handle negative values */
   if (value < 0) {
@@ -66,20 +60,54 @@ int ToBase64(int64_t value, char* where)
   }
 
   /* Determine output size */
-  val = value;
-  do {
-    val >>= 6;
-    i++;
-  } while (val);
-  n = i;
+  uint64_t val = value;
+  int n = 1;
+  while (val >>= 6) { n++; }
+  i += n;
 
   /* Output characters */
+  char* p = where + i;
   val = value;
-  where[i] = 0;
   do {
-    where[--i] = base64_digits[val & (uint64_t)0x3F];
+    *--p = base64_digits[val & (uint64_t)0x3F];
     val >>= 6;
   } while (val);
+  return i;
+}
+
+/* Read the base64 digits at where up to the next space or EOS.
+ * Returns the number of characters used. */
+static inline int GetBase64(int64_t* value, const char* where)
+{
+  uint64_t val = 0;
+  const char* p = where;
+  bool neg = false;
+
+  /* Check if it is negative */
+  if (*p == '-') {
+    p++;
+    neg = true;
+  }
+  /* Construct value */
+  for (uint8_t c; (c = *p) != 0 && c != ' '; p++) {
+    val = (val << 6) | base64_map[c];
+  }
+
+  *value = neg ? -(int64_t)val : (int64_t)val;
+  return p - where;
+}
+
+/* Convert a value to base64 characters.
+ * The result is stored in where, which
+ * must be at least 13 characters long.
+ *
+ * Returns the number of characters
+ * stored (not including the EOS).
+ */
+int ToBase64(int64_t value, char* where)
+{
+  int n = PutBase64(value, where);
+  where[n] = 0;
   return n;
 }
 
@@ -88,31 +116,48 @@ int ToBase64(int64_t value, char* where)
  * a value. No checking is done on the validity
  * of the characters!!
  *
- * Returns the value.
+ * Returns the number of characters used.
  */
 int FromBase64(int64_t* value, char* where)
 {
-  uint64_t val = 0;
-  int i, neg;
+  return GetBase64(value, where);
+}
 
-  if (!base64_inited) Base64Init();
-  /* Check if it is negative */
-  i = neg = 0;
-  if (where[i] == '-') {
-    i++;
-    neg = 1;
-  }
-  /* Construct value */
-  while (where[i] != 0 && where[i] != ' ') {
-    val <<= 6;
-    val += base64_map[(uint8_t)where[i++]];
+/**
+ * Convert count values to base64 numbers separated by a space, like the
+ * fields of an LStat. where must have room for 13 characters per value.
+ *
+ * Returns the number of characters stored (not including the EOS).
+ */
+int ToBase64List(const int64_t* values, int count, char* where)
+{
+  char* p = where;
+  for (int i = 0; i < count; i++) {
+    if (i > 0) { *p++ = ' '; }
+    p += PutBase64(values[i], p);
   }
+  *p = 0;
+  return p - where;
+}
 
-  *value = neg ? -(int64_t)val : (int64_t)val;
+/**
+ * Convert up to count base64 numbers separated by a space to values.
+ * No checking is done on the validity of the characters!!
+ *
+ * Returns the number of values found, the remaining ones are not touched.
+ */
+int FromBase64List(int64_t* values, int count, const char* where)
+{
+  const char* p = where;
+  int i = 0;
+  while (i < count) {
+    p += GetBase64(&values[i++], p);
+    if (*p != ' ') { break; }
+    p++;
+  }
   return i;
 }
 
-
 /**
  * Encode binary data in bin of len bytes into
  * buf as base64 characters.
@@ -177,8 +222,6 @@ int Base64ToBin(char* dest, int dest_size, char* src, int srclen)
   uint8_t* bufplain = (uint8_t*)dest;
   const uint8_t* bufin;
 
-  if (!base64_inited) Base64Init();
-
   if (dest_size < (((srclen + 3) / 4) * 3)) {
     /* dest buffer too small */
     *dest = 0;
@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2000-2006 Free Software Foundation Europe e.V.
-   Copyright (C) 2016-2021 Bareos GmbH & Co. KG
+   Copyright (C) 2016-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -32,9 +32,10 @@
 #define BASE64_SIZE(len) ((4 * len + 2) / 3 + 1)
 
 // #define BASE64_SIZE(len) (((len + 3 - (len % 3)) / 3) * 4)
-void Base64Init(void);
 int ToBase64(int64_t value, char* where);
 int FromBase64(int64_t* value, char* where);
+int ToBase64List(const int64_t* values, int count, char* where);
+int FromBase64List(int64_t* values, int count, const char* where);
 int BinToBase64(char* buf, int buflen, char* bin, int binlen, bool compatible);
 int Base64ToBin(char* dest, int destlen, char* src, int srclen);
 int Base64LengthUnpadded(int source_length);
@@ -35,8 +35,10 @@
 #include "lib/tls.h"
 #include "lib/util.h"
 #include "lib/bstringlist.h"
+#include "lib/ascii_control_characters.h"
 #include "lib/parse_conf.h"
 #include "lib/version.h"
+#include "lib/token_bucket.h"
 
 #include <algorithm>
 
@@ -80,6 +82,7 @@ BareosSocket::BareosSocket()
     , bwlimit_(0)
     , nb_bytes_(0)
     , last_tick_{0}
+    , bandwidth_bucket_(nullptr)
     , tls_established_(false)
 {
   Dmsg0(100, "Construct BareosSocket\n");
@@ -128,6 +131,7 @@ BareosSocket::BareosSocket(const BareosSocket& other)
   bwlimit_ = other.bwlimit_;
   nb_bytes_ = other.nb_bytes_;
   last_tick_ = other.last_tick_;
+  bandwidth_bucket_ = other.bandwidth_bucket_;
   tls_established_ = other.tls_established_;
 }
 
@@ -512,6 +516,7 @@ void BareosSocket::ParameterizeTlsCert(Tls* conn_init,
   conn_init->SetCipherSuites(tls_resource->ciphersuites_);
   conn_init->SetVerifyPeer(tls_resource->tls_cert_.verify_peer_);
   conn_init->SetEnableKtls(tls_resource->enable_ktls_);
+  conn_init->SetTlsSessionLifetime(tls_resource->tls_session_lifetime_);
 }
 
 bool BareosSocket::ParameterizeAndInitTlsConnectionAsAServer(
@@ -618,6 +623,12 @@ bool BareosSocket::ParameterizeAndInitTlsConnection(TlsResource* tls_resource,
     if (!initiated_by_remote) {
       const PskCredentials psk_cred(identity, password);
       tls_conn_init->SetTlsPskClientContext(psk_cred);
+      // the same identity may connect to several daemons
+      std::string session_key{identity};
+      session_key += AsciiControlCharacters::RecordSeparator();
+      session_key += host() ? host() : "";
+      session_key += ":" + std::to_string(port());
+      tls_conn_init->SetTlsSessionCacheKey(session_key);
     }
   } else {
     Dmsg2(200, "Tls is not configured %s\n", identity);
@@ -779,6 +790,11 @@ void BareosSocket::ControlBwlimit(int bytes)
   // If nothing written or read nothing todo.
   if (bytes == 0) { return; }
 
+  /* Limits shared with other connections first, the limit of this
+   * connection is applied on top of that. */
+  if (bandwidth_bucket_) { bandwidth_bucket_->Consume(bytes); }
+  if (bwlimit_ <= 0) { return; }
+
   // See if this is the first time we enter here.
   now = GetCurrentBtime();
   if (last_tick_ == 0) {
@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2000-2009 Free Software Foundation Europe e.V.
-   Copyright (C) 2016-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2016-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -56,6 +56,7 @@ struct btimer_t; /* forward reference */
 class BareosSocket;
 class Tls;
 class BStringList;
+class TokenBucket;
 class QualifiedResourceNameTypeConverter;
 template <typename T> class dlist;
 btimer_t* StartBsockTimer(BareosSocket* bs, uint32_t wait);
@@ -107,6 +108,7 @@ class BareosSocket {
   int64_t bwlimit_;      /* Set to limit bandwidth */
   int64_t nb_bytes_;     /* Bytes sent/recv since the last tick */
   btime_t last_tick_;    /* Last tick used by bwlimit */
+  TokenBucket* bandwidth_bucket_; /* Shared bandwidth limit or NULL */
   bool tls_established_; /* is true when tls connection is established */
   std::unique_ptr<BnetDump> bnet_dump_;
 
@@ -267,7 +269,8 @@ class BareosSocket {
   boffset_t get_data_end() { return data_end_; }
   int32_t get_FileIndex() { return FileIndex_; }
   void SetBwlimit(int64_t maxspeed) { bwlimit_ = maxspeed; }
-  bool UseBwlimit() { return bwlimit_ > 0; }
+  bool UseBwlimit() { return bwlimit_ > 0 || bandwidth_bucket_; }
+  void SetBandwidthBucket(TokenBucket* bucket) { bandwidth_bucket_ = bucket; }
   void SetBwlimitBursting() { use_bursting_ = true; }
   void clear_bwlimit_bursting() { use_bursting_ = false; }
   void SetSpooling() { spool_ = true; }
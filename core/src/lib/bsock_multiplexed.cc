@@ -0,0 +1,183 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Send the messages of one stream over several network connections
+ */
+
+#include "include/bareos.h"
+#include "lib/bsock_multiplexed.h"
+#include "lib/serial.h"
+
+#include <cstring>
+
+static const int debuglevel = 200;
+
+// blocks queued per connection before the stream has to wait
+static const std::size_t queued_blocks = 2;
+
+static const int32_t message_header_length = sizeof(int32_t);
+
+bool UnpackMultiplexedBlockHeader(const char* data,
+                                  int32_t length,
+                                  MultiplexedBlockHeader& header)
+{
+  if (length < kMultiplexedBlockHeaderLength) { return false; }
+
+  unser_declare;
+  UnserBegin(data, kMultiplexedBlockHeaderLength);
+  unser_uint64(header.sequence);
+  unser_uint32(header.length);
+  return true;
+}
+
+bool UnpackMultiplexedMessages(
+    const char* data,
+    uint32_t length,
+    const std::function<void(int32_t length, const char* data)>& fn)
+{
+  uint32_t offset = 0;
+  while (offset < length) {
+    if (length - offset < message_header_length) { return false; }
+
+    int32_t message_length;
+    unser_declare;
+    UnserBegin(data + offset, message_header_length);
+    unser_int32(message_length);
+    offset += message_header_length;
+
+    if (message_length < 0) {
+      fn(message_length, nullptr);
+      continue;
+    }
+    if (static_cast<uint32_t>(message_length) > length - offset) {
+      return false;
+    }
+    fn(message_length, data + offset);
+    offset += message_length;
+  }
+  return true;
+}
+
+BareosSocketMultiplexed::BareosSocketMultiplexed(
+    JobControlRecord* jcr,
+    std::vector<BareosSocket*> connections,
+    int32_t block_size)
+    : connections_{std::move(connections)}, block_size_{block_size}
+{
+  jcr_ = jcr;
+  block_.check_size(block_size_);
+  for (BareosSocket* connection : connections_) {
+    auto [in, out] = channel::CreateBufferedChannel<Block>(queued_blocks);
+    inputs_.emplace_back(std::move(in));
+    senders_.emplace_back(
+        [this, connection, blocks = std::move(out)]() mutable {
+          SendLoop(connection, std::move(blocks));
+        });
+  }
+  Dmsg2(debuglevel, "Sending stream over %zu connections in blocks of %d\n",
+        connections_.size(), block_size_);
+}
+
+BareosSocketMultiplexed::~BareosSocketMultiplexed() { Finish(); }
+
+bool BareosSocketMultiplexed::send()
+{
+  if (IsTerminated()) { return false; }
+  if (failed_) {
+    b_errno = failed_errno_;
+    errors++;
+    return false;
+  }
+
+  int32_t data_length = message_length > 0 ? message_length : 0;
+  int32_t needed = message_header_length + data_length;
+  if (block_length_ > kMultiplexedBlockHeaderLength
+      && block_length_ + needed > block_size_) {
+    SendBlock();
+  }
+
+  block_.check_size(block_length_ + needed);
+  char* pos = block_.c_str() + block_length_;
+  ser_declare;
+  SerBegin(pos, message_header_length);
+  ser_int32(message_length);
+  if (data_length > 0) {
+    memcpy(pos + message_header_length, msg, data_length);
+  }
+  block_length_ += needed;
+
+  if (UseBwlimit()) { ControlBwlimit(needed); }
+  return !failed_;
+}
+
+void BareosSocketMultiplexed::SendBlock()
+{
+  ser_declare;
+  SerBegin(block_.c_str(), kMultiplexedBlockHeaderLength);
+  ser_uint64(sequence_);
+  ser_uint32(block_length_ - kMultiplexedBlockHeaderLength);
+
+  auto& input = inputs_[sequence_ % inputs_.size()];
+  if (!input.emplace(Block{std::move(block_), block_length_})) {
+    failed_ = true;
+  }
+  sequence_++;
+
+  block_ = PoolMem(PM_MESSAGE);
+  block_.check_size(block_size_);
+  block_length_ = kMultiplexedBlockHeaderLength;
+}
+
+void BareosSocketMultiplexed::SendLoop(BareosSocket* connection,
+                                       channel::output<Block> blocks)
+{
+  POOLMEM* save = connection->msg;
+  while (std::optional<Block> block = blocks.get()) {
+    connection->msg = block->data.addr();
+    connection->message_length = block->length;
+    if (!connection->send()) {
+      failed_errno_ = connection->b_errno;
+      failed_ = true;
+      break;
+    }
+  }
+  blocks.close();
+  connection->msg = save;
+}
+
+bool BareosSocketMultiplexed::Finish()
+{
+  if (senders_.empty()) { return !failed_; }
+
+  if (block_length_ > kMultiplexedBlockHeaderLength) { SendBlock(); }
+  for (auto& input : inputs_) { input.close(); }
+  for (auto& sender : senders_) { sender.join(); }
+  senders_.clear();
+
+  Dmsg2(debuglevel, "Sent %llu blocks over %zu connections\n",
+        static_cast<unsigned long long>(sequence_), connections_.size());
+  if (failed_) {
+    b_errno = failed_errno_;
+    errors++;
+  }
+  return !failed_;
+}
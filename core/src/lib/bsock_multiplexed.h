@@ -0,0 +1,104 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Send the messages of one stream over several network connections
+ */
+
+#ifndef BAREOS_LIB_BSOCK_MULTIPLEXED_H_
+#define BAREOS_LIB_BSOCK_MULTIPLEXED_H_
+
+#include "lib/bsock_tcp.h"
+#include "lib/channel.h"
+#include "lib/mem_pool.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/* Messages are packed into numbered blocks and block n is sent over
+ * connection n % number of connections. The receiver restores the original
+ * order by reading the blocks from the connections in the same order.
+ *
+ * A block starts with its sequence number (64 bit) and the length of the
+ * packed messages (32 bit). Every packed message is its length, or a signal,
+ * (32 bit) followed by its data. All numbers are in network byte order. A
+ * block is sent as one ordinary message, so it arrives in several packets
+ * when it is larger than the maximum packet size. */
+constexpr int32_t kMultiplexedBlockHeaderLength = 12;
+
+struct MultiplexedBlockHeader {
+  uint64_t sequence{0};
+  uint32_t length{0}; /**< of the packed messages following the header */
+};
+
+bool UnpackMultiplexedBlockHeader(const char* data,
+                                  int32_t length,
+                                  MultiplexedBlockHeader& header);
+
+// Call fn for every packed message, a length < 0 is a signal
+bool UnpackMultiplexedMessages(
+    const char* data,
+    uint32_t length,
+    const std::function<void(int32_t length, const char* data)>& fn);
+
+/* Stands in for the socket of a stream while its messages are sent over the
+ * given connections. Every connection is written by its own thread, so a
+ * stalled TCP window or TLS encryption of one connection does not hold up
+ * the others. The connections are not owned and can be used again after
+ * Finish(). A bandwidth limit set on this socket applies to the stream as a
+ * whole. */
+class BareosSocketMultiplexed : public BareosSocketTCP {
+ public:
+  BareosSocketMultiplexed(JobControlRecord* jcr,
+                          std::vector<BareosSocket*> connections,
+                          int32_t block_size);
+  ~BareosSocketMultiplexed() override;
+
+  bool send() override;
+  // Send the last block and wait until all blocks are sent
+  bool Finish();
+
+  uint64_t BlocksSent() const { return sequence_; }
+
+ private:
+  struct Block {
+    PoolMem data;
+    int32_t length;
+  };
+
+  void SendBlock();
+  void SendLoop(BareosSocket* connection, channel::output<Block> blocks);
+
+  std::vector<BareosSocket*> connections_;
+  std::vector<channel::input<Block>> inputs_;
+  std::vector<std::thread> senders_;
+  const int32_t block_size_;
+  PoolMem block_{PM_MESSAGE};
+  int32_t block_length_{kMultiplexedBlockHeaderLength};
+  uint64_t sequence_{0};
+  std::atomic<bool> failed_{false};
+  std::atomic<int> failed_errno_{0};
+};
+
+#endif  // BAREOS_LIB_BSOCK_MULTIPLEXED_H_
@@ -1,7 +1,7 @@
 /*
    BAREOS® - Backup Archiving REcovery Open Sourced
 
-   Copyright (C) 2013-2021 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -33,14 +33,14 @@ class BareosSocketTCP : public BareosSocket {
    *   >= 0: the length of the message that follows
    */
   static const int32_t header_length = sizeof(int32_t);
-
- private:
   /*
    * max size of each single packet.
    * 1000000 is used by older version of Bareos/Bacula,
    * so stick to this value to be compatible with older version of bconsole.
    */
   static const int32_t max_packet_size = 1000000;
+
+ private:
   static const int32_t max_message_len = max_packet_size - header_length;
 
   /* methods -- in bsock_tcp.c */
@@ -82,10 +82,8 @@ class BareosSocketTCP : public BareosSocket {
                bool verbose) override;
   int32_t recv() override;
   bool send() override;
-  bool fsend(const char*, ...);
   int32_t read_nbytes(char* ptr, int32_t nbytes) override;
   int32_t write_nbytes(char* ptr, int32_t nbytes) override;
-  bool signal(int signal);
   void close() override;
   void destroy() override;
   int GetPeer(char* buf, socklen_t buflen) override;
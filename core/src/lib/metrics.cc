@@ -0,0 +1,244 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+#include "include/bareos.h"
+#include "include/jcr.h"
+#include "lib/metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace metrics {
+
+void LatencyHistogram::Observe(uint64_t usec)
+{
+  auto bound = std::lower_bound(kBucketBoundsUsec.begin(),
+                                kBucketBoundsUsec.end(), usec);
+  auto index = std::distance(kBucketBoundsUsec.begin(), bound);
+  buckets_[index].fetch_add(1, std::memory_order_relaxed);
+  sum_usec_.fetch_add(usec, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::CumulativeCount(std::size_t i) const
+{
+  uint64_t sum = 0;
+  for (std::size_t b = 0; b <= i && b < buckets_.size(); ++b) {
+    sum += buckets_[b].load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+static const char* TypeName(TextWriter::Type type)
+{
+  switch (type) {
+    case TextWriter::Type::kCounter:
+      return "counter";
+    case TextWriter::Type::kGauge:
+      return "gauge";
+    case TextWriter::Type::kHistogram:
+      return "histogram";
+  }
+  return "unknown";
+}
+
+// label values may contain any utf-8 character but \, " and newline
+static void AppendEscaped(std::string& out, std::string_view value)
+{
+  for (char c : value) {
+    switch (c) {
+      case '\\':
+        out += "\\\\";
+        break;
+      case '"':
+        out += "\\\"";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      default:
+        out += c;
+    }
+  }
+}
+
+void TextWriter::Family(std::string_view name,
+                        Type type,
+                        std::string_view help)
+{
+  // the Prometheus format wants the name of the samples here
+  std::string family{name};
+  if (format_ == Format::kPrometheus && type == Type::kCounter) {
+    family += "_total";
+  }
+
+  out_ += "# TYPE ";
+  out_ += family;
+  out_ += ' ';
+  out_ += TypeName(type);
+  out_ += "\n# HELP ";
+  out_ += family;
+  out_ += ' ';
+  AppendEscaped(out_, help);
+  out_ += '\n';
+}
+
+void TextWriter::WriteName(std::string_view name, const Labels& labels)
+{
+  out_ += name;
+  if (!labels.empty()) {
+    out_ += '{';
+    bool first = true;
+    for (auto& [key, value] : labels) {
+      if (!first) { out_ += ','; }
+      first = false;
+      out_ += key;
+      out_ += "=\"";
+      AppendEscaped(out_, value);
+      out_ += '"';
+    }
+    out_ += '}';
+  }
+  out_ += ' ';
+}
+
+void TextWriter::Sample(std::string_view name,
+                        const Labels& labels,
+                        uint64_t value)
+{
+  WriteName(name, labels);
+  out_ += std::to_string(value);
+  out_ += '\n';
+}
+
+void TextWriter::Sample(std::string_view name,
+                        const Labels& labels,
+                        int64_t value)
+{
+  WriteName(name, labels);
+  out_ += std::to_string(value);
+  out_ += '\n';
+}
+
+void TextWriter::Sample(std::string_view name,
+                        const Labels& labels,
+                        double value)
+{
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.6g", value);
+  WriteName(name, labels);
+  out_ += buf;
+  out_ += '\n';
+}
+
+void TextWriter::Histogram(std::string_view name,
+                           const Labels& labels,
+                           const LatencyHistogram& histogram)
+{
+  std::string bucket_name{name};
+  bucket_name += "_bucket";
+
+  const auto& bounds = LatencyHistogram::kBucketBoundsUsec;
+  for (std::size_t i = 0; i <= bounds.size(); ++i) {
+    Labels bucket_labels = labels;
+    if (i < bounds.size()) {
+      char le[32];
+      snprintf(le, sizeof(le), "%g", bounds[i] / 1'000'000.0);
+      bucket_labels.emplace_back("le", le);
+    } else {
+      bucket_labels.emplace_back("le", "+Inf");
+    }
+    Sample(bucket_name, bucket_labels, histogram.CumulativeCount(i));
+  }
+
+  std::string count_name{name};
+  count_name += "_count";
+  Sample(count_name, labels, histogram.Count());
+
+  std::string sum_name{name};
+  sum_name += "_sum";
+  Sample(sum_name, labels, histogram.SumUsec() / 1'000'000.0);
+}
+
+std::string TextWriter::Finish()
+{
+  if (format_ == Format::kOpenMetrics) { out_ += "# EOF\n"; }
+  return std::move(out_);
+}
+
+namespace {
+struct JobSample {
+  Labels labels;
+  uint64_t bytes;
+  uint64_t files;
+  int64_t queue_depth;
+  double rate;
+};
+}  // namespace
+
+void CollectJobMetrics(TextWriter& writer)
+{
+  std::vector<JobSample> samples;
+  time_t now = time(nullptr);
+  JobControlRecord* jcr;
+
+  foreach_jcr (jcr) {
+    if (jcr->JobId == 0) { continue; }
+
+    JobSample& sample = samples.emplace_back();
+    sample.labels.emplace_back("jobid", std::to_string(jcr->JobId));
+    sample.labels.emplace_back("job", jcr->Job);
+    sample.bytes = jcr->job_metrics.bytes.Get();
+    sample.files = jcr->job_metrics.files.Get();
+    sample.queue_depth = jcr->job_metrics.queue_depth.Get();
+
+    time_t started = jcr->run_time ? jcr->run_time : jcr->start_time;
+    time_t elapsed = (started && now > started) ? now - started : 1;
+    sample.rate = static_cast<double>(sample.bytes) / elapsed;
+  }
+  endeach_jcr(jcr);
+
+  writer.Family("bareos_job_bytes", TextWriter::Type::kCounter,
+                "Bytes processed by the job.");
+  for (auto& s : samples) {
+    writer.Sample("bareos_job_bytes_total", s.labels, s.bytes);
+  }
+
+  writer.Family("bareos_job_files", TextWriter::Type::kCounter,
+                "Files processed by the job.");
+  for (auto& s : samples) {
+    writer.Sample("bareos_job_files_total", s.labels, s.files);
+  }
+
+  writer.Family("bareos_job_rate_bytes_per_second", TextWriter::Type::kGauge,
+                "Average transfer rate of the job since it started.");
+  for (auto& s : samples) {
+    writer.Sample("bareos_job_rate_bytes_per_second", s.labels, s.rate);
+  }
+
+  writer.Family("bareos_job_queue_depth", TextWriter::Type::kGauge,
+                "Data messages waiting in the job's processing pipeline.");
+  for (auto& s : samples) {
+    writer.Sample("bareos_job_queue_depth", s.labels, s.queue_depth);
+  }
+}
+
+}  // namespace metrics
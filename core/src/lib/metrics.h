@@ -0,0 +1,141 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * lock-free counters and an OpenMetrics text writer
+ *
+ * The counters are meant to be updated on the hot paths (one relaxed atomic
+ * operation per update) and read only when the metrics endpoint is scraped.
+ */
+
+#ifndef BAREOS_LIB_METRICS_H_
+#define BAREOS_LIB_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace metrics {
+
+// monotonically increasing value
+class Counter {
+ public:
+  void Add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+  uint64_t Get() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> value_{0};
+};
+
+// value that can go up and down
+class Gauge {
+ public:
+  void Set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+  void Add(int64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+  void Sub(int64_t n = 1) { value_.fetch_sub(n, std::memory_order_relaxed); }
+  int64_t Get() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+// fixed bucket histogram for latencies given in microseconds
+class LatencyHistogram {
+ public:
+  static constexpr std::array<uint64_t, 14> kBucketBoundsUsec{
+      50,    100,    250,    500,    1'000,   2'500,   5'000,
+      10'000, 25'000, 50'000, 100'000, 250'000, 500'000, 1'000'000};
+
+  void Observe(uint64_t usec);
+
+  // number of observations <= kBucketBoundsUsec[i];
+  // index kBucketBoundsUsec.size() is the +Inf bucket
+  uint64_t CumulativeCount(std::size_t i) const;
+  uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+  uint64_t SumUsec() const { return sum_usec_.load(std::memory_order_relaxed); }
+
+ private:
+  std::array<std::atomic<uint64_t>, kBucketBoundsUsec.size() + 1> buckets_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_usec_{0};
+};
+
+// per job counters, embedded into the JobControlRecord
+struct JobMetrics {
+  Counter bytes;      /**< bytes sent/received/written */
+  Counter files;      /**< files processed */
+  Gauge queue_depth;  /**< messages waiting in the data pipeline */
+};
+
+using Labels = std::vector<std::pair<std::string_view, std::string>>;
+
+/* Renders metrics in the OpenMetrics text exposition format or in the older
+ * Prometheus text format 0.0.4.  All samples of one metric family have to be
+ * written directly after the corresponding Family() call.  Counter samples
+ * are named <family>_total; in the Prometheus format the family is declared
+ * under that name as well. */
+class TextWriter {
+ public:
+  enum class Type
+  {
+    kCounter,
+    kGauge,
+    kHistogram
+  };
+
+  enum class Format
+  {
+    kOpenMetrics,
+    kPrometheus
+  };
+
+  explicit TextWriter(Format format = Format::kOpenMetrics) : format_{format}
+  {
+  }
+
+  void Family(std::string_view name, Type type, std::string_view help);
+  void Sample(std::string_view name, const Labels& labels, uint64_t value);
+  void Sample(std::string_view name, const Labels& labels, int64_t value);
+  void Sample(std::string_view name, const Labels& labels, double value);
+  // writes the _bucket, _count and _sum samples of a latency histogram
+  void Histogram(std::string_view name,
+                 const Labels& labels,
+                 const LatencyHistogram& histogram);
+
+  // terminates the exposition and returns the text
+  std::string Finish();
+
+ private:
+  void WriteName(std::string_view name, const Labels& labels);
+  Format format_;
+  std::string out_;
+};
+
+// writes the JobMetrics of all currently running jobs
+void CollectJobMetrics(TextWriter& writer);
+
+}  // namespace metrics
+
+#endif  // BAREOS_LIB_METRICS_H_
@@ -0,0 +1,198 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+/* We deliberately do not use BnetThreadServerTcp() here: a scrape is a
+ * single short lived, unauthenticated http request and must never tie up
+ * one of the daemon's connection threads. */
+
+#include "include/bareos.h"
+#include "lib/address_conf.h"
+#include "lib/berrno.h"
+#include "lib/bnet_server_tcp.h"
+#include "lib/metrics.h"
+#include "lib/metrics_server.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef HAVE_POLL_H
+#  include <poll.h>
+#elif HAVE_SYS_POLL_H
+#  include <sys/poll.h>
+#endif
+
+namespace metrics {
+
+static constexpr int kRequestTimeoutSec = 5;
+static constexpr std::size_t kMaxRequestSize = 8192;
+
+static std::atomic<bool> quit{false};
+static std::thread server_thread;
+
+static bool SendAll(int fd, const std::string& data)
+{
+  std::size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) { continue; }
+    if (n <= 0) { return false; }
+    sent += n;
+  }
+  return true;
+}
+
+static void SendResponse(int fd,
+                         const char* status,
+                         const char* content_type,
+                         const std::string& body)
+{
+  std::string response = "HTTP/1.1 ";
+  response += status;
+  response += "\r\nContent-Type: ";
+  response += content_type;
+  response += "\r\nContent-Length: ";
+  response += std::to_string(body.size());
+  response += "\r\nConnection: close\r\n\r\n";
+  response += body;
+
+  SendAll(fd, response);
+}
+
+static void HandleRequest(int fd, const Collector& collector)
+{
+  struct timeval tv {
+    .tv_sec = kRequestTimeoutSec, .tv_usec = 0
+  };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, (sockopt_val_t)&tv, sizeof(tv));
+
+  std::string request;
+  char buf[1024];
+  while (request.find("\r\n\r\n") == std::string::npos
+         && request.size() < kMaxRequestSize) {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n < 0 && errno == EINTR) { continue; }
+    if (n <= 0) { break; }
+    request.append(buf, n);
+  }
+
+  std::size_t eol = request.find("\r\n");
+  if (eol == std::string::npos) { return; }
+  std::string_view request_line(request.data(), eol);
+
+  if (request_line.substr(0, 4) != "GET ") {
+    SendResponse(fd, "405 Method Not Allowed", "text/plain", "");
+    return;
+  }
+
+  std::string_view target = request_line.substr(4);
+  target = target.substr(0, target.find(' '));
+  target = target.substr(0, target.find('?'));
+  if (target != "/metrics") {
+    SendResponse(fd, "404 Not Found", "text/plain", "");
+    return;
+  }
+
+  bool openmetrics = request.find("application/openmetrics-text")
+                     != std::string::npos;
+  TextWriter writer(openmetrics ? TextWriter::Format::kOpenMetrics
+                                : TextWriter::Format::kPrometheus);
+  collector(writer);
+
+  SendResponse(fd, "200 OK",
+               openmetrics ? "application/openmetrics-text; version=1.0.0; "
+                             "charset=utf-8"
+                           : "text/plain; version=0.0.4; charset=utf-8",
+               writer.Finish());
+}
+
+static void ServeMetrics(std::vector<s_sockfd> sockets, Collector collector)
+{
+  std::vector<struct pollfd> pfds;
+  for (auto& sock : sockets) {
+    listen(sock.fd, kListenBacklog);
+    pfds.push_back({.fd = sock.fd, .events = POLLIN, .revents = 0});
+  }
+
+  while (!quit) {
+    static constexpr int timeout_ms{1000};
+
+    int status = poll(pfds.data(), pfds.size(), timeout_ms);
+    if (status <= 0) {
+      if (status < 0 && errno != EINTR) {
+        BErrNo be;
+        Emsg1(M_ERROR, 0, T_("Metrics server: error in poll: %s\n"),
+              be.bstrerror());
+        break;
+      }
+      continue;
+    }
+
+    for (auto& pfd : pfds) {
+      if (!(pfd.revents & POLLIN)) { continue; }
+
+      int fd = accept(pfd.fd, nullptr, nullptr);
+      if (fd < 0) { continue; }
+
+      HandleRequest(fd, collector);
+      close_socket(fd);
+    }
+  }
+}
+
+bool StartMetricsServer(const char* address,
+                        uint32_t port,
+                        Collector collector)
+{
+  if (port == 0 || port > 0xffff) { return false; }
+
+  dlist<IPADDR>* addrs = nullptr;
+  char errmsg[1024];
+  if (!AddAddress(&addrs, IPADDR::R_MULTIPLE, htons(port), 0, address, nullptr,
+                  errmsg, sizeof(errmsg))) {
+    Emsg2(M_ERROR, 0, T_("Cannot use metrics address %s: %s\n"), address,
+          errmsg);
+    if (addrs) { FreeAddresses(addrs); }
+    return false;
+  }
+
+  std::vector<s_sockfd> sockets = OpenAndBindSockets(addrs);
+  FreeAddresses(addrs);
+  if (sockets.empty()) { return false; }
+
+  Dmsg2(100, "Metrics server listening on %s:%u\n", address, port);
+
+  quit = false;
+  server_thread
+      = std::thread(ServeMetrics, std::move(sockets), std::move(collector));
+  return true;
+}
+
+void StopMetricsServer()
+{
+  if (!server_thread.joinable()) { return; }
+
+  quit = true;
+  server_thread.join();
+}
+
+}  // namespace metrics
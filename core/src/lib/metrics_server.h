@@ -0,0 +1,48 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * minimal http listener that serves GET /metrics
+ */
+
+#ifndef BAREOS_LIB_METRICS_SERVER_H_
+#define BAREOS_LIB_METRICS_SERVER_H_
+
+#include <cstdint>
+#include <functional>
+
+namespace metrics {
+
+class TextWriter;
+
+using Collector = std::function<void(TextWriter& writer)>;
+
+/* Start a thread that answers http requests for /metrics on address:port.
+ * The collector is called (on the server thread) once per scrape.
+ * Returns false if the address could not be bound. */
+bool StartMetricsServer(const char* address,
+                        uint32_t port,
+                        Collector collector);
+void StopMetricsServer();
+
+}  // namespace metrics
+
+#endif  // BAREOS_LIB_METRICS_SERVER_H_
@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2016-2016 Planets Communications B.V.
-   Copyright (C) 2015-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2015-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -44,6 +44,11 @@ const char* json_error_message_template
       "} "
       "}\n";
 
+#if HAVE_JANSSON
+// Streamed output is collected up to this size before it is sent.
+static constexpr std::size_t kStreamBufferSize = 64 * 1024;
+#endif
+
 OutputFormatter::OutputFormatter(SEND_HANDLER* send_func_arg,
                                  void* send_ctx_arg,
                                  FILTER_HANDLER* filter_func_arg,
@@ -178,6 +183,10 @@ void OutputFormatter::ObjectEnd(const char* name, const char* fmt)
 #if HAVE_JANSSON
     case API_MODE_JSON:
       result_stack_json->pop();
+      if (streamed_array_json
+          && result_stack_json->last() == streamed_array_json) {
+        JsonStreamArrayItems();
+      }
       Dmsg1(800, "result stack: %d\n", result_stack_json->size());
       break;
 #endif
@@ -233,7 +242,12 @@ void OutputFormatter::ArrayStart(const char* name, const char* fmt)
         return;
       } else {
         json_new = json_array();
-        json_object_set_new(json_object_current, lname.c_str(), json_new);
+        if (stream && json_object_current == result_json
+            && !streamed_array_json) {
+          JsonStreamArrayStart(lname.c_str(), json_new);
+        } else {
+          json_object_set_new(json_object_current, lname.c_str(), json_new);
+        }
         result_stack_json->push(json_new);
       }
       Dmsg1(800, "result stack: %d\n", result_stack_json->size());
@@ -255,7 +269,10 @@ void OutputFormatter::ArrayEnd(const char* name, const char* fmt)
   switch (api) {
 #if HAVE_JANSSON
     case API_MODE_JSON:
-      result_stack_json->pop();
+      if (result_stack_json->pop() == streamed_array_json
+          && streamed_array_json) {
+        JsonStreamArrayEnd();
+      }
       Dmsg1(800, "result stack: %d\n", result_stack_json->size());
       break;
 #endif
@@ -840,6 +857,7 @@ bool OutputFormatter::JsonArrayItemAdd(json_t* value)
   }
   if (json_is_array(json_array_current)) {
     json_array_append_new(json_array_current, value);
+    if (json_array_current == streamed_array_json) { JsonStreamArrayItems(); }
   } else {
     /* nameless objects only are indented to be added to arrays.
      * We do a workaround here, but this will only keep the last added
@@ -948,13 +966,58 @@ bool OutputFormatter::JsonSendErrorMessage(const char* message)
   return send_func(send_ctx, "%s", json_error_message.c_str());
 }
 
+void OutputFormatter::JsonAddMeta()
+{
+  if (!HasFilters()) { return; }
+
+  json_t* meta_obj = json_object();
+  json_object_set_new(result_json, "meta", meta_obj);
+
+  json_t* range_obj = json_object();
+
+  of_filter_tuple* tuple = nullptr;
+  foreach_alist (tuple, filters) {
+    if (tuple->type == OF_FILTER_LIMIT) {
+      json_object_set_new(range_obj, "limit",
+                          json_integer(tuple->u.limit_filter.limit));
+    }
+    if (tuple->type == OF_FILTER_OFFSET) {
+      json_object_set_new(range_obj, "offset",
+                          json_integer(tuple->u.offset_filter.offset));
+    }
+  }
+  json_object_set_new(range_obj, "filtered",
+                      json_integer(get_num_rows_filtered()));
+  json_object_set_new(meta_obj, "range", range_obj);
+}
+
+void OutputFormatter::JsonResetResult()
+{
+  while (result_stack_json->pop()) {}
+
+  json_object_clear(result_json);
+  json_decref(result_json);
+  result_json = nullptr;
+  result_json = json_object();
+  result_stack_json->push(result_json);
+
+  json_object_clear(message_object_json);
+  json_decref(message_object_json);
+  message_object_json = nullptr;
+  message_object_json = json_object();
+}
+
 void OutputFormatter::JsonFinalizeResult(bool result)
 {
+  if (stream_started) {
+    JsonStreamFinalizeResult(result);
+    JsonResetResult();
+    return;
+  }
+
   json_t* msg_obj = json_object();
   json_t* error_obj = NULL;
   json_t* data_obj = NULL;
-  json_t* meta_obj = NULL;
-  json_t* range_obj = NULL;
   PoolMem ErrorMsg;
   char* string;
 
@@ -974,27 +1037,7 @@ void OutputFormatter::JsonFinalizeResult(bool result)
     json_object_set_new(msg_obj, "error", error_obj);
   } else {
     json_object_set(msg_obj, "result", result_json);
-    if (HasFilters()) {
-      meta_obj = json_object();
-      json_object_set_new(result_json, "meta", meta_obj);
-
-      range_obj = json_object();
-
-      of_filter_tuple* tuple = nullptr;
-      foreach_alist (tuple, filters) {
-        if (tuple->type == OF_FILTER_LIMIT) {
-          json_object_set_new(range_obj, "limit",
-                              json_integer(tuple->u.limit_filter.limit));
-        }
-        if (tuple->type == OF_FILTER_OFFSET) {
-          json_object_set_new(range_obj, "offset",
-                              json_integer(tuple->u.offset_filter.offset));
-        }
-      }
-      json_object_set_new(range_obj, "filtered",
-                          json_integer(get_num_rows_filtered()));
-      json_object_set_new(meta_obj, "range", range_obj);
-    }
+    JsonAddMeta();
   }
 
   if (compact) {
@@ -1028,21 +1071,137 @@ void OutputFormatter::JsonFinalizeResult(bool result)
   }
 
   /* cleanup and reinitialize */
-  while (result_stack_json->pop()) {}
-
-  json_object_clear(result_json);
-  json_decref(result_json);
-  result_json = nullptr;
-  result_json = json_object();
-  result_stack_json->push(result_json);
-
-  json_object_clear(message_object_json);
-  json_decref(message_object_json);
-  message_object_json = nullptr;
-  message_object_json = json_object();
+  JsonResetResult();
 
   json_object_clear(msg_obj);
   json_decref(msg_obj);
   msg_obj = nullptr;
 }
+
+/* Streaming mode.
+ *
+ * The members of the result object and the items of a top level array are
+ * serialized as soon as they are complete and removed from the json tree,
+ * so only the item currently being built is kept in memory. The surrounding
+ * json-rpc message is written by hand around them. */
+
+void OutputFormatter::JsonStreamAppend(json_t* value)
+{
+  size_t flags = compact ? UA_JSON_FLAGS_COMPACT : UA_JSON_FLAGS_NORMAL;
+  char* string = json_dumps(value, flags | JSON_ENCODE_ANY);
+  if (string == NULL) {
+    Emsg0(M_ERROR, 0, "Failed to generate json string.\n");
+    return;
+  }
+  stream_buffer += string;
+  free(string);
+}
+
+void OutputFormatter::JsonStreamFlush(bool force)
+{
+  if (stream_buffer.empty()) { return; }
+  if (!force && stream_buffer.size() < kStreamBufferSize) { return; }
+
+  if (!send_func(send_ctx, "%s", stream_buffer.c_str())) {
+    Dmsg1(100, "Failed to send json message (length=%lld).\n",
+          static_cast<long long>(stream_buffer.size()));
+  }
+  stream_buffer.clear();
+}
+
+// Send all members collected in the result object so far.
+void OutputFormatter::JsonStreamResultMembers()
+{
+  const char* key;
+  json_t* value;
+
+  json_object_foreach(result_json, key, value)
+  {
+    if (stream_result_member_sent) { stream_buffer += ","; }
+    json_t* json_key = json_string(key);
+    JsonStreamAppend(json_key);
+    json_decref(json_key);
+    stream_buffer += ":";
+    JsonStreamAppend(value);
+    stream_result_member_sent = true;
+  }
+  json_object_clear(result_json);
+}
+
+void OutputFormatter::JsonStreamArrayStart(const char* name, json_t* array)
+{
+  if (!stream_started) {
+    stream_buffer += R"({"jsonrpc":"2.0","id":null,"result":{)";
+    stream_started = true;
+  }
+  JsonStreamResultMembers();
+
+  if (stream_result_member_sent) { stream_buffer += ","; }
+  json_t* json_key = json_string(name);
+  JsonStreamAppend(json_key);
+  json_decref(json_key);
+  stream_buffer += ":[";
+  stream_result_member_sent = true;
+
+  streamed_array_json = array;
+  stream_array_item_sent = false;
+}
+
+void OutputFormatter::JsonStreamArrayItems()
+{
+  size_t index;
+  json_t* value;
+
+  json_array_foreach(streamed_array_json, index, value)
+  {
+    if (stream_array_item_sent) { stream_buffer += ","; }
+    JsonStreamAppend(value);
+    stream_array_item_sent = true;
+  }
+  json_array_clear(streamed_array_json);
+
+  JsonStreamFlush(false);
+}
+
+void OutputFormatter::JsonStreamArrayEnd()
+{
+  JsonStreamArrayItems();
+  stream_buffer += "]";
+
+  json_decref(streamed_array_json);
+  streamed_array_json = nullptr;
+}
+
+void OutputFormatter::JsonStreamFinalizeResult(bool result)
+{
+  // Close an array that was left open, e.g. after a database error.
+  if (streamed_array_json) {
+    while (result_stack_json->size() > 1) { result_stack_json->pop(); }
+    JsonStreamArrayEnd();
+  }
+
+  bool failed = !result || JsonHasErrorMessage();
+  if (!failed) { JsonAddMeta(); }
+  JsonStreamResultMembers();
+  stream_buffer += "}";
+
+  /* The result has already been sent, so a failure can only be reported
+   * next to it. */
+  if (failed) {
+    json_t* error_obj = json_object();
+    json_object_set_new(error_obj, "code", json_integer(1));
+    json_object_set_new(error_obj, "message", json_string("failed"));
+    json_t* data_obj = json_object();
+    json_object_set(data_obj, "messages", message_object_json);
+    json_object_set_new(error_obj, "data", data_obj);
+    stream_buffer += R"(,"error":)";
+    JsonStreamAppend(error_obj);
+    json_decref(error_obj);
+  }
+  stream_buffer += "}";
+
+  JsonStreamFlush(true);
+  stream_started = false;
+  stream_result_member_sent = false;
+}
 #endif
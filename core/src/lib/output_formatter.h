@@ -53,6 +53,7 @@ typedef struct json_t json_t;
 #include "lib/alist.h"
 #include "lib/api_mode.h"
 #include <stdint.h>
+#include <string>
 
 class PoolMem;
 
@@ -126,10 +127,16 @@ class OutputFormatter {
   PoolMem* result_message_plain = nullptr;
   static const unsigned int max_message_length_shown_in_error = 1024;
   int num_rows_filtered = 0;
+  bool stream = false;
 #if HAVE_JANSSON
   json_t* result_json = nullptr;
   alist<json_t*>* result_stack_json = nullptr;
   json_t* message_object_json = nullptr;
+  json_t* streamed_array_json = nullptr; /* top level array being streamed */
+  bool stream_started = false; /* start of the json message already sent */
+  bool stream_result_member_sent = false;
+  bool stream_array_item_sent = false;
+  std::string stream_buffer;
 #endif
 
  private:
@@ -150,6 +157,15 @@ class OutputFormatter {
 
 #if HAVE_JANSSON
   bool JsonSendErrorMessage(const char* message);
+  void JsonAddMeta();
+  void JsonResetResult();
+  void JsonStreamAppend(json_t* value);
+  void JsonStreamFlush(bool force);
+  void JsonStreamResultMembers();
+  void JsonStreamArrayStart(const char* name, json_t* array);
+  void JsonStreamArrayItems();
+  void JsonStreamArrayEnd();
+  void JsonStreamFinalizeResult(bool result);
 #endif
 
  public:
@@ -170,6 +186,14 @@ class OutputFormatter {
   void SetCompact(bool value) { compact = value; }
   bool GetCompact() { return compact; }
 
+  /* Allow to send the items of top level arrays as soon as they are complete
+   * instead of keeping the whole result in memory. Only used for json api
+   * mode. As the result is sent before it is known whether the command
+   * succeeds, a failure is reported by an "error" member next to the
+   * "result" member. */
+  void SetStreaming(bool value) { stream = value; }
+  bool GetStreaming() { return stream; }
+
   void Decoration(const char* fmt, ...);
 
   void ArrayStart(const char* name, const char* fmt = NULL);
@@ -266,33 +266,27 @@ bool ConfigurationParser::AppendToResourcesChain(BareosResource* new_resource,
     return false;
   }
 
-  if (!config_resources_container_->configuration_resources_[rindex]) {
-    config_resources_container_->configuration_resources_[rindex]
-        = new_resource;
-    Dmsg3(900, "Inserting first %s res: %s index=%d\n", ResToStr(rcode),
-          new_resource->resource_name_, rindex);
-  } else {  // append
-    BareosResource* last = nullptr;
-    BareosResource* current
-        = config_resources_container_->configuration_resources_[rindex];
-    do {
-      if (bstrcmp(current->resource_name_, new_resource->resource_name_)) {
-        Emsg2(M_ERROR, 0,
-              T_("Attempt to define second %s resource named \"%s\" is not "
-                 "permitted.\n"),
-              resource_definitions_[rindex].name, new_resource->resource_name_);
-        return false;
-      }
-      last = current;
-      current = last->next_;
-    } while (current);
-    last->next_ = new_resource;
-    Dmsg3(900, T_("Inserting %s res: %s index=%d\n"), ResToStr(rcode),
-          new_resource->resource_name_, rindex);
+  if (config_resources_container_->Find(rindex, new_resource->resource_name_)) {
+    Emsg2(M_ERROR, 0,
+          T_("Attempt to define second %s resource named \"%s\" is not "
+             "permitted.\n"),
+          resource_definitions_[rindex].name, new_resource->resource_name_);
+    return false;
   }
+
+  config_resources_container_->Append(rindex, new_resource);
+  Dmsg3(900, T_("Inserting %s res: %s index=%d\n"), ResToStr(rcode),
+        new_resource->resource_name_, rindex);
   return true;
 }
 
+/* Rebuild the name index of a resource type, needed after resources in the
+ * chain have been renamed. */
+void ConfigurationParser::ReindexResources(int rcode)
+{
+  config_resources_container_->Reindex(rcode);
+}
+
 int ConfigurationParser::GetResourceTableIndex(const char* resource_type_name)
 {
   for (int i = 0; resource_definitions_[i].name; i++) {
@@ -513,11 +507,83 @@ ConfigurationParser::GetResourcesContainer()
   return config_resources_container_;
 }
 
+BareosResource* ConfigResourcesContainer::Find(int rindex,
+                                               const char* name) const
+{
+  if (!name) { return nullptr; }
+
+  auto& by_name = index_[rindex].by_name;
+  auto it = by_name.find(name);
+  if (it == by_name.end()) { return nullptr; }
+  if (bstrcmp(it->second->resource_name_, name)) { return it->second; }
+
+  // the indexed resource was renamed, fall back to walking the chain
+  for (BareosResource* res = configuration_resources_[rindex]; res;
+       res = res->next_) {
+    if (bstrcmp(res->resource_name_, name)) { return res; }
+  }
+  return nullptr;
+}
+
+void ConfigResourcesContainer::Append(int rindex, BareosResource* res)
+{
+  ResourceIndex& index = index_[rindex];
+
+  res->next_ = nullptr;
+  if (!configuration_resources_[rindex]) {
+    configuration_resources_[rindex] = res;
+  } else {
+    if (!index.last) { Reindex(rindex); }
+    index.last->next_ = res;
+  }
+  index.last = res;
+  index.by_name.emplace(res->resource_name_, res);
+}
+
+bool ConfigResourcesContainer::Remove(int rindex, BareosResource* res)
+{
+  BareosResource* prev = nullptr;
+  BareosResource* current = configuration_resources_[rindex];
+  while (current && current != res) {
+    prev = current;
+    current = current->next_;
+  }
+  if (!current) { return false; }
+
+  if (prev) {
+    prev->next_ = res->next_;
+  } else {
+    configuration_resources_[rindex] = res->next_;
+  }
+  res->next_ = nullptr;
+
+  ResourceIndex& index = index_[rindex];
+  if (index.last == res) { index.last = prev; }
+  for (auto it = index.by_name.begin(); it != index.by_name.end(); ++it) {
+    if (it->second == res) {
+      index.by_name.erase(it);
+      break;
+    }
+  }
+  return true;
+}
+
+void ConfigResourcesContainer::Reindex(int rindex)
+{
+  ResourceIndex& index = index_[rindex];
+  index.by_name.clear();
+  index.last = nullptr;
+  for (BareosResource* res = configuration_resources_[rindex]; res;
+       res = res->next_) {
+    if (res->resource_name_) { index.by_name.emplace(res->resource_name_, res); }
+    index.last = res;
+  }
+}
+
 
 bool ConfigurationParser::RemoveResource(int rcode, const char* name)
 {
   int rindex = rcode;
-  BareosResource* last;
 
   /* Remove resource from list.
    *
@@ -526,31 +592,13 @@ bool ConfigurationParser::RemoveResource(int rcode, const char* name)
    * For a general approach, a check if this resource is referenced by other
    * resource_definitions must be added. If it is referenced, don't remove it.
    */
-  last = nullptr;
-  for (BareosResource* res
-       = config_resources_container_->configuration_resources_[rindex];
-       res; res = res->next_) {
-    if (bstrcmp(res->resource_name_, name)) {
-      if (!last) {
-        Dmsg2(900,
-              T_("removing resource %s, name=%s (first resource in list)\n"),
-              ResToStr(rcode), name);
-        config_resources_container_->configuration_resources_[rindex]
-            = res->next_;
-      } else {
-        Dmsg2(900, T_("removing resource %s, name=%s\n"), ResToStr(rcode),
-              name);
-        last->next_ = res->next_;
-      }
-      res->next_ = nullptr;
-      FreeResourceCb_(res, rcode);
-      return true;
-    }
-    last = res;
-  }
+  BareosResource* res = config_resources_container_->Find(rindex, name);
+  if (!res) { return false; }
 
-  // Resource with this name not found
-  return false;
+  Dmsg2(900, T_("removing resource %s, name=%s\n"), ResToStr(rcode), name);
+  config_resources_container_->Remove(rindex, res);
+  FreeResourceCb_(res, rcode);
+  return true;
 }
 
 bool ConfigurationParser::DumpResources(bool sendit(void* sock,
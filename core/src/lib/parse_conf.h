@@ -39,6 +39,8 @@
 #include <functional>
 #include <memory>
 #include <map>
+#include <unordered_map>
+#include <vector>
 
 struct ResourceItem;
 class ConfigParserStateMachine;
@@ -268,6 +270,7 @@ class ConfigurationParser {
                     std::function<void()> ResourceSpecificInitializer);
   bool AppendToResourcesChain(BareosResource* new_resource, int rcode);
   bool RemoveResource(int rcode, const char* name);
+  void ReindexResources(int rcode);
   bool DumpResources(bool sendit(void* sock, const char* fmt, ...),
                      void* sock,
                      const std::string& res_type_name,
@@ -429,12 +432,21 @@ class ConfigResourcesContainer {
   std::chrono::time_point<std::chrono::system_clock> timestamp_{};
   ConfigurationParser* config_ = nullptr;
 
+  /* Name index and last element of each resource chain, so that appending
+   * and looking up resources does not have to walk the chain. */
+  struct ResourceIndex {
+    std::unordered_map<std::string, BareosResource*> by_name;
+    BareosResource* last = nullptr;
+  };
+  std::vector<ResourceIndex> index_;
+
  public:
   BareosResource** configuration_resources_ = nullptr;
   ConfigResourcesContainer(ConfigurationParser* config)
   {
     config_ = config;
     int num = config_->r_num_;
+    index_.resize(num);
     configuration_resources_
         = (BareosResource**)malloc(num * sizeof(BareosResource*));
 
@@ -457,6 +469,11 @@ class ConfigResourcesContainer {
   }
   void SetTimestampToNow() { timestamp_ = std::chrono::system_clock::now(); }
   std::string TimeStampAsString() { return TPAsString(timestamp_); }
+
+  BareosResource* Find(int rindex, const char* name) const;
+  void Append(int rindex, BareosResource* res);
+  bool Remove(int rindex, BareosResource* res);
+  void Reindex(int rindex);
 };
 
 
@@ -94,26 +94,11 @@ BareosResource* ConfigurationParser::GetResWithName(int rcode,
                                                     const char* name,
                                                     bool lock) const
 {
-  BareosResource* res;
-  int rindex = rcode;
-
   if (lock) {
     ResLocker _{this};
-
-    res = config_resources_container_->configuration_resources_[rindex];
-    while (res) {
-      if (bstrcmp(res->resource_name_, name)) { break; }
-      res = res->next_;
-    }
-  } else {
-    res = config_resources_container_->configuration_resources_[rindex];
-    while (res) {
-      if (bstrcmp(res->resource_name_, name)) { break; }
-      res = res->next_;
-    }
+    return config_resources_container_->Find(rcode, name);
   }
-
-  return res;
+  return config_resources_container_->Find(rcode, name);
 }
 
 /*
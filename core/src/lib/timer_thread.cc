@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2002-2011 Free Software Foundation Europe e.V.
-   Copyright (C) 2019-2022 Bareos GmbH & Co. KG
+   Copyright (C) 2019-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -32,7 +32,10 @@
 #include <condition_variable>
 #include <mutex>
 #include <memory>
+#include <set>
 #include <thread>
+#include <unordered_set>
+#include <utility>
 
 namespace TimerThread {
 
@@ -63,7 +66,19 @@ static std::atomic<bool> quit_timer_thread(false);
 static std::unique_ptr<std::thread> timer_thread;
 static std::mutex controlled_items_list_mutex;
 
-static std::vector<TimerThread::Timer*> controlled_items_list;
+/* All timers created by NewTimer(), and the registered ones ordered by their
+ * next run, so registering and unregistering does not depend on the number of
+ * timers. */
+static std::unordered_set<TimerThread::Timer*> controlled_items_list;
+static std::set<std::pair<std::chrono::steady_clock::time_point,
+                          TimerThread::Timer*>>
+    scheduled_items;
+
+/* Callbacks run without holding the list mutex; an item is protected from
+ * being deleted while its callback is running. */
+static TimerThread::Timer* running_item = nullptr;
+static bool running_item_unregistered = false;
+static std::condition_variable running_item_finished;
 
 bool Start(void)
 {
@@ -108,29 +123,49 @@ TimerThread::Timer* NewTimer(void)
   TimerThread::Timer* t = new TimerThread::Timer;
 
   std::lock_guard<std::mutex> l(controlled_items_list_mutex);
-  controlled_items_list.push_back(t);
+  controlled_items_list.insert(t);
 
   if (timer_thread_state != TimerThreadState::IS_RUNNING) { Start(); }
 
   return t;
 }
 
+// needs the list mutex
+static void Unschedule(TimerThread::Timer* t)
+{
+  if (t->is_active) {
+    scheduled_items.erase({t->scheduled_run_timepoint, t});
+    t->is_active = false;
+  }
+}
+
+static void DeleteTimer(TimerThread::Timer* t)
+{
+  if (t->user_destructor) { t->user_destructor(t); }
+  delete t;
+}
+
 bool RegisterTimer(TimerThread::Timer* t)
 {
   assert(t->user_callback != nullptr);
 
   TimerThread::Timer wd_copy;
+  bool runs_first;
 
   {
     std::lock_guard<std::mutex> l(controlled_items_list_mutex);
 
-    if (std::find(controlled_items_list.begin(), controlled_items_list.end(), t)
-        == controlled_items_list.end()) {
+    if (controlled_items_list.find(t) == controlled_items_list.end()) {
       return false;
     }
 
+    Unschedule(t);
     t->scheduled_run_timepoint = std::chrono::steady_clock::now() + t->interval;
     t->is_active = true;
+    scheduled_items.emplace(t->scheduled_run_timepoint, t);
+
+    // the timer thread only has to wake up earlier for the first item
+    runs_first = scheduled_items.begin()->second == t;
 
     wd_copy = *t;
   }
@@ -138,49 +173,61 @@ bool RegisterTimer(TimerThread::Timer* t)
   Dmsg3(800, "Registered timer interval %d%s\n", wd_copy.interval,
         wd_copy.single_shot ? " one shot" : "");
 
-  WakeTimer();
+  if (runs_first) { WakeTimer(); }
 
   return true;
 }
 
 bool UnregisterTimer(TimerThread::Timer* t)
 {
-  std::lock_guard<std::mutex> l(controlled_items_list_mutex);
-
-  auto pos = std::find(controlled_items_list.begin(),
-                       controlled_items_list.end(), t);
+  std::unique_lock<std::mutex> l(controlled_items_list_mutex);
 
-  if (pos != controlled_items_list.end()) {
-    if ((*pos)->user_destructor) { (*pos)->user_destructor((*pos)); }
-    delete (*pos);
-    controlled_items_list.erase(pos);
-    Dmsg1(800, "Unregistered timer %p\n", t);
-    return true;
-  } else {
+  if (controlled_items_list.find(t) == controlled_items_list.end()) {
     Dmsg1(800, "Failed to unregister timer %p\n", t);
     return false;
   }
+
+  if (t == running_item) {
+    if (CurrentThreadIsTimerThread()) {
+      // called from its own callback, deleted when the callback returns
+      running_item_unregistered = true;
+      Dmsg1(800, "Unregistered timer %p\n", t);
+      return true;
+    }
+    running_item_finished.wait(l, [t]() { return running_item != t; });
+    if (controlled_items_list.find(t) == controlled_items_list.end()) {
+      Dmsg1(800, "Failed to unregister timer %p\n", t);
+      return false;
+    }
+  }
+
+  Unschedule(t);
+  controlled_items_list.erase(t);
+  l.unlock();
+
+  Dmsg1(800, "Unregistered timer %p\n", t);
+  DeleteTimer(t);
+  return true;
 }
 
 bool IsRegisteredTimer(const TimerThread::Timer* t)
 {
   std::lock_guard<std::mutex> l(controlled_items_list_mutex);
 
-  auto pos = std::find(controlled_items_list.begin(),
-                       controlled_items_list.end(), t);
-
-  return pos != controlled_items_list.end();
+  return controlled_items_list.find(const_cast<TimerThread::Timer*>(t))
+         != controlled_items_list.end();
 }
 
 static void Cleanup()
 {
-  std::lock_guard<std::mutex> l(controlled_items_list_mutex);
-
-  for (auto p : controlled_items_list) {
-    if (p->user_destructor) { p->user_destructor(p); }
-    delete p;
+  std::unordered_set<TimerThread::Timer*> items;
+  {
+    std::lock_guard<std::mutex> l(controlled_items_list_mutex);
+    std::swap(items, controlled_items_list);
+    scheduled_items.clear();
   }
-  controlled_items_list.clear();
+
+  for (auto p : items) { DeleteTimer(p); }
 }
 
 static void SleepUntil(std::chrono::steady_clock::time_point next_timer_run)
@@ -197,42 +244,49 @@ static void LogMessage(TimerThread::Timer* p)
         p->scheduled_run_timepoint);
 }
 
-static bool RunOneItem(TimerThread::Timer* p,
-                       std::chrono::steady_clock::time_point& next_timer_run)
+/* Runs the callback of every item that is due, and returns when the next
+ * item will be due. */
+static std::chrono::steady_clock::time_point RunDueItems()
 {
-  std::chrono::time_point<std::chrono::steady_clock> last_timer_run_timepoint
-      = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> l(controlled_items_list_mutex);
 
-  bool remove_from_list = false;
-  next_timer_run = min(p->scheduled_run_timepoint, next_timer_run);
-  if (p->is_active && last_timer_run_timepoint > p->scheduled_run_timepoint) {
-    LogMessage(p);
-    p->user_callback(p);
-    if (p->single_shot) {
-      if (p->user_destructor) { p->user_destructor(p); }
-      delete p;
-      remove_from_list = true;
-    } else {
-      p->scheduled_run_timepoint = last_timer_run_timepoint + p->interval;
-    }
-  }
-  return remove_from_list;
-}
+  for (;;) {
+    std::chrono::steady_clock::time_point now
+        = std::chrono::steady_clock::now();
+    calendar_time_on_last_timer_run = time(nullptr);
 
-static void RunAllItemsAndRemoveOneShotItems(
-    std::chrono::steady_clock::time_point& next_timer_run)
-{
-  std::unique_lock<std::mutex> l(controlled_items_list_mutex);
+    std::chrono::steady_clock::time_point next_timer_run
+        = now + idle_timeout_interval_milliseconds;
+    if (scheduled_items.empty()) { return next_timer_run; }
+
+    TimerThread::Timer* p = scheduled_items.begin()->second;
+    if (p->scheduled_run_timepoint >= now) {
+      return std::min(p->scheduled_run_timepoint, next_timer_run);
+    }
 
-  auto new_end_of_vector = std::remove_if(  // one_shot items will be removed
-      controlled_items_list.begin(), controlled_items_list.end(),
-      [&next_timer_run](TimerThread::Timer* p) {
-        calendar_time_on_last_timer_run = time(nullptr);
+    Unschedule(p);
+    running_item = p;
+    running_item_unregistered = false;
+    l.unlock();
 
-        return RunOneItem(p, next_timer_run);
-      });
+    LogMessage(p);
+    p->user_callback(p);
 
-  controlled_items_list.erase(new_end_of_vector, controlled_items_list.end());
+    l.lock();
+    running_item = nullptr;
+    if (p->single_shot || running_item_unregistered) {
+      Unschedule(p);
+      controlled_items_list.erase(p);
+      l.unlock();
+      DeleteTimer(p);
+      l.lock();
+    } else if (!p->is_active) {  // the callback may have registered it again
+      p->scheduled_run_timepoint = now + p->interval;
+      p->is_active = true;
+      scheduled_items.emplace(p->scheduled_run_timepoint, p);
+    }
+    running_item_finished.notify_all();
+  }
 }
 
 static void TimerThread(void)
@@ -243,12 +297,7 @@ static void TimerThread(void)
   timer_thread_state = TimerThreadState::IS_RUNNING;
 
   while (!quit_timer_thread) {
-    std::chrono::steady_clock::time_point next_timer_run
-        = std::chrono::steady_clock::now() + idle_timeout_interval_milliseconds;
-
-    RunAllItemsAndRemoveOneShotItems(next_timer_run);
-
-    SleepUntil(next_timer_run);
+    SleepUntil(RunDueItems());
   }  // while (!quit_timer_thread)
 
   Cleanup();
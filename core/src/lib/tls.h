@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2005-2009 Free Software Foundation Europe e.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version two of the GNU Lesser General
@@ -80,6 +80,15 @@ class Tls {
 
   virtual bool KtlsSendStatus() = 0;
   virtual bool KtlsRecvStatus() = 0;
+  virtual bool TlsBsockPending() = 0;
+  /* Reads up to nbytes without waiting for the peer: returns the number of
+   * bytes read, 0 if nothing arrived yet and -1 on errors or end of file */
+  virtual int TlsBsockReadAvailable(BareosSocket* bsock,
+                                    char* ptr,
+                                    int32_t nbytes)
+      = 0;
+  // client side: the handshake resumed a session of an earlier connection
+  virtual bool TlsSessionResumed() const = 0;
 
   virtual void Setca_certfile_(const std::string& ca_certfile) = 0;
   virtual void SetCaCertdir(const std::string& ca_certdir) = 0;
@@ -91,6 +100,8 @@ class Tls {
   virtual void SetDhFile(const std::string& dhfile_) = 0;
   virtual void SetVerifyPeer(const bool& verify_peer) = 0;
   virtual void SetEnableKtls(bool ktls) = 0;
+  virtual void SetTlsSessionLifetime(utime_t lifetime) = 0;
+  virtual void SetTlsSessionCacheKey(const std::string& key) = 0;
   virtual void SetTcpFileDescriptor(const int& fd) = 0;
 };
 
@@ -1,7 +1,7 @@
 /*
    BAREOS® - Backup Archiving REcovery Open Sourced
 
-   Copyright (C) 2018-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2018-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -48,6 +48,7 @@ class TlsResource {
   bool tls_enable_{false};
   bool tls_require_{false};
   bool enable_ktls_{false}; /* enable support for ktls */
+  utime_t tls_session_lifetime_{0}; /* resume TLS sessions for this long */
 
   bool IsTlsConfigured() const;
   TlsPolicy GetPolicy() const;
@@ -346,4 +346,19 @@ bool TlsOpenSsl::KtlsSendStatus() { return d_->KtlsSendStatus(); }
 
 bool TlsOpenSsl::KtlsRecvStatus() { return d_->KtlsRecvStatus(); }
 
+// Decrypted data that was already read from the socket but not yet consumed
+bool TlsOpenSsl::TlsBsockPending()
+{
+  return d_->openssl_ && SSL_pending(d_->openssl_) > 0;
+}
+
+int TlsOpenSsl::TlsBsockReadAvailable(BareosSocket* bsock,
+                                      char* ptr,
+                                      int32_t nbytes)
+{
+  return d_->OpensslBsockReadAvailable(bsock, ptr, nbytes);
+}
+
+bool TlsOpenSsl::TlsSessionResumed() const { return d_->session_resumed_; }
+
 #endif /* HAVE_TLS  && HAVE_OPENSSL */
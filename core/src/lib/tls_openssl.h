@@ -1,7 +1,7 @@
 /*
    BAREOS® - Backup Archiving REcovery Open Sourced
 
-   Copyright (C) 2018-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2018-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -70,10 +70,17 @@ class TlsOpenSsl : public Tls {
   void SetDhFile(const std::string& dhfile_) override;
   void SetVerifyPeer(const bool& verify_peer) override;
   void SetEnableKtls(bool ktls) override;
+  void SetTlsSessionLifetime(utime_t lifetime) override;
+  void SetTlsSessionCacheKey(const std::string& key) override;
   void SetTcpFileDescriptor(const int& fd) override;
 
   bool KtlsSendStatus() override;
   bool KtlsRecvStatus() override;
+  bool TlsBsockPending() override;
+  int TlsBsockReadAvailable(BareosSocket* bsock,
+                            char* ptr,
+                            int32_t nbytes) override;
+  bool TlsSessionResumed() const override;
 
  private:
   std::unique_ptr<TlsOpenSslPrivate> d_; /* private data */
@@ -37,6 +37,7 @@
 #include "include/allow_deprecated.h"
 
 #include <openssl/err.h>
+#include <openssl/rand.h>
 #include <openssl/ssl.h>
 #include <algorithm>
 #include <array>
@@ -49,6 +50,19 @@ static synchronized<std::unordered_map<const SSL_CTX*, PskCredentials>>
     client_cred;
 static std::mutex file_access_mutex_;
 
+namespace {
+struct CachedTlsSession {
+  SSL_SESSION* session{};
+  time_t expires{};
+};
+}  // namespace
+
+/* Client side TLS sessions for resumption, keyed by the qualified resource
+ * name and the address of the peer. The sessions are intentionally not freed
+ * on exit, as OpenSSL may already be deinitialized by then. */
+static synchronized<std::unordered_map<std::string, CachedTlsSession>>
+    session_cache;
+
 /* No anonymous ciphers, no <128 bit ciphers, no export ciphers, no MD5 ciphers
  */
 static constexpr std::string_view tls_default_ciphers_{
@@ -103,6 +117,11 @@ TlsOpenSslPrivate::~TlsOpenSslPrivate()
     openssl_ = nullptr;
   }
 
+  if (offered_session_) {
+    SSL_SESSION_free(offered_session_);
+    offered_session_ = nullptr;
+  }
+
   /* the openssl_ctx object is the factory that creates
    * openssl objects, so delete this at the end */
   if (openssl_ctx_) {
@@ -247,12 +266,16 @@ bool TlsOpenSslPrivate::init()
     SSL_CTX_set_verify(openssl_ctx_, SSL_VERIFY_NONE, NULL);
   }
 
+  if (!SetupSessionResumption()) { return false; }
+
   openssl_ = SSL_new(openssl_ctx_);
   if (!openssl_) {
     OpensslPostErrors(M_FATAL, T_("Error creating new SSL object"));
     return false;
   }
 
+  ResumeCachedSession();
+
   /* Non-blocking partial writes */
   SSL_set_mode(openssl_, SSL_MODE_ENABLE_PARTIAL_WRITE
                              | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
@@ -375,6 +398,32 @@ cleanup:
   return nbytes - nleft;
 }
 
+int TlsOpenSslPrivate::OpensslBsockReadAvailable(BareosSocket* bsock,
+                                                char* ptr,
+                                                int nbytes)
+{
+  if (!openssl_) { return -1; }
+
+  int flags = bsock->SetNonblocking();
+  int nread = SSL_read(openssl_, ptr, nbytes);
+  int ssl_error = SSL_get_error(openssl_, nread);
+  bsock->RestoreBlocking(flags);
+
+  switch (ssl_error) {
+    case SSL_ERROR_NONE:
+      return nread;
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+      return 0;
+    case SSL_ERROR_SYSCALL:
+      if (nread == -1 && (errno == EINTR || errno == EAGAIN)) { return 0; }
+      [[fallthrough]];
+    default:
+      ERR_clear_error();
+      return -1;
+  }
+}
+
 bool TlsOpenSslPrivate::OpensslBsockSessionStart(BareosSocket* bsock,
                                                  bool server)
 {
@@ -398,6 +447,11 @@ bool TlsOpenSslPrivate::OpensslBsockSessionStart(BareosSocket* bsock,
     switch (ssl_error) {
       case SSL_ERROR_NONE:
         bsock->SetTlsEstablished();
+        /* a TLS 1.3 handshake with an external PSK also counts as reused,
+         * so check that the server took the session that we offered */
+        session_resumed_ = offered_session_ && SSL_session_reused(openssl_)
+                           && SSL_get_session(openssl_) == offered_session_;
+        if (session_resumed_) { Dmsg0(100, "TLS session resumed\n"); }
         status = true;
         goto cleanup;
       case SSL_ERROR_ZERO_RETURN:
@@ -459,6 +513,118 @@ bool TlsOpenSslPrivate::KtlsRecvStatus()
 #endif
 }
 
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+/* Every connection has its own SSL_CTX, so all of them have to encrypt their
+ * session tickets with the same keys for a ticket to be accepted by a later
+ * connection. The keys are created once per process. */
+static std::array<unsigned char, 80>* SessionTicketKeys()
+{
+  static std::array<unsigned char, 80> keys{};
+  static bool have_keys
+      = RAND_bytes(keys.data(), static_cast<int>(keys.size())) == 1;
+  return have_keys ? &keys : nullptr;
+}
+#endif
+
+bool TlsOpenSslPrivate::SetupSessionResumption()
+{
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+  if (session_lifetime_ <= 0) {
+    // nobody would be able to use the tickets
+    SSL_CTX_set_options(openssl_ctx_, SSL_OP_NO_TICKET);
+    SSL_CTX_set_num_tickets(openssl_ctx_, 0);
+    return true;
+  }
+
+  auto* keys = SessionTicketKeys();
+  if (!keys) {
+    OpensslPostErrors(M_ERROR, T_("Error creating TLS session ticket keys"));
+    return false;
+  }
+  SSL_CTX_set_tlsext_ticket_keys(openssl_ctx_, keys->data(), keys->size());
+
+  SSL_CTX_set_timeout(openssl_ctx_, static_cast<long>(session_lifetime_));
+
+  // tickets are stateless, neither side needs OpenSSL's internal cache
+  if (session_cache_key_.empty()) {
+    /* Required to resume sessions with peer verification. Only the server
+     * may set it, a client would reject its own TLS-PSK sessions. */
+    static constexpr std::string_view session_id_context{"bareos"};
+    SSL_CTX_set_session_id_context(
+        openssl_ctx_,
+        reinterpret_cast<const unsigned char*>(session_id_context.data()),
+        session_id_context.size());
+    SSL_CTX_set_session_cache_mode(openssl_ctx_, SSL_SESS_CACHE_OFF);
+  } else {
+    SSL_CTX_set_session_cache_mode(
+        openssl_ctx_, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_set_ex_data(openssl_ctx_, SslCtxExDataIndex::kTlsOpenSslPrivatePtr,
+                        this);
+    SSL_CTX_sess_set_new_cb(openssl_ctx_, TlsOpenSslPrivate::new_session_cb);
+  }
+#else
+  if (session_lifetime_ > 0) {
+    Dmsg0(100, "TLS session resumption needs OpenSSL 1.1.1 or newer\n");
+  }
+#endif
+  return true;
+}
+
+void TlsOpenSslPrivate::ResumeCachedSession()
+{
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+  if (session_lifetime_ <= 0 || session_cache_key_.empty()) { return; }
+
+  auto locked = session_cache.lock();
+  auto iter = locked->find(session_cache_key_);
+  if (iter == locked->end()) { return; }
+
+  CachedTlsSession& cached = iter->second;
+  if (time(nullptr) >= cached.expires
+      || !SSL_SESSION_is_resumable(cached.session)) {
+    SSL_SESSION_free(cached.session);
+    locked->erase(iter);
+    return;
+  }
+
+  if (SSL_set_session(openssl_, cached.session) != 1) {
+    Dmsg0(100, "Could not set cached TLS session\n");
+    ERR_clear_error();
+    return;
+  }
+  SSL_SESSION_up_ref(cached.session);
+  offered_session_ = cached.session;
+#endif
+}
+
+int TlsOpenSslPrivate::new_session_cb(SSL* ssl, SSL_SESSION* session)
+{
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+  auto* priv = static_cast<TlsOpenSslPrivate*>(SSL_CTX_get_ex_data(
+      SSL_get_SSL_CTX(ssl), SslCtxExDataIndex::kTlsOpenSslPrivatePtr));
+  if (!priv || !SSL_SESSION_is_resumable(session)) { return 0; }
+
+  // the peer may want us to forget the ticket earlier than configured
+  utime_t lifetime = priv->session_lifetime_;
+  if (auto hint = SSL_SESSION_get_ticket_lifetime_hint(session); hint > 0) {
+    lifetime = std::min(lifetime, static_cast<utime_t>(hint));
+  }
+
+  auto locked = session_cache.lock();
+  CachedTlsSession& cached = (*locked)[priv->session_cache_key_];
+  if (cached.session) { SSL_SESSION_free(cached.session); }
+  cached.session = session;
+  cached.expires = time(nullptr) + lifetime;
+
+  // we keep the reference that was passed to us
+  return 1;
+#else
+  (void)ssl;
+  (void)session;
+  return 0;
+#endif
+}
+
 int TlsOpenSslPrivate::tls_pem_callback_dispatch(char* buf,
                                                  int size,
                                                  int,
@@ -627,6 +793,17 @@ void TlsOpenSsl::SetEnableKtls(bool ktls)
   d_->enable_ktls_ = ktls;
 }
 
+void TlsOpenSsl::SetTlsSessionLifetime(utime_t lifetime)
+{
+  Dmsg1(100, "Set session lifetime:\t<%lld>\n", lifetime);
+  d_->session_lifetime_ = lifetime;
+}
+
+void TlsOpenSsl::SetTlsSessionCacheKey(const std::string& key)
+{
+  d_->session_cache_key_ = key;
+}
+
 void TlsOpenSsl::SetTcpFileDescriptor(const int& fd)
 {
   Dmsg1(100, "Set tcp filedescriptor: <%d>\n", fd);
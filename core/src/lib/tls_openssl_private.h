@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2005-2010 Free Software Foundation Europe e.V.
-   Copyright (C) 2018-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2018-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -39,18 +39,23 @@ class TlsOpenSslPrivate {
 
   enum SslCtxExDataIndex : int
   {
-    kConfigurationParserPtr = 0
+    kConfigurationParserPtr = 0,
+    kTlsOpenSslPrivatePtr = 1
   };
 
   int OpensslBsockReadwrite(BareosSocket* bsock,
                             char* ptr,
                             int nbytes,
                             bool write);
+  int OpensslBsockReadAvailable(BareosSocket* bsock, char* ptr, int nbytes);
   bool OpensslBsockSessionStart(BareosSocket* bsock, bool server);
 
   bool KtlsSendStatus();
   bool KtlsRecvStatus();
 
+  bool SetupSessionResumption();
+  void ResumeCachedSession();
+
   void ClientContextInsertCredentials(const PskCredentials& cred);
   void ServerContextInsertCredentials(const PskCredentials& cred);
 
@@ -60,6 +65,7 @@ class TlsOpenSslPrivate {
                                        int rwflag,
                                        void* userdata);
   static int OpensslVerifyPeer(int ok, X509_STORE_CTX* store);
+  static int new_session_cb(SSL* ssl, SSL_SESSION* session);
   static unsigned int psk_server_cb(SSL* ssl,
                                     const char* identity,
                                     unsigned char* psk,
@@ -93,6 +99,10 @@ class TlsOpenSslPrivate {
   std::string ciphersuites_;
   bool verify_peer_{};
   bool enable_ktls_{false};
+  utime_t session_lifetime_{0};
+  std::string session_cache_key_; /* empty on the server side */
+  SSL_SESSION* offered_session_{};
+  bool session_resumed_{false};
   std::shared_ptr<ConfigResourcesContainer>
       config_table_{};  // config table being used
 };
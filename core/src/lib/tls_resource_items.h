@@ -38,6 +38,9 @@
   { "EnableKtls", CFG_TYPE_BOOL, ITEM(res, enable_ktls_), 0, CFG_ITEM_DEFAULT, "false", \
      NULL, "If set to \"yes\", Bareos will allow the SSL implementation to use " \
      "Kernel TLS. " }, \
+  { "TlsSessionLifetime", CFG_TYPE_TIME, ITEM(res, tls_session_lifetime_), 0, CFG_ITEM_DEFAULT, "0", \
+     NULL, "How long a TLS session can be resumed by later connections to the same peer, " \
+     "skipping the full TLS handshake. 0 disables session resumption." }, \
   { "TlsCipherList", CFG_TYPE_STDSTR, ITEM(res, cipherlist_), 0, CFG_ITEM_PLATFORM_SPECIFIC, NULL, \
      NULL, "Colon separated list of valid TLSv1.2 and lower Ciphers; see \"openssl ciphers\" command." \
      " Leftmost element has the highest priority."}, \
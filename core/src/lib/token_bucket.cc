@@ -0,0 +1,67 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+
+#include "lib/token_bucket.h"
+
+#include <algorithm>
+#include <thread>
+
+void TokenBucket::SetRate(int64_t rate)
+{
+  std::lock_guard l(mutex_);
+  rate_ = rate;
+}
+
+TokenBucket::clock::duration TokenBucket::ReserveHere(int64_t bytes,
+                                                      clock::time_point now)
+{
+  bytes_ += bytes;
+
+  std::lock_guard l(mutex_);
+  int64_t rate = rate_;
+  if (rate <= 0) { return clock::duration::zero(); }
+
+  /* Capacity not used in the past is lost, except for what fits into the
+   * burst window. */
+  next_free_ = std::max(next_free_, now - kBurstTime);
+  next_free_ += std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>(static_cast<double>(bytes) / rate));
+
+  return std::max(next_free_ - now, clock::duration::zero());
+}
+
+TokenBucket::clock::duration TokenBucket::Reserve(int64_t bytes,
+                                                  clock::time_point now)
+{
+  auto wait = clock::duration::zero();
+  if (bytes <= 0) { return wait; }
+
+  for (TokenBucket* bucket = this; bucket; bucket = bucket->parent_) {
+    wait = std::max(wait, bucket->ReserveHere(bytes, now));
+  }
+  return wait;
+}
+
+void TokenBucket::Consume(int64_t bytes)
+{
+  auto wait = Reserve(bytes, clock::now());
+  if (wait > clock::duration::zero()) { std::this_thread::sleep_for(wait); }
+}
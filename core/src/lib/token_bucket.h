@@ -0,0 +1,82 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * hierarchical token buckets for bandwidth shaping
+ */
+
+#ifndef BAREOS_LIB_TOKEN_BUCKET_H_
+#define BAREOS_LIB_TOKEN_BUCKET_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * A token bucket limiting the rate of bytes passing through it.
+ *
+ * Buckets can be chained: every byte consumed from a bucket is also consumed
+ * from all of its parents, so e.g. several jobs can share the limit of the
+ * whole daemon. Capacity is reserved at the time of the call and callers
+ * then sleep until their reservation is due, so concurrent senders are
+ * served in the order they asked and each of them gets a fair share of a
+ * contended parent.
+ *
+ * A rate of 0 means unlimited; such a bucket only counts the bytes.
+ */
+class TokenBucket {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  // how much unused capacity may be saved up for a burst
+  static constexpr std::chrono::milliseconds kBurstTime{100};
+
+  explicit TokenBucket(int64_t rate = 0, TokenBucket* parent = nullptr)
+      : rate_(rate), parent_(parent)
+  {
+  }
+  TokenBucket(const TokenBucket&) = delete;
+  TokenBucket& operator=(const TokenBucket&) = delete;
+
+  void SetRate(int64_t rate);
+  int64_t GetRate() const { return rate_; }
+  TokenBucket* GetParent() const { return parent_; }
+  uint64_t GetBytes() const { return bytes_; }
+
+  // Account bytes on this bucket and all its parents; return when allowed.
+  void Consume(int64_t bytes);
+
+  /* Like Consume() but does not sleep: returns how long the caller has to
+   * wait before the bytes may be sent. */
+  clock::duration Reserve(int64_t bytes, clock::time_point now);
+
+ private:
+  clock::duration ReserveHere(int64_t bytes, clock::time_point now);
+
+  std::mutex mutex_;
+  std::atomic<int64_t> rate_; /**< bytes per second, 0 is unlimited */
+  TokenBucket* parent_;
+  std::atomic<uint64_t> bytes_{0}; /**< total bytes consumed */
+  clock::time_point next_free_{};  /**< when all reservations are done */
+};
+
+#endif  // BAREOS_LIB_TOKEN_BUCKET_H_
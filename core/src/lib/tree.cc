@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2002-2012 Free Software Foundation Europe e.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -29,6 +29,13 @@
 #include "lib/tree.h"
 #include "lib/util.h"
 #include "lib/fnmatch.h"
+#include "lib/berrno.h"
+
+#if !defined(HAVE_WIN32)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
 
 #define B_PAGE_SIZE 4096
 #define MAX_PAGES 2400
@@ -51,12 +58,77 @@ template <typename T> static T* tree_alloc(TREE_ROOT* root, int size);
 #define Dmsg2(n, f, a1, a2)
 #define Dmsg3(n, f, a1, a2, a3)
 
+/* The spool file is only used where its space can be reserved, writing to
+ * a page of a sparse file on a full disk raises SIGBUS. */
+#if !defined(HAVE_WIN32) && defined(HAVE_POSIX_FALLOCATE)
+// Map the next size bytes of the spool file, size is rounded up to full pages.
+static struct s_mem* MapBuf(TREE_ROOT* root, uint32_t& size)
+{
+  static const uint32_t page_size = sysconf(_SC_PAGESIZE);
+  size = (size + page_size - 1) / page_size * page_size;
+
+  off_t offset = root->spool_size;
+  if (int error = posix_fallocate(root->spool_fd, offset, size); error != 0) {
+    BErrNo be;
+    be.SetErrno(error);
+    Dmsg1(100, "Cannot grow restore tree spool file: ERR=%s\n",
+          be.bstrerror());
+    return nullptr;
+  }
+
+  void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    root->spool_fd, offset);
+  if (addr == MAP_FAILED) {
+    BErrNo be;
+    Dmsg1(100, "Cannot map restore tree spool file: ERR=%s\n",
+          be.bstrerror());
+    return nullptr;
+  }
+  root->spool_size += size;
+  return static_cast<struct s_mem*>(addr);
+}
+
+static void UnmapBuf(struct s_mem* mem) { munmap(mem, mem->size); }
+
+static int OpenSpoolFile(const char* spool_directory)
+{
+  PoolMem fname(PM_FNAME);
+  Mmsg(fname, "%s/bareos-restore-tree.XXXXXX", spool_directory);
+  int fd = mkstemp(fname.c_str());
+  if (fd < 0) {
+    BErrNo be;
+    Emsg2(M_WARNING, 0,
+          T_("Cannot create restore tree spool file %s, keeping the tree in "
+             "memory: ERR=%s\n"),
+          fname.c_str(), be.bstrerror());
+    return -1;
+  }
+  // nobody else needs to see it, the space is freed when we close it
+  unlink(fname.c_str());
+  return fd;
+}
+
+static void CloseSpoolFile(int fd) { close(fd); }
+#else
+static struct s_mem* MapBuf(TREE_ROOT*, uint32_t&) { return nullptr; }
+static void UnmapBuf(struct s_mem*) {}
+static int OpenSpoolFile(const char*) { return -1; }
+static void CloseSpoolFile(int) {}
+#endif
+
 // This subroutine gets a big buffer.
-static void MallocBuf(TREE_ROOT* root, int size)
+static void MallocBuf(TREE_ROOT* root, uint32_t size)
 {
-  struct s_mem* mem;
+  struct s_mem* mem = nullptr;
 
-  mem = (struct s_mem*)malloc(size);
+  if (root->spool_fd >= 0) { mem = MapBuf(root, size); }
+  if (mem) {
+    mem->mapped = true;
+  } else {
+    mem = (struct s_mem*)malloc(size);
+    mem->mapped = false;
+  }
+  mem->size = size;
   root->total_size += size;
   root->blocks++;
   mem->next = root->mem;
@@ -72,7 +144,7 @@ static void MallocBuf(TREE_ROOT* root, int size)
  * than 100 times as fast as directly using malloc()
  * for each of the nodes.
  */
-TREE_ROOT* new_tree(int count)
+TREE_ROOT* new_tree(int count, const char* spool_directory)
 {
   TREE_ROOT* root;
   uint32_t size;
@@ -87,6 +159,7 @@ TREE_ROOT* new_tree(int count)
   size = count * (BALIGN(sizeof(TREE_NODE)) + 40);
   if (count > 1000000 || size > (MAX_BUF_SIZE / 2)) { size = MAX_BUF_SIZE; }
   Dmsg2(400, "count=%d size=%d\n", count, size);
+  if (spool_directory) { root->spool_fd = OpenSpoolFile(spool_directory); }
   MallocBuf(root, size);
   root->cached_path_len = -1;
   root->cached_path = GetPoolMemory(PM_FNAME);
@@ -159,8 +232,13 @@ void FreeTree(TREE_ROOT* root)
   for (mem = root->mem; mem;) {
     rel = mem;
     mem = mem->next;
-    free(rel);
+    if (rel->mapped) {
+      UnmapBuf(rel);
+    } else {
+      free(rel);
+    }
   }
+  if (root->spool_fd >= 0) { CloseSpoolFile(root->spool_fd); }
   if (root->cached_path) {
     FreePoolMemory(root->cached_path);
     root->cached_path = NULL;
@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2002-2009 Free Software Foundation Europe e.V.
-   Copyright (C) 2016-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2016-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -37,6 +37,8 @@ struct s_mem {
   struct s_mem* next; /* next buffer */
   int rem;            /* remaining bytes */
   void* mem;          /* memory pointer */
+  uint32_t size;      /* size of the buffer */
+  bool mapped;        /* buffer is mapped from the spool file */
   char first[1];      /* first byte */
 };
 
@@ -139,12 +141,14 @@ struct s_tree_root {
   struct s_tree_node* first{}; /* first entry in the tree */
   struct s_tree_node* last{};  /* last entry in tree */
   struct s_mem* mem{};         /* tree memory */
-  uint32_t total_size{};       /* total bytes allocated */
+  uint64_t total_size{};       /* total bytes allocated */
   uint32_t blocks{};           /* total mallocs */
   int cached_path_len{};       /* length of cached path */
   char* cached_path{};         /* cached current path */
   TREE_NODE* cached_parent{};  /* cached parent for above path */
   HardlinkTable hardlinks;     /* references to first occurence of hardlinks */
+  int spool_fd{-1};            /* file the tree memory is mapped from */
+  uint64_t spool_size{};       /* bytes used in the spool file */
 };
 typedef struct s_tree_root TREE_ROOT;
 
@@ -156,7 +160,10 @@ typedef struct s_tree_root TREE_ROOT;
 #define TN_FILE 5    /* file entry */
 
 /* External interface */
-TREE_ROOT* new_tree(int count);
+/* When spool_directory is given, the memory of the tree is mapped from an
+ * (unlinked) file in that directory instead of being allocated from the
+ * heap, so the kernel can page it out. */
+TREE_ROOT* new_tree(int count, const char* spool_directory = nullptr);
 TREE_NODE* insert_tree_node(char* path,
                             char* fname,
                             int type,
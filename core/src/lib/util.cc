@@ -37,6 +37,7 @@
 #include "include/allow_deprecated.h"
 #include "lib/bpipe.h"
 #include "lib/btime.h"
+#include "lib/zero_block.h"
 
 #include <algorithm>
 #include <cctype>
@@ -104,28 +105,7 @@ std::string EscapeString(const char* old)
 
 
 // Return true of buffer has all zero bytes
-bool IsBufZero(char* buf, int len)
-{
-  uint64_t* ip;
-  char* p;
-  int i, len64, done, rem;
-
-  if (buf[0] != 0) { return false; }
-  ip = (uint64_t*)buf;
-
-  // Optimize by checking uint64_t for zero
-  len64 = len / sizeof(uint64_t);
-  for (i = 0; i < len64; i++) {
-    if (ip[i] != 0) { return false; }
-  }
-  done = len64 * sizeof(uint64_t); /* bytes already checked */
-  p = buf + done;
-  rem = len - done;
-  for (i = 0; i < rem; i++) {
-    if (p[i] != 0) { return false; }
-  }
-  return true;
-}
+bool IsBufZero(char* buf, int len) { return IsZeroBlock(buf, len); }
 
 
 // Convert a string in place to lower case
@@ -196,6 +176,7 @@ static std::list<HelloInformation> hello_list{
     {"Hello Storage calling Start Job", "R_JOB", 5, -1},
     {"Hello Start Storage Job", "R_JOB", 4, -1},
     {"Hello Start Job", "R_JOB", 3, -1},
+    {"Hello Data Connection", "R_JOB", 3, -1},
     {"Hello Director", "R_DIRECTOR", 2, -1},
     {"Hello Storage", "R_STORAGE", 2, -1},
     {"Hello Client", "R_CLIENT", 2, -1},
@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2002-2011 Free Software Foundation Europe e.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -34,10 +34,13 @@
 #include "lib/thread_specific_data.h"
 #include "lib/watchdog.h"
 
+#include <set>
+#include <utility>
 
 /* Exported globals */
 utime_t watchdog_time = 0;        /* this has granularity of SLEEP_TIME */
 utime_t watchdog_sleep_time = 60; /* examine things every 60 seconds */
+static utime_t watchdog_wakeup = 0; /* when the watchdog thread wakes up */
 
 /* Locals */
 static pthread_mutex_t timer_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -55,7 +58,8 @@ static bool wd_is_init = false;
 static brwlock_t lock; /* watchdog lock */
 
 static pthread_t wd_tid;
-static dlist<watchdog_t>* wd_queue;
+/* active watchdogs ordered by the time they fire, the first one first */
+static std::set<std::pair<utime_t, watchdog_t*>>* wd_queue;
 static dlist<watchdog_t>* wd_inactive;
 
 /*
@@ -91,7 +95,7 @@ int StartWatchdog(void)
     Jmsg1(NULL, M_ABORT, 0, T_("Unable to initialize watchdog lock. ERR=%s\n"),
           be.bstrerror(errstat));
   }
-  wd_queue = new dlist<watchdog_t>();
+  wd_queue = new std::set<std::pair<utime_t, watchdog_t*>>();
   wd_inactive = new dlist<watchdog_t>();
   wd_is_init = true;
 
@@ -131,10 +135,8 @@ int StopWatchdog(void)
 
   status = pthread_join(wd_tid, NULL);
 
-  while (!wd_queue->empty()) {
-    watchdog_t* item = wd_queue->first();
-    wd_queue->remove(item);
-    p = item;
+  for (auto& item : *wd_queue) {
+    p = item.second;
     if (p->destructor != NULL) { p->destructor(p); }
     free(p);
   }
@@ -165,6 +167,7 @@ watchdog_t* new_watchdog(void)
   if (wd == NULL) { return NULL; }
   wd->one_shot = true;
   wd->interval = 0;
+  wd->next_fire = 0;
   wd->callback = NULL;
   wd->destructor = NULL;
   wd->data = NULL;
@@ -186,12 +189,16 @@ bool RegisterWatchdog(watchdog_t* wd)
   }
 
   wd_lock();
+  wd_queue->erase({wd->next_fire, wd});  // registering again reschedules it
   wd->next_fire = watchdog_time + wd->interval;
-  wd_queue->append(wd);
+  wd_queue->emplace(wd->next_fire, wd);
+  // the watchdog thread only needs to wake up earlier for the first one
+  bool fires_first = wd_queue->begin()->second == wd
+                     && wd->next_fire < watchdog_wakeup;
   Dmsg3(800, "Registered watchdog %p, interval %d%s\n", wd, wd->interval,
         wd->one_shot ? " one shot" : "");
   wd_unlock();
-  ping_watchdog();
+  if (fires_first) { ping_watchdog(); }
 
   return false;
 }
@@ -208,13 +215,10 @@ bool UnregisterWatchdog(watchdog_t* wd)
   }
 
   wd_lock();
-  foreach_dlist (p, wd_queue) {
-    if (wd == p) {
-      wd_queue->remove(wd);
-      Dmsg1(800, "Unregistered watchdog %p\n", wd);
-      ok = true;
-      goto get_out;
-    }
+  if (wd_queue->erase({wd->next_fire, wd}) > 0) {
+    Dmsg1(800, "Unregistered watchdog %p\n", wd);
+    ok = true;
+    goto get_out;
   }
 
   foreach_dlist (p, wd_inactive) {
@@ -229,8 +233,9 @@ bool UnregisterWatchdog(watchdog_t* wd)
   Dmsg1(800, "Failed to unregister watchdog %p\n", wd);
 
 get_out:
+  /* No need to wake the watchdog thread, waking up for nothing once is
+   * cheaper than waking it up for every removal. */
   wd_unlock();
-  ping_watchdog();
   return ok;
 }
 
@@ -251,8 +256,6 @@ extern "C" void* watchdog_thread(void*)
   Dmsg0(800, "NicB-reworked watchdog thread entered\n");
 
   while (!quit) {
-    watchdog_t* p;
-
     /*  NOTE. lock_jcr_chain removed, but the message below
      *   was left until we are sure there are no deadlocks.
      *
@@ -265,26 +268,33 @@ extern "C" void* watchdog_thread(void*)
      *   the other's needed lock. */
     wd_lock();
 
-  walk_list:
     watchdog_time = time(NULL);
     next_time = watchdog_time + watchdog_sleep_time;
-    foreach_dlist (p, wd_queue) {
-      if (p->next_fire <= watchdog_time) {
-        /* Run the callback */
-        Dmsg2(3400, "Watchdog callback p=0x%p fire=%d\n", p, p->next_fire);
-        p->callback(p);
-
-        /* Reschedule (or move to inactive list if it's a one-shot timer) */
-        if (p->one_shot) {
-          wd_queue->remove(p);
-          wd_inactive->append(p);
-          goto walk_list;
-        } else {
-          p->next_fire = watchdog_time + p->interval;
-        }
+    while (!wd_queue->empty()) {
+      auto [next_fire, p] = *wd_queue->begin();
+      if (next_fire > watchdog_time) {
+        if (next_fire < next_time) { next_time = next_fire; }
+        break;
+      }
+
+      /* Run the callback. It still runs with the watchdog lock held, the
+       * callbacks only signal threads and rely on their watchdog not being
+       * freed meanwhile. */
+      Dmsg2(3400, "Watchdog callback p=0x%p fire=%d\n", p, next_fire);
+      p->callback(p);
+
+      // the callback may have unregistered or registered its own watchdog
+      if (wd_queue->erase({next_fire, p}) == 0) { continue; }
+
+      /* Reschedule (or move to inactive list if it's a one-shot timer) */
+      if (p->one_shot) {
+        wd_inactive->append(p);
+      } else {
+        p->next_fire = watchdog_time + p->interval;
+        wd_queue->emplace(p->next_fire, p);
       }
-      if (p->next_fire <= next_time) { next_time = p->next_fire; }
     }
+    watchdog_wakeup = next_time;
     wd_unlock();
 
     // Wait sleep time or until someone wakes us
@@ -0,0 +1,218 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Check blocks of data for zero bytes only, e.g. to find sparse blocks
+ */
+
+#include "lib/zero_block.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__GNUC__) || defined(__clang__))
+#  define HAVE_X86_ZERO_CHECKS
+#  include <immintrin.h>
+#elif defined(__aarch64__)
+#  define HAVE_NEON_ZERO_CHECK
+#  include <arm_neon.h>
+#endif
+
+using zero_check_fn = bool (*)(const char* buf, std::size_t len);
+
+static bool PortableIsZero(const char* buf, std::size_t len)
+{
+  std::size_t done = 0;
+  for (; done + sizeof(uint64_t) <= len; done += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, buf + done, sizeof(word));
+    if (word != 0) { return false; }
+  }
+  for (; done < len; ++done) {
+    if (buf[done] != 0) { return false; }
+  }
+  return true;
+}
+
+/* The vectorized checks look at four vectors at once and only test the
+ * combination of them, the rest of the block is left to PortableIsZero. */
+#if defined(HAVE_X86_ZERO_CHECKS)
+__attribute__((target("sse2"))) static bool Sse2IsZero(const char* buf,
+                                                       std::size_t len)
+{
+  constexpr std::size_t step = 4 * sizeof(__m128i);
+  const __m128i zero = _mm_setzero_si128();
+  std::size_t done = 0;
+  for (; done + step <= len; done += step) {
+    auto* p = reinterpret_cast<const __m128i*>(buf + done);
+    __m128i v = _mm_or_si128(
+        _mm_or_si128(_mm_loadu_si128(p), _mm_loadu_si128(p + 1)),
+        _mm_or_si128(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3)));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) != 0xFFFF) { return false; }
+  }
+  return PortableIsZero(buf + done, len - done);
+}
+
+__attribute__((target("avx2"))) static bool Avx2IsZero(const char* buf,
+                                                       std::size_t len)
+{
+  constexpr std::size_t step = 4 * sizeof(__m256i);
+  std::size_t done = 0;
+  for (; done + step <= len; done += step) {
+    auto* p = reinterpret_cast<const __m256i*>(buf + done);
+    __m256i v = _mm256_or_si256(
+        _mm256_or_si256(_mm256_loadu_si256(p), _mm256_loadu_si256(p + 1)),
+        _mm256_or_si256(_mm256_loadu_si256(p + 2), _mm256_loadu_si256(p + 3)));
+    if (!_mm256_testz_si256(v, v)) { return false; }
+  }
+  return PortableIsZero(buf + done, len - done);
+}
+
+__attribute__((target("avx512f"))) static bool Avx512IsZero(const char* buf,
+                                                           std::size_t len)
+{
+  constexpr std::size_t step = 4 * sizeof(__m512i);
+  std::size_t done = 0;
+  for (; done + step <= len; done += step) {
+    const char* p = buf + done;
+    __m512i v = _mm512_or_si512(
+        _mm512_or_si512(_mm512_loadu_si512(p), _mm512_loadu_si512(p + 64)),
+        _mm512_or_si512(_mm512_loadu_si512(p + 128),
+                        _mm512_loadu_si512(p + 192)));
+    if (_mm512_test_epi64_mask(v, v) != 0) { return false; }
+  }
+  return PortableIsZero(buf + done, len - done);
+}
+#endif
+
+#if defined(HAVE_NEON_ZERO_CHECK)
+static bool NeonIsZero(const char* buf, std::size_t len)
+{
+  constexpr std::size_t step = 4 * sizeof(uint8x16_t);
+  std::size_t done = 0;
+  for (; done + step <= len; done += step) {
+    auto* p = reinterpret_cast<const uint8_t*>(buf + done);
+    uint8x16_t v = vorrq_u8(vorrq_u8(vld1q_u8(p), vld1q_u8(p + 16)),
+                            vorrq_u8(vld1q_u8(p + 32), vld1q_u8(p + 48)));
+    if (vmaxvq_u8(v) != 0) { return false; }
+  }
+  return PortableIsZero(buf + done, len - done);
+}
+#endif
+
+static zero_check_fn Implementation(ZeroCheck check)
+{
+  switch (check) {
+#if defined(HAVE_X86_ZERO_CHECKS)
+    case ZeroCheck::kSse2:
+      return Sse2IsZero;
+    case ZeroCheck::kAvx2:
+      return Avx2IsZero;
+    case ZeroCheck::kAvx512:
+      return Avx512IsZero;
+#endif
+#if defined(HAVE_NEON_ZERO_CHECK)
+    case ZeroCheck::kNeon:
+      return NeonIsZero;
+#endif
+    default:
+      return PortableIsZero;
+  }
+}
+
+const char* ZeroCheckName(ZeroCheck check)
+{
+  switch (check) {
+    case ZeroCheck::kPortable:
+      return "portable";
+    case ZeroCheck::kSse2:
+      return "sse2";
+    case ZeroCheck::kAvx2:
+      return "avx2";
+    case ZeroCheck::kAvx512:
+      return "avx512";
+    case ZeroCheck::kNeon:
+      return "neon";
+  }
+  return "unknown";
+}
+
+bool ZeroCheckSupported(ZeroCheck check)
+{
+  switch (check) {
+    case ZeroCheck::kPortable:
+      return true;
+#if defined(HAVE_X86_ZERO_CHECKS)
+    case ZeroCheck::kSse2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse2");
+    case ZeroCheck::kAvx2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+    case ZeroCheck::kAvx512:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx512f");
+#endif
+#if defined(HAVE_NEON_ZERO_CHECK)
+    case ZeroCheck::kNeon:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+std::vector<ZeroCheck> SupportedZeroChecks()
+{
+  std::vector<ZeroCheck> supported;
+  for (ZeroCheck check : {ZeroCheck::kPortable, ZeroCheck::kSse2,
+                          ZeroCheck::kAvx2, ZeroCheck::kAvx512,
+                          ZeroCheck::kNeon}) {
+    if (ZeroCheckSupported(check)) { supported.push_back(check); }
+  }
+  return supported;
+}
+
+/* A block of a sparse file is read from memory once, so the checks are
+ * limited by the memory bandwidth long before the vector width matters.
+ * AVX-512 is not preferred over AVX2, it lowers the clock of some cpus. */
+ZeroCheck BestZeroCheck()
+{
+  for (ZeroCheck check :
+       {ZeroCheck::kAvx2, ZeroCheck::kSse2, ZeroCheck::kNeon}) {
+    if (ZeroCheckSupported(check)) { return check; }
+  }
+  return ZeroCheck::kPortable;
+}
+
+bool IsZeroBlock(ZeroCheck check, const char* buf, std::size_t len)
+{
+  return Implementation(check)(buf, len);
+}
+
+bool IsZeroBlock(const char* buf, std::size_t len)
+{
+  static const zero_check_fn best = Implementation(BestZeroCheck());
+  // most blocks that are not zero are recognized by their first byte
+  if (len > 0 && buf[0] != 0) { return false; }
+  return best(buf, len);
+}
@@ -0,0 +1,53 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Check blocks of data for zero bytes only, e.g. to find sparse blocks
+ */
+
+#ifndef BAREOS_LIB_ZERO_BLOCK_H_
+#define BAREOS_LIB_ZERO_BLOCK_H_
+
+#include <cstddef>
+#include <vector>
+
+/* The ways a block can be checked. Only kPortable is available everywhere,
+ * the others depend on the architecture and the cpu running the program. */
+enum class ZeroCheck
+{
+  kPortable,
+  kSse2,
+  kAvx2,
+  kAvx512,
+  kNeon,
+};
+
+const char* ZeroCheckName(ZeroCheck check);
+bool ZeroCheckSupported(ZeroCheck check);
+std::vector<ZeroCheck> SupportedZeroChecks();
+// The fastest check this cpu supports
+ZeroCheck BestZeroCheck();
+
+// The buffer does not need to be aligned
+bool IsZeroBlock(ZeroCheck check, const char* buf, std::size_t len);
+bool IsZeroBlock(const char* buf, std::size_t len);
+
+#endif  // BAREOS_LIB_ZERO_BLOCK_H_
@@ -3,7 +3,7 @@
 
    Copyright (C) 2002-2013 Free Software Foundation Europe e.V.
    Copyright (C) 2011-2012 Planets Communications B.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -573,7 +573,13 @@ bool ReleaseDevice(DeviceControlRecord* dcr)
               T_("Could not create JobMedia record for Volume=\"%s\" Job=%s\n"),
               dcr->getVolCatName(), jcr->Job);
       }
-
+    }
+    if (!dcr->DirFlushJobmediaRecords()) {
+      Jmsg2(jcr, M_FATAL, 0,
+            T_("Could not create JobMedia record for Volume=\"%s\" Job=%s\n"),
+            dcr->getVolCatName(), jcr->Job);
+    }
+    if (dev->IsLabeled()) {
       // If no more writers, and no errors, and wrote something, write an EOF
       if (!dev->num_writers && dev->CanWrite() && dev->block_num > 0) {
         dev->weof(1);
@@ -805,6 +811,12 @@ void FreeDeviceControlRecord(DeviceControlRecord* dcr)
 {
   JobControlRecord* jcr;
 
+  /* Queued JobMedia records are normally flushed by ReleaseDevice(), but
+   * not when the job ends before it. Do not lose them. */
+  if (dcr->jcr && dcr->jcr->dir_bsock && !dcr->DirFlushJobmediaRecords()) {
+    Dmsg0(100, "Could not flush JobMedia records\n");
+  }
+
   lock_mutex(dcr->mutex_);
   jcr = dcr->jcr;
 
@@ -36,6 +36,7 @@
 #include "stored/label.h"
 #include "stored/spool.h"
 #include "lib/bget_msg.h"
+#include "lib/bsock_multiplexed.h"
 #include "lib/edit.h"
 #include "include/jcr.h"
 #include "include/streams.h"
@@ -82,12 +83,11 @@ DeviceRecord ProcessedFileData::GetData()
 
 ProcessedFile::ProcessedFile(int32_t fileindex) : fileindex_(fileindex) {}
 
-void ProcessedFile::SendAttributesToDirector(JobControlRecord* jcr)
+void ProcessedFile::AppendAttributesTo(std::vector<DeviceRecord>& records)
 {
   for_each(attributes_.begin(), attributes_.end(),
-           [&jcr](ProcessedFileData& attribute) {
-             DeviceRecord devicerecord = attribute.GetData();
-             SendAttrsToDir(jcr, &devicerecord);
+           [&records](ProcessedFileData& attribute) {
+             records.push_back(attribute.GetData());
            });
 }
 
@@ -109,9 +109,12 @@ static bool SaveFullyProcessedFilesAttributes(
     std::vector<ProcessedFile>& processed_files)
 {
   if (!processed_files.empty()) {
-    for_each(
-        processed_files.begin(), processed_files.end(),
-        [&jcr](ProcessedFile& file) { file.SendAttributesToDirector(jcr); });
+    std::vector<DeviceRecord> records;
+    for_each(processed_files.begin(), processed_files.end(),
+             [&records](ProcessedFile& file) {
+               file.AppendAttributesTo(records);
+             });
+    SendAttrsToDir(jcr, records);
     jcr->JobFiles = processed_files.back().GetFileIndex();
     processed_files.clear();
     return true;
@@ -119,126 +122,130 @@ static bool SaveFullyProcessedFilesAttributes(
   return false;
 }
 
-class MessageHandler {
- public:
-  using signal_type = int;
-
-  struct message_type {
-    std::size_t size;
-    PoolMem data;
-  };
-
-  struct error_type {
-    enum class type
-    {
-      HARDEOF,
-      // both ERROR and SOCKET_ERROR are taken by windows.h
-      INTERNAL_ERROR,
-    } type;
-
-    std::string msg;
-  };
-
-  using result_type = std::variant<signal_type, message_type, error_type>;
-
-  MessageHandler(BareosSocket* t_fd)
-      : MessageHandler{t_fd,
-                       // 500 msg reserves at most 256MB in size
-                       // probably much less because of signals
-                       channel::CreateBufferedChannel<result_type>(500)}
-  {
+MultiplexedMessageHandler::MultiplexedMessageHandler(
+    BareosSocket* fd,
+    std::vector<BareosSocket*> data_connections)
+    : data_connections_{std::move(data_connections)}
+{
+  handlers_.push_back(std::make_unique<MessageHandler>(fd));
+  for (BareosSocket* connection : data_connections_) {
+    handlers_.push_back(std::make_unique<MessageHandler>(connection));
   }
+}
 
-  std::optional<result_type> get_msg() { return output.get(); }
+std::optional<MultiplexedMessageHandler::result_type>
+MultiplexedMessageHandler::get_msg()
+{
+  if (handlers_.size() == 1) { return handlers_.front()->get_msg(); }
 
-  const char* error()
-  {
-    if (fd->IsError()) { return fd->bstrerror(); }
-    return nullptr;
+  while (received_.empty()) {
+    if (!ReceiveBlock()) { return std::nullopt; }
   }
+  result_type result = std::move(received_.front());
+  received_.pop_front();
+  return result;
+}
 
-  BareosSocket* close_and_get_sock()
-  {
-    output.close();
-    receive_thread.join();
-    return fd;
-  }
+void MultiplexedMessageHandler::AddError(std::string msg)
+{
+  received_.emplace_back(
+      error_type{error_type::type::INTERNAL_ERROR, std::move(msg)});
+}
 
- private:
-  MessageHandler(BareosSocket* t_fd,
-                 std::pair<channel::input<result_type>,
-                           channel::output<result_type>> chan_pair)
-      : fd{t_fd}
-      , input{std::move(chan_pair.first)}
-      , output{std::move(chan_pair.second)}
-      , receive_thread{enlist, this}
-  {
+/* Receive the next block from the connection it was sent over and unpack its
+ * messages. Errors and signals of the connection itself are passed on. */
+bool MultiplexedMessageHandler::ReceiveBlock()
+{
+  std::size_t index = sequence_ % handlers_.size();
+  MessageHandler& handler = *handlers_[index];
+
+  std::optional<result_type> msg = handler.get_msg();
+  if (!msg) { return false; }
+  auto* first = std::get_if<message_type>(&msg.value());
+  if (!first) {
+    received_.push_back(std::move(msg).value());
+    return true;
   }
 
-  BareosSocket* fd;
-  channel::input<result_type> input;
-  channel::output<result_type> output;
-
-  // receive_thread has to be defined last!
-  // The thread created will try to access this class immediately after
-  // being created!  As such everything else has to be initialized.
-  std::thread receive_thread;
-  void do_work()
-  {
-    POOLMEM* save = fd->msg;
-    bool cont = true;
-    for (int res = 0; cont; res = fd->WaitData(0, 100'000)) {
-      if (res == fd->DataAvailable) {
-        PoolMem msg(PM_MESSAGE);
-        fd->msg = msg.addr();
-        result_type result;
-        int n = BgetMsg(fd);
-        // fd->msg might have been relocated
-        msg.addr() = fd->msg;
-        if (n < 0) {
-          if (n == BNET_SIGNAL) {
-            result = signal_type{fd->message_length};
-            // break; /* end of data */
-          } else if (n == BNET_HARDEOF) {
-            result = error_type{error_type::type::HARDEOF, fd->bstrerror()};
-            cont = false;
-          } else {
-            result
-                = error_type{error_type::type::INTERNAL_ERROR, fd->bstrerror()};
-            cont = false;
-          }
-        } else {
-          std::size_t length = n;
-          result = message_type{length, std::move(msg)};
-        }
-        fd->msg = nullptr;
-
-        if (!input.emplace(std::move(result))) {
-          if (input.closed()) {
-            Dmsg1(20, "Tried to put message into closed queue.\n");
-          } else {
-            Dmsg1(20,
-                  "Tried to put message into queue; but it did not succeed.\n");
-          }
-          cont = false;
-        }
-      } else if (res == fd->Error) {
-        cont = false;
-      } else {
-        ASSERT(res == fd->Timeout);
-        input.try_update_status();
-      }
+  MultiplexedBlockHeader header;
+  if (!UnpackMultiplexedBlockHeader(first->data.c_str(),
+                                    static_cast<int32_t>(first->size), header)
+      || header.sequence != sequence_) {
+    AddError("Data connection " + std::to_string(index)
+             + " is out of sequence, expected block "
+             + std::to_string(sequence_));
+    return true;
+  }
 
-      if (input.closed()) { cont = false; }
+  // Blocks larger than a network packet arrive in several messages
+  PoolMem block = std::move(first->data);
+  std::size_t size = first->size;
+  std::size_t expected = kMultiplexedBlockHeaderLength + header.length;
+  while (size < expected) {
+    std::optional<result_type> part = handler.get_msg();
+    if (!part) { return false; }
+    auto* content = std::get_if<message_type>(&part.value());
+    if (!content) {
+      received_.push_back(std::move(part).value());
+      return true;
     }
+    block.check_size(size + content->size);
+    memcpy(block.c_str() + size, content->data.c_str(), content->size);
+    size += content->size;
+  }
+
+  bool ok = size == expected
+            && UnpackMultiplexedMessages(
+                block.c_str() + kMultiplexedBlockHeaderLength, header.length,
+                [this](int32_t length, const char* data) {
+                  if (length == BNET_HEARTBEAT || length == BNET_HB_RESPONSE) {
+                    return;
+                  }
+                  if (length < 0) {
+                    received_.emplace_back(signal_type{length});
+                    return;
+                  }
+                  // messages are expected to be terminated like received ones
+                  PoolMem message(PM_MESSAGE);
+                  message.check_size(length + 1);
+                  memcpy(message.c_str(), data, length);
+                  message.c_str()[length] = 0;
+                  received_.emplace_back(message_type{
+                      static_cast<std::size_t>(length), std::move(message)});
+                });
+  if (!ok) {
+    AddError("Malformed block " + std::to_string(sequence_)
+             + " on data connection " + std::to_string(index));
+    return true;
+  }
 
-    input.close();
+  sequence_++;
+  return true;
+}
 
-    fd->msg = save;
+const char* MultiplexedMessageHandler::error()
+{
+  for (auto& handler : handlers_) {
+    if (const char* error = handler->error()) { return error; }
   }
+  return nullptr;
+}
 
-  static void enlist(MessageHandler* handler) { handler->do_work(); }
-};
+BareosSocket* MultiplexedMessageHandler::close_and_get_sock()
+{
+  BareosSocket* fd = handlers_.front()->close_and_get_sock();
+  for (std::size_t i = 1; i < handlers_.size(); ++i) {
+    BareosSocket* connection = handlers_[i]->close_and_get_sock();
+    /* The file daemon does not read from its data connections, so it would
+     * never answer the shutdown of TLS */
+    connection->tls_conn.reset();
+    connection->close();
+    delete connection;
+  }
+  handlers_.resize(1);
+  data_connections_.clear();
+  return fd;
+}
 
 // Append Data sent from File daemon
 bool DoAppendData(JobControlRecord* jcr, BareosSocket* bs, const char* what)
@@ -351,7 +358,8 @@ bool DoAppendData(JobControlRecord* jcr, BareosSocket* bs, const char* what)
   ProcessedFile file_currently_processed;
   uint32_t current_block_number = jcr->sd_impl->dcr->block->BlockNumber;
 
-  MessageHandler handler(std::exchange(bs, nullptr));
+  MultiplexedMessageHandler handler(std::exchange(bs, nullptr),
+                                    TakeDataConnections(jcr));
 
   for (last_file_index = 0; ok && !jcr->IsJobCanceled();) {
     /* Read Stream header from the daemon.
@@ -369,9 +377,9 @@ bool DoAppendData(JobControlRecord* jcr, BareosSocket* bs, const char* what)
       break;
     }
 
-    using signal_type = MessageHandler::signal_type;
-    using message_type = MessageHandler::message_type;
-    using error_type = MessageHandler::error_type;
+    using signal_type = MultiplexedMessageHandler::signal_type;
+    using message_type = MultiplexedMessageHandler::message_type;
+    using error_type = MultiplexedMessageHandler::error_type;
 
     if (auto* error = std::get_if<error_type>(&msg.value())) {
       Jmsg2(jcr, M_FATAL, 0, T_("Error reading data header from %s. ERR=%s\n"),
@@ -425,6 +433,7 @@ bool DoAppendData(JobControlRecord* jcr, BareosSocket* bs, const char* what)
         processed_files.push_back(std::move(file_currently_processed));
       }
       file_currently_processed = ProcessedFile{file_index};
+      jcr->job_metrics.files.Add();
     }
 
     /* Read data stream from the daemon. The data stream is just raw bytes.
@@ -485,6 +494,7 @@ bool DoAppendData(JobControlRecord* jcr, BareosSocket* bs, const char* what)
               jcr->sd_impl->dcr->dev->bstrerror());
         break;
       }
+      jcr->job_metrics.bytes.Add(content2.size);
 
       if (IsAttribute(jcr->sd_impl->dcr->rec)) {
         file_currently_processed.AddAttribute(jcr->sd_impl->dcr->rec);
@@ -643,4 +653,22 @@ bool SendAttrsToDir(JobControlRecord* jcr, DeviceRecord* rec)
   }
   return true;
 }
+
+// Send attributes and digests of several files to Director for Catalog
+bool SendAttrsToDir(JobControlRecord* jcr, std::vector<DeviceRecord>& recs)
+{
+  if (!jcr->sd_impl->no_attributes && !recs.empty()) {
+    BareosSocket* dir = jcr->dir_bsock;
+    if (AttributesAreSpooled(jcr)) { dir->SetSpooling(); }
+    Dmsg1(850, "Send %d attributes to dir.\n", static_cast<int>(recs.size()));
+    if (!jcr->sd_impl->dcr->DirUpdateFileAttributesBatch(recs)) {
+      Jmsg(jcr, M_FATAL, 0, T_("Error updating file attributes. ERR=%s\n"),
+           dir->bstrerror());
+      dir->ClearSpooling();
+      return false;
+    }
+    dir->ClearSpooling();
+  }
+  return true;
+}
 } /* namespace storagedaemon */
@@ -1,7 +1,7 @@
 /*
    BAREOS® - Backup Archiving REcovery Open Sourced
 
-   Copyright (C) 2018-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2018-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -24,11 +24,173 @@
 
 #include "include/bareos.h"
 #include "lib/bsock.h"
+#include "lib/bget_msg.h"
+#include "lib/channel.h"
 #include "stored/device_control_record.h"
 #include "stored/record.h"
 
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
 namespace storagedaemon {
 
+class MessageHandler {
+ public:
+  using signal_type = int;
+
+  struct message_type {
+    std::size_t size;
+    PoolMem data;
+  };
+
+  struct error_type {
+    enum class type
+    {
+      HARDEOF,
+      // both ERROR and SOCKET_ERROR are taken by windows.h
+      INTERNAL_ERROR,
+    } type;
+
+    std::string msg;
+  };
+
+  using result_type = std::variant<signal_type, message_type, error_type>;
+
+  MessageHandler(BareosSocket* t_fd)
+      : MessageHandler{t_fd,
+                       // 500 msg reserves at most 256MB in size
+                       // probably much less because of signals
+                       channel::CreateBufferedChannel<result_type>(500)}
+  {
+  }
+
+  std::optional<result_type> get_msg() { return output.get(); }
+
+  const char* error()
+  {
+    if (fd->IsError()) { return fd->bstrerror(); }
+    return nullptr;
+  }
+
+  BareosSocket* close_and_get_sock()
+  {
+    output.close();
+    receive_thread.join();
+    return fd;
+  }
+
+ private:
+  MessageHandler(BareosSocket* t_fd,
+                 std::pair<channel::input<result_type>,
+                           channel::output<result_type>> chan_pair)
+      : fd{t_fd}
+      , input{std::move(chan_pair.first)}
+      , output{std::move(chan_pair.second)}
+      , receive_thread{enlist, this}
+  {
+  }
+
+  BareosSocket* fd;
+  channel::input<result_type> input;
+  channel::output<result_type> output;
+
+  // receive_thread has to be defined last!
+  // The thread created will try to access this class immediately after
+  // being created!  As such everything else has to be initialized.
+  std::thread receive_thread;
+  void do_work()
+  {
+    POOLMEM* save = fd->msg;
+    bool cont = true;
+    for (int res = 0; cont; res = fd->WaitData(0, 100'000)) {
+      if (res == fd->DataAvailable) {
+        PoolMem msg(PM_MESSAGE);
+        fd->msg = msg.addr();
+        result_type result;
+        int n = BgetMsg(fd);
+        // fd->msg might have been relocated
+        msg.addr() = fd->msg;
+        if (n < 0) {
+          if (n == BNET_SIGNAL) {
+            result = signal_type{fd->message_length};
+            // break; /* end of data */
+          } else if (n == BNET_HARDEOF) {
+            result = error_type{error_type::type::HARDEOF, fd->bstrerror()};
+            cont = false;
+          } else {
+            result
+                = error_type{error_type::type::INTERNAL_ERROR, fd->bstrerror()};
+            cont = false;
+          }
+        } else {
+          std::size_t length = n;
+          result = message_type{length, std::move(msg)};
+        }
+        fd->msg = nullptr;
+
+        if (!input.emplace(std::move(result))) {
+          if (input.closed()) {
+            Dmsg1(20, "Tried to put message into closed queue.\n");
+          } else {
+            Dmsg1(20,
+                  "Tried to put message into queue; but it did not succeed.\n");
+          }
+          cont = false;
+        }
+      } else if (res == fd->Error) {
+        cont = false;
+      } else {
+        ASSERT(res == fd->Timeout);
+        input.try_update_status();
+      }
+
+      if (input.closed()) { cont = false; }
+    }
+
+    input.close();
+
+    fd->msg = save;
+  }
+
+  static void enlist(MessageHandler* handler) { handler->do_work(); }
+};
+
+/* Receives the data of a job that the file daemon sends over several
+ * connections, see lib/bsock_multiplexed.h, and returns the messages in the
+ * order they were sent. The blocks are read from the connections in turn, so
+ * every connection has its own receive thread and only the next block has to
+ * be waited for. Without additional connections the messages of the job
+ * connection are passed on unchanged. */
+class MultiplexedMessageHandler {
+ public:
+  using signal_type = MessageHandler::signal_type;
+  using message_type = MessageHandler::message_type;
+  using error_type = MessageHandler::error_type;
+  using result_type = MessageHandler::result_type;
+
+  MultiplexedMessageHandler(BareosSocket* fd,
+                            std::vector<BareosSocket*> data_connections);
+
+  std::optional<result_type> get_msg();
+  const char* error();
+  // The data connections are closed and deleted, fd is returned
+  BareosSocket* close_and_get_sock();
+
+ private:
+  bool ReceiveBlock();
+  void AddError(std::string msg);
+
+  std::vector<std::unique_ptr<MessageHandler>> handlers_;
+  std::vector<BareosSocket*> data_connections_;
+  std::deque<result_type> received_;
+  uint64_t sequence_{0};
+};
+
 class ProcessedFileData {
  public:
   explicit ProcessedFileData(DeviceRecord* record);
@@ -48,7 +210,7 @@ class ProcessedFile {
   ProcessedFile() = default;
   explicit ProcessedFile(int32_t fileindex);
 
-  void SendAttributesToDirector(JobControlRecord* jcr);
+  void AppendAttributesTo(std::vector<DeviceRecord>& records);
   void AddAttribute(DeviceRecord* record);
   int32_t GetFileIndex() { return fileindex_; }
   const std::vector<ProcessedFileData>& GetAttributes() const
@@ -64,6 +226,7 @@ class ProcessedFile {
 bool DoAppendData(JobControlRecord* jcr, BareosSocket* bs, const char* what);
 bool IsAttribute(DeviceRecord* record);
 bool SendAttrsToDir(JobControlRecord* jcr, DeviceRecord* rec);
+bool SendAttrsToDir(JobControlRecord* jcr, std::vector<DeviceRecord>& recs);
 }  // namespace storagedaemon
 
 #endif  // BAREOS_STORED_APPEND_H_
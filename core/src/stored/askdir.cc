@@ -34,9 +34,11 @@
 #include "stored/stored_globals.h"
 
 #include "include/jcr.h"
+#include "include/protocol_types.h"
 #include "lib/crypto_cache.h"
 #include "stored/device_control_record.h"
 #include "stored/sd_device_control_record.h"
+#include "stored/stored_jcr_impl.h"
 #include "stored/wait.h"
 #include "stored/dev.h"
 #include "lib/edit.h"
@@ -48,6 +50,7 @@
 namespace storagedaemon {
 
 static const int debuglevel = 50;
+static constexpr std::size_t kJobmediaBatchSize = 64;
 static pthread_mutex_t vol_info_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /* Requests sent to the Director */
@@ -65,6 +68,9 @@ static char Create_job_media[]
     = "CatReq Job=%s CreateJobMedia"
       " FirstIndex=%u LastIndex=%u StartFile=%u EndFile=%u"
       " StartBlock=%u EndBlock=%u Copy=%d Strip=%d MediaId=%s\n";
+static char Create_job_media_batch[]
+    = "CatReq Job=%s CreateJobMediaBatch Count=%d Sync=%d\n";
+static char Job_media_entry[] = "%u %u %u %u %u %u %d %d %s\n";
 
 static char Update_filelist[] = "Catreq Job=%s UpdateFileList\n";
 
@@ -72,6 +78,7 @@ static char Update_jobrecord[]
     = "Catreq Job=%s UpdateJobRecord JobFiles=%lu JobBytes=%llu\n";
 
 static char FileAttributes[] = "UpdCat Job=%s FileAttributes ";
+static char FileAttributesBatch[] = "UpdCat Job=%s FileAttributesBatch ";
 
 
 /* Responses received from the Director */
@@ -337,11 +344,19 @@ bail_out:
   return ok;
 }
 
-// After writing a Volume, create the JobMedia record.
+/**
+ * After writing a Volume, create the JobMedia record.
+ *
+ * The records are queued and sent to the Director in batches without waiting
+ * for an answer, so the thread writing the device does not stall on the
+ * catalog. DirFlushJobmediaRecords() must be called at volume change and job
+ * end to make sure the records made it into the catalog. Directors that do
+ * not announce CC_JOBMEDIA_BATCH get every record in a request of its own.
+ */
 bool StorageDaemonDeviceControlRecord::DirCreateJobmediaRecord(bool zero)
 {
-  BareosSocket* dir = jcr->dir_bsock;
   char ed1[50];
+  char entry[256];
 
   // If system job, do not update catalog
   if (jcr->is_JobType(JT_SYSTEM)) { return true; }
@@ -355,6 +370,39 @@ bool StorageDaemonDeviceControlRecord::DirCreateJobmediaRecord(bool zero)
   if (!WroteVol) { return true; /* nothing written to tape */ }
 
   WroteVol = false;
+  if (!(jcr->sd_impl->catalog_capabilities & CC_JOBMEDIA_BATCH)) {
+    return SendJobmediaRecord(zero);
+  }
+
+  if (zero) {
+    // Send dummy place holder to avoid purging
+    Bsnprintf(entry, sizeof(entry), Job_media_entry, 0, 0, 0, 0, 0, 0, 0, 0,
+              edit_uint64(VolMediaId, ed1));
+    pending_jobmedia_.emplace_back(entry);
+
+    /* The place holder only protects the volume once it is in the catalog,
+     * so do not continue before the Director has acknowledged it. */
+    return DirFlushJobmediaRecords();
+  }
+
+  Bsnprintf(entry, sizeof(entry), Job_media_entry, VolFirstIndex, VolLastIndex,
+            StartFile, EndFile, StartBlock, EndBlock, Copy, Stripe,
+            edit_uint64(VolMediaId, ed1));
+  pending_jobmedia_.emplace_back(entry);
+
+  if (pending_jobmedia_.size() >= kJobmediaBatchSize) {
+    return SendJobmediaBatch(false);
+  }
+
+  return true;
+}
+
+// Send one JobMedia record and wait until the Director stored it.
+bool StorageDaemonDeviceControlRecord::SendJobmediaRecord(bool zero)
+{
+  BareosSocket* dir = jcr->dir_bsock;
+  char ed1[50];
+
   if (zero) {
     // Send dummy place holder to avoid purging
     dir->fsend(Create_job_media, jcr->Job, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -383,6 +431,61 @@ bool StorageDaemonDeviceControlRecord::DirCreateJobmediaRecord(bool zero)
   return true;
 }
 
+// Send all queued JobMedia records and wait until the Director stored them.
+bool StorageDaemonDeviceControlRecord::DirFlushJobmediaRecords()
+{
+  if (pending_jobmedia_.empty() && !jobmedia_unacked_) { return true; }
+
+  return SendJobmediaBatch(true);
+}
+
+/**
+ * Send the queued JobMedia records in one message. With sync the Director
+ * answers once the records are in the catalog, and the answer also reports
+ * errors of the batches sent before without sync.
+ */
+bool StorageDaemonDeviceControlRecord::SendJobmediaBatch(bool sync)
+{
+  BareosSocket* dir = jcr->dir_bsock;
+  PoolMem batch(PM_MESSAGE);
+
+  Mmsg(batch, Create_job_media_batch, jcr->Job,
+       static_cast<int>(pending_jobmedia_.size()), sync ? 1 : 0);
+  for (const auto& entry : pending_jobmedia_) {
+    PmStrcat(batch, entry.c_str());
+  }
+  pending_jobmedia_.clear();
+
+  Dmsg1(debuglevel, ">dird %s", batch.c_str());
+  if (!dir->fsend("%s", batch.c_str())) {
+    Jmsg(jcr, M_FATAL, 0, T_("Error creating JobMedia record: ERR=%s\n"),
+         dir->bstrerror());
+    return false;
+  }
+
+  if (!sync) {
+    jobmedia_unacked_ = true;
+    return true;
+  }
+  jobmedia_unacked_ = false;
+
+  if (dir->recv() <= 0) {
+    Dmsg0(debuglevel, "create_jobmedia error BnetRecv\n");
+    Jmsg(jcr, M_FATAL, 0, T_("Error creating JobMedia record: ERR=%s\n"),
+         dir->bstrerror());
+    return false;
+  }
+  Dmsg1(debuglevel, "<dird %s", dir->msg);
+
+  if (!bstrcmp(dir->msg, OK_create)) {
+    Dmsg1(debuglevel, "Bad response from Dir: %s\n", dir->msg);
+    Jmsg(jcr, M_FATAL, 0, T_("Error creating JobMedia record: %s\n"), dir->msg);
+    return false;
+  }
+
+  return true;
+}
+
 /**
  * Update File Attribute data
  * We do the following:
@@ -430,6 +533,86 @@ bool StorageDaemonDeviceControlRecord::DirUpdateFileAttributes(
   return dir->send();
 }
 
+/**
+ * Update File Attribute data of several records at once
+ * The message starts with a "FileAttributesBatch" header which is followed
+ * by the records, each serialized as in DirUpdateFileAttributes(). Records
+ * are packed into messages of up to kMaxAttributesBatchLength bytes, so the
+ * Director has to handle only one message for many small files.
+ */
+bool StorageDaemonDeviceControlRecord::DirUpdateFileAttributesBatch(
+    std::vector<DeviceRecord>& records)
+{
+  BareosSocket* dir = jcr->dir_bsock;
+
+#ifdef NO_ATTRIBUTES_TEST
+  return true;
+#endif
+
+  // Older Directors only read the first record of a batch
+  if (!(jcr->sd_impl->catalog_capabilities & CC_ATTRIBUTES_BATCH)) {
+    for (DeviceRecord& record : records) {
+      if (!DirUpdateFileAttributes(&record)) { return false; }
+    }
+    return true;
+  }
+
+  std::size_t next = 0;
+  while (next < records.size()) {
+    std::size_t first = next;
+    next = SerializeAttributesBatch(jcr->Job, records, first, dir->msg,
+                                    dir->message_length);
+    Dmsg2(1800, ">dird %d attributes in %d bytes\n",
+          static_cast<int>(next - first), dir->message_length);
+
+    if (!dir->send()) { return false; }
+  }
+
+  return true;
+}
+
+/**
+ * Serialize the records from first on into a FileAttributesBatch message for
+ * job. As many records are taken as fit into max_length bytes, but at least
+ * one. Returns the index of the first record not taken.
+ */
+std::size_t SerializeAttributesBatch(const char* job,
+                                     const std::vector<DeviceRecord>& records,
+                                     std::size_t first,
+                                     POOLMEM*& msg,
+                                     int32_t& message_length,
+                                     uint32_t max_length)
+{
+  static constexpr uint32_t record_header_length = 5 * sizeof(uint32_t);
+  ser_declare;
+
+  std::size_t last = first;
+  uint32_t length = sizeof(FileAttributesBatch) + MAX_NAME_LENGTH;
+  do {
+    length += record_header_length + records[last].data_len;
+    ++last;
+  } while (last < records.size()
+           && length + record_header_length + records[last].data_len
+                  <= max_length);
+
+  msg = CheckPoolMemorySize(msg, length + 1);
+  message_length
+      = Bsnprintf(msg, sizeof(FileAttributesBatch) + MAX_NAME_LENGTH + 1,
+                  FileAttributesBatch, job);
+  SerBegin(msg + message_length, 0);
+  for (std::size_t i = first; i < last; ++i) {
+    ser_uint32(records[i].VolSessionId);
+    ser_uint32(records[i].VolSessionTime);
+    ser_int32(records[i].FileIndex);
+    ser_int32(records[i].Stream);
+    ser_uint32(records[i].data_len);
+    SerBytes(records[i].data, records[i].data_len);
+  }
+  message_length = SerLength(msg);
+
+  return last;
+}
+
 /**
  * Request the sysop to create an appendable volume
  *
@@ -1,7 +1,7 @@
 /*
    BAREOS® - Backup Archiving REcovery Open Sourced
 
-   Copyright (C) 2023-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2023-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -22,8 +22,23 @@
 #define BAREOS_STORED_ASKDIR_H_
 
 #include "lib/jcr.h"
+#include "stored/record.h"
+
+#include <vector>
 
 namespace storagedaemon {
+
+// Largest FileAttributesBatch message sent to the Director
+inline constexpr uint32_t kMaxAttributesBatchLength = 64 * 1024;
+
+std::size_t SerializeAttributesBatch(
+    const char* job,
+    const std::vector<DeviceRecord>& records,
+    std::size_t first,
+    POOLMEM*& msg,
+    int32_t& message_length,
+    uint32_t max_length = kMaxAttributesBatchLength);
+
 // deletes all null jobmedia records from the current job (jcr->job)
 // a null jobmedia record is a record with firstindex = 0 and lastindex = 0
 bool DeleteNullJobmediaRecords(JobControlRecord* jcr);
@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2000-2011 Free Software Foundation Europe e.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -174,9 +174,8 @@ bool AuthenticateWithStoragedaemon(JobControlRecord* jcr)
  *
  * This is used for FD backups or restores.
  */
-bool AuthenticateFiledaemon(JobControlRecord* jcr)
+bool AuthenticateFiledaemon(JobControlRecord* jcr, BareosSocket* fd)
 {
-  BareosSocket* fd = jcr->file_bsock;
   s_password password;
 
   password.encoding = p_encoding_md5;
@@ -194,6 +193,31 @@ bool AuthenticateFiledaemon(JobControlRecord* jcr)
   return true;
 }
 
+/**
+ * Authenticate an additional data connection of a File daemon.
+ *
+ * Only the job connection authenticates the job, so jcr->authenticated is
+ * not touched and the job connection can still follow.
+ */
+bool AuthenticateDataConnection(JobControlRecord* jcr, BareosSocket* fd)
+{
+  s_password password;
+
+  password.encoding = p_encoding_md5;
+  password.value = jcr->sd_auth_key;
+
+  if (!fd->AuthenticateInboundConnection(nullptr, my_config, jcr->client_name,
+                                         password, me)) {
+    Jmsg1(jcr, M_WARNING, 0,
+          T_("Authorization problem: Two way security handshake failed with "
+             "data connection of File daemon at %s\n"),
+          fd->who());
+    return false;
+  }
+
+  return true;
+}
+
 /**
  * Authenticate with a remote file daemon.
  *
@@ -2,7 +2,7 @@
 /*
    BAREOS® - Backup Archiving REcovery Open Sourced
 
-   Copyright (C) 2018-2018 Bareos GmbH & Co. KG
+   Copyright (C) 2018-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -27,7 +27,8 @@ namespace storagedaemon {
 bool AuthenticateDirector(JobControlRecord* jcr);
 bool AuthenticateStoragedaemon(JobControlRecord* jcr);
 bool AuthenticateWithStoragedaemon(JobControlRecord* jcr);
-bool AuthenticateFiledaemon(JobControlRecord* jcr);
+bool AuthenticateFiledaemon(JobControlRecord* jcr, BareosSocket* fd);
+bool AuthenticateDataConnection(JobControlRecord* jcr, BareosSocket* fd);
 bool AuthenticateWithFiledaemon(JobControlRecord* jcr);
 
 } /* namespace storagedaemon */
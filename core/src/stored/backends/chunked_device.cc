@@ -127,6 +127,25 @@ void ChunkedDevice::FreeChunkIoRequest(chunk_io_request* request)
   free(request);
 }
 
+// Call back function for comparing two chunk_io_requests.
+static int CompareChunkIoRequest(ocbuf_item* ocbuf1, ocbuf_item* ocbuf2)
+{
+  chunk_io_request* chunk1 = (chunk_io_request*)ocbuf1->data;
+  chunk_io_request* chunk2 = (chunk_io_request*)ocbuf2->data;
+
+  // Same volume name ?
+  if (bstrcmp(chunk1->volname, chunk2->volname)) {
+    // Compare on chunk number.
+    if (chunk1->chunk == chunk2->chunk) {
+      return 0;
+    } else {
+      return (chunk1->chunk < chunk2->chunk) ? -1 : 1;
+    }
+  } else {
+    return strcmp(chunk1->volname, chunk2->volname);
+  }
+}
+
 // Start the io-threads that are used for uploading.
 bool ChunkedDevice::StartIoThreads()
 {
@@ -138,9 +157,11 @@ bool ChunkedDevice::StartIoThreads()
   /* Create a new ordered circular buffer for exchanging chunks between
    * the producer (the storage driver) and multiple consumers (io-threads). */
   if (io_slots_) {
-    cb_ = new storagedaemon::ordered_circbuf(io_threads_ * io_slots_);
+    cb_ = new storagedaemon::ordered_circbuf(CompareChunkIoRequest,
+                                             io_threads_ * io_slots_);
   } else {
-    cb_ = new storagedaemon::ordered_circbuf(io_threads_ * OQSIZE);
+    cb_ = new storagedaemon::ordered_circbuf(CompareChunkIoRequest,
+                                             io_threads_ * OQSIZE);
   }
 
   // Start all IO threads and keep track of their thread ids in thread_ids_.
@@ -280,25 +301,6 @@ int ChunkedDevice::NrInflightChunks()
   return retval;
 }
 
-// Call back function for comparing two chunk_io_requests.
-static int CompareChunkIoRequest(ocbuf_item* ocbuf1, ocbuf_item* ocbuf2)
-{
-  chunk_io_request* chunk1 = (chunk_io_request*)ocbuf1->data;
-  chunk_io_request* chunk2 = (chunk_io_request*)ocbuf2->data;
-
-  // Same volume name ?
-  if (bstrcmp(chunk1->volname, chunk2->volname)) {
-    // Compare on chunk number.
-    if (chunk1->chunk == chunk2->chunk) {
-      return 0;
-    } else {
-      return (chunk1->chunk < chunk2->chunk) ? -1 : 1;
-    }
-  } else {
-    return strcmp(chunk1->volname, chunk2->volname);
-  }
-}
-
 // Call back function for updating two chunk_io_requests.
 static void UpdateChunkIoRequest(void* item1, void* item2)
 {
@@ -349,8 +351,8 @@ bool ChunkedDevice::EnqueueChunk(chunk_io_request* request)
    * This returns either the same request as we passed
    * in or the previous flush request for the same chunk. */
   enqueued_request = (chunk_io_request*)cb_->enqueue(
-      new_request, sizeof(chunk_io_request), CompareChunkIoRequest,
-      UpdateChunkIoRequest, false, /* use_reserved_slot */
+      new_request, sizeof(chunk_io_request), UpdateChunkIoRequest,
+      false, /* use_reserved_slot */
       false /* no_signal */);
 
   // Compare the return value from the enqueue.
@@ -438,8 +440,8 @@ bool ChunkedDevice::DequeueChunk()
        * This returns either the same request as we passed
        * in or the previous flush request for the same chunk. */
       enqueued_request = (chunk_io_request*)cb_->enqueue(
-          new_request, sizeof(chunk_io_request), CompareChunkIoRequest,
-          UpdateChunkIoRequest, true, /* use_reserved_slot */
+          new_request, sizeof(chunk_io_request), UpdateChunkIoRequest,
+          true, /* use_reserved_slot */
           true /* no_signal */);
       // See if the enqueue succeeded.
       if (!enqueued_request) {
@@ -594,12 +596,12 @@ int ChunkedDevice::SetupChunk(const char*, int flags, int)
 
   current_chunk_->chunk_setup = false;
 
-  /* We need to limit the maximum size of a chunked volume to MAX_CHUNKS *
+  /* We need to limit the maximum size of a chunked volume to max_chunks_ *
    * chunk_size). */
-  if (max_volume_size == 0
-      || max_volume_size
-             > (uint64_t)(MAX_CHUNKS * current_chunk_->chunk_size)) {
-    max_volume_size = MAX_CHUNKS * current_chunk_->chunk_size;
+  uint64_t max_chunked_volume_size
+      = static_cast<uint64_t>(max_chunks_) * current_chunk_->chunk_size;
+  if (max_volume_size == 0 || max_volume_size > max_chunked_volume_size) {
+    max_volume_size = max_chunked_volume_size;
   }
 
   // On open set begin offset to 0.
@@ -50,9 +50,9 @@ namespace storagedaemon {
 #define DEFAULT_CHUNK_SIZE 10 * 1024 * 1024
 
 /*
- * Maximum number of chunks per volume.
- * When you change this make sure you update the %04d format
- * used in the code to format the chunk numbers e.g. 0000-9999
+ * Default maximum number of chunks per volume.
+ * Chunk numbers are formatted with %04d, so the first 10000 chunks are named
+ * 0000-9999 and any further chunks just get more digits.
  */
 #define MAX_CHUNKS 10000
 
@@ -77,7 +77,7 @@ struct thread_handle {
 
 struct chunk_io_request {
   const char* volname; /* VolumeName */
-  uint16_t chunk;      /* Chunk number */
+  uint32_t chunk;      /* Chunk number */
   char* buffer;        /* Data */
   uint32_t wbuflen;    /* Size of the actual valid data in the chunk (Write) */
   uint32_t* rbuflen;   /* Size of the actual valid data in the chunk (Read) */
@@ -127,6 +127,7 @@ class ChunkedDevice : public Device {
   uint8_t io_slots_{};
   uint8_t retries_{};
   uint64_t chunk_size_{};
+  uint32_t max_chunks_{MAX_CHUNKS};
   boffset_t offset_{};
   bool use_mmap_{};
 
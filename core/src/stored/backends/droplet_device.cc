@@ -48,8 +48,11 @@
 #include "droplet_device.h"
 #include "lib/edit.h"
 
+#include <algorithm>
 #include <string>
 
+#include <json.h>
+
 namespace storagedaemon {
 
 // Options that can be specified for this device type.
@@ -65,7 +68,9 @@ enum device_option_type
   argument_iothreads,
   argument_ioslots,
   argument_retries,
-  argument_mmap
+  argument_mmap,
+  argument_partsize,
+  argument_maxchunks
 };
 
 struct device_option {
@@ -85,6 +90,8 @@ static device_option device_options[]
        {"ioslots=", argument_ioslots, 8},
        {"retries=", argument_retries, 8},
        {"mmap", argument_mmap, 4},
+       {"partsize=", argument_partsize, 9},
+       {"maxchunks=", argument_maxchunks, 10},
        {NULL, argument_none, 0}};
 
 static int droplet_reference_count = 0;
@@ -220,7 +227,7 @@ bool DropletDevice::ForEachChunkInDirectoryRunCallback(
   PoolMem path(PM_NAME);
 
   bool found = true;
-  int i = 0;
+  uint32_t i = 0;
   int tries = 0;
 
   while ((i < max_chunks_) && (found) && (retval)) {
@@ -394,6 +401,58 @@ bool DropletDevice::CheckRemoteConnection()
   }
 }
 
+/*
+ * Upload a chunk as a multipart upload of part_size_ sized parts.
+ * The parts of one chunk are sent one after another, the stream api of
+ * libdroplet is not thread safe. Multiple chunks are uploaded in parallel
+ * by the io-threads, so this bounds the size of a single request without
+ * needing any additional buffer memory.
+ */
+dpl_status_t DropletDevice::UploadChunkInParts(const char* chunk_name,
+                                               chunk_io_request* request)
+{
+  dpl_status_t status;
+  dpl_vfile_t* vfile = NULL;
+  dpl_sysmd_t* sysmd = dpl_sysmd_dup(&sysmd_);
+
+  dpl_vfile_flag_t flags = (dpl_vfile_flag_t)(
+      DPL_VFILE_FLAG_CREAT | DPL_VFILE_FLAG_WRONLY | DPL_VFILE_FLAG_STREAM);
+  status = dpl_open(ctx_,       /* context */
+                    chunk_name, /* locator */
+                    flags,      /* flags */
+                    NULL,       /* options */
+                    NULL,       /* condition */
+                    NULL,       /* metadata */
+                    sysmd,      /* sysmd */
+                    NULL,       /* query_params */
+                    NULL,       /* stream_status */
+                    &vfile);    /* vfilep */
+  dpl_sysmd_free(sysmd);
+  if (status != DPL_SUCCESS) { return status; }
+
+  uint32_t offset = 0;
+  while (offset < request->wbuflen) {
+    struct json_object* stream_status = NULL;
+    uint32_t len = std::min<uint64_t>(request->wbuflen - offset, part_size_);
+
+    Dmsg3(100, "Uploading part of chunk %s at offset %u (%u bytes)\n",
+          chunk_name, offset, len);
+    status = dpl_fstream_put(vfile, request->buffer + offset, len,
+                             &stream_status);
+    if (stream_status) { json_object_put(stream_status); }
+    if (status != DPL_SUCCESS) { goto bail_out; }
+
+    offset += len;
+  }
+
+  status = dpl_fstream_flush(vfile);
+
+bail_out:
+  dpl_close(vfile);
+
+  return status;
+}
+
 /*
  * Internal method for flushing a chunk to the backing store.
  * This does the real work either by being called from a
@@ -492,22 +551,26 @@ bool DropletDevice::FlushRemoteChunk(chunk_io_request* request)
 
     dpl_sysmd_free(sysmd);
     sysmd = dpl_sysmd_dup(&sysmd_);
-    status = dpl_fput(ctx_,                   /* context */
-                      chunk_name.c_str(),     /* locator */
-                      &dpl_options,           /* options */
-                      NULL,                   /* condition */
-                      NULL,                   /* range */
-                      NULL,                   /* metadata */
-                      sysmd,                  /* sysmd */
-                      (char*)request->buffer, /* data_buf */
-                      request->wbuflen);      /* data_len */
+    if (part_size_ > 0 && request->wbuflen > part_size_) {
+      status = UploadChunkInParts(chunk_name.c_str(), request);
+    } else {
+      status = dpl_fput(ctx_,                   /* context */
+                        chunk_name.c_str(),     /* locator */
+                        &dpl_options,           /* options */
+                        NULL,                   /* condition */
+                        NULL,                   /* range */
+                        NULL,                   /* metadata */
+                        sysmd,                  /* sysmd */
+                        (char*)request->buffer, /* data_buf */
+                        request->wbuflen);      /* data_len */
+    }
 
     switch (status) {
       case DPL_SUCCESS:
         success = true;
         goto bail_out;
       default:
-        Mmsg2(errmsg, T_("Failed to flush %s using dpl_fput(): ERR=%s.\n"),
+        Mmsg2(errmsg, T_("Failed to flush %s: ERR=%s.\n"),
               chunk_name.c_str(), dpl_status_str(status));
         dev_errno = DropletErrnoToSystemErrno(status);
         Bmicrosleep(INFLIGT_RETRY_TIME, 0);
@@ -784,6 +847,22 @@ bool DropletDevice::initialize()
               use_mmap_ = true;
               done = true;
               break;
+            case argument_partsize:
+              size_to_uint64(bp + device_options[i].compare_size, &value);
+              part_size_ = value;
+              done = true;
+              break;
+            case argument_maxchunks:
+              size_to_uint64(bp + device_options[i].compare_size, &value);
+              if (value == 0 || value > UINT32_MAX) {
+                Mmsg1(errmsg, T_("Illegal maxchunks argument %s\n"),
+                      bp + device_options[i].compare_size);
+                Emsg0(M_FATAL, 0, errmsg);
+                goto bail_out;
+              }
+              max_chunks_ = value;
+              done = true;
+              break;
             default:
               break;
           }
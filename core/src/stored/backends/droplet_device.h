@@ -50,8 +50,6 @@ typedef dpl_status_t (*t_dpl_walk_chunks_call_back)(dpl_sysmd_t* sysmd,
 
 class DropletDevice : public ChunkedDevice {
  private:
-  /* maximun number of chunks in a volume (0000 to 9999) */
-  const int max_chunks_ = 10000;
   char* configstring_{};
   const char* profile_{};
   const char* location_{};
@@ -60,9 +58,12 @@ class DropletDevice : public ChunkedDevice {
   const char* bucketname_{};
   dpl_ctx_t* ctx_{};
   dpl_sysmd_t sysmd_{};
+  uint64_t part_size_{}; /* 0 means upload each chunk as a whole */
 
   bool initialize();
   dpl_status_t check_path(const char* path);
+  dpl_status_t UploadChunkInParts(const char* chunk_name,
+                                  chunk_io_request* request);
 
   // Interface from ChunkedDevice
   bool CheckRemoteConnection() override;
@@ -33,7 +33,9 @@
 
 #include "include/fcntl_def.h"
 #include "include/bareos.h"
+#include "lib/edit.h"
 #include "stored/device_control_record.h"
+#include "stored/device_status_information.h"
 #include "stored/stored.h"
 #include "generic_tape_device.h"
 #include "stored/autochanger.h"
@@ -1347,15 +1349,56 @@ int generic_tape_device::d_open(const char* pathname, int flags, int mode)
 
 ssize_t generic_tape_device::d_read(int t_fd, void* buffer, size_t count)
 {
+  if (!DrainStreamBuffer()) { return -1; }
   return ::read(t_fd, buffer, count);
 }
 
+static TapeStreamBuffer::WriteFunction WriteTo(int t_fd)
+{
+  return [t_fd](const void* data, size_t len) {
+    return ::write(t_fd, data, len);
+  };
+}
+
 ssize_t generic_tape_device::d_write(int t_fd, const void* buffer, size_t count)
 {
+  if (!stream_buffer_ && device_resource
+      && device_resource->streaming_buffer_size > 0) {
+    stream_buffer_ = std::make_unique<TapeStreamBuffer>(
+        print_name(), device_resource->streaming_buffer_size, WriteTo(t_fd));
+  }
+  if (stream_buffer_ && stream_buffer_->KeepsBlocks()) {
+    /* The blocks kept at the end of the last volume follow the label of the
+     * next one, which is the first block written at its beginning. */
+    if (file == 0 && block_num == 0) { return ::write(t_fd, buffer, count); }
+    stream_buffer_->Resume(WriteTo(t_fd));
+  }
+  if (stream_buffer_) { return stream_buffer_->Write(buffer, count); }
   return ::write(t_fd, buffer, count);
 }
 
-int generic_tape_device::d_close(int t_fd) { return ::close(t_fd); }
+int generic_tape_device::d_close(int t_fd)
+{
+  bool drained = DrainStreamBuffer();
+  // blocks kept at the end of the volume are written to the next one
+  if (stream_buffer_ && !stream_buffer_->KeepsBlocks()) {
+    TapeStreamBuffer::Statistics stats = stream_buffer_->GetStatistics();
+    Dmsg5(100,
+          "%s: streaming buffer wrote %llu blocks in %llu bursts, max fill "
+          "%zu bytes, %llu waits for the drive\n",
+          print_name(), static_cast<unsigned long long>(stats.blocks_written),
+          static_cast<unsigned long long>(stats.bursts), stats.max_fill,
+          static_cast<unsigned long long>(stats.producer_waits));
+    stream_buffer_.reset();
+  }
+
+  int status = ::close(t_fd);
+  if (!drained) {
+    errno = EIO;
+    return -1;
+  }
+  return status;
+}
 
 int generic_tape_device::d_ioctl(int, ioctl_req_t, char*) { return -1; }
 
@@ -1370,4 +1413,43 @@ bool generic_tape_device::d_truncate(DeviceControlRecord*)
   return true; /* We don't really truncate tapes */
 }
 
+// Make sure all blocks of a job are on tape before the job finishes
+bool generic_tape_device::d_flush(DeviceControlRecord*)
+{
+  if (!DrainStreamBuffer()) { return false; }
+  if (stream_buffer_ && stream_buffer_->KeepsBlocks()) {
+    errno = ENOSPC;
+    return false;
+  }
+  return true;
+}
+
+bool generic_tape_device::DrainStreamBuffer()
+{
+  return !stream_buffer_ || stream_buffer_->Drain();
+}
+
+// Return the fill statistics of the streaming buffer.
+bool generic_tape_device::DeviceStatus(DeviceStatusInformation* dst)
+{
+  if (!stream_buffer_) { return false; }
+
+  TapeStreamBuffer::Statistics stats = stream_buffer_->GetStatistics();
+  char fill[50], max_fill[50], capacity[50], written[50];
+  PoolMem status(PM_MESSAGE);
+
+  status.bsprintf(
+      T_("Streaming buffer: %s of %s used, max %s. Written %s in %llu "
+         "bursts, %llu waits for the drive.\n"),
+      edit_uint64_with_suffix(stats.fill, fill),
+      edit_uint64_with_suffix(stats.capacity, capacity),
+      edit_uint64_with_suffix(stats.max_fill, max_fill),
+      edit_uint64_with_suffix(stats.bytes_written, written),
+      static_cast<unsigned long long>(stats.bursts),
+      static_cast<unsigned long long>(stats.producer_waits));
+  dst->status_length = PmStrcpy(dst->status, status.c_str());
+
+  return true;
+}
+
 } /* namespace storagedaemon  */
@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2014-2014 Planets Communications B.V.
-   Copyright (C) 2014-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2014-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -29,6 +29,9 @@
 #define BAREOS_STORED_BACKENDS_GENERIC_TAPE_DEVICE_H_
 
 #include "stored/dev.h"
+#include "stored/tape_stream_buffer.h"
+
+#include <memory>
 
 namespace storagedaemon {
 
@@ -73,11 +76,19 @@ class generic_tape_device : public Device {
   virtual ssize_t d_read(int fd, void* buffer, size_t count) override;
   virtual ssize_t d_write(int fd, const void* buffer, size_t count) override;
   virtual bool d_truncate(DeviceControlRecord* dcr) override;
+  virtual bool d_flush(DeviceControlRecord* dcr) override;
+  virtual bool DeviceStatus(DeviceStatusInformation* dst) override;
+
+ protected:
+  // Wait until buffered blocks are on tape, before using the drive otherwise
+  bool DrainStreamBuffer();
 
  private:
   bool do_mount(DeviceControlRecord* dcr, int mount, int dotimeout);
   void OsClrError();
   void HandleError(int func);
+
+  std::unique_ptr<TapeStreamBuffer> stream_buffer_;
 };
 
 } /* namespace storagedaemon */
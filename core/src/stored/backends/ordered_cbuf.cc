@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2016-2017 Planets Communications B.V.
-   Copyright (C) 2017-2022 Bareos GmbH & Co. KG
+   Copyright (C) 2017-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -23,7 +23,6 @@
 
 // Ordered Circular buffer used for producer/consumer problem with pthreads.
 #include "include/bareos.h"
-#include "lib/dlist.h"
 #include "ordered_cbuf.h"
 namespace storagedaemon {
 
@@ -47,12 +46,7 @@ int ordered_circbuf::init(int capacity)
   size_ = 0;
   capacity_ = capacity;
   reserved_ = 0;
-  if (data_) {
-    data_->destroy();
-    delete data_;
-  }
-  static_assert(offsetof(ocbuf_item, link) == 0);
-  data_ = new dlist<ocbuf_item>();
+  data_.clear();
 
   return 0;
 }
@@ -63,22 +57,16 @@ void ordered_circbuf::destroy()
   pthread_cond_destroy(&notempty_);
   pthread_cond_destroy(&notfull_);
   pthread_mutex_destroy(&lock_);
-  if (data_) {
-    data_->destroy();
-    delete data_;
-  }
+  data_.clear();
 }
 
 // Enqueue a new item into the ordered circular buffer.
 void* ordered_circbuf::enqueue(void* data,
                                uint32_t data_size,
-                               int compare(ocbuf_item*, ocbuf_item*),
                                void update(void*, void*),
                                bool use_reserved_slot,
                                bool no_signal)
 {
-  struct ocbuf_item *new_item, *item;
-
   if (pthread_mutex_lock(&lock_) != 0) { return NULL; }
 
   // See if we should use a reserved slot and there are actually slots reserved.
@@ -95,31 +83,24 @@ void* ordered_circbuf::enqueue(void* data,
   if (use_reserved_slot) { reserved_--; }
 
   /*
-   * Binary insert the data into the ordered circular buffer. If the
-   * item returned is not our new_item it means there is already an
-   * entry with the same keys on the ordered circular list. We then
-   * just call the update function callback which should perform the
-   * right actions to update the already existing item with the new
-   * data in the new item. The compare function callback is used to binary
-   * insert the item at the right location in the ordered circular list.
+   * Insert the data into the ordered circular buffer. If there is already
+   * an entry with the same keys on the ordered circular list we just call
+   * the update function callback which should perform the right actions to
+   * update the already existing item with the new data.
    */
-  new_item = (struct ocbuf_item*)malloc(sizeof(struct ocbuf_item));
-  new_item->data = data;
-  new_item->data_size = data_size;
-
-  item = (struct ocbuf_item*)data_->binary_insert(new_item, compare);
-  if (item == new_item) {
+  auto [item, inserted] = data_.insert(ocbuf_item{data_size, data});
+  if (inserted) {
     size_++;
+
+    // Let a waiting consumer know there is data.
+    if (!no_signal) { pthread_cond_signal(&notempty_); }
   } else {
     /*
      * Update the data on the ordered circular list with the new data.
-     * e.g. replace the old with the new data but don't allocate a new
-     * item on the ordered circular list.
+     * e.g. replace the old with the new data but don't add a new
+     * item to the ordered circular list.
      */
-    update(item->data, new_item->data);
-
-    // Release the unused ocbuf_item.
-    free(new_item);
+    update(item->data, data);
 
     /*
      * Update data to point to the data that was attached to the original
@@ -128,12 +109,6 @@ void* ordered_circbuf::enqueue(void* data,
     data = item->data;
   }
 
-  // See if we need to signal any workers that work is available or not.
-  if (!no_signal) {
-    // Let any waiting consumer know there is data.
-    pthread_cond_broadcast(&notempty_);
-  }
-
   pthread_mutex_unlock(&lock_);
 
   /*
@@ -150,7 +125,6 @@ void* ordered_circbuf::dequeue(bool reserve_slot,
                                int timeout)
 {
   void* data = NULL;
-  struct ocbuf_item* item;
 
   if (pthread_mutex_lock(&lock_) != 0) { return NULL; }
 
@@ -209,19 +183,13 @@ void* ordered_circbuf::dequeue(bool reserve_slot,
   // When we are requested to flush and there is no data left return NULL.
   if (empty() && flush_) { goto bail_out; }
 
-  // Get the first item from the dlist and remove it.
-  item = (struct ocbuf_item*)data_->first();
-  if (!item) { goto bail_out; }
-
-  data_->remove(item);
+  // Get the first item and remove it.
+  data = data_.begin()->data;
+  data_.erase(data_.begin());
   size_--;
 
-  // Let all waiting producers know there is room.
-  pthread_cond_broadcast(&notfull_);
-
-  // Extract the payload and drop the placeholder.
-  data = item->data;
-  free(item);
+  // Let a waiting producer know there is room.
+  pthread_cond_signal(&notfull_);
 
   // Increase the reserved slot count when we are asked to reserve the slot.
   if (reserve_slot) { reserved_++; }
@@ -243,7 +211,6 @@ void* ordered_circbuf::peek(enum oc_peek_types type,
                             int callback(void* item1, void* item2))
 {
   void* retval = NULL;
-  struct ocbuf_item* item;
 
   if (pthread_mutex_lock(&lock_) != 0) { return NULL; }
 
@@ -256,44 +223,32 @@ void* ordered_circbuf::peek(enum oc_peek_types type,
    */
   switch (type) {
     case PEEK_FIRST:
-      item = (struct ocbuf_item*)data_->first();
-      while (item) {
-        if (callback(item->data, data) == 0) {
-          retval = malloc(item->data_size);
-          memcpy(retval, item->data, item->data_size);
+      for (auto& item : data_) {
+        if (callback(item.data, data) == 0) {
+          retval = malloc(item.data_size);
+          memcpy(retval, item.data, item.data_size);
           goto bail_out;
         }
-
-        item = (struct ocbuf_item*)data_->next(item);
       }
       break;
     case PEEK_LAST:
-      item = (struct ocbuf_item*)data_->last();
-      while (item) {
-        if (callback(item->data, data) == 0) {
-          retval = malloc(item->data_size);
-          memcpy(retval, item->data, item->data_size);
+      for (auto it = data_.rbegin(); it != data_.rend(); ++it) {
+        if (callback(it->data, data) == 0) {
+          retval = malloc(it->data_size);
+          memcpy(retval, it->data, it->data_size);
           goto bail_out;
         }
-
-        item = (struct ocbuf_item*)data_->prev(item);
       }
       break;
     case PEEK_LIST:
-      item = (struct ocbuf_item*)data_->first();
-      while (item) {
-        callback(item->data, data);
-        item = (struct ocbuf_item*)data_->next(item);
-      }
+      for (auto& item : data_) { callback(item.data, data); }
       break;
     case PEEK_CLONE:
-      item = (struct ocbuf_item*)data_->first();
-      while (item) {
-        if (callback(item->data, data) == 0) {
+      for (auto& item : data_) {
+        if (callback(item.data, data) == 0) {
           retval = data;
           break;
         }
-        item = (struct ocbuf_item*)data_->next(item);
       }
       break;
     default:
@@ -320,8 +275,8 @@ int ordered_circbuf::unreserve_slot()
   if (reserved_) {
     reserved_--;
 
-    // Let all waiting producers know there is room.
-    pthread_cond_broadcast(&notfull_);
+    // Let a waiting producer know there is room.
+    pthread_cond_signal(&notfull_);
 
     retval = 0;
   }
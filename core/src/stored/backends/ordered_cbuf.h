@@ -2,7 +2,7 @@
    BAREOS® - Backup Archiving REcovery Open Sourced
 
    Copyright (C) 2016-2017 Planets Communications B.V.
-   Copyright (C) 2017-2022 Bareos GmbH & Co. KG
+   Copyright (C) 2017-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -26,6 +26,8 @@
 #ifndef BAREOS_STORED_BACKENDS_ORDERED_CBUF_H_
 #define BAREOS_STORED_BACKENDS_ORDERED_CBUF_H_
 
+#include <set>
+
 #define OQSIZE 10 /* # of pointers in the queue */
 
 namespace storagedaemon {
@@ -39,11 +41,18 @@ enum oc_peek_types
 };
 
 struct ocbuf_item {
-  dlink<ocbuf_item> link;
   uint32_t data_size = 0;
   void* data = nullptr;
 };
 
+typedef int(ocbuf_compare_t)(ocbuf_item* item1, ocbuf_item* item2);
+
+/*
+ * The items are kept in a balanced tree ordered by the compare callback,
+ * so enqueue (including finding an existing item for the same key) and
+ * dequeue of the first item are O(log n).
+ */
+
 class ordered_circbuf {
  private:
   int size_ = 0;
@@ -54,17 +63,26 @@ class ordered_circbuf {
   pthread_cond_t notfull_
       = PTHREAD_COND_INITIALIZER; /* Full -> not full condition */
   pthread_cond_t notempty_
-      = PTHREAD_COND_INITIALIZER;     /* Empty -> not empty condition */
-  dlist<ocbuf_item>* data_ = nullptr; /* Circular buffer of pointers */
+      = PTHREAD_COND_INITIALIZER; /* Empty -> not empty condition */
+
+  struct ItemOrder {
+    ocbuf_compare_t* compare;
+    bool operator()(const ocbuf_item& item1, const ocbuf_item& item2) const
+    {
+      return compare(const_cast<ocbuf_item*>(&item1),
+                     const_cast<ocbuf_item*>(&item2))
+             < 0;
+    }
+  };
+  std::set<ocbuf_item, ItemOrder> data_; /* Ordered items */
 
  public:
-  ordered_circbuf(int capacity = OQSIZE);
+  ordered_circbuf(ocbuf_compare_t* compare, int capacity = OQSIZE);
   ~ordered_circbuf();
   int init(int capacity);
   void destroy();
   void* enqueue(void* data,
                 uint32_t data_size,
-                int compare(ocbuf_item*, ocbuf_item*),
                 void update(void*, void*),
                 bool use_reserved_slot = false,
                 bool no_signal = false);
@@ -84,7 +102,11 @@ class ordered_circbuf {
 };
 
 // Constructor
-inline ordered_circbuf::ordered_circbuf(int capacity) { init(capacity); }
+inline ordered_circbuf::ordered_circbuf(ocbuf_compare_t* compare, int capacity)
+    : data_(ItemOrder{compare})
+{
+  init(capacity);
+}
 
 // Destructor
 inline ordered_circbuf::~ordered_circbuf() { destroy(); }
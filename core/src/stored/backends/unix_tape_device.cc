@@ -65,6 +65,7 @@ static std::vector<std::size_t> bufsizes(std::size_t count)
 
 int unix_tape_device::d_ioctl(int t_fd, ioctl_req_t request, char* op)
 {
+  if (!DrainStreamBuffer()) { return -1; }
   return ::ioctl(t_fd, request, op);
 }
 
@@ -75,6 +76,7 @@ unix_tape_device::unix_tape_device()
 
 ssize_t unix_tape_device::d_read(int t_fd, void* buffer, size_t count)
 {
+  if (!DrainStreamBuffer()) { return -1; }
   ssize_t ret = ::read(t_fd, buffer, count);
   /* If the driver fails to `read()` with `ENOMEM`, then the provided buffer
    * was too small. By re-reading with a temporary buffer that is enlarged
@@ -438,7 +438,8 @@ static bool TerminateWritingVolume(DeviceControlRecord* dcr)
 
   /* Create a JobMedia record to indicated end of tape */
   dev->VolCatInfo.VolCatFiles = dev->file;
-  if (!dcr->DirCreateJobmediaRecord(false)) {
+  if (!dcr->DirCreateJobmediaRecord(false)
+      || !dcr->DirFlushJobmediaRecords()) {
     Dmsg0(50, "Error from create JobMedia\n");
     dev->dev_errno = EIO;
     Mmsg2(dev->errmsg,
@@ -718,6 +719,7 @@ bool DeviceControlRecord::WriteBlockToDev()
     }
     status = dev->write(block->buf, (size_t)wlen);
   } while (status == -1 && (errno == EBUSY) && retry++ < 3);
+  dev->block_write_latency.Observe(dev->last_tick);
 
   if (debug_block_checksum) {
     uint32_t achecksum = SerBlockHeader(block, dev->DoChecksum());
@@ -823,6 +825,8 @@ bool DeviceControlRecord::WriteBlockToDev()
         (int)(dev->VolCatInfo.VolCatBytes + wlen));
   dev->VolCatInfo.VolCatBytes += wlen;
   dev->VolCatInfo.VolCatBlocks++;
+  dev->blocks_written.Add();
+  dev->block_bytes_written.Add(wlen);
   dev->EndBlock = dev->block_num;
   dev->EndFile = dev->file;
   dev->LastBlock = block->BlockNumber;
@@ -57,6 +57,14 @@
 #include "lib/version.h"
 #include "lib/compression.h"
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 /* Dummy functions */
 namespace storagedaemon {
 extern bool ParseSdConfig(const char* configfile, int exit_code);
@@ -65,6 +73,8 @@ extern bool ParseSdConfig(const char* configfile, int exit_code);
 using namespace storagedaemon;
 
 /* Forward referenced functions */
+static bool SetupScan(std::string device_name, DirectorResource* director);
+static void CleanupScan();
 static void do_scan(void);
 static bool RecordCb(DeviceControlRecord* dcr, DeviceRecord* rec);
 static bool CreateFileAttributesRecord(BareosDb* db,
@@ -89,47 +99,83 @@ static bool UpdateJobRecord(BareosDb* db,
                             DeviceRecord* rec);
 static bool CreateClientRecord(BareosDb* db, ClientDbRecord* cr);
 static bool CreateFilesetRecord(BareosDb* db, FileSetDbRecord* fsr);
-static bool CreateJobmediaRecord(BareosDb* db, JobControlRecord* jcr);
+static bool CreateJobmediaRecord(JobControlRecord* jcr);
 static JobControlRecord* create_jcr(JobDbRecord* jr,
                                     DeviceRecord* rec,
                                     uint32_t JobId);
+static bool FlushCachedAttributes(BareosDb* db, JobId_t JobId);
+static void FlushAllCachedAttributes(BareosDb* db);
 static bool UpdateDigestRecord(BareosDb* db,
                                char* digest,
                                DeviceRecord* rec,
                                int type);
+static bool FlushJobmediaRecords(BareosDb* db);
 
 /* Local variables */
-static Device* dev = nullptr;
-static BareosDb* db;
-static JobControlRecord* bjcr; /* jcr for bscan */
 static BootStrapRecord* bsr = nullptr;
-static MediaDbRecord mr;
-static PoolDbRecord pr;
-static JobDbRecord jr;
-static ClientDbRecord cr;
-static FileSetDbRecord fsr;
-static RestoreObjectDbRecord rop;
-static AttributesDbRecord ar;
-static FileDbRecord fr;
-static Session_Label label;
-static Session_Label elabel;
-static Attributes* attr;
-
-static time_t lasttime = 0;
 
 static bool update_db = false;
 static bool update_vol_info = false;
 static bool list_records = false;
-static int ignored_msgs = 0;
 
-static uint64_t currentVolumeSize;
-static int last_pct = -1;
 static bool showProgress = false;
-static int num_jobs = 0;
-static int num_pools = 0;
-static int num_media = 0;
-static int num_files = 0;
-static int num_restoreobjects = 0;
+static std::atomic<int> num_jobs{0};
+static std::atomic<int> num_pools{0};
+static std::atomic<int> num_media{0};
+static std::atomic<int> num_files{0};
+static std::atomic<int> num_restoreobjects{0};
+
+/* The File Attributes of every job are held back until the next record of
+ * that job arrives, so that a following digest record can be stored together
+ * with them. This way they can go through the batch insert (COPY) path
+ * instead of inserting (and later updating) every File record on its own. */
+struct CachedAttributes {
+  AttributesDbRecord ar;
+  std::string fname;
+  std::string lname;
+  std::string attr;
+  std::string digest;
+};
+
+/* Everything needed to scan one set of volumes. Each set given with -V gets
+ * its own device, jcr and catalog connection, so that several sets can be
+ * scanned at the same time. */
+struct ScanContext {
+  std::string volumes;
+  Device* dev{nullptr};
+  BareosDb* db{nullptr};
+  JobControlRecord* bjcr{nullptr}; /* jcr for bscan */
+  bool update_db{false};
+  MediaDbRecord mr;
+  PoolDbRecord pr;
+  JobDbRecord jr;
+  ClientDbRecord cr;
+  FileSetDbRecord fsr;
+  RestoreObjectDbRecord rop;
+  AttributesDbRecord ar;
+  FileDbRecord fr;
+  Session_Label label;
+  Session_Label elabel;
+  Attributes* attr{nullptr};
+  time_t lasttime{0};
+  int ignored_msgs{0};
+  uint64_t currentVolumeSize{0};
+  int last_pct{-1};
+  std::unordered_map<JobId_t, CachedAttributes> cached_attributes;
+  /* JobMedia records of the current volume, they are written together
+   * before the Media record is updated at the end of the volume. */
+  std::vector<JobMediaDbRecord> jobmedia;
+};
+
+// The volume set scanned by this thread
+static thread_local ScanContext* scan = nullptr;
+
+/* Pool, Media, Client, FileSet and Job records can be shared by several
+ * volume sets, so the labels are processed by one scan at a time. */
+static std::mutex label_mutex;
+
+// Devices and jcrs are set up and torn down by one scan at a time
+static std::mutex setup_mutex;
 
 int main(int argc, char* argv[])
 {
@@ -216,12 +262,23 @@ int main(int argc, char* argv[])
   bscan_app.add_flag("-s,--update-db", update_db,
                      "Synchronize or store in database.");
 
-  std::string volumes;
+  std::vector<std::string> volume_sets;
   bscan_app
-      .add_option("-V,--volumes", volumes,
-                  "Specify volume names (separated by |).")
+      .add_option("-V,--volumes", volume_sets,
+                  "Specify volume names (separated by |).\n"
+                  "Can be given several times, every set of volumes is "
+                  "scanned on its own.")
+      ->allow_extra_args(false)
       ->type_name("<vol1|vol2|...>");
 
+  std::size_t threads = 1;
+  bscan_app
+      .add_option("--threads", threads,
+                  "Scan up to <number> sets of volumes at the same time.")
+      ->check(CLI::PositiveNumber)
+      ->type_name("<number>")
+      ->capture_default_str();
+
   AddVerboseOption(bscan_app);
 
   std::string work_dir;
@@ -287,64 +344,116 @@ int main(int argc, char* argv[])
           working_directory);
   }
 
-  DeviceControlRecord* dcr = new DeviceControlRecord;
-  bjcr = SetupJcr("bscan", device_name.data(), bsr, director, dcr, volumes,
-                  true);
-  if (!bjcr) { exit(BEXIT_FAILURE); }
-  dev = bjcr->sd_impl->read_dcr->dev;
-
-  // Let SD plugins setup the record translation
-  if (GeneratePluginEvent(bjcr, bSdEventSetupRecordTranslation, dcr)
-      != bRC_OK) {
-    Jmsg(bjcr, M_FATAL, 0, T_("bSdEventSetupRecordTranslation call failed!\n"));
+  if (volume_sets.empty()) { volume_sets.emplace_back(); }
+  if (bsr && volume_sets.size() > 1) {
+    Emsg0(M_ERROR_TERM, 0,
+          T_("A bootstrap file cannot be used with several volume sets.\n"));
   }
-
-
-  if (showProgress) {
-    char ed1[50];
-    struct stat sb;
-    fstat(dev->fd, &sb);
-    currentVolumeSize = sb.st_size;
-    Pmsg1(000, T_("First Volume Size = %s\n"),
-          edit_uint64(currentVolumeSize, ed1));
-  }
-
-  std::string db_driver = "postgresql";
-  db = db_init_database(nullptr, db_driver.c_str(), db_name.c_str(),
-                        db_user.c_str(), db_password.c_str(), db_host.c_str(),
-                        db_port, nullptr, false, false, false, false);
-  if (db == nullptr) {
-    Emsg0(M_ERROR_TERM, 0, T_("Could not init Bareos database\n"));
-  }
-  if (!db->OpenDatabase(nullptr)) { Emsg0(M_ERROR_TERM, 0, db->strerror()); }
-  Dmsg0(200, "Database opened\n");
   if (g_verbose) {
     Pmsg2(000, T_("Using Database: %s, User: %s\n"), db_name.c_str(),
           db_user.c_str());
   }
 
-  do_scan();
+  // Every thread scans the next volume set that is left until all are done
+  std::atomic<std::size_t> next_set{0};
+  std::atomic<bool> failed{false};
+  auto scan_volume_sets = [&]() {
+    for (std::size_t i = next_set++; i < volume_sets.size(); i = next_set++) {
+      ScanContext context;
+      context.volumes = volume_sets[i];
+      context.update_db = update_db;
+      scan = &context;
+      if (!SetupScan(device_name, director)) {
+        failed = true;
+        continue;
+      }
+
+      std::string db_driver = "postgresql";
+      context.db = db_init_database(
+          nullptr, db_driver.c_str(), db_name.c_str(), db_user.c_str(),
+          db_password.c_str(), db_host.c_str(), db_port, nullptr, false,
+          false, false, false, true);
+      if (context.db == nullptr) {
+        Emsg0(M_ERROR_TERM, 0, T_("Could not init Bareos database\n"));
+      }
+      if (!context.db->OpenDatabase(nullptr)) {
+        Emsg0(M_ERROR_TERM, 0, context.db->strerror());
+      }
+      Dmsg0(200, "Database opened\n");
+
+      do_scan();
+      CleanupScan();
+      scan = nullptr;
+    }
+  };
+
+  std::vector<std::thread> scanners;
+  for (std::size_t i = 1; i < threads && i < volume_sets.size(); ++i) {
+    scanners.emplace_back(scan_volume_sets);
+  }
+  scan_volume_sets();
+  for (auto& scanner : scanners) { scanner.join(); }
+
   if (update_db) {
     printf(
         "Records added or updated in the catalog:\n%7d Media\n"
         "%7d Pool\n%7d Job\n%7d File\n%7d RestoreObject\n",
-        num_media, num_pools, num_jobs, num_files, num_restoreobjects);
+        num_media.load(), num_pools.load(), num_jobs.load(), num_files.load(),
+        num_restoreobjects.load());
   } else {
     printf(
         "Records would have been added or updated in the catalog:\n"
         "%7d Media\n%7d Pool\n%7d Job\n%7d File\n%7d RestoreObject\n",
-        num_media, num_pools, num_jobs, num_files, num_restoreobjects);
+        num_media.load(), num_pools.load(), num_jobs.load(), num_files.load(),
+        num_restoreobjects.load());
   }
-  db->CloseDatabase(bjcr);
+  UnloadSdPlugins();
+
+  return failed ? BEXIT_FAILURE : BEXIT_SUCCESS;
+}
+
+// Set up the device and the jcr to read the volumes of this scan
+static bool SetupScan(std::string device_name, DirectorResource* director)
+{
+  std::lock_guard l{setup_mutex};
+
+  DeviceControlRecord* dcr = new DeviceControlRecord;
+  scan->bjcr = SetupJcr("bscan", device_name.data(), bsr, director, dcr,
+                        scan->volumes, true);
+  if (!scan->bjcr) { return false; }
+  scan->dev = scan->bjcr->sd_impl->read_dcr->dev;
+
+  // Let SD plugins setup the record translation
+  if (GeneratePluginEvent(scan->bjcr, bSdEventSetupRecordTranslation, dcr)
+      != bRC_OK) {
+    Jmsg(scan->bjcr, M_FATAL, 0,
+         T_("bSdEventSetupRecordTranslation call failed!\n"));
+  }
+
+  if (showProgress) {
+    char ed1[50];
+    struct stat sb;
+    fstat(scan->dev->fd, &sb);
+    scan->currentVolumeSize = sb.st_size;
+    Pmsg1(000, T_("First Volume Size = %s\n"),
+          edit_uint64(scan->currentVolumeSize, ed1));
+  }
+
+  return true;
+}
+
+static void CleanupScan()
+{
+  std::lock_guard l{setup_mutex};
+  JobControlRecord* bjcr = scan->bjcr;
+
+  scan->db->CloseDatabase(bjcr);
   CleanDevice(bjcr->sd_impl->dcr);
-  delete dev;
+  delete scan->dev;
   FreeDeviceControlRecord(bjcr->sd_impl->dcr);
   FreePlugins(bjcr);
   CleanupCompression(bjcr);
   FreeJcr(bjcr);
-  UnloadSdPlugins();
-
-  return BEXIT_SUCCESS;
 }
 
 /**
@@ -372,15 +481,15 @@ static bool BscanMountNextReadVolume(DeviceControlRecord* dcr)
     mdcr->VolMediaId = dcr->VolMediaId;
     mjcr->sd_impl->read_dcr->VolLastIndex = dcr->VolLastIndex;
     if (mjcr->sd_impl->insert_jobmedia_records) {
-      if (!CreateJobmediaRecord(db, mjcr)) {
-        Pmsg2(000,
-              T_("Could not create JobMedia record for Volume=%s Job=%s\n"),
-              my_dev->getVolCatName(), mjcr->Job);
-      }
+      CreateJobmediaRecord(mjcr);
     }
   }
 
-  UpdateMediaRecord(db, &mr);
+  if (!FlushJobmediaRecords(scan->db)) {
+    Pmsg1(000, T_("Could not create JobMedia records for Volume=%s\n"),
+          my_dev->getVolCatName());
+  }
+  UpdateMediaRecord(scan->db, &scan->mr);
 
   /* Now let common read routine get up next tape. Note,
    * we call mount_next... with bscan's jcr because that is where we
@@ -391,16 +500,16 @@ static bool BscanMountNextReadVolume(DeviceControlRecord* dcr)
     char ed1[50];
     struct stat sb;
     fstat(my_dev->fd, &sb);
-    currentVolumeSize = sb.st_size;
+    scan->currentVolumeSize = sb.st_size;
     Pmsg1(000, T_("First Volume Size = %s\n"),
-          edit_uint64(currentVolumeSize, ed1));
+          edit_uint64(scan->currentVolumeSize, ed1));
   }
   return status;
 }
 
 static void do_scan()
 {
-  attr = new_attr(bjcr);
+  scan->attr = new_attr(scan->bjcr);
 
   AttributesDbRecord ar_emtpy;
   PoolDbRecord pr_empty;
@@ -409,21 +518,25 @@ static void do_scan()
   FileSetDbRecord fsr_empty;
   FileDbRecord fr_empty;
 
-  ar = ar_emtpy;
-  pr = pr_empty;
-  jr = jr_empty;
-  cr = cr_empty;
-  fsr = fsr_empty;
-  fr = fr_empty;
+  scan->ar = ar_emtpy;
+  scan->pr = pr_empty;
+  scan->jr = jr_empty;
+  scan->cr = cr_empty;
+  scan->fsr = fsr_empty;
+  scan->fr = fr_empty;
 
   // Detach bscan's jcr as we are not a real Job on the tape
-  ReadRecords(bjcr->sd_impl->read_dcr, RecordCb, BscanMountNextReadVolume);
-
-  if (update_db) {
-    db->WriteBatchFileRecords(bjcr); /* used by bulk batch file insert */
+  ReadRecords(scan->bjcr->sd_impl->read_dcr, RecordCb,
+              BscanMountNextReadVolume);
+
+  if (scan->update_db) {
+    FlushAllCachedAttributes(scan->db);
+    FlushJobmediaRecords(scan->db);
+    /* used by bulk batch file insert */
+    scan->db->WriteBatchFileRecords(scan->bjcr);
   }
 
-  FreeAttr(attr);
+  FreeAttr(scan->attr);
 }
 
 /**
@@ -480,14 +593,14 @@ static bool RecordCb(DeviceControlRecord* dcr, DeviceRecord* rec)
   char digest[BASE64_SIZE(CRYPTO_DIGEST_MAX_SIZE)];
 
   if (rec->data_len > 0) {
-    mr.VolBytes
+    scan->mr.VolBytes
         += rec->data_len + WRITE_RECHDR_LENGTH; /* Accumulate Volume bytes */
-    if (showProgress && currentVolumeSize > 0) {
-      int pct = (mr.VolBytes * 100) / currentVolumeSize;
-      if (pct != last_pct) {
+    if (showProgress && scan->currentVolumeSize > 0) {
+      int pct = (scan->mr.VolBytes * 100) / scan->currentVolumeSize;
+      if (pct != scan->last_pct) {
         fprintf(stdout, T_("done: %d%%\n"), pct);
         fflush(stdout);
-        last_pct = pct;
+        scan->last_pct = pct;
       }
     }
   }
@@ -501,7 +614,8 @@ static bool RecordCb(DeviceControlRecord* dcr, DeviceRecord* rec)
 
   // Check for Start or End of Session Record
   if (rec->FileIndex < 0) {
-    bool save_update_db = update_db;
+    std::lock_guard l{label_mutex};
+    bool save_update_db = scan->update_db;
 
     if (g_verbose > 1) { DumpLabelRecord(my_dev, rec, true); }
     switch (rec->FileIndex) {
@@ -513,56 +627,58 @@ static bool RecordCb(DeviceControlRecord* dcr, DeviceRecord* rec)
       case VOL_LABEL:
         UnserVolumeLabel(my_dev, rec);
         // Check Pool info
-        bstrncpy(pr.Name, my_dev->VolHdr.PoolName, sizeof(pr.Name));
-        bstrncpy(pr.PoolType, my_dev->VolHdr.PoolType, sizeof(pr.PoolType));
+        bstrncpy(scan->pr.Name, my_dev->VolHdr.PoolName, sizeof(scan->pr.Name));
+        bstrncpy(scan->pr.PoolType, my_dev->VolHdr.PoolType,
+                 sizeof(scan->pr.PoolType));
         num_pools++;
-        if (db->GetPoolRecord(my_bjcr, &pr)) {
+        if (scan->db->GetPoolRecord(my_bjcr, &scan->pr)) {
           if (g_verbose) {
-            Pmsg1(000, T_("Pool record for %s found in DB.\n"), pr.Name);
+            Pmsg1(000, T_("Pool record for %s found in DB.\n"), scan->pr.Name);
           }
         } else {
-          if (!update_db) {
+          if (!scan->update_db) {
             Pmsg1(000, T_("VOL_LABEL: Pool record not found for Pool: %s\n"),
-                  pr.Name);
+                  scan->pr.Name);
           }
-          CreatePoolRecord(db, &pr);
+          CreatePoolRecord(scan->db, &scan->pr);
         }
-        if (!bstrcmp(pr.PoolType, my_dev->VolHdr.PoolType)) {
+        if (!bstrcmp(scan->pr.PoolType, my_dev->VolHdr.PoolType)) {
           Pmsg2(000, T_("VOL_LABEL: PoolType mismatch. DB=%s Vol=%s\n"),
-                pr.PoolType, my_dev->VolHdr.PoolType);
+                scan->pr.PoolType, my_dev->VolHdr.PoolType);
           return true;
         } else if (g_verbose) {
-          Pmsg1(000, T_("Pool type \"%s\" is OK.\n"), pr.PoolType);
+          Pmsg1(000, T_("Pool type \"%s\" is OK.\n"), scan->pr.PoolType);
         }
 
         // Check Media Info
-        mr = MediaDbRecord{};
-        bstrncpy(mr.VolumeName, my_dev->VolHdr.VolumeName,
-                 sizeof(mr.VolumeName));
-        mr.PoolId = pr.PoolId;
+        scan->mr = MediaDbRecord{};
+        bstrncpy(scan->mr.VolumeName, my_dev->VolHdr.VolumeName,
+                 sizeof(scan->mr.VolumeName));
+        scan->mr.PoolId = scan->pr.PoolId;
         num_media++;
-        if (db->GetMediaRecord(my_bjcr, &mr)) {
+        if (scan->db->GetMediaRecord(my_bjcr, &scan->mr)) {
           if (g_verbose) {
-            Pmsg1(000, T_("Media record for %s found in DB.\n"), mr.VolumeName);
+            Pmsg1(000, T_("Media record for %s found in DB.\n"),
+                  scan->mr.VolumeName);
           }
           // Clear out some volume statistics that will be updated
-          mr.VolJobs = mr.VolFiles = mr.VolBlocks = 0;
-          mr.VolBytes = rec->data_len + 20;
+          scan->mr.VolJobs = scan->mr.VolFiles = scan->mr.VolBlocks = 0;
+          scan->mr.VolBytes = rec->data_len + 20;
         } else {
-          if (!update_db) {
+          if (!scan->update_db) {
             Pmsg1(000, T_("VOL_LABEL: Media record not found for Volume: %s\n"),
-                  mr.VolumeName);
+                  scan->mr.VolumeName);
           }
-          bstrncpy(mr.MediaType, my_dev->VolHdr.MediaType,
-                   sizeof(mr.MediaType));
-          CreateMediaRecord(db, &mr, &my_dev->VolHdr);
+          bstrncpy(scan->mr.MediaType, my_dev->VolHdr.MediaType,
+                   sizeof(scan->mr.MediaType));
+          CreateMediaRecord(scan->db, &scan->mr, &my_dev->VolHdr);
         }
-        if (!bstrcmp(mr.MediaType, my_dev->VolHdr.MediaType)) {
+        if (!bstrcmp(scan->mr.MediaType, my_dev->VolHdr.MediaType)) {
           Pmsg2(000, T_("VOL_LABEL: MediaType mismatch. DB=%s Vol=%s\n"),
-                mr.MediaType, my_dev->VolHdr.MediaType);
+                scan->mr.MediaType, my_dev->VolHdr.MediaType);
           return true; /* ignore error */
         } else if (g_verbose) {
-          Pmsg1(000, T_("Media type \"%s\" is OK.\n"), mr.MediaType);
+          Pmsg1(000, T_("Media type \"%s\" is OK.\n"), scan->mr.MediaType);
         }
 
         // Reset some DeviceControlRecord variables
@@ -573,7 +689,7 @@ static bool RecordCb(DeviceControlRecord* dcr, DeviceRecord* rec)
           d->VolMediaId = 0;
         }
 
-        Pmsg1(000, T_("VOL_LABEL: OK for Volume: %s\n"), mr.VolumeName);
+        Pmsg1(000, T_("VOL_LABEL: OK for Volume: %s\n"), scan->mr.VolumeName);
         break;
 
       case SOS_LABEL:
@@ -582,85 +698,88 @@ static bool RecordCb(DeviceControlRecord* dcr, DeviceRecord* rec)
           Dmsg0(200, T_("SOS_LABEL skipped. Record does not match "
                         "BootStrapRecord filter.\n"));
         } else {
-          mr.VolJobs++;
+          scan->mr.VolJobs++;
           num_jobs++;
-          if (ignored_msgs > 0) {
+          if (scan->ignored_msgs > 0) {
             Pmsg1(000,
                   T_("%d \"errors\" ignored before first Start of Session "
                      "record.\n"),
-                  ignored_msgs);
-            ignored_msgs = 0;
+                  scan->ignored_msgs);
+            scan->ignored_msgs = 0;
           }
-          UnserSessionLabel(&label, rec);
-          jr = JobDbRecord{};
-          bstrncpy(jr.Job, label.Job, sizeof(jr.Job));
-          if (db->GetJobRecord(my_bjcr, &jr)) {
+          UnserSessionLabel(&scan->label, rec);
+          scan->jr = JobDbRecord{};
+          bstrncpy(scan->jr.Job, scan->label.Job, sizeof(scan->jr.Job));
+          if (scan->db->GetJobRecord(my_bjcr, &scan->jr)) {
             // Job record already exists in DB
-            update_db = false; /* don't change db in CreateJobRecord */
+            scan->update_db = false; /* don't change db in CreateJobRecord */
             if (g_verbose) {
               Pmsg1(000, T_("SOS_LABEL: Found Job record for JobId: %d\n"),
-                    jr.JobId);
+                    scan->jr.JobId);
             }
           } else {
             // Must create a Job record in DB
-            if (!update_db) {
+            if (!scan->update_db) {
               Pmsg1(000, T_("SOS_LABEL: Job record not found for JobId: %d\n"),
-                    jr.JobId);
+                    scan->jr.JobId);
             }
           }
 
           // Create Client record if not already there
-          bstrncpy(cr.Name, label.ClientName, sizeof(cr.Name));
-          CreateClientRecord(db, &cr);
-          jr.ClientId = cr.ClientId;
+          bstrncpy(scan->cr.Name, scan->label.ClientName,
+                   sizeof(scan->cr.Name));
+          CreateClientRecord(scan->db, &scan->cr);
+          scan->jr.ClientId = scan->cr.ClientId;
 
           // Process label, if Job record exists don't update db
-          mjcr = CreateJobRecord(db, &jr, &label, rec);
+          mjcr = CreateJobRecord(scan->db, &scan->jr, &scan->label, rec);
           dcr = mjcr->sd_impl->read_dcr;
-          update_db = save_update_db;
+          scan->update_db = save_update_db;
 
-          jr.PoolId = pr.PoolId;
-          mjcr->start_time = jr.StartTime;
-          mjcr->setJobLevel(jr.JobLevel);
+          scan->jr.PoolId = scan->pr.PoolId;
+          mjcr->start_time = scan->jr.StartTime;
+          mjcr->setJobLevel(scan->jr.JobLevel);
 
           mjcr->client_name = GetPoolMemory(PM_FNAME);
-          PmStrcpy(mjcr->client_name, label.ClientName);
+          PmStrcpy(mjcr->client_name, scan->label.ClientName);
           mjcr->sd_impl->fileset_name = GetPoolMemory(PM_FNAME);
-          PmStrcpy(mjcr->sd_impl->fileset_name, label.FileSetName);
-          bstrncpy(dcr->pool_type, label.PoolType, sizeof(dcr->pool_type));
-          bstrncpy(dcr->pool_name, label.PoolName, sizeof(dcr->pool_name));
+          PmStrcpy(mjcr->sd_impl->fileset_name, scan->label.FileSetName);
+          bstrncpy(dcr->pool_type, scan->label.PoolType,
+                   sizeof(dcr->pool_type));
+          bstrncpy(dcr->pool_name, scan->label.PoolName,
+                   sizeof(dcr->pool_name));
 
           /* Look for existing Job Media records for this job.  If there are
            * any, no new ones need be created.  This may occur if File
            * Retention has expired before Job Retention, or if the volume
            * has already been bscan'd */
           Mmsg(sql_buffer, "SELECT count(*) from JobMedia where JobId=%d",
-               jr.JobId);
-          db->SqlQuery(sql_buffer.c_str(), db_int64_handler, &jmr_count);
+               scan->jr.JobId);
+          scan->db->SqlQuery(sql_buffer.c_str(), db_int64_handler, &jmr_count);
           if (jmr_count.value > 0) {
             mjcr->sd_impl->insert_jobmedia_records = false;
           } else {
             mjcr->sd_impl->insert_jobmedia_records = true;
           }
 
-          if (rec->VolSessionId != jr.VolSessionId) {
+          if (rec->VolSessionId != scan->jr.VolSessionId) {
             Pmsg3(000,
                   T_("SOS_LABEL: VolSessId mismatch for JobId=%u. DB=%d "
                      "Vol=%d\n"),
-                  jr.JobId, jr.VolSessionId, rec->VolSessionId);
+                  scan->jr.JobId, scan->jr.VolSessionId, rec->VolSessionId);
             return true; /* ignore error */
           }
-          if (rec->VolSessionTime != jr.VolSessionTime) {
+          if (rec->VolSessionTime != scan->jr.VolSessionTime) {
             Pmsg3(000,
                   T_("SOS_LABEL: VolSessTime mismatch for JobId=%u. DB=%d "
                      "Vol=%d\n"),
-                  jr.JobId, jr.VolSessionTime, rec->VolSessionTime);
+                  scan->jr.JobId, scan->jr.VolSessionTime, rec->VolSessionTime);
             return true; /* ignore error */
           }
-          if (jr.PoolId != pr.PoolId) {
+          if (scan->jr.PoolId != scan->pr.PoolId) {
             Pmsg3(000,
                   T_("SOS_LABEL: PoolId mismatch for JobId=%u. DB=%d Vol=%d\n"),
-                  jr.JobId, jr.PoolId, pr.PoolId);
+                  scan->jr.JobId, scan->jr.PoolId, scan->pr.PoolId);
             return true; /* ignore error */
           }
         }
@@ -672,13 +791,15 @@ static bool RecordCb(DeviceControlRecord* dcr, DeviceRecord* rec)
           Dmsg0(200, T_("EOS_LABEL skipped. Record does not match "
                         "BootStrapRecord filter.\n"));
         } else {
-          UnserSessionLabel(&elabel, rec);
+          UnserSessionLabel(&scan->elabel, rec);
 
           // Create FileSet record
-          bstrncpy(fsr.FileSet, label.FileSetName, sizeof(fsr.FileSet));
-          bstrncpy(fsr.MD5, label.FileSetMD5, sizeof(fsr.MD5));
-          CreateFilesetRecord(db, &fsr);
-          jr.FileSetId = fsr.FileSetId;
+          bstrncpy(scan->fsr.FileSet, scan->label.FileSetName,
+                   sizeof(scan->fsr.FileSet));
+          bstrncpy(scan->fsr.MD5, scan->label.FileSetMD5,
+                   sizeof(scan->fsr.MD5));
+          CreateFilesetRecord(scan->db, &scan->fsr);
+          scan->jr.FileSetId = scan->fsr.FileSetId;
 
           mjcr = get_jcr_by_session(rec->VolSessionId, rec->VolSessionTime);
           if (!mjcr) {
@@ -688,16 +809,18 @@ static bool RecordCb(DeviceControlRecord* dcr, DeviceRecord* rec)
             break;
           }
 
+          FlushCachedAttributes(scan->db, mjcr->JobId);
+
           // Do the final update to the Job record
-          UpdateJobRecord(db, &jr, &elabel, rec);
+          UpdateJobRecord(scan->db, &scan->jr, &scan->elabel, rec);
 
-          mjcr->end_time = jr.EndTime;
+          mjcr->end_time = scan->jr.EndTime;
           mjcr->setJobStatusWithPriorityCheck(JS_Terminated);
 
           // Create JobMedia record
           mjcr->sd_impl->read_dcr->VolLastIndex = dcr->VolLastIndex;
           if (mjcr->sd_impl->insert_jobmedia_records) {
-            CreateJobmediaRecord(db, mjcr);
+            CreateJobmediaRecord(mjcr);
           }
           FreeDeviceControlRecord(mjcr->sd_impl->read_dcr);
           FreeJcr(mjcr);
@@ -709,33 +832,37 @@ static bool RecordCb(DeviceControlRecord* dcr, DeviceRecord* rec)
 
       case EOT_LABEL: /* end of all tapes */
         // Wiffle through all jobs still open and close them.
-        if (update_db) {
+        if (scan->update_db) {
+          FlushAllCachedAttributes(scan->db);
           for (auto mdcr : my_dev->attached_dcrs) {
             JobControlRecord* mjcr2 = mdcr->jcr;
             if (!mjcr2 || mjcr2->JobId == 0) { continue; }
-            jr.JobId = mjcr2->JobId;
-            jr.JobStatus = JS_ErrorTerminated; /* Mark Job as Error Terimined */
-            jr.JobFiles = mjcr2->JobFiles;
-            jr.JobBytes = mjcr2->JobBytes;
-            jr.VolSessionId = mjcr2->VolSessionId;
-            jr.VolSessionTime = mjcr2->VolSessionTime;
-            jr.JobTDate = (utime_t)mjcr2->start_time;
-            jr.ClientId = mjcr2->ClientId;
-            if (!db->UpdateJobEndRecord(my_bjcr, &jr)) {
+            scan->jr.JobId = mjcr2->JobId;
+            /* Mark Job as Error Terimined */
+            scan->jr.JobStatus = JS_ErrorTerminated;
+            scan->jr.JobFiles = mjcr2->JobFiles;
+            scan->jr.JobBytes = mjcr2->JobBytes;
+            scan->jr.VolSessionId = mjcr2->VolSessionId;
+            scan->jr.VolSessionTime = mjcr2->VolSessionTime;
+            scan->jr.JobTDate = (utime_t)mjcr2->start_time;
+            scan->jr.ClientId = mjcr2->ClientId;
+            if (!scan->db->UpdateJobEndRecord(my_bjcr, &scan->jr)) {
               Pmsg1(0, T_("Could not update job record. ERR=%s\n"),
-                    db->strerror());
+                    scan->db->strerror());
             }
           }
         }
-        mr.VolFiles = rec->File;
-        mr.VolBlocks = rec->Block;
-        mr.VolBytes += mr.VolBlocks * WRITE_BLKHDR_LENGTH; /* approx. */
-        mr.VolMounts++;
-        UpdateMediaRecord(db, &mr);
+        scan->mr.VolFiles = rec->File;
+        scan->mr.VolBlocks = rec->Block;
+        /* approx. */
+        scan->mr.VolBytes += scan->mr.VolBlocks * WRITE_BLKHDR_LENGTH;
+        scan->mr.VolMounts++;
+        FlushJobmediaRecords(scan->db);
+        UpdateMediaRecord(scan->db, &scan->mr);
         Pmsg3(0,
               T_("End of all Volumes. VolFiles=%u VolBlocks=%u VolBytes=%s\n"),
-              mr.VolFiles, mr.VolBlocks,
-              edit_uint64_with_commas(mr.VolBytes, ec1));
+              scan->mr.VolFiles, scan->mr.VolBlocks,
+              edit_uint64_with_commas(scan->mr.VolBytes, ec1));
         break;
       default:
         break;
@@ -745,11 +872,11 @@ static bool RecordCb(DeviceControlRecord* dcr, DeviceRecord* rec)
 
   mjcr = get_jcr_by_session(rec->VolSessionId, rec->VolSessionTime);
   if (!mjcr) {
-    if (mr.VolJobs > 0) {
+    if (scan->mr.VolJobs > 0) {
       Pmsg2(000, T_("Could not find Job for SessId=%d SessTime=%d record.\n"),
             rec->VolSessionId, rec->VolSessionTime);
     } else {
-      ignored_msgs++;
+      scan->ignored_msgs++;
     }
     return true;
   }
@@ -761,18 +888,25 @@ static bool RecordCb(DeviceControlRecord* dcr, DeviceRecord* rec)
     case STREAM_UNIX_ATTRIBUTES:
     case STREAM_UNIX_ATTRIBUTES_EX:
       if (!UnpackAttributesRecord(my_bjcr, rec->Stream, rec->data,
-                                  rec->data_len, attr)) {
+                                  rec->data_len, scan->attr)) {
         Emsg0(M_ERROR_TERM, 0, T_("Cannot continue.\n"));
       }
 
+      // The catalog stores the LStat text
+      if (IsCompactStat(scan->attr->attr)) {
+        char lstat[kMaxLStatLength];
+        CompactStatToLStat(scan->attr->attr, lstat);
+        PmStrcpy(scan->attr->attr, lstat);
+      }
+
       if (g_verbose > 1) {
-        DecodeStat(attr->attr, &attr->statp, sizeof(attr->statp),
-                   &attr->LinkFI);
-        BuildAttrOutputFnames(my_bjcr, attr);
-        PrintLsOutput(my_bjcr, attr);
+        DecodeStat(scan->attr->attr, &scan->attr->statp,
+                   sizeof(scan->attr->statp), &scan->attr->LinkFI);
+        BuildAttrOutputFnames(my_bjcr, scan->attr);
+        PrintLsOutput(my_bjcr, scan->attr);
       }
-      fr.JobId = mjcr->JobId;
-      fr.FileId = 0;
+      scan->fr.JobId = mjcr->JobId;
+      scan->fr.FileId = 0;
       num_files++;
       if (g_verbose && (num_files & 0x7FFF) == 0) {
         char ed1[30], ed2[30], ed3[30], ed4[30];
@@ -780,24 +914,27 @@ static bool RecordCb(DeviceControlRecord* dcr, DeviceRecord* rec)
               edit_uint64_with_commas(num_files, ed1),
               edit_uint64_with_commas(rec->File, ed2),
               edit_uint64_with_commas(rec->Block, ed3),
-              edit_uint64_with_commas(mr.VolBytes, ed4));
+              edit_uint64_with_commas(scan->mr.VolBytes, ed4));
       }
-      CreateFileAttributesRecord(db, mjcr, attr->fname, attr->lname, attr->type,
-                                 attr->attr, rec);
+      CreateFileAttributesRecord(scan->db, mjcr, scan->attr->fname,
+                                 scan->attr->lname, scan->attr->type,
+                                 scan->attr->attr, rec);
       FreeJcr(mjcr);
       break;
 
     case STREAM_RESTORE_OBJECT:
       if (!UnpackRestoreObject(my_bjcr, rec->Stream, rec->data, rec->data_len,
-                               &rop)) {
+                               &scan->rop)) {
         Emsg0(M_ERROR_TERM, 0, T_("Cannot continue.\n"));
       }
-      rop.FileIndex = mjcr->FileId;
-      rop.JobId = mjcr->JobId;
-      rop.FileType = FT_RESTORE_FIRST;
+      scan->rop.FileIndex = rec->FileIndex;
+      scan->rop.JobId = mjcr->JobId;
+      scan->rop.FileType = FT_RESTORE_FIRST;
 
 
-      if (update_db) { db->CreateRestoreObjectRecord(mjcr, &rop); }
+      if (scan->update_db) {
+        scan->db->CreateRestoreObjectRecord(mjcr, &scan->rop);
+      }
 
       num_restoreobjects++;
 
@@ -852,35 +989,35 @@ static bool RecordCb(DeviceControlRecord* dcr, DeviceRecord* rec)
       BinToBase64(digest, sizeof(digest), (char*)rec->data,
                   CRYPTO_DIGEST_MD5_SIZE, true);
       if (g_verbose > 1) { Pmsg1(000, T_("Got MD5 record: %s\n"), digest); }
-      UpdateDigestRecord(db, digest, rec, CRYPTO_DIGEST_MD5);
+      UpdateDigestRecord(scan->db, digest, rec, CRYPTO_DIGEST_MD5);
       break;
 
     case STREAM_SHA1_DIGEST:
       BinToBase64(digest, sizeof(digest), (char*)rec->data,
                   CRYPTO_DIGEST_SHA1_SIZE, true);
       if (g_verbose > 1) { Pmsg1(000, T_("Got SHA1 record: %s\n"), digest); }
-      UpdateDigestRecord(db, digest, rec, CRYPTO_DIGEST_SHA1);
+      UpdateDigestRecord(scan->db, digest, rec, CRYPTO_DIGEST_SHA1);
       break;
 
     case STREAM_SHA256_DIGEST:
       BinToBase64(digest, sizeof(digest), (char*)rec->data,
                   CRYPTO_DIGEST_SHA256_SIZE, true);
       if (g_verbose > 1) { Pmsg1(000, T_("Got SHA256 record: %s\n"), digest); }
-      UpdateDigestRecord(db, digest, rec, CRYPTO_DIGEST_SHA256);
+      UpdateDigestRecord(scan->db, digest, rec, CRYPTO_DIGEST_SHA256);
       break;
 
     case STREAM_SHA512_DIGEST:
       BinToBase64(digest, sizeof(digest), (char*)rec->data,
                   CRYPTO_DIGEST_SHA512_SIZE, true);
       if (g_verbose > 1) { Pmsg1(000, T_("Got SHA512 record: %s\n"), digest); }
-      UpdateDigestRecord(db, digest, rec, CRYPTO_DIGEST_SHA512);
+      UpdateDigestRecord(scan->db, digest, rec, CRYPTO_DIGEST_SHA512);
       break;
 
     case STREAM_XXH128_DIGEST:
       BinToBase64(digest, sizeof(digest), (char*)rec->data,
                   CRYPTO_DIGEST_XXH128_SIZE, true);
       if (g_verbose > 1) { Pmsg1(000, T_("Got XXH128 record: %s\n"), digest); }
-      UpdateDigestRecord(db, digest, rec, CRYPTO_DIGEST_XXH128);
+      UpdateDigestRecord(scan->db, digest, rec, CRYPTO_DIGEST_XXH128);
       break;
 
     case STREAM_ENCRYPTED_SESSION_DATA:
@@ -1024,33 +1161,65 @@ static bool CreateFileAttributesRecord(BareosDb* t_db,
                                        DeviceRecord* rec)
 {
   DeviceControlRecord* dcr = mjcr->sd_impl->read_dcr;
-  ar.fname = fname;
-  ar.link = lname;
-  ar.ClientId = mjcr->ClientId;
-  ar.JobId = mjcr->JobId;
-  ar.Stream = rec->Stream;
+  scan->ar.fname = fname;
+  scan->ar.link = lname;
+  scan->ar.ClientId = mjcr->ClientId;
+  scan->ar.JobId = mjcr->JobId;
+  scan->ar.Stream = rec->Stream;
   if (type == FT_DELETED) {
-    ar.FileIndex = 0;
+    scan->ar.FileIndex = 0;
   } else {
-    ar.FileIndex = rec->FileIndex;
+    scan->ar.FileIndex = rec->FileIndex;
   }
-  ar.attr = ap;
+  scan->ar.attr = ap;
   if (dcr->VolFirstIndex == 0) { dcr->VolFirstIndex = rec->FileIndex; }
   dcr->FileIndex = rec->FileIndex;
   mjcr->JobFiles++;
 
-  if (!update_db) { return true; }
+  if (!scan->update_db) { return true; }
 
-  if (!t_db->CreateFileAttributesRecord(bjcr, &ar)) {
+  bool retval = FlushCachedAttributes(t_db, mjcr->JobId);
+
+  CachedAttributes& cached = scan->cached_attributes[mjcr->JobId];
+  cached.ar = scan->ar;
+  cached.ar.FileType = type;
+  cached.fname = fname;
+  cached.lname = lname ? lname : "";
+  cached.attr = ap;
+  cached.digest.clear();
+
+  return retval;
+}
+
+// Store the held back File Attributes of a job in the catalog
+static bool FlushCachedAttributes(BareosDb* t_db, JobId_t JobId)
+{
+  auto it = scan->cached_attributes.find(JobId);
+  if (it == scan->cached_attributes.end()) { return true; }
+
+  CachedAttributes& cached = it->second;
+  cached.ar.fname = cached.fname.data();
+  cached.ar.link = cached.lname.data();
+  cached.ar.attr = cached.attr.data();
+  cached.ar.Digest = cached.digest.empty() ? nullptr : cached.digest.data();
+
+  bool retval = t_db->CreateAttributesRecord(scan->bjcr, &cached.ar);
+  if (!retval) {
     Pmsg1(0, T_("Could not create File Attributes record. ERR=%s\n"),
           t_db->strerror());
-    return false;
+  } else if (g_verbose > 1) {
+    Pmsg1(000, T_("Created File record: %s\n"), cached.fname.c_str());
   }
-  mjcr->FileId = ar.FileId;
 
-  if (g_verbose > 1) { Pmsg1(000, T_("Created File record: %s\n"), fname); }
+  scan->cached_attributes.erase(it);
+  return retval;
+}
 
-  return true;
+static void FlushAllCachedAttributes(BareosDb* t_db)
+{
+  while (!scan->cached_attributes.empty()) {
+    FlushCachedAttributes(t_db, scan->cached_attributes.begin()->first);
+  }
 }
 
 // For each Volume we see, we create a Medium record
@@ -1067,19 +1236,19 @@ static bool CreateMediaRecord(BareosDb* t_db,
   t_mr->set_first_written = true; /* Save FirstWritten during update_media */
   t_mr->FirstWritten = BtimeToUtime(vl->write_btime);
   t_mr->LabelDate = BtimeToUtime(vl->label_btime);
-  lasttime = t_mr->LabelDate;
+  scan->lasttime = t_mr->LabelDate;
 
   if (t_mr->VolJobs == 0) { t_mr->VolJobs = 1; }
 
   if (t_mr->VolMounts == 0) { t_mr->VolMounts = 1; }
 
-  if (!update_db) { return true; }
+  if (!scan->update_db) { return true; }
 
-  if (!t_db->CreateMediaRecord(bjcr, t_mr)) {
+  if (!t_db->CreateMediaRecord(scan->bjcr, t_mr)) {
     Pmsg1(000, T_("Could not create media record. ERR=%s\n"), t_db->strerror());
     return false;
   }
-  if (!t_db->UpdateMediaRecord(bjcr, t_mr)) {
+  if (!t_db->UpdateMediaRecord(scan->bjcr, t_mr)) {
     Pmsg1(000, T_("Could not update media record. ERR=%s\n"), t_db->strerror());
     return false;
   }
@@ -1093,10 +1262,10 @@ static bool CreateMediaRecord(BareosDb* t_db,
 // Called at end of media to update it
 static bool UpdateMediaRecord(BareosDb* t_db, MediaDbRecord* t_mr)
 {
-  if (!update_db && !update_vol_info) { return true; }
+  if (!scan->update_db && !update_vol_info) { return true; }
 
-  t_mr->LastWritten = lasttime;
-  if (!t_db->UpdateMediaRecord(bjcr, t_mr)) {
+  t_mr->LastWritten = scan->lasttime;
+  if (!t_db->UpdateMediaRecord(scan->bjcr, t_mr)) {
     Pmsg1(000, T_("Could not update media record. ERR=%s\n"), t_db->strerror());
     return false;
   }
@@ -1115,9 +1284,9 @@ static bool CreatePoolRecord(BareosDb* t_db, PoolDbRecord* t_pr)
   t_pr->UseCatalog = 1;
   t_pr->VolRetention = 355 * 3600 * 24; /* 1 year */
 
-  if (!update_db) { return true; }
+  if (!scan->update_db) { return true; }
 
-  if (!t_db->CreatePoolRecord(bjcr, t_pr)) {
+  if (!t_db->CreatePoolRecord(scan->bjcr, t_pr)) {
     Pmsg1(000, T_("Could not create pool record. ERR=%s\n"), t_db->strerror());
     return false;
   }
@@ -1134,9 +1303,9 @@ static bool CreateClientRecord(BareosDb* t_db, ClientDbRecord* t_cr)
 {
   /* Note, update_db can temporarily be set false while
    * updating the database, so we must ensure that ClientId is non-zero. */
-  if (!update_db) {
+  if (!scan->update_db) {
     t_cr->ClientId = 0;
-    if (!t_db->GetClientRecord(bjcr, t_cr)) {
+    if (!t_db->GetClientRecord(scan->bjcr, t_cr)) {
       Pmsg1(0, T_("Could not get Client record. ERR=%s\n"), t_db->strerror());
       return false;
     }
@@ -1144,7 +1313,7 @@ static bool CreateClientRecord(BareosDb* t_db, ClientDbRecord* t_cr)
     return true;
   }
 
-  if (!t_db->CreateClientRecord(bjcr, t_cr)) {
+  if (!t_db->CreateClientRecord(scan->bjcr, t_cr)) {
     Pmsg1(000, T_("Could not create Client record. ERR=%s\n"),
           t_db->strerror());
     return false;
@@ -1159,7 +1328,7 @@ static bool CreateClientRecord(BareosDb* t_db, ClientDbRecord* t_cr)
 
 static bool CreateFilesetRecord(BareosDb* t_db, FileSetDbRecord* t_fsr)
 {
-  if (!update_db) { return true; }
+  if (!scan->update_db) { return true; }
 
   t_fsr->FileSetId = 0;
   if (t_fsr->MD5[0] == 0) {
@@ -1167,12 +1336,12 @@ static bool CreateFilesetRecord(BareosDb* t_db, FileSetDbRecord* t_fsr)
     t_fsr->MD5[1] = 0;
   }
 
-  if (t_db->GetFilesetRecord(bjcr, t_fsr)) {
+  if (t_db->GetFilesetRecord(scan->bjcr, t_fsr)) {
     if (g_verbose) {
       Pmsg1(000, T_("Fileset \"%s\" already exists.\n"), t_fsr->FileSet);
     }
   } else {
-    if (!t_db->CreateFilesetRecord(bjcr, t_fsr)) {
+    if (!t_db->CreateFilesetRecord(scan->bjcr, t_fsr)) {
       Pmsg2(000, T_("Could not create FileSet record \"%s\". ERR=%s\n"),
             t_fsr->FileSet, t_db->strerror());
       return false;
@@ -1214,16 +1383,16 @@ static JobControlRecord* CreateJobRecord(BareosDb* t_db,
   /* Now create a JobControlRecord as if starting the Job */
   mjcr = create_jcr(t_jr, t_rec, t_label->JobId);
 
-  if (!update_db) { return mjcr; }
+  if (!scan->update_db) { return mjcr; }
 
   // This creates the bare essentials
-  if (!t_db->CreateJobRecord(bjcr, t_jr)) {
+  if (!t_db->CreateJobRecord(scan->bjcr, t_jr)) {
     Pmsg1(0, T_("Could not create JobId record. ERR=%s\n"), t_db->strerror());
     return mjcr;
   }
 
   // This adds the client, StartTime, JobTDate, ...
-  if (!t_db->UpdateJobStartRecord(bjcr, t_jr)) {
+  if (!t_db->UpdateJobStartRecord(scan->bjcr, t_jr)) {
     Pmsg1(0, T_("Could not update job start record. ERR=%s\n"),
           t_db->strerror());
     return mjcr;
@@ -1255,7 +1424,7 @@ static bool UpdateJobRecord(BareosDb* t_db,
   ASSERT(t_elabel->VerNum >= 11);
   t_jr->EndTime = BtimeToUnix(t_elabel->write_btime);
 
-  lasttime = t_jr->EndTime;
+  scan->lasttime = t_jr->EndTime;
   mjcr->end_time = t_jr->EndTime;
 
   t_jr->JobId = mjcr->JobId;
@@ -1271,12 +1440,12 @@ static bool UpdateJobRecord(BareosDb* t_db,
   t_jr->JobTDate = (utime_t)mjcr->start_time;
   t_jr->ClientId = mjcr->ClientId;
 
-  if (!update_db) {
+  if (!scan->update_db) {
     FreeJcr(mjcr);
     return true;
   }
 
-  if (!t_db->UpdateJobEndRecord(bjcr, t_jr)) {
+  if (!t_db->UpdateJobEndRecord(scan->bjcr, t_jr)) {
     Pmsg2(0, T_("Could not update JobId=%u record. ERR=%s\n"), t_jr->JobId,
           t_db->strerror());
     FreeJcr(mjcr);
@@ -1292,7 +1461,7 @@ static bool UpdateJobRecord(BareosDb* t_db,
 
   if (g_verbose > 1) {
     const char* TermMsg;
-    static char term_code[70];
+    char term_code[70];
     char sdt[50], edt[50];
     char ec1[30], ec2[30], ec3[30];
 
@@ -1338,7 +1507,8 @@ static bool UpdateJobRecord(BareosDb* t_db,
            job_level_to_str(mjcr->getJobLevel()), mjcr->client_name, sdt, edt,
            edit_uint64_with_commas(mjcr->JobFiles, ec1),
            edit_uint64_with_commas(mjcr->JobBytes, ec2), mjcr->VolSessionId,
-           mjcr->VolSessionTime, edit_uint64_with_commas(mr.VolBytes, ec3),
+           mjcr->VolSessionTime,
+           edit_uint64_with_commas(scan->mr.VolBytes, ec3),
            kBareosVersionStrings.BinaryInfo, TermMsg);
   }
   FreeJcr(mjcr);
@@ -1346,17 +1516,18 @@ static bool UpdateJobRecord(BareosDb* t_db,
   return true;
 }
 
-static bool CreateJobmediaRecord(BareosDb* t_db, JobControlRecord* mjcr)
+// The JobMedia records are written by FlushJobmediaRecords()
+static bool CreateJobmediaRecord(JobControlRecord* mjcr)
 {
   JobMediaDbRecord jmr;
   DeviceControlRecord* dcr = mjcr->sd_impl->read_dcr;
 
-  dcr->EndBlock = dev->EndBlock;
-  dcr->EndFile = dev->EndFile;
-  dcr->VolMediaId = dev->VolCatInfo.VolMediaId;
+  dcr->EndBlock = scan->dev->EndBlock;
+  dcr->EndFile = scan->dev->EndFile;
+  dcr->VolMediaId = scan->dev->VolCatInfo.VolMediaId;
 
   jmr.JobId = mjcr->JobId;
-  jmr.MediaId = mr.MediaId;
+  jmr.MediaId = scan->mr.MediaId;
   jmr.FirstIndex = dcr->VolFirstIndex;
   jmr.LastIndex = dcr->VolLastIndex;
   jmr.StartFile = dcr->StartFile;
@@ -1364,19 +1535,41 @@ static bool CreateJobmediaRecord(BareosDb* t_db, JobControlRecord* mjcr)
   jmr.StartBlock = dcr->StartBlock;
   jmr.EndBlock = dcr->EndBlock;
 
-  if (!update_db) { return true; }
+  if (scan->update_db) { scan->jobmedia.push_back(jmr); }
 
-  if (!t_db->CreateJobmediaRecord(bjcr, &jmr)) {
-    Pmsg1(0, T_("Could not create JobMedia record. ERR=%s\n"),
-          t_db->strerror());
-    return false;
-  }
-  if (g_verbose) {
-    Pmsg2(000, T_("Created JobMedia record JobId %d, MediaId %d\n"), jmr.JobId,
-          jmr.MediaId);
+  return true;
+}
+
+/**
+ * Write the JobMedia records collected for the current volume. The records
+ * of each job are created with a single INSERT.
+ */
+static bool FlushJobmediaRecords(BareosDb* t_db)
+{
+  bool retval = true;
+  std::vector<JobMediaDbRecord>& pending = scan->jobmedia;
+
+  while (!pending.empty()) {
+    JobId_t JobId = pending.front().JobId;
+    auto end_of_job = std::stable_partition(
+        pending.begin(), pending.end(),
+        [JobId](const JobMediaDbRecord& jm) { return jm.JobId == JobId; });
+    std::vector<JobMediaDbRecord> jms(pending.begin(), end_of_job);
+    pending.erase(pending.begin(), end_of_job);
+
+    if (!t_db->CreateJobmediaRecords(scan->bjcr, jms)) {
+      Pmsg1(0, T_("Could not create JobMedia record. ERR=%s\n"),
+            t_db->strerror());
+      retval = false;
+    } else if (g_verbose) {
+      for (const auto& jm : jms) {
+        Pmsg2(000, T_("Created JobMedia record JobId %d, MediaId %d\n"),
+              jm.JobId, jm.MediaId);
+      }
+    }
   }
 
-  return true;
+  return retval;
 }
 
 // Simulate the database call that updates the MD5/SHA1 record
@@ -1389,32 +1582,31 @@ static bool UpdateDigestRecord(BareosDb* t_db,
 
   mjcr = get_jcr_by_session(rec->VolSessionId, rec->VolSessionTime);
   if (!mjcr) {
-    if (mr.VolJobs > 0) {
+    if (scan->mr.VolJobs > 0) {
       Pmsg2(000,
             T_("Could not find SessId=%d SessTime=%d for MD5/SHA1 record.\n"),
             rec->VolSessionId, rec->VolSessionTime);
     } else {
-      ignored_msgs++;
+      scan->ignored_msgs++;
     }
     return false;
   }
 
-  if (!update_db || mjcr->FileId == 0) {
+  auto cached = scan->cached_attributes.find(mjcr->JobId);
+  if (!scan->update_db || cached == scan->cached_attributes.end()) {
     FreeJcr(mjcr);
     return true;
   }
 
-  if (!t_db->AddDigestToFileRecord(bjcr, mjcr->FileId, digest, type)) {
-    Pmsg1(0, T_("Could not add MD5/SHA1 to File record. ERR=%s\n"),
-          t_db->strerror());
-    FreeJcr(mjcr);
-    return false;
+  cached->second.digest = digest;
+  cached->second.ar.DigestType = type;
+  bool retval = FlushCachedAttributes(t_db, mjcr->JobId);
+  if (retval && g_verbose > 1) {
+    Pmsg0(000, T_("Updated MD5/SHA1 record\n"));
   }
-
-  if (g_verbose > 1) { Pmsg0(000, T_("Updated MD5/SHA1 record\n")); }
   FreeJcr(mjcr);
 
-  return true;
+  return retval;
 }
 
 // Create a JobControlRecord as if we are really starting the job
@@ -1439,7 +1631,7 @@ static JobControlRecord* create_jcr(JobDbRecord* t_jr,
   jobjcr->VolSessionTime = rec->VolSessionTime;
   jobjcr->ClientId = t_jr->ClientId;
   jobjcr->sd_impl->dcr = jobjcr->sd_impl->read_dcr = new DeviceControlRecord;
-  SetupNewDcrDevice(jobjcr, jobjcr->sd_impl->dcr, dev, nullptr);
+  SetupNewDcrDevice(jobjcr, jobjcr->sd_impl->dcr, scan->dev, nullptr);
 
   return jobjcr;
 }
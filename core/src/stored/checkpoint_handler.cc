@@ -1,7 +1,7 @@
 /*
    BAREOS® - Backup Archiving REcovery Open Sourced
 
-Copyright (C) 2023-2023 Bareos GmbH & Co. KG
+Copyright (C) 2023-2024 Bareos GmbH & Co. KG
 
 This program is Free Software; you can redistribute it and/or
 modify it under the terms of version three of the GNU Affero General Public
@@ -45,6 +45,7 @@ void CheckpointHandler::UpdateJobmediaRecord(JobControlRecord* jcr)
 {
   Dmsg0(100, T_("... create job media record\n"));
   jcr->sd_impl->dcr->DirCreateJobmediaRecord(false);
+  jcr->sd_impl->dcr->DirFlushJobmediaRecords();
 
   jcr->sd_impl->dcr->VolFirstIndex = jcr->sd_impl->dcr->VolLastIndex;
   jcr->sd_impl->dcr->StartFile = jcr->sd_impl->dcr->EndFile;
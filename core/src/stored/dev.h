@@ -65,6 +65,7 @@
 #include "stored/volume_catalog_info.h"
 #include "stored/io_direction.h"
 #include "lib/btimers.h"
+#include "lib/metrics.h"
 
 #include <vector>
 #include <atomic>
@@ -291,6 +292,11 @@ class Device {
   uint64_t DevWriteBytes{};
   uint64_t DevReadBytes{};
 
+  /* Lock-free counters exported by the metrics endpoint */
+  metrics::LatencyHistogram block_write_latency; /**< Per block write (usec) */
+  metrics::Counter blocks_written;
+  metrics::Counter block_bytes_written;
+
   /* Methods */
   btime_t GetTimerCount(); /**< Return the last timer interval (ms) */
 
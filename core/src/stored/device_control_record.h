@@ -3,7 +3,7 @@
 
    Copyright (C) 2000-2012 Free Software Foundation Europe e.V.
    Copyright (C) 2011-2012 Planets Communications B.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -155,7 +155,12 @@ class DeviceControlRecord {
     return true;
   }
   virtual bool DirCreateJobmediaRecord(bool /* zero */) { return true; }
+  virtual bool DirFlushJobmediaRecords() { return true; }
   virtual bool DirUpdateFileAttributes(DeviceRecord*) { return true; }
+  virtual bool DirUpdateFileAttributesBatch(std::vector<DeviceRecord>&)
+  {
+    return true;
+  }
   virtual bool DirAskSysopToMountVolume(int mode);
   virtual bool DirAskSysopToCreateAppendableVolume() { return true; }
   virtual bool DirGetVolumeInfo(enum get_vol_info_rw writing);
@@ -3,7 +3,7 @@
 
    Copyright (C) 2000-2011 Free Software Foundation Europe e.V.
    Copyright (C) 2011-2012 Planets Communications B.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -90,6 +90,7 @@ DeviceResource::DeviceResource(const DeviceResource& other)
   volume_capacity = other.volume_capacity;
   max_spool_size = other.max_spool_size;
   max_job_spool_size = other.max_job_spool_size;
+  streaming_buffer_size = other.streaming_buffer_size;
 
   if (other.mount_point) { mount_point = strdup(other.mount_point); }
   if (other.mount_command) { mount_command = strdup(other.mount_command); }
@@ -146,6 +147,7 @@ DeviceResource& DeviceResource::operator=(const DeviceResource& rhs)
   volume_capacity = rhs.volume_capacity;
   max_spool_size = rhs.max_spool_size;
   max_job_spool_size = rhs.max_job_spool_size;
+  streaming_buffer_size = rhs.streaming_buffer_size;
 
   mount_point = rhs.mount_point;
   mount_command = rhs.mount_command;
@@ -80,6 +80,7 @@ static struct s_fd_cmds fd_cmds[] = {
 
 /* Commands from the File daemon that require additional scanning */
 static char read_open[] = "read open session = %127s %ld %ld %ld %ld %ld %ld\n";
+static char append_data[] = "append data %d connections=%d\n";
 
 /* Responses sent to the File daemon */
 static char NO_open[] = "3901 Error session already open\n";
@@ -130,7 +131,7 @@ void* HandleFiledConnection(BareosSocket* fd, char* job_name)
   jcr->file_bsock->SetJcr(jcr);
 
   // Authenticate the File daemon
-  if (!AuthenticateFiledaemon(jcr)) {
+  if (!AuthenticateFiledaemon(jcr, jcr->file_bsock)) {
     Dmsg1(50, "Authentication failed Job %s\n", jcr->Job);
     Jmsg(jcr, M_FATAL, 0, T_("Unable to authenticate File daemon\n"));
     jcr->setJobStatusWithPriorityCheck(JS_ErrorTerminated);
@@ -152,6 +153,102 @@ void* HandleFiledConnection(BareosSocket* fd, char* job_name)
   return NULL;
 }
 
+/**
+ * An additional connection that the File daemon opens to send the data of a
+ * backup over several connections. Data connections are opened before the
+ * connection of the job itself, while the session key is still known, and
+ * are kept until the File daemon sends the data.
+ */
+void* HandleDataConnection(BareosSocket* fd, char* job_name, int index)
+{
+  JobControlRecord* jcr = get_jcr_by_full_name(job_name);
+  if (!jcr) {
+    Jmsg1(NULL, M_FATAL, 0,
+          T_("FD data connection failed: Job name not found: %s\n"),
+          job_name);
+    fd->close();
+    delete fd;
+    return NULL;
+  }
+
+  if (jcr->authenticated || jcr->IsJobCanceled() || index < 1) {
+    Jmsg2(jcr, M_FATAL, 0, T_("Unexpected data connection %d for Job %s.\n"),
+          index, jcr->Job);
+    fd->close();
+    delete fd;
+    FreeJcr(jcr);
+    return NULL;
+  }
+
+  fd->SetJcr(jcr);
+  if (!AuthenticateDataConnection(jcr, fd)) {
+    Dmsg2(50, "Authentication of data connection %d failed Job %s\n", index,
+          jcr->Job);
+    fd->close();
+    delete fd;
+    FreeJcr(jcr);
+    return NULL;
+  }
+
+  {
+    auto locked = jcr->sd_impl->data_connections.lock();
+    auto [it, inserted] = locked->emplace(index, fd);
+    if (!inserted) {
+      Jmsg2(jcr, M_FATAL, 0, T_("Duplicate data connection %d for Job %s.\n"),
+            index, jcr->Job);
+      fd->close();
+      delete fd;
+    }
+  }
+  Dmsg2(50, "OK data connection %d Job %s\n", index, jcr->Job);
+
+  jcr->sd_impl->data_connection_wait.notify_one();
+  FreeJcr(jcr);
+
+  return NULL;
+}
+
+// Wait until the data connections 1 .. connections - 1 are there
+static bool WaitDataConnections(JobControlRecord* jcr, int connections)
+{
+  auto timeout = std::chrono::system_clock::now() + std::chrono::seconds(30);
+  auto locked = jcr->sd_impl->data_connections.lock();
+
+  auto complete = [connections](const std::map<int, BareosSocket*>& sockets) {
+    for (int index = 1; index < connections; index++) {
+      if (sockets.find(index) == sockets.end()) { return false; }
+    }
+    return true;
+  };
+  locked.wait_until(jcr->sd_impl->data_connection_wait, timeout, complete);
+
+  if (!complete(*locked)) {
+    Jmsg2(jcr, M_FATAL, 0,
+          T_("File daemon announced %d data connections, but only %d were "
+             "opened.\n"),
+          connections, static_cast<int>(locked->size()) + 1);
+    return false;
+  }
+  return true;
+}
+
+std::vector<BareosSocket*> TakeDataConnections(JobControlRecord* jcr)
+{
+  std::vector<BareosSocket*> sockets;
+  auto locked = jcr->sd_impl->data_connections.lock();
+  for (auto& [index, fd] : *locked) { sockets.push_back(fd); }
+  locked->clear();
+  return sockets;
+}
+
+void CloseDataConnections(JobControlRecord* jcr)
+{
+  for (BareosSocket* fd : TakeDataConnections(jcr)) {
+    fd->close();
+    delete fd;
+  }
+}
+
 /**
  * Run a File daemon Job -- File daemon already authorized
  * Director sends us this command.
@@ -251,11 +348,20 @@ void DoFdCommands(JobControlRecord* jcr)
 static bool AppendDataCmd(JobControlRecord* jcr)
 {
   BareosSocket* fd = jcr->file_bsock;
+  int ticket, connections = 1;
 
   Dmsg1(120, "Append data: %s", fd->msg);
   if (jcr->sd_impl->session_opened) {
     Dmsg1(110, "<filed: %s", fd->msg);
     jcr->setJobType(JT_BACKUP);
+    sscanf(fd->msg, append_data, &ticket, &connections);
+    if (connections <= 1) {
+      CloseDataConnections(jcr);
+    } else if (!WaitDataConnections(jcr, connections)) {
+      PmStrcpy(jcr->errmsg, T_("Append data error.\n"));
+      fd->fsend(ERROR_append);
+      return false;
+    }
     if (DoAppendData(jcr, fd, "FD")) {
       return true;
     } else {
@@ -1,7 +1,7 @@
 /*
    BAREOS® - Backup Archiving REcovery Open Sourced
 
-   Copyright (C) 2018-2018 Bareos GmbH & Co. KG
+   Copyright (C) 2018-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -21,9 +21,14 @@
 #ifndef BAREOS_STORED_FD_CMDS_H_
 #define BAREOS_STORED_FD_CMDS_H_
 
+#include <vector>
+
 namespace storagedaemon {
 
 void* HandleFiledConnection(BareosSocket* fd, char* job_name);
+void* HandleDataConnection(BareosSocket* fd, char* job_name, int index);
+std::vector<BareosSocket*> TakeDataConnections(JobControlRecord* jcr);
+void CloseDataConnections(JobControlRecord* jcr);
 void RunJob(JobControlRecord* jcr);
 void DoFdCommands(JobControlRecord* jcr);
 
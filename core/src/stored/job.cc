@@ -55,6 +55,7 @@ static char jobcmd[]
       "SpoolData=%d PreferMountedVols=%d SpoolSize=%127s "
       "rerunning=%d VolSessionId=%d VolSessionTime=%d Quota=%llu "
       "Protocol=%d BackupFormat=%127s\n";
+static char jobcmd_capabilities[] = " CatalogCapabilities=%d";
 
 /* Responses sent to Director daemon */
 static char OK_job[] = "3000 OK Job SDid=%u SDtime=%u Authorization=%s\n";
@@ -82,6 +83,7 @@ bool job_cmd(JobControlRecord* jcr)
   PoolMem job_name, client_name, job, fileset_name, fileset_md5, backup_format;
   int32_t JobType, level, spool_attributes, no_attributes, spool_data;
   int32_t PreferMountedVols, rerunning, protocol;
+  int32_t catalog_capabilities = 0;
   int status;
   uint64_t quota = 0;
   JobControlRecord* ojcr;
@@ -106,6 +108,14 @@ bool job_cmd(JobControlRecord* jcr)
   jcr->rerunning = (rerunning) ? true : false;
   jcr->setJobProtocol(protocol);
 
+  // Directors before CatalogCapabilities was added do not send it
+  const char* capabilities = strstr(dir->msg, " CatalogCapabilities=");
+  if (capabilities
+      && sscanf(capabilities, jobcmd_capabilities, &catalog_capabilities)
+             == 1) {
+    jcr->sd_impl->catalog_capabilities = catalog_capabilities;
+  }
+
   Dmsg4(100, "rerunning=%d VolSesId=%d VolSesTime=%d Protocol=%d\n",
         jcr->rerunning, jcr->VolSessionId, jcr->VolSessionTime,
         jcr->getJobProtocol());
@@ -381,6 +391,8 @@ void StoredFreeJcr(JobControlRecord* jcr)
     jcr->file_bsock = NULL;
   }
 
+  CloseDataConnections(jcr);
+
   if (jcr->sd_impl->job_name) { FreePoolMemory(jcr->sd_impl->job_name); }
 
   if (jcr->client_name) {
@@ -3,7 +3,7 @@
 
    Copyright (C) 2000-2012 Free Software Foundation Europe e.V.
    Copyright (C) 2011-2012 Planets Communications B.V.
-   Copyright (C) 2013-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2013-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -26,6 +26,9 @@
 
 #include "stored/device_control_record.h"
 
+#include <string>
+#include <vector>
+
 namespace storagedaemon {
 
 class StorageDaemonDeviceControlRecord : public DeviceControlRecord {
@@ -33,13 +36,23 @@ class StorageDaemonDeviceControlRecord : public DeviceControlRecord {
   bool DirFindNextAppendableVolume() override;
   bool DirUpdateVolumeInfo(is_labeloperation label) override;
   bool DirCreateJobmediaRecord(bool zero) override;
+  bool DirFlushJobmediaRecords() override;
   bool DirUpdateFileAttributes(DeviceRecord* record) override;
+  bool DirUpdateFileAttributesBatch(
+      std::vector<DeviceRecord>& records) override;
   bool DirAskSysopToMountVolume(int mode) override;
   bool DirAskSysopToCreateAppendableVolume() override;
   bool DirGetVolumeInfo(enum get_vol_info_rw writing) override;
   bool DirAskToUpdateFileList() override;
   bool DirAskToUpdateJobRecord() override;
   DeviceControlRecord* get_new_spooling_dcr() override;
+
+ private:
+  bool SendJobmediaRecord(bool zero);
+  bool SendJobmediaBatch(bool sync);
+
+  std::vector<std::string> pending_jobmedia_; /**< Not yet sent to the Dir */
+  bool jobmedia_unacked_{}; /**< Batches sent since the last acknowledge */
 };
 
 
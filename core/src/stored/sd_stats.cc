@@ -30,6 +30,9 @@
 #include "stored/stored_globals.h"
 #include "stored/device_control_record.h"
 #include "stored/stored_jcr_impl.h"
+#include "stored/sd_stats.h"
+#include "stored/spool.h"
+#include "lib/metrics.h"
 #include "lib/util.h"
 #include "include/jcr.h"
 #include "lib/parse_conf.h"
@@ -578,4 +581,44 @@ bool StatsCmd(JobControlRecord* jcr)
   return false;
 }
 
+// Gather everything the metrics endpoint of the storage daemon exposes.
+void CollectMetrics(metrics::TextWriter& writer)
+{
+  using Type = metrics::TextWriter::Type;
+
+  metrics::CollectJobMetrics(writer);
+
+  std::vector<Device*> devices;
+  DeviceResource* device_resource = nullptr;
+  foreach_res (device_resource, R_DEVICE) {
+    if (device_resource->dev) { devices.push_back(device_resource->dev); }
+  }
+
+  writer.Family("bareos_device_block_write_duration_seconds", Type::kHistogram,
+                "Time spent writing a single block to the device.");
+  for (Device* dev : devices) {
+    writer.Histogram("bareos_device_block_write_duration_seconds",
+                     {{"device", dev->device_resource->resource_name_}},
+                     dev->block_write_latency);
+  }
+
+  writer.Family("bareos_device_blocks_written", Type::kCounter,
+                "Blocks written to the device.");
+  for (Device* dev : devices) {
+    writer.Sample("bareos_device_blocks_written_total",
+                  {{"device", dev->device_resource->resource_name_}},
+                  dev->blocks_written.Get());
+  }
+
+  writer.Family("bareos_device_bytes_written", Type::kCounter,
+                "Bytes written to the device in blocks.");
+  for (Device* dev : devices) {
+    writer.Sample("bareos_device_bytes_written_total",
+                  {{"device", dev->device_resource->resource_name_}},
+                  dev->block_bytes_written.Get());
+  }
+
+  CollectSpoolMetrics(writer);
+}
+
 } /* namespace storagedaemon */
@@ -21,6 +21,10 @@
 #ifndef BAREOS_STORED_SD_STATS_H_
 #define BAREOS_STORED_SD_STATS_H_
 
+namespace metrics {
+class TextWriter;
+}
+
 namespace storagedaemon {
 
 bool StartStatisticsThread(void);
@@ -28,6 +32,7 @@ void StopStatisticsThread();
 void UpdateDeviceTapealert(const char* devname, uint64_t flags, utime_t now);
 void UpdateJobStatistics(JobControlRecord* jcr, utime_t now);
 bool StatsCmd(JobControlRecord* jcr);
+void CollectMetrics(metrics::TextWriter& writer);
 
 } /* namespace storagedaemon */
 
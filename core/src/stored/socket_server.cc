@@ -103,6 +103,14 @@ void* HandleConnectionRequest(ConfigurationParser* config, void* arg)
     return HandleFiledConnection(bs, name);
   }
 
+  // Additional data connection of a FD job
+  int index;
+  if (sscanf(bs->msg, "Hello Data Connection %127s %d", name, &index) == 2) {
+    Dmsg2(110, "Got data connection %d of a FD at %s\n", index,
+          bstrftimes(tbuf, sizeof(tbuf), (utime_t)time(NULL)));
+    return HandleDataConnection(bs, name, index);
+  }
+
   // See if this is a Storage daemon connection. If so call SD handler.
   if (sscanf(bs->msg, "Hello Start Storage Job %127s", name) == 1) {
     Dmsg1(110, "Got a SD connection at %s\n",
@@ -37,6 +37,7 @@
 #include "lib/berrno.h"
 #include "lib/bsock.h"
 #include "lib/edit.h"
+#include "lib/metrics.h"
 #include "lib/status_packet.h"
 #include "lib/util.h"
 #include "include/jcr.h"
@@ -116,6 +117,28 @@ void ListSpoolStats(StatusPacket* sp)
   }
 }
 
+void CollectSpoolMetrics(metrics::TextWriter& writer)
+{
+  using Type = metrics::TextWriter::Type;
+
+  lock_mutex(mutex);
+  spool_stats_t stats = spool_stats;
+  unlock_mutex(mutex);
+
+  writer.Family("bareos_spool_jobs", Type::kGauge,
+                "Jobs currently spooling.");
+  writer.Sample("bareos_spool_jobs", {{"type", "data"}},
+                static_cast<int64_t>(stats.data_jobs));
+  writer.Sample("bareos_spool_jobs", {{"type", "attribute"}},
+                static_cast<int64_t>(stats.attr_jobs));
+
+  writer.Family("bareos_spool_bytes", Type::kGauge,
+                "Bytes currently held in spool files.");
+  writer.Sample("bareos_spool_bytes", {{"type", "data"}}, stats.data_size);
+  writer.Sample("bareos_spool_bytes", {{"type", "attribute"}},
+                stats.attr_size);
+}
+
 bool BeginDataSpool(DeviceControlRecord* dcr)
 {
   bool status = true;
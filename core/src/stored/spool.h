@@ -22,6 +22,9 @@
 #define BAREOS_STORED_SPOOL_H_
 
 class StatusPacket;
+namespace metrics {
+class TextWriter;
+}
 
 namespace storagedaemon {
 
@@ -34,6 +37,7 @@ bool DiscardAttributeSpool(JobControlRecord* jcr);
 bool CommitAttributeSpool(JobControlRecord* jcr);
 bool WriteBlockToSpoolFile(DeviceControlRecord* dcr);
 void ListSpoolStats(StatusPacket* sp);
+void CollectSpoolMetrics(metrics::TextWriter& writer);
 
 } /* namespace storagedaemon */
 
@@ -54,6 +54,7 @@
 #include "lib/bnet_network_dump.h"
 #include "lib/cli.h"
 #include "lib/daemon.h"
+#include "lib/metrics_server.h"
 #include "lib/bsignal.h"
 #include "lib/parse_conf.h"
 #include "lib/thread_specific_data.h"
@@ -300,6 +301,13 @@ int main(int argc, char* argv[])
 
   StartStatisticsThread();
 
+#if !defined(HAVE_WIN32)
+  if (me->metrics_port) {
+    metrics::StartMetricsServer(me->metrics_address, me->metrics_port,
+                                CollectMetrics);
+  }
+#endif
+
 #if HAVE_NDMP
   // Separate thread that handles NDMP connections
   if (me->ndmp_enable) { StartNdmpThreadServer(me->NDMPaddrs); }
@@ -586,6 +594,9 @@ static
   if (me->ndmp_enable) { StopNdmpThreadServer(); }
 #endif
   StopSocketServer();
+#if !defined(HAVE_WIN32)
+  metrics::StopMetricsServer();
+#endif
 
   StopWatchdog();
 
@@ -114,6 +114,10 @@ static ResourceItem store_items[] = {
   {"SecureEraseCommand", CFG_TYPE_STR, ITEM(res_store, secure_erase_cmdline), 0, 0, NULL, "15.2.1-",
       "Specify command that will be called when bareos unlinks files."},
   {"LogTimestampFormat", CFG_TYPE_STR, ITEM(res_store, log_timestamp_format), 0, CFG_ITEM_DEFAULT, "%d-%b %H:%M", "15.2.3-", NULL},
+  {"MetricsPort", CFG_TYPE_PINT32, ITEM(res_store, metrics_port), 0, CFG_ITEM_DEFAULT, "0", NULL,
+      "TCP port of the OpenMetrics (Prometheus) text endpoint. 0 disables the endpoint."},
+  {"MetricsAddress", CFG_TYPE_STR, ITEM(res_store, metrics_address), 0, CFG_ITEM_DEFAULT, "127.0.0.1", NULL,
+      "Address the metrics endpoint is bound to."},
     TLS_COMMON_CONFIG(res_store),
     TLS_CERT_CONFIG(res_store),
   {nullptr, 0, 0, nullptr, 0, 0, nullptr, nullptr, nullptr}
@@ -196,6 +200,9 @@ static ResourceItem dev_items[] = {
   {"SpoolDirectory", CFG_TYPE_DIR, ITEM(res_dev, spool_directory), 0, 0, NULL, NULL, NULL},
   {"MaximumSpoolSize", CFG_TYPE_SIZE64, ITEM(res_dev, max_spool_size), 0, 0, NULL, NULL, NULL},
   {"MaximumJobSpoolSize", CFG_TYPE_SIZE64, ITEM(res_dev, max_job_spool_size), 0, 0, NULL, NULL, NULL},
+  {"StreamingBufferSize", CFG_TYPE_SIZE64, ITEM(res_dev, streaming_buffer_size), 0, CFG_ITEM_DEFAULT, "0", NULL,
+      "Size of an in-memory buffer in front of a tape drive. Blocks are written from it in bursts, so a drive that "
+      "gets data slower than its streaming speed does not have to stop after every block. 0 disables the buffer."},
   {"DriveIndex", CFG_TYPE_PINT16, ITEM(res_dev, drive_index), 0, 0, NULL, NULL, NULL},
   {"MountPoint", CFG_TYPE_STRNAME, ITEM(res_dev, mount_point), 0, 0, NULL, NULL, NULL},
   {"MountCommand", CFG_TYPE_STRNAME, ITEM(res_dev, mount_command), 0, 0, NULL, NULL, NULL},
@@ -467,6 +474,8 @@ static void MultiplyConfiguredDevices(ConfigurationParser& config)
     DeviceResource& d = dynamic_cast<DeviceResource&>(*p);
     if (d.count > 1) { MultiplyDevice(d); }
   }
+  // the multiplied devices got renamed
+  config.ReindexResources(R_DEVICE);
 }
 
 static void ConfigBeforeCallback(ConfigurationParser& config)
@@ -929,6 +938,7 @@ static void FreeResource(BareosResource* res, int type)
       if (p->scripts_directory) { free(p->scripts_directory); }
       if (p->verid) { free(p->verid); }
       if (p->secure_erase_cmdline) { free(p->secure_erase_cmdline); }
+      if (p->metrics_address) { free(p->metrics_address); }
       if (p->log_timestamp_format) { free(p->log_timestamp_format); }
       delete p;
       break;
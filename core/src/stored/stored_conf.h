@@ -135,6 +135,8 @@ class StorageResource
   char* log_timestamp_format = nullptr; /**< Timestamp format to use in generic
                                  logging messages */
   uint64_t max_bandwidth_per_job = 0;   /**< Bandwidth limitation (global) */
+  uint32_t metrics_port = 0;            /**< Port of the metrics endpoint */
+  char* metrics_address = nullptr;      /**< Address of the metrics endpoint */
 
   StorageResource() = default;
   virtual ~StorageResource() = default;
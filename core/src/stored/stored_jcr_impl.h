@@ -28,6 +28,8 @@
 #include "stored/stored_conf.h"
 #include "lib/thread_util.h"
 
+#include <map>
+
 #define SD_APPEND 1
 #define SD_READ 0
 
@@ -72,6 +74,8 @@ struct StoredJcrImpl {
   pthread_cond_t job_end_wait = PTHREAD_COND_INITIALIZER;   /**< Wait for Job to end */
   synchronized<bool> client_available;
   std::condition_variable job_start_wait; /**< Wait for Client (FD/SD) to start Job */
+  synchronized<std::map<int, BareosSocket*>> data_connections; /**< Additional FD connections by index */
+  std::condition_variable data_connection_wait; /**< Wait for additional FD connections */
   storagedaemon::DeviceControlRecord* read_dcr{}; /**< Device context for reading */
   storagedaemon::DeviceControlRecord* dcr{};      /**< Device context record */
   POOLMEM* job_name{};            /**< Base Job name (not unique) */
@@ -91,6 +95,7 @@ struct StoredJcrImpl {
   bool no_attributes{};           /**< Set if no attributes wanted */
   int64_t spool_size{};           /**< Spool size for this job */
   bool spool_data{};              /**< Set to spool data */
+  int32_t catalog_capabilities{}; /**< CatalogCapabilities of the Director */
   storagedaemon::DirectorResource* director{}; /**< Director resource */
   alist<const char*>* plugin_options{};        /**< Specific Plugin Options sent by DIR */
   alist<storagedaemon::DirectorStorage*>* write_store{};           /**< List of write storage devices sent by DIR */
@@ -0,0 +1,288 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Ring buffer that decouples the block writes of jobs from a tape drive
+ */
+
+#include "include/bareos.h"
+#include "stored/tape_stream_buffer.h"
+#include "lib/berrno.h"
+
+#include <cstring>
+
+namespace storagedaemon {
+
+static const int debuglevel = 150;
+
+TapeStreamBuffer::TapeStreamBuffer(std::string name,
+                                   std::size_t capacity,
+                                   WriteFunction write)
+    : name_{std::move(name)}
+    , capacity_{capacity}
+    , low_watermark_{capacity / 4}
+    , high_watermark_{capacity - capacity / 4}
+    , write_{std::move(write)}
+    , buffer_{new char[capacity]}
+{
+  stats_.capacity = capacity_;
+  writer_ = std::thread([this]() { WriterLoop(); });
+  Dmsg4(debuglevel, "%s: streaming buffer of %zu bytes (low=%zu high=%zu)\n",
+        name_.c_str(), capacity_, low_watermark_, high_watermark_);
+}
+
+TapeStreamBuffer::~TapeStreamBuffer()
+{
+  {
+    std::lock_guard l{mutex_};
+    stop_ = true;
+  }
+  data_ready_.notify_one();
+  writer_.join();
+}
+
+// Check if a block can be copied into the buffer as one contiguous piece
+bool TapeStreamBuffer::Fits(std::size_t len) const
+{
+  if (used_ == 0) { return len <= capacity_; }
+  if (head_ > tail_) {
+    // free space is at the end and, after wrapping, at the start
+    return capacity_ - head_ >= len || tail_ >= len;
+  }
+  return tail_ - head_ >= len;
+}
+
+bool TapeStreamBuffer::ShouldWrite() const
+{
+  if (blocks_.empty() || keep_blocks_) { return false; }
+  return bursting_ || stop_ || waiting_ > 0 || used_ >= high_watermark_;
+}
+
+ssize_t TapeStreamBuffer::Write(const void* data, size_t len)
+{
+  std::unique_lock l{mutex_};
+  if (ReportFailure()) { return -1; }
+
+  if (len > capacity_) {
+    l.unlock();
+    if (!Drain()) { return -1; }
+    if (KeepsBlocks()) {
+      errno = ENOSPC;
+      return -1;
+    }
+    return write_(data, len);
+  }
+
+  if (!Fits(len)) {
+    stats_.producer_waits++;
+    waiting_++;
+    data_ready_.notify_one();
+    space_ready_.wait(l, [this, len]() {
+      return error_ || end_of_medium_ || keep_blocks_ || Fits(len);
+    });
+    waiting_--;
+    if (ReportFailure()) { return -1; }
+    if (!Fits(len)) {
+      // the kept blocks leave no room until the next volume is loaded
+      errno = ENOSPC;
+      return -1;
+    }
+  }
+
+  Block block{0, len, 0};
+  if (used_ == 0) {
+    head_ = tail_ = 0;
+  } else if (head_ > tail_ && capacity_ - head_ < len) {
+    block.padding = capacity_ - head_;
+    head_ = 0;
+  }
+  block.offset = head_;
+  memcpy(buffer_.get() + block.offset, data, len);
+  head_ += len;
+  used_ += len + block.padding;
+  blocks_.push_back(block);
+  queued_++;
+  if (used_ > stats_.max_fill) { stats_.max_fill = used_; }
+
+  if (used_ >= high_watermark_) { data_ready_.notify_one(); }
+  return static_cast<ssize_t>(len);
+}
+
+bool TapeStreamBuffer::Drain()
+{
+  std::unique_lock l{mutex_};
+  uint64_t target = queued_;
+  waiting_++;
+  data_ready_.notify_one();
+  space_ready_.wait(
+      l, [this, target]() { return written_ >= target || keep_blocks_; });
+  waiting_--;
+  if (error_) {
+    // the end of medium warning is superseded by the lost blocks
+    error_ = 0;
+    end_of_medium_ = false;
+    errno = EIO;
+    return false;
+  }
+  // the blocks kept for the next volume are not written yet
+  if (keep_blocks_ && end_of_medium_) {
+    end_of_medium_ = false;
+    errno = ENOSPC;
+    return false;
+  }
+  return true;
+}
+
+bool TapeStreamBuffer::KeepsBlocks() const
+{
+  std::lock_guard l{mutex_};
+  return keep_blocks_ && !end_of_medium_;
+}
+
+void TapeStreamBuffer::Resume(WriteFunction write)
+{
+  {
+    // the writer is idle while it keeps blocks, so write_ can be replaced
+    std::lock_guard l{mutex_};
+    if (keep_blocks_ && !end_of_medium_) {
+      write_ = std::move(write);
+      Dmsg2(debuglevel, "%s: writing %zu kept blocks to the next volume\n",
+            name_.c_str(), blocks_.size());
+      keep_blocks_ = false;
+      bursting_ = true;
+    }
+  }
+  data_ready_.notify_one();
+}
+
+/* Called with the lock held, reports a failure of the writer once. Lost
+ * blocks are reported as EIO, the end of medium alone as ENOSPC. */
+bool TapeStreamBuffer::ReportFailure()
+{
+  if (error_) {
+    error_ = 0;
+    end_of_medium_ = false;
+    errno = EIO;
+    return true;
+  }
+  if (end_of_medium_) {
+    end_of_medium_ = false;
+    errno = ENOSPC;
+    return true;
+  }
+  return false;
+}
+
+TapeStreamBuffer::Statistics TapeStreamBuffer::GetStatistics() const
+{
+  std::lock_guard l{mutex_};
+  Statistics stats = stats_;
+  stats.fill = used_;
+  return stats;
+}
+
+/* Write one block. In variable block mode the tape driver writes the block
+ * that reaches the early end of medium warning and returns ENOSPC for it
+ * anyway, so the block must not be written again. */
+TapeStreamBuffer::BlockStatus TapeStreamBuffer::WriteBlock(const char* data,
+                                                           std::size_t len)
+{
+  ssize_t status = write_(data, len);
+  if (status == static_cast<ssize_t>(len)) { return BlockStatus::kWritten; }
+  if (status == -1 && errno == ENOSPC) {
+    Dmsg1(debuglevel, "%s: early end of medium while streaming\n",
+          name_.c_str());
+    return BlockStatus::kEndOfMedium;
+  }
+
+  if (status >= 0) { errno = ENOSPC; }
+  return BlockStatus::kFailed;
+}
+
+// Called with the lock held after a buffered block could not be written
+void TapeStreamBuffer::DiscardBlocks(int error)
+{
+  BErrNo be;
+  be.SetErrno(error);
+  Emsg3(M_ERROR, 0,
+        T_("Write error on device %s, %d buffered blocks lost. ERR=%s\n"),
+        name_.c_str(), static_cast<int>(blocks_.size()), be.bstrerror());
+
+  error_ = error;
+  stats_.blocks_lost += blocks_.size();
+  blocks_.clear();
+  head_ = tail_ = used_ = 0;
+  written_ = queued_;
+  bursting_ = false;
+  space_ready_.notify_all();
+}
+
+void TapeStreamBuffer::WriterLoop()
+{
+  std::unique_lock l{mutex_};
+  while (true) {
+    data_ready_.wait(l, [this]() { return stop_ || ShouldWrite(); });
+    if (!ShouldWrite()) { break; }
+
+    if (!bursting_) {
+      bursting_ = true;
+      stats_.bursts++;
+      Dmsg2(debuglevel, "%s: start streaming with %zu bytes buffered\n",
+            name_.c_str(), used_);
+    }
+
+    // The block stays accounted in used_ so nothing overwrites it meanwhile
+    Block block = blocks_.front();
+    l.unlock();
+    BlockStatus status = WriteBlock(buffer_.get() + block.offset, block.len);
+    int error = errno;
+    l.lock();
+
+    if (status == BlockStatus::kFailed) {
+      DiscardBlocks(error);
+      continue;
+    }
+
+    blocks_.pop_front();
+    used_ -= block.len + block.padding;
+    tail_ = block.offset + block.len;
+    written_++;
+    stats_.blocks_written++;
+    stats_.bytes_written += block.len;
+
+    // the drive takes no more blocks, those behind the last one are kept
+    if (status == BlockStatus::kEndOfMedium) {
+      end_of_medium_ = true;
+      keep_blocks_ = !blocks_.empty();
+      bursting_ = false;
+      space_ready_.notify_all();
+      continue;
+    }
+
+    if (blocks_.empty()
+        || (used_ <= low_watermark_ && waiting_ == 0 && !stop_)) {
+      bursting_ = false;
+    }
+    space_ready_.notify_all();
+  }
+}
+
+}  // namespace storagedaemon
@@ -0,0 +1,151 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+/**
+ * @file
+ * Ring buffer that decouples the block writes of jobs from a tape drive
+ */
+
+#ifndef BAREOS_STORED_TAPE_STREAM_BUFFER_H_
+#define BAREOS_STORED_TAPE_STREAM_BUFFER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <sys/types.h>
+
+namespace storagedaemon {
+
+/* Blocks are copied into the buffer and written by a dedicated writer thread
+ * with one write per block, so record boundaries on tape are kept.
+ *
+ * The writer only starts once the buffer is filled up to its high watermark
+ * and then writes without pause until the buffer is drained down to its low
+ * watermark. When jobs deliver data slower than the drive streams, the
+ * drive therefore writes in long bursts instead of stopping and
+ * repositioning after every block. When data arrives faster than the drive
+ * can write, the buffer never drains to the low watermark and the drive
+ * streams continuously.
+ *
+ * A block is reported as written as soon as it was copied into the buffer.
+ * The tape driver writes the block that reaches the early end of medium
+ * warning and still returns ENOSPC for it, then refuses further blocks. Such
+ * a block therefore counts as written and the burst ends. The blocks
+ * buffered behind it were already reported as written to the job, so they
+ * are kept for the next volume. The next call to Write(), or to Drain() if
+ * blocks are kept, reports ENOSPC once, like the tape driver itself does.
+ * Afterwards Drain() no longer waits for the kept blocks, so the volume can
+ * be finished, and Resume() writes them to the next volume in front of any
+ * later block. Blocks that cannot be written at all are lost, the next call
+ * to Write() or Drain() then fails with EIO. Once reported, the failure is
+ * cleared, so the device can be used with the next volume. */
+class TapeStreamBuffer {
+ public:
+  using WriteFunction = std::function<ssize_t(const void* data, size_t len)>;
+
+  struct Statistics {
+    std::size_t capacity{0};
+    std::size_t fill{0};            /**< bytes currently buffered */
+    std::size_t max_fill{0};        /**< highest fill level seen */
+    uint64_t blocks_written{0};     /**< blocks written to the drive */
+    uint64_t bytes_written{0};      /**< bytes written to the drive */
+    uint64_t bursts{0};             /**< times the writer started streaming */
+    uint64_t producer_waits{0};     /**< times a write waited for space */
+    uint64_t blocks_lost{0};        /**< buffered blocks that failed */
+  };
+
+  TapeStreamBuffer(std::string name,
+                   std::size_t capacity,
+                   WriteFunction write);
+  ~TapeStreamBuffer();
+  TapeStreamBuffer(const TapeStreamBuffer&) = delete;
+  TapeStreamBuffer& operator=(const TapeStreamBuffer&) = delete;
+
+  // Queue a block, waits while the buffer is full; returns len or -1/errno
+  ssize_t Write(const void* data, size_t len);
+  // Wait until all blocks queued before the call are written or kept
+  bool Drain();
+  // Whether blocks are kept for the next volume after a reported end of medium
+  bool KeepsBlocks() const;
+  // Write the kept blocks, if any, with write, which goes to the next volume
+  void Resume(WriteFunction write);
+  Statistics GetStatistics() const;
+
+  std::size_t LowWatermark() const { return low_watermark_; }
+  std::size_t HighWatermark() const { return high_watermark_; }
+
+ private:
+  enum class BlockStatus
+  {
+    kWritten,
+    kEndOfMedium, /**< written, but the drive takes no further blocks */
+    kFailed
+  };
+
+  struct Block {
+    std::size_t offset;
+    std::size_t len;
+    std::size_t padding; /**< unused bytes at the end before a wrap */
+  };
+
+  bool Fits(std::size_t len) const;
+  bool ShouldWrite() const;
+  bool ReportFailure();
+  BlockStatus WriteBlock(const char* data, std::size_t len);
+  void DiscardBlocks(int error);
+  void WriterLoop();
+
+  const std::string name_;
+  const std::size_t capacity_;
+  const std::size_t low_watermark_;
+  const std::size_t high_watermark_;
+  WriteFunction write_;
+  std::unique_ptr<char[]> buffer_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable data_ready_;  /**< signals the writer */
+  std::condition_variable space_ready_; /**< signals writers and drains */
+  std::deque<Block> blocks_;
+  std::size_t head_{0}; /**< where the next block is copied to */
+  std::size_t tail_{0}; /**< end of the last block that was written */
+  std::size_t used_{0}; /**< buffered bytes, including padding */
+  uint64_t queued_{0};  /**< number of blocks queued */
+  uint64_t written_{0}; /**< number of queued blocks done with */
+  int waiting_{0};      /**< producers and drains waiting for the writer */
+  bool bursting_{false};
+  bool stop_{false};
+  bool end_of_medium_{false};
+  bool keep_blocks_{false}; /**< the queued blocks wait for Resume() */
+  int error_{0};
+  Statistics stats_;
+
+  std::thread writer_;
+};
+
+}  // namespace storagedaemon
+
+#endif  // BAREOS_STORED_TAPE_STREAM_BUFFER_H_
@@ -1,7 +1,7 @@
 /*
    BAREOS® - Backup Archiving REcovery Open Sourced
 
-   Copyright (C) 2022-2022 Bareos GmbH & Co. KG
+   Copyright (C) 2022-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -56,3 +56,228 @@ TEST(AppendProcessedFileTest, AddDeviceRecordCopiesDataContentNotPointer)
 
   FreePoolMemory(test_msg);
 }
+
+#if !defined(HAVE_WIN32)
+#  include "lib/bsock_multiplexed.h"
+#  include "lib/bsock_tcp.h"
+#  include "lib/tls.h"
+
+#  include <arpa/inet.h>
+#  include <netinet/in.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+
+#  include <memory>
+#  include <string>
+#  include <thread>
+#  include <vector>
+
+using storagedaemon::MultiplexedMessageHandler;
+
+namespace {
+// Both ends of a TCP connection over the loopback interface
+struct Connection {
+  BareosSocket* receiver;
+  BareosSocket* sender;
+};
+
+bool ConnectOverLoopback(Connection& connection)
+{
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  if (listener < 0) { return false; }
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  int client = -1, server = -1;
+  if (bind(listener, (sockaddr*)&addr, sizeof(addr)) == 0
+      && listen(listener, 1) == 0
+      && getsockname(listener, (sockaddr*)&addr, &len) == 0) {
+    client = socket(AF_INET, SOCK_STREAM, 0);
+    if (client >= 0 && connect(client, (sockaddr*)&addr, sizeof(addr)) == 0) {
+      server = accept(listener, nullptr, nullptr);
+    }
+  }
+  close(listener);
+  if (server < 0) {
+    if (client >= 0) { close(client); }
+    return false;
+  }
+
+  connection.receiver = new BareosSocketTCP;
+  connection.receiver->fd_ = server;
+  connection.sender = new BareosSocketTCP;
+  connection.sender->fd_ = client;
+  return true;
+}
+
+std::shared_ptr<Tls> MakeTls(BareosSocket* bs)
+{
+  std::shared_ptr<Tls> tls{
+      Tls::CreateNewTlsContext(Tls::TlsImplementationType::kTlsOpenSsl)};
+  tls->SetTcpFileDescriptor(bs->fd_);
+  return tls;
+}
+
+bool StartTls(Connection& connection)
+{
+  auto server_tls = MakeTls(connection.receiver);
+  server_tls->SetCertfile(CERTDIR "/bareos-dir.bareos.org-cert.pem");
+  server_tls->SetKeyfile(CERTDIR "/bareos-dir.bareos.org-key.pem");
+  auto client_tls = MakeTls(connection.sender);
+
+  bool accepted = false;
+  std::thread server([&]() {
+    accepted
+        = server_tls->init() && server_tls->TlsBsockAccept(connection.receiver);
+  });
+  bool connected
+      = client_tls->init() && client_tls->TlsBsockConnect(connection.sender);
+  server.join();
+  if (!accepted || !connected) { return false; }
+
+  connection.receiver->tls_conn = server_tls;
+  connection.sender->tls_conn = client_tls;
+  return true;
+}
+
+// Without waiting for the TLS shutdown of the receiving side
+void CloseSender(Connection& connection)
+{
+  connection.sender->tls_conn.reset();
+  connection.sender->close();
+  delete connection.sender;
+}
+
+// A message with its data, or a signal when the data is empty and length < 0
+struct TestMessage {
+  int32_t length;
+  std::string data;
+};
+
+std::vector<TestMessage> TestStream()
+{
+  std::vector<TestMessage> messages;
+  for (int file = 1; file <= 200; ++file) {
+    std::string header = std::to_string(file) + " 1 0";
+    messages.push_back({static_cast<int32_t>(header.size()), header});
+    std::string data(file * 97 % 5000, 'a' + file % 26);
+    messages.push_back({static_cast<int32_t>(data.size()), data});
+    messages.push_back({BNET_EOD, ""});
+  }
+  // larger than a network packet
+  std::string large(3 * 1000 * 1000, 'L');
+  messages.push_back({static_cast<int32_t>(large.size()), large});
+  messages.push_back({BNET_EOD, ""});
+  return messages;
+}
+
+bool Send(BareosSocketMultiplexed& stream,
+          const std::vector<TestMessage>& messages)
+{
+  for (const TestMessage& message : messages) {
+    if (message.length < 0) {
+      if (!stream.signal(message.length)) { return false; }
+      // heartbeats are not passed on
+      if (!stream.signal(BNET_HEARTBEAT)) { return false; }
+      continue;
+    }
+    stream.msg = CheckPoolMemorySize(stream.msg, message.length + 1);
+    memcpy(stream.msg, message.data.data(), message.length);
+    stream.message_length = message.length;
+    if (!stream.send()) { return false; }
+  }
+  return stream.Finish();
+}
+}  // namespace
+
+TEST(MultiplexedDataConnections, KeepsMessageOrderOverTls)
+{
+  std::vector<Connection> connections(3);
+  for (Connection& connection : connections) {
+    ASSERT_TRUE(ConnectOverLoopback(connection));
+    ASSERT_TRUE(StartTls(connection));
+  }
+
+  std::vector<TestMessage> messages = TestStream();
+  bool sent = false;
+  uint64_t blocks = 0;
+  std::thread sender([&]() {
+    BareosSocketMultiplexed stream(
+        nullptr,
+        {connections[0].sender, connections[1].sender, connections[2].sender},
+        64 * 1024);
+    sent = Send(stream, messages);
+    blocks = stream.BlocksSent();
+  });
+
+  MultiplexedMessageHandler handler(
+      connections[0].receiver,
+      {connections[1].receiver, connections[2].receiver});
+  using signal_type = MultiplexedMessageHandler::signal_type;
+  using message_type = MultiplexedMessageHandler::message_type;
+
+  std::size_t received = 0;
+  for (const TestMessage& expected : messages) {
+    auto msg = handler.get_msg();
+    if (!msg) { break; }
+    if (expected.length < 0) {
+      auto* signal = std::get_if<signal_type>(&msg.value());
+      ASSERT_NE(signal, nullptr);
+      EXPECT_EQ(*signal, expected.length);
+    } else {
+      auto* content = std::get_if<message_type>(&msg.value());
+      ASSERT_NE(content, nullptr);
+      ASSERT_EQ(content->size, expected.data.size());
+      EXPECT_EQ(std::string(content->data.c_str(), content->size),
+                expected.data);
+      EXPECT_EQ(content->data.c_str()[content->size], 0);
+    }
+    received++;
+  }
+  EXPECT_EQ(received, messages.size());
+  EXPECT_EQ(handler.error(), nullptr);
+
+  sender.join();
+  EXPECT_TRUE(sent);
+  EXPECT_GT(blocks, 3u);
+
+  for (Connection& connection : connections) { CloseSender(connection); }
+  BareosSocket* job_connection = handler.close_and_get_sock();
+  EXPECT_EQ(job_connection, connections[0].receiver);
+  job_connection->close();
+  delete job_connection;
+}
+
+TEST(MultiplexedDataConnections, DetectsBlocksOutOfSequence)
+{
+  std::vector<Connection> connections(2);
+  for (Connection& connection : connections) {
+    ASSERT_TRUE(ConnectOverLoopback(connection));
+  }
+
+  {
+    BareosSocketMultiplexed stream(
+        nullptr, {connections[0].sender, connections[1].sender}, 100);
+    std::vector<TestMessage> messages;
+    for (int i = 0; i < 10; ++i) {
+      messages.push_back({60, std::string(60, 'x')});
+    }
+    ASSERT_TRUE(Send(stream, messages));
+  }
+
+  // the connections are given in the wrong order
+  MultiplexedMessageHandler handler(connections[1].receiver,
+                                    {connections[0].receiver});
+  auto msg = handler.get_msg();
+  ASSERT_TRUE(msg);
+  EXPECT_TRUE(std::holds_alternative<MultiplexedMessageHandler::error_type>(
+      msg.value()));
+
+  for (Connection& connection : connections) { CloseSender(connection); }
+  BareosSocket* job_connection = handler.close_and_get_sock();
+  job_connection->close();
+  delete job_connection;
+}
+#endif
@@ -0,0 +1,181 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+#if defined(HAVE_MINGW)
+#  include "include/bareos.h"
+#  include "gtest/gtest.h"
+#else
+#  include "gtest/gtest.h"
+#  include "include/bareos.h"
+#endif
+
+#include "dird/catreq.h"
+#include "include/streams.h"
+#include "lib/serial.h"
+#include "stored/askdir.h"
+
+#include <string>
+#include <vector>
+
+using directordaemon::AttributesMessageRecord;
+using directordaemon::ParseAttributesMessage;
+using storagedaemon::DeviceRecord;
+using storagedaemon::SerializeAttributesBatch;
+
+namespace {
+/* Records with the given data, the storage daemon serializes FileAttributes
+ * messages from the data of records like these. */
+class AttributesBatchTest : public ::testing::Test {
+ protected:
+  void TearDown() override { FreePoolMemory(msg_); }
+
+  void AddRecord(const std::string& data)
+  {
+    data_.push_back(data);
+    DeviceRecord record;
+    record.VolSessionId = 7;
+    record.VolSessionTime = 1700000000;
+    record.FileIndex = static_cast<int32_t>(records_.size()) + 1;
+    record.Stream = STREAM_UNIX_ATTRIBUTES;
+    record.data_len = data.size();
+    records_.push_back(record);
+  }
+
+  // Splits all records into messages and parses them again
+  std::vector<std::vector<AttributesMessageRecord>> RoundTrip(
+      uint32_t max_length)
+  {
+    for (std::size_t i = 0; i < records_.size(); ++i) {
+      records_[i].data = data_[i].data();
+    }
+
+    std::vector<std::vector<AttributesMessageRecord>> messages;
+    std::size_t next = 0;
+    while (next < records_.size()) {
+      std::size_t first = next;
+      next = SerializeAttributesBatch(job_, records_, first, msg_,
+                                      message_length_, max_length);
+      EXPECT_GT(next, first);
+      if (next - first > 1) {
+        EXPECT_LE(static_cast<uint32_t>(message_length_), max_length);
+      }
+
+      std::vector<AttributesMessageRecord> parsed;
+      EXPECT_TRUE(ParseAttributesMessage(msg_, message_length_, parsed));
+      EXPECT_EQ(parsed.size(), next - first);
+      for (std::size_t i = 0; i < parsed.size(); ++i) {
+        const DeviceRecord& record = records_[first + i];
+        EXPECT_EQ(parsed[i].VolSessionId, record.VolSessionId);
+        EXPECT_EQ(parsed[i].VolSessionTime, record.VolSessionTime);
+        EXPECT_EQ(parsed[i].FileIndex,
+                  static_cast<uint32_t>(record.FileIndex));
+        EXPECT_EQ(parsed[i].Stream, record.Stream);
+        EXPECT_EQ(std::string(parsed[i].data, parsed[i].reclen),
+                  data_[first + i]);
+      }
+      messages.push_back(parsed);
+    }
+    return messages;
+  }
+
+  const char* job_ = "backup.2024-01-01_00.00.00_01";
+  std::vector<std::string> data_;
+  std::vector<DeviceRecord> records_;
+  POOLMEM* msg_ = GetPoolMemory(PM_MESSAGE);
+  int32_t message_length_ = 0;
+};
+}  // namespace
+
+TEST_F(AttributesBatchTest, SmallRecordsGoIntoOneMessage)
+{
+  AddRecord(std::string("1 3 /etc/hosts\0P0A CK0 IGk B A A A", 34));
+  AddRecord("2 3 /etc/passwd");
+  AddRecord("");
+  auto messages = RoundTrip(storagedaemon::kMaxAttributesBatchLength);
+  ASSERT_EQ(messages.size(), 1u);
+  std::string header
+      = std::string("UpdCat Job=") + job_ + " FileAttributesBatch ";
+  EXPECT_EQ(std::string(msg_, header.size()), header);
+}
+
+TEST_F(AttributesBatchTest, SplitsAtTheMaximumLength)
+{
+  for (int i = 0; i < 20; ++i) { AddRecord(std::string(1000, 'a' + i)); }
+  auto messages = RoundTrip(4096);
+  EXPECT_EQ(messages.size(), 7u);
+
+  // every record is sent once and in order
+  std::size_t records = 0;
+  for (const auto& message : messages) {
+    for (const auto& record : message) {
+      EXPECT_EQ(record.FileIndex, ++records);
+    }
+  }
+  EXPECT_EQ(records, 20u);
+}
+
+TEST_F(AttributesBatchTest, LargeRecordsAreSentAlone)
+{
+  AddRecord("small");
+  AddRecord(std::string(10000, 'x'));
+  AddRecord("small");
+  auto messages = RoundTrip(4096);
+  ASSERT_EQ(messages.size(), 3u);
+  EXPECT_EQ(messages[1][0].reclen, 10000u);
+}
+
+TEST_F(AttributesBatchTest, RejectsTruncatedMessages)
+{
+  AddRecord("1 3 /etc/hosts");
+  AddRecord("2 3 /etc/passwd");
+  RoundTrip(storagedaemon::kMaxAttributesBatchLength);
+
+  std::vector<AttributesMessageRecord> parsed;
+  for (int32_t cut : {1, 10, 20}) {
+    EXPECT_FALSE(ParseAttributesMessage(msg_, message_length_ - cut, parsed))
+        << "cut " << cut;
+  }
+}
+
+TEST_F(AttributesBatchTest, SingleRecordMessage)
+{
+  std::string data = "1 3 /etc/hosts";
+  std::string header = std::string("UpdCat Job=") + job_ + " FileAttributes ";
+  std::vector<char> msg(header.size() + 20 + data.size() + 16, 0);
+  memcpy(msg.data(), header.data(), header.size());
+  ser_declare;
+  SerBegin(msg.data() + header.size(), 0);
+  ser_uint32(7);
+  ser_uint32(1700000000);
+  ser_int32(1);
+  ser_int32(STREAM_UNIX_ATTRIBUTES);
+  ser_uint32(data.size());
+  SerBytes(data.data(), data.size());
+  int32_t length = SerLength(msg.data());
+
+  // a single record message holds one record, whatever follows it
+  std::vector<AttributesMessageRecord> parsed;
+  ASSERT_TRUE(ParseAttributesMessage(msg.data(), length + 16, parsed));
+  ASSERT_EQ(parsed.size(), 1u);
+  EXPECT_EQ(std::string(parsed[0].data, parsed[0].reclen), data);
+  EXPECT_EQ(parsed[0].FileIndex, 1u);
+
+  EXPECT_FALSE(ParseAttributesMessage(msg.data(), length - 1, parsed));
+}
@@ -118,7 +118,38 @@ static void CheckEncryption(const BareosSocket* UA_sock, TlsPolicy tls_policy)
   }
 }
 
-static bool do_connection_test(std::string path_to_config, TlsPolicy tls_policy)
+static void CheckCommandOutput(BareosSocket* UA_sock,
+                               const char* command,
+                               const char* expected)
+{
+  UA_sock->fsend("%s", command);
+
+  std::string output;
+  while (UA_sock->recv() >= 0) { output += UA_sock->msg; }
+  EXPECT_EQ(UA_sock->message_length, BNET_EOD);
+  EXPECT_NE(output.find(expected), std::string::npos) << output;
+}
+
+static void CheckSessionResumption()
+{
+  JobControlRecord jcr;
+  PBareosSocket UA_sock(ConnectToDirector(jcr));
+  if (!UA_sock) { return; }
+
+  EXPECT_TRUE(UA_sock->tls_conn.get());
+  if (UA_sock->tls_conn) {
+    EXPECT_TRUE(UA_sock->tls_conn->TlsSessionResumed());
+  }
+
+  UA_sock->signal(BNET_TERMINATE);
+  UA_sock->close();
+  jcr.dir_bsock = nullptr;
+}
+
+static bool do_connection_test(std::string path_to_config,
+                               TlsPolicy tls_policy,
+                               uint32_t console_worker_threads = 0,
+                               utime_t tls_session_lifetime = 0)
 {
   debug_level = 10;  // set debug level high enough so we can see error messages
   InitSignalHandler();
@@ -130,6 +161,9 @@ static bool do_connection_test(std::string path_to_config, TlsPolicy tls_policy)
   PConfigParser director_config(DirectorPrepareResources(path_to_config));
   if (!director_config) { return false; }
 
+  directordaemon::me->console_worker_threads = console_worker_threads;
+  directordaemon::me->tls_session_lifetime_ = tls_session_lifetime;
+  console::director_resource->tls_session_lifetime_ = tls_session_lifetime;
   bool start_socket_server_ok
       = directordaemon::StartSocketServer(directordaemon::me->DIRaddrs);
   EXPECT_TRUE(start_socket_server_ok) << "Could not start SocketServer";
@@ -142,10 +176,25 @@ static bool do_connection_test(std::string path_to_config, TlsPolicy tls_policy)
 
   CheckEncryption(UA_sock.get(), tls_policy);
 
+  if (tls_session_lifetime && UA_sock->tls_conn) {
+    EXPECT_FALSE(UA_sock->tls_conn->TlsSessionResumed());
+  }
+
+  if (console_worker_threads) {
+    // every command goes through the event loop and back
+    CheckCommandOutput(UA_sock.get(), "version", "Version:");
+    CheckCommandOutput(UA_sock.get(), "whoami", "root");
+  }
+
   UA_sock->signal(BNET_TERMINATE);
   UA_sock->close();
   jcr.dir_bsock = nullptr;
 
+  if (tls_session_lifetime) {
+    // the first connection left a session ticket behind
+    CheckSessionResumption();
+  }
+
   directordaemon::StopSocketServer();
   StopWatchdog();
   return true;
@@ -159,9 +208,32 @@ TEST(bsock, console_director_connection_test_tls_psk)
       TlsPolicy::kBnetTlsEnabled);
 }
 
+TEST(bsock, console_director_connection_test_tls_psk_session_resumption)
+{
+  InitOpenSsl();
+  do_connection_test(
+      std::string("configs/console-director/tls_psk_default_enabled/"),
+      TlsPolicy::kBnetTlsEnabled, 0, 300);
+}
+
 TEST(bsock, console_director_connection_test_cleartext)
 {
   InitOpenSsl();
   do_connection_test(std::string("configs/console-director/tls_disabled/"),
                      TlsPolicy::kBnetTlsNone);
 }
+
+TEST(bsock, console_director_connection_test_event_loop_tls_psk)
+{
+  InitOpenSsl();
+  do_connection_test(
+      std::string("configs/console-director/tls_psk_default_enabled/"),
+      TlsPolicy::kBnetTlsEnabled, 2);
+}
+
+TEST(bsock, console_director_connection_test_event_loop_cleartext)
+{
+  InitOpenSsl();
+  do_connection_test(std::string("configs/console-director/tls_disabled/"),
+                     TlsPolicy::kBnetTlsNone, 2);
+}
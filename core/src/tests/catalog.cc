@@ -30,6 +30,8 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "include/bareos.h"
+#include "include/filetypes.h"
+#include "include/streams.h"
 #include "lib/parse_conf.h"
 #include "lib/util.h"
 #include "dird/jcr_util.h"
@@ -163,3 +165,186 @@ TEST_F(CatalogTest, database)
 
   EXPECT_EQ(time_converted, StrToUtime("2019-11-27 15:04:49"));
 }
+
+static int CollectRows(void* ctx, int num_fields, char** row)
+{
+  auto* rows = static_cast<std::vector<std::string>*>(ctx);
+  std::string line;
+  for (int i = 0; i < num_fields; ++i) {
+    if (i > 0) { line += " "; }
+    line += row[i] ? row[i] : "NULL";
+  }
+  rows->push_back(line);
+  return 0;
+}
+
+TEST_F(CatalogTest, CreateJobmediaRecords)
+{
+  ASSERT_TRUE(db->SqlQuery(
+      "INSERT INTO Job (Job, Name, Type, Level, JobStatus, SchedTime)"
+      " VALUES ('jobmedia.2024-01-01_00.00.00_01', 'jobmedia', 'B', 'F', 'R',"
+      " '2024-01-01 00:00:00')",
+      0));
+  ASSERT_TRUE(db->SqlQuery(
+      "INSERT INTO Media (VolumeName, MediaType, VolStatus)"
+      " VALUES ('jobmedia-1', 'File', 'Append'),"
+      " ('jobmedia-2', 'File', 'Append')",
+      0));
+
+  JobDbRecord jr;
+  bstrncpy(jr.Job, "jobmedia.2024-01-01_00.00.00_01", sizeof(jr.Job));
+  ASSERT_TRUE(db->GetJobRecord(jcr, &jr));
+  MediaDbRecord media1, media2;
+  bstrncpy(media1.VolumeName, "jobmedia-1", sizeof(media1.VolumeName));
+  bstrncpy(media2.VolumeName, "jobmedia-2", sizeof(media2.VolumeName));
+  ASSERT_TRUE(db->GetMediaRecord(jcr, &media1));
+  ASSERT_TRUE(db->GetMediaRecord(jcr, &media2));
+
+  auto record = [&jr](DBId_t MediaId, uint32_t first, uint32_t last,
+                      uint32_t end_block) {
+    JobMediaDbRecord jm;
+    jm.JobId = jr.JobId;
+    jm.MediaId = MediaId;
+    jm.FirstIndex = first;
+    jm.LastIndex = last;
+    jm.EndBlock = end_block;
+    return jm;
+  };
+
+  EXPECT_TRUE(db->CreateJobmediaRecords(jcr, {}));
+  ASSERT_TRUE(db->CreateJobmediaRecords(
+      jcr, {record(media1.MediaId, 1, 10, 100),
+            record(media1.MediaId, 10, 20, 200),
+            record(media2.MediaId, 20, 30, 50)}));
+  // a second batch continues the volume index
+  ASSERT_TRUE(db->CreateJobmediaRecords(
+      jcr, {record(media2.MediaId, 30, 40, 80)}));
+
+  std::vector<std::string> rows;
+  std::string query = "SELECT MediaId, FirstIndex, LastIndex, VolIndex"
+                      " FROM JobMedia WHERE JobId="
+                      + std::to_string(jr.JobId) + " ORDER BY JobMediaId";
+  ASSERT_TRUE(db->SqlQuery(query.c_str(), CollectRows, &rows));
+  std::string m1 = std::to_string(media1.MediaId);
+  std::string m2 = std::to_string(media2.MediaId);
+  EXPECT_EQ(rows, (std::vector<std::string>{
+                      m1 + " 1 10 1", m1 + " 10 20 2", m2 + " 20 30 3",
+                      m2 + " 30 40 4"}));
+
+  // the media records end where their last JobMedia record ends
+  ASSERT_TRUE(db->GetMediaRecord(jcr, &media1));
+  ASSERT_TRUE(db->GetMediaRecord(jcr, &media2));
+  EXPECT_EQ(media1.EndBlock, 200u);
+  EXPECT_EQ(media2.EndBlock, 80u);
+}
+
+TEST_F(CatalogTest, CreateAttributesRecords)
+{
+  ASSERT_TRUE(db->SqlQuery(
+      "INSERT INTO Job (Job, Name, Type, Level, JobStatus, SchedTime)"
+      " VALUES ('attributes.2024-01-01_00.00.00_01', 'attributes', 'B', 'F',"
+      " 'R', '2024-01-01 00:00:00')",
+      0));
+  JobDbRecord jr;
+  bstrncpy(jr.Job, "attributes.2024-01-01_00.00.00_01", sizeof(jr.Job));
+  ASSERT_TRUE(db->GetJobRecord(jcr, &jr));
+
+  std::vector<std::string> names{"/tmp/attributes/one", "/tmp/attributes/two",
+                                 "/tmp/three"};
+  std::vector<AttributesDbRecord> records(names.size());
+  std::vector<AttributesDbRecord*> ars;
+  char lstat[] = "P0A CK0 IGk B A A A";
+  for (std::size_t i = 0; i < names.size(); ++i) {
+    records[i].fname = names[i].data();
+    records[i].attr = lstat;
+    records[i].FileIndex = i + 1;
+    records[i].Stream = STREAM_UNIX_ATTRIBUTES;
+    records[i].FileType = FT_REG;
+    records[i].JobId = jr.JobId;
+    ars.push_back(&records[i]);
+  }
+
+  ASSERT_TRUE(db->CreateAttributesRecords(jcr, ars));
+  ASSERT_TRUE(db->WriteBatchFileRecords(jcr));
+
+  std::vector<std::string> rows;
+  std::string query = "SELECT FileIndex, Path || Name FROM File"
+                      " JOIN Path USING (PathId) WHERE JobId="
+                      + std::to_string(jr.JobId) + " ORDER BY FileIndex";
+  ASSERT_TRUE(db->SqlQuery(query.c_str(), CollectRows, &rows));
+  EXPECT_EQ(rows, (std::vector<std::string>{"1 /tmp/attributes/one",
+                                            "2 /tmp/attributes/two",
+                                            "3 /tmp/three"}));
+
+  jcr->db_batch->CloseDatabase(jcr);
+  jcr->db_batch = nullptr;
+}
+
+TEST_F(CatalogTest, PurgeFilesInBatches)
+{
+  ASSERT_TRUE(db->SqlQuery(
+      "INSERT INTO Job (Job, Name, Type, Level, JobStatus, SchedTime)"
+      " VALUES ('purge.2024-01-01_00.00.00_01', 'purge', 'B', 'F', 'T',"
+      " '2024-01-01 00:00:00'),"
+      " ('purge.2024-01-01_00.00.00_02', 'purge', 'B', 'F', 'T',"
+      " '2024-01-01 00:00:00')",
+      0));
+  JobDbRecord purged, kept;
+  bstrncpy(purged.Job, "purge.2024-01-01_00.00.00_01", sizeof(purged.Job));
+  bstrncpy(kept.Job, "purge.2024-01-01_00.00.00_02", sizeof(kept.Job));
+  ASSERT_TRUE(db->GetJobRecord(jcr, &purged));
+  ASSERT_TRUE(db->GetJobRecord(jcr, &kept));
+  ASSERT_TRUE(db->SqlQuery("INSERT INTO Path (Path) VALUES ('/purge/')", 0));
+
+  // the FileIds of the purged job have a large gap filled by the other job
+  auto insert_files = [this](JobId_t jobid, int first, int last) {
+    std::string query
+        = "INSERT INTO File (FileId, JobId, PathId, LStat, Md5, Name)"
+          " SELECT id, "
+          + std::to_string(jobid)
+          + ", (SELECT PathId FROM Path WHERE Path='/purge/'), '', '',"
+            " 'file' || id FROM generate_series("
+          + std::to_string(first) + ", " + std::to_string(last) + ") id";
+    return db->SqlQuery(query.c_str(), 0);
+  };
+  ASSERT_TRUE(insert_files(purged.JobId, 1000001, 1000005));
+  ASSERT_TRUE(insert_files(kept.JobId, 1500001, 1500003));
+  ASSERT_TRUE(insert_files(purged.JobId, 2000001, 2000005));
+
+  FilePurgeSettings settings;
+  settings.batch_size = 4;
+  std::vector<uint64_t> progress;
+  settings.progress = [&progress, &purged](JobId_t jobid, uint64_t count) {
+    EXPECT_EQ(jobid, purged.JobId);
+    progress.push_back(count);
+  };
+  ASSERT_TRUE(db->PurgeFiles(std::to_string(purged.JobId).c_str(), settings));
+  EXPECT_EQ(progress, (std::vector<uint64_t>{4, 8, 10}));
+
+  std::vector<std::string> rows;
+  std::string query = "SELECT JobId, PurgedFiles, (SELECT count(*) FROM File"
+                      " WHERE File.JobId=Job.JobId) FROM Job WHERE JobId IN ("
+                      + std::to_string(purged.JobId) + ", "
+                      + std::to_string(kept.JobId) + ") ORDER BY JobId";
+  ASSERT_TRUE(db->SqlQuery(query.c_str(), CollectRows, &rows));
+  EXPECT_EQ(rows, (std::vector<std::string>{
+                      std::to_string(purged.JobId) + " 1 0",
+                      std::to_string(kept.JobId) + " 0 3"}));
+}
+
+TEST_F(CatalogTest, PurgeJobsKeepsJobsIfFilesCannotBePurged)
+{
+  ASSERT_TRUE(db->SqlQuery(
+      "INSERT INTO Job (Job, Name, Type, Level, JobStatus, SchedTime)"
+      " VALUES ('purge-error.2024-01-01_00.00.00_01', 'purge-error', 'B', 'F',"
+      " 'T', '2024-01-01 00:00:00')",
+      0));
+  JobDbRecord jr;
+  bstrncpy(jr.Job, "purge-error.2024-01-01_00.00.00_01", sizeof(jr.Job));
+  ASSERT_TRUE(db->GetJobRecord(jcr, &jr));
+
+  // a jobid list the File DELETE cannot be run with
+  std::string jobids = std::to_string(jr.JobId) + ",not-a-jobid";
+  EXPECT_FALSE(db->PurgeJobs(jobids.c_str()));
+  EXPECT_TRUE(db->GetJobRecord(jcr, &jr));
+}
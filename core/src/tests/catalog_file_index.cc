@@ -0,0 +1,121 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+#if defined(HAVE_MINGW)
+#  include "include/bareos.h"
+#  include "gtest/gtest.h"
+#else
+#  include "gtest/gtest.h"
+#  include "include/bareos.h"
+#endif
+
+#include "cats/cats.h"
+#include "dird/catalog_file_index.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace directordaemon;
+
+static std::vector<std::string> SortedMissing(const CatalogFileIndex& index)
+{
+  std::vector<std::string> missing = index.Missing();
+  std::sort(missing.begin(), missing.end());
+  return missing;
+}
+
+TEST(CatalogFileIndex, FindsFiles)
+{
+  CatalogFileIndex index;
+  index.Add("/etc/passwd", 1, "lstat-passwd", "digest-passwd");
+  index.Add("/etc/", 2, "lstat-etc", nullptr);
+
+  FileDbRecord fdbr;
+  ASSERT_TRUE(index.Find("/etc/passwd", 1, &fdbr));
+  EXPECT_STREQ(fdbr.LStat, "lstat-passwd");
+  EXPECT_STREQ(fdbr.Digest, "digest-passwd");
+
+  ASSERT_TRUE(index.Find("/etc/", 2, &fdbr));
+  EXPECT_STREQ(fdbr.LStat, "lstat-etc");
+  EXPECT_STREQ(fdbr.Digest, "");
+  EXPECT_TRUE(index.Missing().empty());
+}
+
+TEST(CatalogFileIndex, MissesUnknownFiles)
+{
+  CatalogFileIndex index;
+  index.Add("/etc/passwd", 1, "lstat-passwd", "digest-passwd");
+
+  FileDbRecord fdbr;
+  EXPECT_FALSE(index.Find("/etc/shadow", 1, &fdbr));
+  EXPECT_FALSE(index.Find("/etc/passw", 1, &fdbr));
+  EXPECT_FALSE(index.Find("/etc/passwd/", 1, &fdbr));
+  EXPECT_FALSE(index.Find("", 1, &fdbr));
+  EXPECT_EQ(index.Missing(), std::vector<std::string>{"/etc/passwd"});
+}
+
+// the File daemon reports a file found by any version of it in the job
+TEST(CatalogFileIndex, DuplicateNames)
+{
+  CatalogFileIndex index;
+  index.Add("/data/file", 1, "lstat-first", "");
+  index.Add("/data/file", 5, "lstat-second", "");
+
+  FileDbRecord fdbr;
+  ASSERT_TRUE(index.Find("/data/file", 5, &fdbr));
+  EXPECT_STREQ(fdbr.LStat, "lstat-first");
+  ASSERT_TRUE(index.Find("/data/file", 1, &fdbr));
+  EXPECT_STREQ(fdbr.LStat, "lstat-first");
+
+  // only one of the versions was seen
+  EXPECT_EQ(index.Missing(), std::vector<std::string>{"/data/file"});
+}
+
+// VolumeToCatalog tells the versions apart by their FileIndex
+TEST(CatalogFileIndex, DuplicateNamesMatchingFileIndex)
+{
+  CatalogFileIndex index(true);
+  index.Add("/data/file", 1, "lstat-first", "");
+  index.Add("/data/file", 5, "lstat-second", "");
+
+  FileDbRecord fdbr;
+  EXPECT_FALSE(index.Find("/data/file", 3, &fdbr));
+  ASSERT_TRUE(index.Find("/data/file", 5, &fdbr));
+  EXPECT_STREQ(fdbr.LStat, "lstat-second");
+  EXPECT_EQ(index.Missing(), std::vector<std::string>{"/data/file"});
+
+  ASSERT_TRUE(index.Find("/data/file", 1, &fdbr));
+  EXPECT_STREQ(fdbr.LStat, "lstat-first");
+  EXPECT_TRUE(index.Missing().empty());
+}
+
+// files deleted since the previous backup have FileIndex 0
+TEST(CatalogFileIndex, DeletedFilesAreNotMissing)
+{
+  CatalogFileIndex index;
+  index.Add("/data/deleted", 0, "lstat-deleted", "");
+  index.Add("/data/one", 1, "lstat-one", "");
+  index.Add("/data/two", 2, "lstat-two", "");
+
+  FileDbRecord fdbr;
+  ASSERT_TRUE(index.Find("/data/one", 1, &fdbr));
+  EXPECT_EQ(SortedMissing(index), std::vector<std::string>{"/data/two"});
+}
@@ -0,0 +1,111 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+#if defined(HAVE_MINGW)
+#  include "include/bareos.h"
+#  include "gtest/gtest.h"
+#else
+#  include "gtest/gtest.h"
+#  include "include/bareos.h"
+#endif
+
+#include "dird/catreq.h"
+
+#include <string>
+#include <vector>
+
+using namespace directordaemon;
+
+static const std::string header
+    = "CatReq Job=backup.2024-01-01_00.00.00_01 CreateJobMediaBatch";
+
+TEST(JobmediaBatch, ParsesAllRecords)
+{
+  std::string msg = header + " Count=2 Sync=0\n"
+                    + "1 10 0 0 100 199 0 0 3\n"
+                    + "11 20 0 1 200 4294967295 0 0 4000000000\n";
+  std::vector<JobMediaDbRecord> jms;
+  ASSERT_TRUE(ParseJobmediaBatch(msg.c_str(), 42, 2, jms));
+  ASSERT_EQ(jms.size(), 2u);
+
+  EXPECT_EQ(jms[0].JobId, 42u);
+  EXPECT_EQ(jms[0].MediaId, 3u);
+  EXPECT_EQ(jms[0].FirstIndex, 1u);
+  EXPECT_EQ(jms[0].LastIndex, 10u);
+  EXPECT_EQ(jms[0].StartBlock, 100u);
+  EXPECT_EQ(jms[0].EndBlock, 199u);
+
+  EXPECT_EQ(jms[1].JobId, 42u);
+  EXPECT_EQ(jms[1].MediaId, 4000000000u);
+  EXPECT_EQ(jms[1].FirstIndex, 11u);
+  EXPECT_EQ(jms[1].EndFile, 1u);
+  EXPECT_EQ(jms[1].EndBlock, 4294967295u);
+}
+
+TEST(JobmediaBatch, ParsesPlaceHolder)
+{
+  std::string msg = header + " Count=1 Sync=1\n" + "0 0 0 0 0 0 0 0 7\n";
+  std::vector<JobMediaDbRecord> jms;
+  ASSERT_TRUE(ParseJobmediaBatch(msg.c_str(), 1, 1, jms));
+  ASSERT_EQ(jms.size(), 1u);
+  EXPECT_EQ(jms[0].MediaId, 7u);
+  EXPECT_EQ(jms[0].FirstIndex, 0u);
+}
+
+TEST(JobmediaBatch, RejectsWrongCount)
+{
+  std::string msg = header + " Count=3 Sync=0\n" + "1 10 0 0 100 199 0 0 3\n"
+                    + "11 20 0 1 200 299 0 0 3\n";
+  std::vector<JobMediaDbRecord> jms;
+  EXPECT_FALSE(ParseJobmediaBatch(msg.c_str(), 1, 3, jms));
+  EXPECT_EQ(jms.size(), 2u);
+  EXPECT_FALSE(ParseJobmediaBatch(msg.c_str(), 1, 1, jms));
+}
+
+TEST(JobmediaBatch, RejectsMalformedRecords)
+{
+  std::string msg = header + " Count=2 Sync=0\n" + "1 10 0 0 100 199 0 0 3\n"
+                    + "11 20 0 1 200\n";
+  std::vector<JobMediaDbRecord> jms;
+  EXPECT_FALSE(ParseJobmediaBatch(msg.c_str(), 1, 2, jms));
+  EXPECT_EQ(jms.size(), 1u);
+
+  // a short record does not take the numbers of the next one
+  msg = header + " Count=2 Sync=0\n" + "11 20 0 1\n" + "200 299 0 0 3\n";
+  EXPECT_FALSE(ParseJobmediaBatch(msg.c_str(), 1, 2, jms));
+  EXPECT_TRUE(jms.empty());
+
+  msg = header + " Count=1 Sync=0\n" + "1 10 0 0 100 199 0 0 x3\n";
+  EXPECT_FALSE(ParseJobmediaBatch(msg.c_str(), 1, 1, jms));
+  msg = header + " Count=1 Sync=0\n" + "1 10 0 0 100 199 0 0 3 4\n";
+  EXPECT_FALSE(ParseJobmediaBatch(msg.c_str(), 1, 1, jms));
+}
+
+TEST(JobmediaBatch, EmptyBatch)
+{
+  std::vector<JobMediaDbRecord> jms;
+  std::string msg = header + " Count=0 Sync=1\n";
+  EXPECT_TRUE(ParseJobmediaBatch(msg.c_str(), 1, 0, jms));
+  EXPECT_TRUE(jms.empty());
+
+  // without the terminating newline of the request line
+  msg.pop_back();
+  EXPECT_TRUE(ParseJobmediaBatch(msg.c_str(), 1, 0, jms));
+}
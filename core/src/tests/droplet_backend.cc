@@ -54,10 +54,10 @@
 
 using namespace storagedaemon;
 
-void droplet_write_reread_testdata(std::vector<std::vector<char>>& test_data)
+void droplet_write_reread_testdata(std::vector<std::vector<char>>& test_data,
+                                   const char* dev_name = "droplet")
 {
   const char* name = "sd_backend_test";
-  const char* dev_name = "droplet";
   const char* volname
       = ::testing::UnitTest::GetInstance()->current_test_info()->name();
 
@@ -192,3 +192,17 @@ TEST_F(sd, droplet_double_oversized_write)
 
   droplet_write_reread_testdata(test_data);
 }
+
+// chunks uploaded in several parts by the io-threads
+TEST_F(sd, droplet_multipart_upload)
+{
+  using namespace std::string_literals;
+  std::vector<std::vector<char>> test_data;
+  for (char& c : "0123"s) {
+    std::vector<char> tmp(11 * 1024 * 1024);
+    std::fill(tmp.begin(), tmp.end(), c);
+    test_data.push_back(tmp);
+  }
+
+  droplet_write_reread_testdata(test_data, "droplet-multipart");
+}
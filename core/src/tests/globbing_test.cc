@@ -31,6 +31,8 @@
 #include "dird/ua.h"
 #include "dird/ua_restore.cc"
 
+#include <filesystem>
+
 using namespace directordaemon;
 
 int FakeCdCmd(UaContext* ua, TreeContext* tree, std::string path)
@@ -184,3 +186,37 @@ TEST_F(Globbing, globbing_in_markcmd)
   //  EXPECT_EQ(FakeMarkCmd(&ua, tree, "{*tory1,*tory2}/file1"), 1);
   //  EXPECT_EQ(fnmatch("{*tory1,*tory2}", "subdirectory1", 0), 0);
 }
+
+TEST_F(Globbing, spooled_tree)
+{
+  FreeTree(tree.root);
+  tree.root = new_tree(1, std::filesystem::temp_directory_path().c_str());
+  tree.node = (TREE_NODE*)tree.root;
+  ASSERT_GE(tree.root->spool_fd, 0);
+
+  std::vector<std::string> files;
+  for (int i = 0; i < 100000; ++i) {
+    files.push_back("/spool/dir" + std::to_string(i / 1000) + "/file"
+                    + std::to_string(i));
+  }
+  PopulateTree(files, &tree);
+
+  // the tree needs several buffers, all of them mapped from the spool file
+  EXPECT_GT(tree.root->blocks, 1u);
+  for (s_mem* mem = tree.root->mem; mem; mem = mem->next) {
+    EXPECT_TRUE(mem->mapped);
+  }
+
+  FakeCdCmd(ua, &tree, "/spool/dir42/");
+  EXPECT_EQ(FakeMarkCmd(ua, &tree, "file4200?"), 10);
+
+  FakeCdCmd(ua, &tree, "/");
+  EXPECT_EQ(FakeMarkCmd(ua, &tree, "*"), files.size());
+
+  std::size_t marked = 0;
+  for (TREE_NODE* node = FirstTreeNode(tree.root); node;
+       node = NextTreeNode(node)) {
+    if (node->extract && node->type == TN_FILE) { marked++; }
+  }
+  EXPECT_EQ(marked, files.size());
+}
@@ -0,0 +1,122 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+#if defined(HAVE_MINGW)
+#  include "include/bareos.h"
+#  include "gtest/gtest.h"
+#else
+#  include "gtest/gtest.h"
+#  include "include/bareos.h"
+#endif
+
+#include "lib/metrics.h"
+
+#include <thread>
+#include <vector>
+
+using metrics::LatencyHistogram;
+using metrics::TextWriter;
+
+TEST(metrics, counter_is_consistent_across_threads)
+{
+  metrics::Counter counter;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&counter] {
+      for (int j = 0; j < 10000; ++j) { counter.Add(2); }
+    });
+  }
+  for (auto& t : threads) { t.join(); }
+
+  EXPECT_EQ(counter.Get(), 4 * 10000 * 2);
+}
+
+TEST(metrics, histogram_buckets_are_cumulative)
+{
+  LatencyHistogram histogram;
+  histogram.Observe(10);         // <= 50us
+  histogram.Observe(50);         // <= 50us
+  histogram.Observe(800);        // <= 1ms
+  histogram.Observe(5'000'000);  // +Inf
+
+  const std::size_t inf = LatencyHistogram::kBucketBoundsUsec.size();
+  EXPECT_EQ(histogram.CumulativeCount(0), 2);
+  EXPECT_EQ(histogram.CumulativeCount(3), 2);
+  EXPECT_EQ(histogram.CumulativeCount(4), 3);
+  EXPECT_EQ(histogram.CumulativeCount(inf - 1), 3);
+  EXPECT_EQ(histogram.CumulativeCount(inf), 4);
+  EXPECT_EQ(histogram.Count(), 4);
+  EXPECT_EQ(histogram.SumUsec(), 10 + 50 + 800 + 5'000'000);
+}
+
+TEST(metrics, text_format)
+{
+  TextWriter writer;
+  writer.Family("bareos_test_bytes", TextWriter::Type::kCounter, "Test.");
+  writer.Sample("bareos_test_bytes_total",
+                {{"job", "a\"b\\c"}, {"jobid", "1"}}, uint64_t{42});
+  writer.Family("bareos_test_depth", TextWriter::Type::kGauge, "Depth.");
+  writer.Sample("bareos_test_depth", {}, int64_t{-1});
+
+  EXPECT_EQ(writer.Finish(),
+            "# TYPE bareos_test_bytes counter\n"
+            "# HELP bareos_test_bytes Test.\n"
+            "bareos_test_bytes_total{job=\"a\\\"b\\\\c\",jobid=\"1\"} 42\n"
+            "# TYPE bareos_test_depth gauge\n"
+            "# HELP bareos_test_depth Depth.\n"
+            "bareos_test_depth -1\n"
+            "# EOF\n");
+}
+
+TEST(metrics, prometheus_text_format)
+{
+  TextWriter writer(TextWriter::Format::kPrometheus);
+  writer.Family("bareos_test_bytes", TextWriter::Type::kCounter, "Test.");
+  writer.Sample("bareos_test_bytes_total", {{"jobid", "1"}}, uint64_t{42});
+  writer.Family("bareos_test_depth", TextWriter::Type::kGauge, "Depth.");
+  writer.Sample("bareos_test_depth", {}, int64_t{-1});
+
+  EXPECT_EQ(writer.Finish(),
+            "# TYPE bareos_test_bytes_total counter\n"
+            "# HELP bareos_test_bytes_total Test.\n"
+            "bareos_test_bytes_total{jobid=\"1\"} 42\n"
+            "# TYPE bareos_test_depth gauge\n"
+            "# HELP bareos_test_depth Depth.\n"
+            "bareos_test_depth -1\n");
+}
+
+TEST(metrics, histogram_text_format)
+{
+  LatencyHistogram histogram;
+  histogram.Observe(100);
+
+  TextWriter writer;
+  writer.Histogram("lat", {{"device", "d"}}, histogram);
+  std::string text = writer.Finish();
+
+  EXPECT_NE(text.find("lat_bucket{device=\"d\",le=\"5e-05\"} 0\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("lat_bucket{device=\"d\",le=\"0.0001\"} 1\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("lat_bucket{device=\"d\",le=\"+Inf\"} 1\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("lat_count{device=\"d\"} 1\n"), std::string::npos);
+  EXPECT_NE(text.find("lat_sum{device=\"d\"} 0.0001\n"), std::string::npos);
+}
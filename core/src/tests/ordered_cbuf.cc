@@ -0,0 +1,180 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+#if defined(HAVE_MINGW)
+#  include "include/bareos.h"
+#  include "gtest/gtest.h"
+#else
+#  include "gtest/gtest.h"
+#  include "include/bareos.h"
+#endif
+
+#include "stored/backends/ordered_cbuf.h"
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+
+using namespace storagedaemon;
+
+namespace {
+struct request {
+  std::string volname;
+  uint32_t chunk;
+  int updates{0};
+};
+
+int CompareRequest(ocbuf_item* item1, ocbuf_item* item2)
+{
+  auto* r1 = static_cast<request*>(item1->data);
+  auto* r2 = static_cast<request*>(item2->data);
+
+  if (int res = r1->volname.compare(r2->volname); res != 0) { return res; }
+  if (r1->chunk == r2->chunk) { return 0; }
+  return (r1->chunk < r2->chunk) ? -1 : 1;
+}
+
+void UpdateRequest(void* item, void*)
+{
+  static_cast<request*>(item)->updates++;
+}
+
+void* Enqueue(ordered_circbuf& cb,
+              request& r,
+              bool use_reserved_slot = false,
+              bool no_signal = false)
+{
+  return cb.enqueue(&r, sizeof(r), UpdateRequest, use_reserved_slot,
+                    no_signal);
+}
+
+// An absolute timeout as used by the io-threads of the chunked device
+struct timespec In(std::chrono::milliseconds ms)
+{
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  long long nsec = tv.tv_usec * 1000LL + ms.count() * 1'000'000LL;
+  struct timespec ts;
+  ts.tv_sec = tv.tv_sec + nsec / 1'000'000'000LL;
+  ts.tv_nsec = nsec % 1'000'000'000LL;
+  return ts;
+}
+}  // namespace
+
+TEST(ordered_circbuf, dequeues_in_order)
+{
+  ordered_circbuf cb(CompareRequest);
+  request b1{"b", 1}, a2{"a", 2}, a1{"a", 1};
+  Enqueue(cb, b1);
+  Enqueue(cb, a2);
+  Enqueue(cb, a1);
+
+  EXPECT_EQ(cb.dequeue(), &a1);
+  EXPECT_EQ(cb.dequeue(), &a2);
+  EXPECT_EQ(cb.dequeue(), &b1);
+  EXPECT_TRUE(cb.empty());
+}
+
+TEST(ordered_circbuf, merges_requests_for_the_same_chunk)
+{
+  ordered_circbuf cb(CompareRequest);
+  request first{"a", 1}, again{"a", 1};
+  EXPECT_EQ(Enqueue(cb, first), &first);
+  EXPECT_EQ(Enqueue(cb, again), &first);
+  EXPECT_EQ(first.updates, 1);
+
+  EXPECT_EQ(cb.dequeue(), &first);
+  EXPECT_TRUE(cb.empty());
+}
+
+TEST(ordered_circbuf, reserved_slot)
+{
+  ordered_circbuf cb(CompareRequest, 2);
+  request r1{"a", 1}, r2{"a", 2};
+  Enqueue(cb, r1);
+  Enqueue(cb, r2);
+  ASSERT_TRUE(cb.full());
+
+  // the slot of a dequeued request stays taken while it is reserved
+  EXPECT_EQ(cb.dequeue(true), &r1);
+  EXPECT_TRUE(cb.full());
+  EXPECT_EQ(cb.unreserve_slot(), 0);
+  EXPECT_FALSE(cb.full());
+  EXPECT_EQ(cb.unreserve_slot(), -1);
+
+  // a request can be put back into its reserved slot without waiting
+  EXPECT_EQ(cb.dequeue(true), &r2);
+  Enqueue(cb, r1);
+  ASSERT_TRUE(cb.full());
+  EXPECT_EQ(Enqueue(cb, r2, true), &r2);
+  EXPECT_TRUE(cb.full());
+  EXPECT_EQ(cb.unreserve_slot(), -1);
+}
+
+TEST(ordered_circbuf, enqueue_wakes_a_consumer)
+{
+  ordered_circbuf cb(CompareRequest);
+  request r{"a", 1};
+  auto consumer
+      = std::async(std::launch::async, [&cb] { return cb.dequeue(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  Enqueue(cb, r);
+  ASSERT_EQ(consumer.wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+  EXPECT_EQ(consumer.get(), &r);
+}
+
+TEST(ordered_circbuf, requeue_waits_for_the_timeout)
+{
+  ordered_circbuf cb(CompareRequest);
+  request requeued{"a", 1}, other{"a", 2};
+  constexpr auto timeout = std::chrono::milliseconds(500);
+
+  auto start = std::chrono::steady_clock::now();
+  auto consumer = std::async(std::launch::async, [&cb, timeout] {
+    struct timespec ts = In(timeout);
+    return cb.dequeue(false, true, &ts, 1);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // neither the requeue nor another consumer wakes up the waiting one
+  Enqueue(cb, requeued, false, true);
+  Enqueue(cb, other, false, true);
+  EXPECT_EQ(cb.dequeue(), &requeued);
+  EXPECT_EQ(consumer.wait_for(timeout / 2), std::future_status::timeout);
+
+  EXPECT_EQ(consumer.get(), &other);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, timeout);
+}
+
+TEST(ordered_circbuf, flush_wakes_all_consumers)
+{
+  ordered_circbuf cb(CompareRequest);
+  auto first = std::async(std::launch::async, [&cb] { return cb.dequeue(); });
+  auto second = std::async(std::launch::async, [&cb] { return cb.dequeue(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  cb.flush();
+  EXPECT_EQ(first.get(), nullptr);
+  EXPECT_EQ(second.get(), nullptr);
+  EXPECT_TRUE(cb.IsFlushing());
+}
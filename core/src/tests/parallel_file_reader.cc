@@ -0,0 +1,220 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+#if defined(HAVE_MINGW)
+#  include "include/bareos.h"
+#  include "gtest/gtest.h"
+#else
+#  include "gtest/gtest.h"
+#  include "include/bareos.h"
+#endif
+
+#include "filed/parallel_file_reader.h"
+#include "findlib/hole_finder.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace filedaemon;
+
+namespace {
+constexpr std::size_t block_size = 4096;
+constexpr std::size_t num_readers = 4;
+
+struct ReadResult {
+  std::string data;
+  std::vector<std::uint64_t> offsets;
+  std::vector<std::size_t> sizes;
+  std::vector<int> errors;
+};
+
+class ParallelFileReaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    file_ = tmpfile();
+    ASSERT_NE(file_, nullptr);
+    fd_ = fileno(file_);
+  }
+  void TearDown() override
+  {
+    if (file_) { fclose(file_); }
+  }
+
+  // Every byte tells its position, so misplaced blocks are noticed
+  static std::string Content(std::size_t size)
+  {
+    std::string content(size, '\0');
+    for (std::size_t i = 0; i < size; ++i) {
+      content[i] = static_cast<char>((i / block_size * 7 + i) % 251);
+    }
+    return content;
+  }
+
+  void Write(const std::string& content, std::uint64_t offset = 0)
+  {
+    ASSERT_EQ(pwrite(fd_, content.data(), content.size(), offset),
+              static_cast<ssize_t>(content.size()));
+  }
+
+  ReadResult ReadAll(parallel_file_reader& reader)
+  {
+    ReadResult result;
+    while (std::optional block = reader.next()) {
+      result.data.append(block->msg.data_ptr(), block->msg.data_size());
+      result.offsets.push_back(block->offset);
+      result.sizes.push_back(block->msg.data_size());
+      result.errors.push_back(block->error);
+    }
+    return result;
+  }
+
+  thread_pool pool_;
+  FILE* file_{nullptr};
+  int fd_{-1};
+};
+}  // namespace
+
+TEST_F(ParallelFileReaderTest, BlocksComeInFileOrder)
+{
+  std::string content = Content(50 * block_size);
+  Write(content);
+
+  parallel_file_reader reader(pool_, fd_, num_readers, block_size,
+                              content.size());
+  ReadResult result = ReadAll(reader);
+
+  ASSERT_EQ(result.offsets.size(), 50u);
+  for (std::size_t i = 0; i < result.offsets.size(); ++i) {
+    EXPECT_EQ(result.offsets[i], i * block_size);
+    EXPECT_EQ(result.sizes[i], block_size);
+    EXPECT_EQ(result.errors[i], 0);
+  }
+  EXPECT_TRUE(result.data == content);
+  EXPECT_FALSE(reader.next());
+}
+
+TEST_F(ParallelFileReaderTest, LastBlockIsShort)
+{
+  std::string content = Content(10 * block_size + 100);
+  Write(content);
+
+  parallel_file_reader reader(pool_, fd_, num_readers, block_size,
+                              content.size());
+  ReadResult result = ReadAll(reader);
+
+  ASSERT_EQ(result.sizes.size(), 11u);
+  EXPECT_EQ(result.sizes.back(), 100u);
+  EXPECT_EQ(result.offsets.back(), 10 * block_size);
+  EXPECT_TRUE(result.data == content);
+}
+
+TEST_F(ParallelFileReaderTest, FileSmallerThanOneBlock)
+{
+  std::string content = Content(100);
+  Write(content);
+
+  parallel_file_reader reader(pool_, fd_, num_readers, block_size,
+                              content.size());
+  ReadResult result = ReadAll(reader);
+
+  EXPECT_EQ(result.sizes, std::vector<std::size_t>{100});
+  EXPECT_TRUE(result.data == content);
+}
+
+TEST_F(ParallelFileReaderTest, ReadsOnlyTheSizeOfAGrowingFile)
+{
+  std::string content = Content(20 * block_size);
+  Write(content);
+  std::uint64_t size = 5 * block_size + block_size / 2;
+
+  parallel_file_reader reader(pool_, fd_, num_readers, block_size, size);
+  Write(content, content.size());
+  ReadResult result = ReadAll(reader);
+
+  ASSERT_EQ(result.sizes.size(), 6u);
+  EXPECT_EQ(result.sizes.back(), block_size / 2);
+  EXPECT_TRUE(result.data == content.substr(0, size));
+}
+
+TEST_F(ParallelFileReaderTest, FileGotShorter)
+{
+  std::string content = Content(10 * block_size);
+  Write(content);
+  std::uint64_t new_size = 3 * block_size + block_size / 2;
+  ASSERT_EQ(ftruncate(fd_, new_size), 0);
+
+  // the size the file had when it was stat()ed
+  parallel_file_reader reader(pool_, fd_, num_readers, block_size,
+                              content.size());
+  ReadResult result = ReadAll(reader);
+
+  ASSERT_EQ(result.sizes.size(), 10u);
+  EXPECT_EQ(result.sizes[3], block_size / 2);
+  for (std::size_t i = 4; i < result.sizes.size(); ++i) {
+    EXPECT_EQ(result.sizes[i], 0u);
+    EXPECT_EQ(result.errors[i], 0);
+  }
+  EXPECT_TRUE(result.data == content.substr(0, new_size));
+}
+
+TEST_F(ParallelFileReaderTest, ReadErrorsArePassedOn)
+{
+  Write(Content(8 * block_size));
+  std::string path = "/proc/self/fd/" + std::to_string(fd_);
+  int write_only = open(path.c_str(), O_WRONLY);
+  if (write_only < 0) { GTEST_SKIP() << "cannot reopen the file"; }
+
+  {
+    parallel_file_reader reader(pool_, write_only, num_readers, block_size,
+                                8 * block_size);
+    ReadResult result = ReadAll(reader);
+    EXPECT_EQ(result.errors, std::vector<int>(8, EBADF));
+    EXPECT_EQ(result.sizes, std::vector<std::size_t>(8, 0));
+  }
+  close(write_only);
+}
+
+TEST_F(ParallelFileReaderTest, SkipsHoles)
+{
+  // data in the first and the last block
+  std::string content = Content(block_size);
+  Write(content);
+  Write(content, 63 * block_size);
+#if defined(SEEK_HOLE)
+  if (lseek(fd_, 0, SEEK_HOLE) >= static_cast<off_t>(64 * block_size)) {
+    GTEST_SKIP() << "the filesystem does not report holes";
+  }
+#else
+  GTEST_SKIP() << "holes cannot be looked up on this platform";
+#endif
+
+  HoleFinder holes(fd_, 64 * block_size);
+  parallel_file_reader reader(pool_, fd_, num_readers, block_size,
+                              64 * block_size, &holes);
+  ReadResult result = ReadAll(reader);
+
+  EXPECT_EQ(result.offsets, (std::vector<std::uint64_t>{0, 63 * block_size}));
+  EXPECT_TRUE(result.data == content + content);
+}
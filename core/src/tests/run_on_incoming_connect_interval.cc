@@ -251,6 +251,10 @@ class MockDatabase : public BareosDb {
   {
     return true;
   }
+  virtual bool SqlBatchFlushFileTable(JobControlRecord*) override
+  {
+    return true;
+  }
 };
 
 static void scheduler_loop(Scheduler* scheduler) { scheduler->Run(); }
@@ -0,0 +1,193 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+#if defined(HAVE_MINGW)
+#  include "include/bareos.h"
+#  include "gtest/gtest.h"
+#else
+#  include "gtest/gtest.h"
+#  include "include/bareos.h"
+#endif
+
+#include "include/jcr.h"
+#include "lib/bsock_tcp.h"
+#include "lib/parse_conf.h"
+#include "lib/qualified_resource_name_type_converter.h"
+#include "stored/fd_cmds.h"
+#include "stored/job.h"
+#include "stored/socket_server.h"
+#include "stored/stored_conf.h"
+#include "stored/stored_globals.h"
+#include "stored/stored_jcr_impl.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace storagedaemon;
+
+/* The File daemon side of the connections is built from the storage daemon
+ * resource, which stands in for the client resource as its TLS resource. */
+class DataConnectionTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    struct sigaction sig = {};
+    sig.sa_handler = SIG_IGN;
+    sigaction(SIGUSR2, &sig, nullptr);
+    sigaction(SIGPIPE, &sig, nullptr);
+
+    OSDependentInit();
+    config_.reset(InitSdConfig("configs/sd_data_connections/", M_ERROR_TERM));
+    my_config = config_.get();
+    ASSERT_TRUE(my_config->ParseConfig());
+    me = static_cast<StorageResource*>(my_config->GetNextRes(R_STORAGE, NULL));
+    ASSERT_NE(me, nullptr);
+    my_config->own_resource_ = me;
+
+    jcr_ = NewStoredJcr();
+    bstrncpy(jcr_->Job, "backup-job.2024-01-01_00.00.00_01", sizeof(jcr_->Job));
+    jcr_->sd_auth_key = strdup("the session key of the job");
+    jcr_->client_name = GetPoolMemory(PM_NAME);
+    PmStrcpy(jcr_->client_name, "test-fd");
+  }
+
+  void TearDown() override
+  {
+    // close our ends first, so the storage daemon does not wait for them
+    for (BareosSocket* bs : clients_) {
+      bs->tls_conn.reset();
+      bs->close();
+      delete bs;
+    }
+    if (jcr_) {
+      jcr_->JobId = 0;
+      FreeJcr(jcr_);
+    }
+    my_config = nullptr;
+    me = nullptr;
+  }
+
+  // Connects the way the File daemon does and lets the SD handle the hello
+  bool Connect(const std::string& hello)
+  {
+    int fds[2];
+    if (!LoopbackConnection(fds)) { return false; }
+
+    BareosSocket* server = new BareosSocketTCP;
+    server->fd_ = fds[0];
+    server->SetWho(strdup("test-fd"));
+    server->SetHost(strdup("127.0.0.1"));
+    std::thread handler(
+        [server]() { HandleConnectionRequest(my_config, server); });
+
+    BareosSocket* client = new BareosSocketTCP;
+    client->fd_ = fds[1];
+    client->SetWho(strdup("Storage daemon"));
+    client->SetHost(strdup("127.0.0.1"));
+    clients_.push_back(client);
+
+    std::string identity;
+    my_config->GetQualifiedResourceNameTypeConverter()->ResourceToString(
+        jcr_->Job, R_JOB, identity);
+    s_password password;
+    password.encoding = p_encoding_md5;
+    password.value = jcr_->sd_auth_key;
+
+    bool ok = client->DoTlsHandshake(TlsPolicy::kBnetTlsAuto, me, false,
+                                     identity.c_str(), jcr_->sd_auth_key,
+                                     nullptr)
+              && client->fsend("%s", hello.c_str())
+              && client->AuthenticateOutboundConnection(
+                  nullptr, "test-fd", jcr_->client_name, password, me);
+    handler.join();
+    return ok && client->tls_conn;
+  }
+
+  std::string DataConnectionHello(int index)
+  {
+    return std::string("Hello Data Connection ") + jcr_->Job + " "
+           + std::to_string(index) + "\n";
+  }
+
+  std::unique_ptr<ConfigurationParser> config_;
+  JobControlRecord* jcr_{nullptr};
+  std::vector<BareosSocket*> clients_;
+
+ private:
+  static bool LoopbackConnection(int fds[2])
+  {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) { return false; }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    fds[0] = fds[1] = -1;
+    if (bind(listener, (sockaddr*)&addr, sizeof(addr)) == 0
+        && listen(listener, 1) == 0
+        && getsockname(listener, (sockaddr*)&addr, &len) == 0) {
+      fds[1] = socket(AF_INET, SOCK_STREAM, 0);
+      if (fds[1] >= 0
+          && connect(fds[1], (sockaddr*)&addr, sizeof(addr)) == 0) {
+        fds[0] = accept(listener, nullptr, nullptr);
+      }
+    }
+    close(listener);
+    if (fds[0] < 0) {
+      if (fds[1] >= 0) { close(fds[1]); }
+      return false;
+    }
+    return true;
+  }
+};
+
+TEST_F(DataConnectionTest, DataConnectionsDoNotAuthenticateTheJob)
+{
+  ASSERT_TRUE(Connect(DataConnectionHello(1)));
+  ASSERT_TRUE(Connect(DataConnectionHello(2)));
+  EXPECT_FALSE(jcr_->authenticated);
+  EXPECT_EQ(jcr_->sd_impl->data_connections.lock()->size(), 2u);
+
+  // the job connection still follows
+  ASSERT_TRUE(Connect(std::string("Hello Start Job ") + jcr_->Job + "\n"));
+  EXPECT_TRUE(jcr_->authenticated);
+  EXPECT_NE(jcr_->file_bsock, nullptr);
+
+  // and no more data connections after it
+  EXPECT_FALSE(Connect(DataConnectionHello(3)));
+  EXPECT_EQ(jcr_->sd_impl->data_connections.lock()->size(), 2u);
+}
+
+TEST_F(DataConnectionTest, RejectsDuplicateDataConnections)
+{
+  ASSERT_TRUE(Connect(DataConnectionHello(1)));
+  Connect(DataConnectionHello(1));
+  EXPECT_EQ(jcr_->sd_impl->data_connections.lock()->size(), 1u);
+  EXPECT_FALSE(jcr_->authenticated);
+}
@@ -0,0 +1,117 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+#if defined(HAVE_MINGW)
+#  include "include/bareos.h"
+#  include "gtest/gtest.h"
+#else
+#  include "gtest/gtest.h"
+#  include "include/bareos.h"
+#endif
+
+#include "cats/shared_path_id_cache.h"
+
+#include <string>
+
+TEST(shared_path_id_cache, lookup_counts_hits_and_misses)
+{
+  SharedPathIdCache cache(100);
+
+  EXPECT_EQ(cache.Lookup("/etc/"), 0u);
+  cache.Insert("/etc/", 42);
+  EXPECT_EQ(cache.Lookup("/etc/"), 42u);
+  EXPECT_EQ(cache.Lookup("/etc"), 0u);
+
+  EXPECT_EQ(cache.hits(), 1u);
+  EXPECT_EQ(cache.misses(), 2u);
+  EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(shared_path_id_cache, is_bounded)
+{
+  SharedPathIdCache cache(160);
+
+  for (uint32_t i = 1; i <= 10000; ++i) {
+    cache.Insert("/data/" + std::to_string(i) + "/", i);
+  }
+  // at most one path per shard more than the capacity
+  EXPECT_LE(cache.size(), cache.capacity() + 16);
+  EXPECT_EQ(cache.Lookup("/data/10000/"), 10000u);
+  EXPECT_EQ(cache.Lookup("/data/1/"), 0u);
+}
+
+TEST(shared_path_id_cache, replaces_path_id)
+{
+  SharedPathIdCache cache(100);
+
+  cache.Insert("/a/", 1);
+  cache.Insert("/a/", 2);
+  EXPECT_EQ(cache.Lookup("/a/"), 2u);
+  EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(shared_path_id_cache, erases_paths)
+{
+  SharedPathIdCache cache(10);
+  cache.Insert("/a/", 1);
+  cache.Insert("/b/", 2);
+  cache.Erase("/a/");
+  cache.Erase("/unknown/");
+  EXPECT_EQ(cache.size(), 1u);
+  EXPECT_EQ(cache.Lookup("/a/"), 0u);
+  EXPECT_EQ(cache.Lookup("/b/"), 2u);
+
+  cache.Insert("/a/", 3);
+  EXPECT_EQ(cache.Lookup("/a/"), 3u);
+}
+
+TEST(shared_path_id_cache, keeps_recently_used_paths)
+{
+  SharedPathIdCache cache(160);
+
+  cache.Insert("/hot/", 1);
+  for (uint32_t i = 0; i < 10000; ++i) {
+    cache.Insert("/cold/" + std::to_string(i) + "/", i + 10);
+    ASSERT_EQ(cache.Lookup("/hot/"), 1u);
+  }
+}
+
+TEST(shared_path_id_cache, configured_per_database)
+{
+  EXPECT_EQ(GetSharedPathIdCache("bareos", "localhost", 5432), nullptr);
+
+  uint64_t generation = SharedPathIdCacheGeneration();
+  ConfigureSharedPathIdCache("bareos", "localhost", 5432, 1000);
+  EXPECT_NE(SharedPathIdCacheGeneration(), generation);
+
+  auto cache = GetSharedPathIdCache("bareos", "localhost", 5432);
+  ASSERT_NE(cache, nullptr);
+  EXPECT_EQ(cache->capacity(), 1000u);
+  EXPECT_EQ(GetSharedPathIdCache("bareos", "otherhost", 5432), nullptr);
+
+  // an unchanged configuration keeps the cached paths
+  generation = SharedPathIdCacheGeneration();
+  ConfigureSharedPathIdCache("bareos", "localhost", 5432, 1000);
+  EXPECT_EQ(SharedPathIdCacheGeneration(), generation);
+  EXPECT_EQ(GetSharedPathIdCache("bareos", "localhost", 5432), cache);
+
+  ConfigureSharedPathIdCache("bareos", "localhost", 5432, 0);
+  EXPECT_EQ(GetSharedPathIdCache("bareos", "localhost", 5432), nullptr);
+}
@@ -0,0 +1,154 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+#if defined(HAVE_MINGW)
+#  include "include/bareos.h"
+#  include "gtest/gtest.h"
+#else
+#  include "gtest/gtest.h"
+#  include "include/bareos.h"
+#endif
+
+#include "findlib/hole_finder.h"
+#include "lib/zero_block.h"
+
+#include <cstdio>
+#include <vector>
+
+TEST(ZeroBlock, EveryCheckFindsEveryNonZeroByte)
+{
+  // odd offset and length, so the checks also see unaligned data and a tail
+  std::vector<char> storage(3 * 4096 + 100, 0);
+  char* buf = storage.data() + 1;
+  std::size_t len = storage.size() - 1;
+
+  for (ZeroCheck check : SupportedZeroChecks()) {
+    SCOPED_TRACE(ZeroCheckName(check));
+    EXPECT_TRUE(IsZeroBlock(check, buf, len));
+    EXPECT_TRUE(IsZeroBlock(check, buf, 0));
+    for (std::size_t i = 0; i < len; ++i) {
+      buf[i] = 1;
+      ASSERT_FALSE(IsZeroBlock(check, buf, len)) << "at " << i;
+      EXPECT_TRUE(IsZeroBlock(check, buf + i + 1, len - i - 1));
+      buf[i] = 0;
+    }
+  }
+}
+
+TEST(ZeroBlock, BestCheckIsSupported)
+{
+  EXPECT_TRUE(ZeroCheckSupported(BestZeroCheck()));
+
+  std::vector<char> buf(65536, 0);
+  EXPECT_TRUE(IsZeroBlock(buf.data(), buf.size()));
+  buf.back() = 0x80;
+  EXPECT_FALSE(IsZeroBlock(buf.data(), buf.size()));
+}
+
+#if !defined(HAVE_WIN32)
+namespace {
+constexpr std::size_t block_size = 64 * 1024;
+
+/* A file with data in the first and seventh block and holes in between and
+ * at the end */
+class HoleFinderTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    file_ = tmpfile();
+    ASSERT_NE(file_, nullptr);
+    fd_ = fileno(file_);
+
+    std::vector<char> data(block_size, 'x');
+    ASSERT_EQ(pwrite(fd_, data.data(), data.size(), 0), block_size);
+    ASSERT_EQ(pwrite(fd_, data.data(), data.size(), 6 * block_size),
+              block_size);
+  }
+  void TearDown() override
+  {
+    if (file_) { fclose(file_); }
+  }
+
+  void Resize(std::uint64_t size)
+  {
+    ASSERT_EQ(ftruncate(fd_, size), 0);
+#  if defined(SEEK_HOLE)
+    if (lseek(fd_, 0, SEEK_HOLE) >= static_cast<off_t>(size)) {
+      GTEST_SKIP() << "the filesystem does not report holes";
+    }
+#  else
+    GTEST_SKIP() << "holes cannot be looked up on this platform";
+#  endif
+  }
+
+  std::int64_t Offset() { return lseek(fd_, 0, SEEK_CUR); }
+
+  FILE* file_{nullptr};
+  int fd_{-1};
+};
+}  // namespace
+
+TEST_F(HoleFinderTest, SkipsWholeBlocksOfHoles)
+{
+  Resize(10 * block_size);
+  if (IsSkipped()) { return; }
+
+  HoleFinder holes(fd_, 10 * block_size);
+  EXPECT_EQ(holes.SkipHole(0, block_size), 0);
+  EXPECT_EQ(holes.SkipHole(block_size, block_size), 6 * block_size);
+  EXPECT_EQ(Offset(), 6 * block_size);
+  EXPECT_EQ(holes.SkipHole(6 * block_size, block_size), 6 * block_size);
+  EXPECT_EQ(holes.SkippedBytes(), 5 * block_size);
+}
+
+TEST_F(HoleFinderTest, KeepsTheLastBlock)
+{
+  Resize(10 * block_size);
+  if (IsSkipped()) { return; }
+
+  HoleFinder holes(fd_, 10 * block_size);
+  EXPECT_EQ(holes.SkipHole(7 * block_size, block_size), 9 * block_size);
+  EXPECT_EQ(Offset(), 9 * block_size);
+  EXPECT_EQ(holes.SkipHole(9 * block_size, block_size), 9 * block_size);
+  EXPECT_EQ(holes.SkippedBytes(), 2 * block_size);
+}
+
+TEST_F(HoleFinderTest, KeepsAShortLastBlock)
+{
+  std::uint64_t size = 10 * block_size + 100;
+  Resize(size);
+  if (IsSkipped()) { return; }
+
+  HoleFinder holes(fd_, size);
+  EXPECT_EQ(holes.SkipHole(7 * block_size, block_size), 10 * block_size);
+  EXPECT_EQ(holes.SkippedBytes(), 3 * block_size);
+}
+
+TEST_F(HoleFinderTest, DoesNotSkipPartialBlocks)
+{
+  Resize(10 * block_size);
+  if (IsSkipped()) { return; }
+
+  // the hole ends in the middle of the fifth block read from here
+  std::uint64_t position = block_size + block_size / 2;
+  HoleFinder holes(fd_, 10 * block_size);
+  EXPECT_EQ(holes.SkipHole(position, block_size), position + 4 * block_size);
+}
+#endif
@@ -0,0 +1,308 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+#if defined(HAVE_MINGW)
+#  include "include/bareos.h"
+#  include "gtest/gtest.h"
+#else
+#  include "gtest/gtest.h"
+#  include "include/bareos.h"
+#endif
+
+#include "stored/tape_stream_buffer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using storagedaemon::TapeStreamBuffer;
+
+namespace {
+/* Stands in for a tape drive: a file that records the size of every write.
+ * Like the st driver in variable block mode, the write that reaches the
+ * early end of medium warning is written but returns ENOSPC, further writes
+ * return ENOSPC without writing until the next volume is loaded. */
+class FileTape {
+ public:
+  FileTape() : file_{tmpfile()} {}
+  ~FileTape() { fclose(file_); }
+
+  TapeStreamBuffer::WriteFunction Writer()
+  {
+    return [this](const void* data, size_t len) -> ssize_t {
+      if (fail_after_ == 0 || at_end_) {
+        errno = fail_after_ == 0 ? EIO : ENOSPC;
+        return -1;
+      }
+      if (fail_after_ > 0) { fail_after_--; }
+      std::this_thread::sleep_for(write_delay_);
+      ssize_t written = ::write(fileno(file_), data, len);
+      if (written > 0) { writes_.push_back(written); }
+      if (early_warning_at_ == writes_.size()) {
+        early_warning_at_ = -1;
+        at_end_ = true;
+        errno = ENOSPC;
+        return -1;
+      }
+      return written;
+    };
+  }
+
+  void LoadNextVolume() { at_end_ = false; }
+
+  std::string Contents()
+  {
+    fflush(file_);
+    std::string contents;
+    char buf[4096];
+    ssize_t n;
+    off_t offset = 0;
+    while ((n = pread(fileno(file_), buf, sizeof(buf), offset)) > 0) {
+      contents.append(buf, n);
+      offset += n;
+    }
+    return contents;
+  }
+
+  std::vector<ssize_t> writes_;
+  std::size_t early_warning_at_ = -1; /**< number of writes that reach it */
+  int fail_after_ = -1;
+  std::chrono::milliseconds write_delay_{0};
+
+ private:
+  FILE* file_;
+  bool at_end_{false};
+};
+
+std::string Block(std::size_t len, char c) { return std::string(len, c); }
+}  // namespace
+
+TEST(tape_stream_buffer, keeps_blocks_and_their_order)
+{
+  FileTape tape;
+  std::string expected;
+  std::vector<ssize_t> sizes;
+  {
+    TapeStreamBuffer buffer("test", 10000, tape.Writer());
+    // different sizes, so blocks wrap around the end of the buffer
+    for (int i = 0; i < 200; ++i) {
+      std::string block = Block(500 + (i * 37) % 2000, 'a' + i % 26);
+      ASSERT_EQ(buffer.Write(block.data(), block.size()),
+                static_cast<ssize_t>(block.size()));
+      expected += block;
+      sizes.push_back(block.size());
+    }
+    ASSERT_TRUE(buffer.Drain());
+
+    TapeStreamBuffer::Statistics stats = buffer.GetStatistics();
+    EXPECT_EQ(stats.fill, 0u);
+    EXPECT_EQ(stats.blocks_written, 200u);
+    EXPECT_EQ(stats.bytes_written, expected.size());
+    EXPECT_LE(stats.max_fill, 10000u);
+  }
+  EXPECT_EQ(tape.writes_, sizes);
+  EXPECT_EQ(tape.Contents(), expected);
+}
+
+TEST(tape_stream_buffer, waits_for_high_watermark)
+{
+  FileTape tape;
+  TapeStreamBuffer buffer("test", 4000, tape.Writer());
+  std::string block = Block(1000, 'x');
+
+  // below the high watermark nothing is written
+  ASSERT_EQ(buffer.Write(block.data(), block.size()), 1000);
+  ASSERT_EQ(buffer.Write(block.data(), block.size()), 1000);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(buffer.GetStatistics().blocks_written, 0u);
+
+  // reaching it starts one burst down to the low watermark
+  ASSERT_EQ(buffer.Write(block.data(), block.size()), 1000);
+  for (int i = 0; i < 500 && buffer.GetStatistics().fill > 1000; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  TapeStreamBuffer::Statistics stats = buffer.GetStatistics();
+  EXPECT_EQ(stats.bursts, 1u);
+  EXPECT_EQ(stats.blocks_written, 2u);
+  EXPECT_EQ(stats.fill, buffer.LowWatermark());
+
+  ASSERT_TRUE(buffer.Drain());
+  EXPECT_EQ(buffer.GetStatistics().blocks_written, 3u);
+}
+
+TEST(tape_stream_buffer, writes_large_blocks_directly)
+{
+  FileTape tape;
+  TapeStreamBuffer buffer("test", 1000, tape.Writer());
+  std::string small = Block(100, 's');
+  std::string large = Block(5000, 'l');
+
+  ASSERT_EQ(buffer.Write(small.data(), small.size()), 100);
+  ASSERT_EQ(buffer.Write(large.data(), large.size()), 5000);
+  ASSERT_TRUE(buffer.Drain());
+  EXPECT_EQ(tape.writes_, (std::vector<ssize_t>{100, 5000}));
+  EXPECT_EQ(tape.Contents(), small + large);
+}
+
+TEST(tape_stream_buffer, reports_early_end_of_medium_afterwards)
+{
+  FileTape tape;
+  tape.early_warning_at_ = 5;
+  TapeStreamBuffer buffer("test", 10000, tape.Writer());
+  std::string block = Block(1000, 'e');
+
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(buffer.Write(block.data(), block.size()), 1000);
+  }
+  ASSERT_TRUE(buffer.Drain());
+  // the block that reached the warning is on tape and not written twice
+  EXPECT_EQ(tape.writes_.size(), 5u);
+  EXPECT_EQ(tape.Contents(), Block(5000, 'e'));
+  EXPECT_EQ(buffer.GetStatistics().blocks_written, 5u);
+
+  // the warning is passed on once
+  errno = 0;
+  EXPECT_EQ(buffer.Write(block.data(), block.size()), -1);
+  EXPECT_EQ(errno, ENOSPC);
+  tape.LoadNextVolume();
+  EXPECT_EQ(buffer.Write(block.data(), block.size()), 1000);
+  ASSERT_TRUE(buffer.Drain());
+  EXPECT_EQ(tape.writes_.size(), 6u);
+}
+
+TEST(tape_stream_buffer, keeps_blocks_buffered_behind_end_of_medium)
+{
+  FileTape tape;
+  tape.early_warning_at_ = 3;
+  TapeStreamBuffer buffer("test", 10000, tape.Writer());
+  std::string expected;
+
+  for (int i = 0; i < 5; ++i) {
+    std::string block = Block(1000, 'a' + i);
+    ASSERT_EQ(buffer.Write(block.data(), block.size()), 1000);
+    expected += block;
+  }
+  errno = 0;
+  EXPECT_FALSE(buffer.Drain());
+  EXPECT_EQ(errno, ENOSPC);
+  EXPECT_EQ(tape.writes_.size(), 3u);
+  EXPECT_TRUE(buffer.KeepsBlocks());
+
+  // the volume can be finished without the kept blocks
+  EXPECT_TRUE(buffer.Drain());
+
+  tape.LoadNextVolume();
+  buffer.Resume(tape.Writer());
+  ASSERT_TRUE(buffer.Drain());
+  EXPECT_FALSE(buffer.KeepsBlocks());
+  EXPECT_EQ(tape.Contents(), expected);
+
+  TapeStreamBuffer::Statistics stats = buffer.GetStatistics();
+  EXPECT_EQ(stats.blocks_written, 5u);
+  EXPECT_EQ(stats.blocks_lost, 0u);
+  EXPECT_EQ(stats.fill, 0u);
+}
+
+TEST(tape_stream_buffer, end_of_medium_during_a_burst)
+{
+  FileTape tape;
+  tape.early_warning_at_ = 4;
+  // a slow drive, so the job has refilled the buffer when the end comes
+  tape.write_delay_ = std::chrono::milliseconds(5);
+  TapeStreamBuffer buffer("test", 4000, tape.Writer());
+  std::string expected;
+
+  // the job writes on until it is told about the end of the volume
+  int i = 0;
+  for (;; ++i) {
+    ASSERT_LT(i, 100);
+    std::string block = Block(1000, 'a' + i % 26);
+    ssize_t status = buffer.Write(block.data(), block.size());
+    if (status < 0) {
+      EXPECT_EQ(errno, ENOSPC);
+      break;
+    }
+    ASSERT_EQ(status, 1000);
+    expected += block;
+  }
+  EXPECT_EQ(tape.writes_.size(), 4u);
+  EXPECT_TRUE(buffer.KeepsBlocks());
+  EXPECT_TRUE(buffer.Drain());
+
+  // like the device layer, write the refused block again on the next volume
+  tape.LoadNextVolume();
+  buffer.Resume(tape.Writer());
+  for (; i < 20; ++i) {
+    std::string block = Block(1000, 'a' + i % 26);
+    ASSERT_EQ(buffer.Write(block.data(), block.size()), 1000);
+    expected += block;
+  }
+  ASSERT_TRUE(buffer.Drain());
+  EXPECT_EQ(tape.Contents(), expected);
+  EXPECT_EQ(buffer.GetStatistics().blocks_lost, 0u);
+}
+
+TEST(tape_stream_buffer, fails_when_buffered_blocks_are_lost)
+{
+  FileTape tape;
+  tape.fail_after_ = 2;
+  TapeStreamBuffer buffer("test", 10000, tape.Writer());
+  std::string block = Block(1000, 'f');
+
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(buffer.Write(block.data(), block.size()), 1000);
+  }
+  errno = 0;
+  EXPECT_FALSE(buffer.Drain());
+  EXPECT_EQ(errno, EIO);
+  EXPECT_EQ(buffer.GetStatistics().blocks_lost, 3u);
+
+  // the failure is reported once and does not fail later jobs
+  tape.fail_after_ = -1;
+  EXPECT_EQ(buffer.Write(block.data(), block.size()), 1000);
+  EXPECT_TRUE(buffer.Drain());
+  EXPECT_EQ(tape.writes_.size(), 3u);
+}
+
+TEST(tape_stream_buffer, write_reports_lost_blocks_once)
+{
+  FileTape tape;
+  tape.fail_after_ = 0;
+  TapeStreamBuffer buffer("test", 4000, tape.Writer());
+  std::string block = Block(1000, 'w');
+
+  // the third block starts a burst that fails
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(buffer.Write(block.data(), block.size()), 1000);
+  }
+  for (int i = 0; i < 500 && buffer.GetStatistics().blocks_lost == 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(buffer.GetStatistics().blocks_lost, 3u);
+
+  errno = 0;
+  EXPECT_EQ(buffer.Write(block.data(), block.size()), -1);
+  EXPECT_EQ(errno, EIO);
+  tape.fail_after_ = -1;
+  EXPECT_EQ(buffer.Write(block.data(), block.size()), 1000);
+  EXPECT_TRUE(buffer.Drain());
+}
@@ -0,0 +1,206 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+#if defined(HAVE_MINGW)
+#  include "include/bareos.h"
+#  include "gtest/gtest.h"
+#else
+#  include "gtest/gtest.h"
+#  include "include/bareos.h"
+#endif
+
+#include "include/streams.h"
+#include "lib/attribs.h"
+#include "lib/base64.h"
+
+#include <sys/stat.h>
+
+static struct stat SampleStat()
+{
+  struct stat statp {};
+  statp.st_dev = 66306;
+  statp.st_ino = 13107581;
+  statp.st_mode = S_IFREG | 0644;
+  statp.st_nlink = 1;
+  statp.st_uid = 1000;
+  statp.st_gid = 1000;
+  statp.st_size = 1234567;
+  statp.st_blksize = 4096;
+  statp.st_blocks = 2416;
+  statp.st_atime = 1700000000;
+  statp.st_mtime = 1700000100;
+  statp.st_ctime = 1700000200;
+  return statp;
+}
+
+// the LStat format is stored in the catalog and on volumes
+static const char* sample_lstat
+    = "QMC yAF9 IGk B Po Po A EtaH BAA lw BlU/EA BlU/Fk BlU/HI A A B";
+
+TEST(attribs, encode_stat)
+{
+  struct stat statp = SampleStat();
+  char buf[200];
+  EncodeStat(buf, &statp, sizeof(statp), 0, STREAM_UNIX_ATTRIBUTES);
+  EXPECT_STREQ(buf, sample_lstat);
+}
+
+TEST(attribs, decode_stat)
+{
+  struct stat statp;
+  int32_t LinkFI = -1;
+  char lstat[200];
+  bstrncpy(lstat, sample_lstat, sizeof(lstat));
+
+  EXPECT_EQ(DecodeStat(lstat, &statp, sizeof(statp), &LinkFI),
+            STREAM_UNIX_ATTRIBUTES);
+  EXPECT_EQ(LinkFI, 0);
+  struct stat expected = SampleStat();
+  EXPECT_EQ(statp.st_dev, expected.st_dev);
+  EXPECT_EQ(statp.st_ino, expected.st_ino);
+  EXPECT_EQ(statp.st_mode, expected.st_mode);
+  EXPECT_EQ(statp.st_nlink, expected.st_nlink);
+  EXPECT_EQ(statp.st_uid, expected.st_uid);
+  EXPECT_EQ(statp.st_gid, expected.st_gid);
+  EXPECT_EQ(statp.st_size, expected.st_size);
+  EXPECT_EQ(statp.st_atime, expected.st_atime);
+  EXPECT_EQ(statp.st_mtime, expected.st_mtime);
+  EXPECT_EQ(statp.st_ctime, expected.st_ctime);
+}
+
+TEST(attribs, decode_stat_roundtrip_link_fi)
+{
+  struct stat statp = SampleStat();
+  char buf[200];
+  EncodeStat(buf, &statp, sizeof(statp), 4711, STREAM_FILE_DATA);
+
+  struct stat decoded;
+  int32_t LinkFI = 0;
+  EXPECT_EQ(DecodeStat(buf, &decoded, sizeof(decoded), &LinkFI),
+            STREAM_FILE_DATA);
+  EXPECT_EQ(LinkFI, 4711);
+  EXPECT_EQ(decoded.st_size, statp.st_size);
+}
+
+// old clients send neither LinkFI, flags nor the data stream
+TEST(attribs, decode_stat_without_optional_fields)
+{
+  struct stat statp;
+  int32_t LinkFI = -1;
+  char lstat[] = "QMC yAF9 IGk B Po Po A EtaH BAA lw BlU/EA BlU/Fk BlU/HI";
+
+  EXPECT_EQ(DecodeStat(lstat, &statp, sizeof(statp), &LinkFI), 0);
+  EXPECT_EQ(LinkFI, 0);
+  EXPECT_EQ(statp.st_ctime, 1700000200);
+}
+
+TEST(attribs, base64_values)
+{
+  char buf[20];
+  int64_t value = 0;
+
+  EXPECT_EQ(ToBase64(0, buf), 1);
+  EXPECT_STREQ(buf, "A");
+  EXPECT_EQ(ToBase64(-5, buf), 2);
+  EXPECT_STREQ(buf, "-F");
+  EXPECT_EQ(ToBase64(INT64_MAX, buf), 11);
+  EXPECT_STREQ(buf, "H//////////");
+
+  EXPECT_EQ(FromBase64(&value, buf), 11);
+  EXPECT_EQ(value, INT64_MAX);
+  char negative[] = "-F rest";
+  EXPECT_EQ(FromBase64(&value, negative), 2);
+  EXPECT_EQ(value, -5);
+}
+
+TEST(attribs, compact_stat_roundtrip)
+{
+  struct stat statp = SampleStat();
+  char buf[kMaxLStatLength];
+  EncodeStatCompact(buf, &statp, sizeof(statp), 4711, STREAM_FILE_DATA);
+  EXPECT_TRUE(IsCompactStat(buf));
+  EXPECT_LT(strlen(buf), strlen(sample_lstat));
+
+  struct stat decoded;
+  int32_t LinkFI = 0;
+  EXPECT_EQ(DecodeStat(buf, &decoded, sizeof(decoded), &LinkFI),
+            STREAM_FILE_DATA);
+  EXPECT_EQ(LinkFI, 4711);
+  EXPECT_EQ(decoded.st_ino, statp.st_ino);
+  EXPECT_EQ(decoded.st_mode, statp.st_mode);
+  EXPECT_EQ(decoded.st_size, statp.st_size);
+  EXPECT_EQ(decoded.st_mtime, statp.st_mtime);
+}
+
+// the catalog gets the same LStat as from a client sending the text
+TEST(attribs, compact_stat_to_lstat)
+{
+  struct stat statp = SampleStat();
+  char compact[kMaxLStatLength];
+  char lstat[kMaxLStatLength];
+  EncodeStatCompact(compact, &statp, sizeof(statp), 0, STREAM_UNIX_ATTRIBUTES);
+  CompactStatToLStat(compact, lstat);
+  EXPECT_STREQ(lstat, sample_lstat);
+  EXPECT_FALSE(IsCompactStat(lstat));
+}
+
+// compact stat packets are passed in zero separated attribute records
+TEST(attribs, compact_stat_extreme_values)
+{
+  struct stat statp = SampleStat();
+  statp.st_size = INT64_MAX;
+  statp.st_mtime = -1;
+  statp.st_atime = 0;
+  statp.st_ino = static_cast<ino_t>(-1);
+  char compact[kMaxLStatLength];
+  EncodeStatCompact(compact, &statp, sizeof(statp), -1, STREAM_FILE_DATA);
+  for (const char* p = compact + 1; *p; ++p) {
+    ASSERT_GE(static_cast<uint8_t>(*p), 0x40) << "at " << p - compact;
+  }
+
+  char lstat[kMaxLStatLength];
+  char expected[kMaxLStatLength];
+  CompactStatToLStat(compact, lstat);
+  EncodeStat(expected, &statp, sizeof(statp), -1, STREAM_FILE_DATA);
+  EXPECT_STREQ(lstat, expected);
+
+  struct stat decoded;
+  int32_t LinkFI = 0;
+  DecodeStat(compact, &decoded, sizeof(decoded), &LinkFI);
+  EXPECT_EQ(decoded.st_size, INT64_MAX);
+  EXPECT_EQ(decoded.st_mtime, -1);
+  EXPECT_EQ(decoded.st_ino, statp.st_ino);
+  EXPECT_EQ(LinkFI, -1);
+}
+
+TEST(attribs, truncated_compact_stat)
+{
+  struct stat statp = SampleStat();
+  char compact[kMaxLStatLength];
+  EncodeStatCompact(compact, &statp, sizeof(statp), 0, STREAM_FILE_DATA);
+  compact[8] = 0;
+
+  struct stat decoded;
+  int32_t LinkFI = -1;
+  EXPECT_EQ(DecodeStat(compact, &decoded, sizeof(decoded), &LinkFI), 0);
+  EXPECT_EQ(LinkFI, 0);
+  EXPECT_EQ(decoded.st_dev, statp.st_dev);
+  EXPECT_EQ(decoded.st_size, 0);
+}
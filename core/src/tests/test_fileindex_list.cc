@@ -1,7 +1,7 @@
 /*
    BAREOS® - Backup Archiving REcovery Open Sourced
 
-   Copyright (C) 2019-2023 Bareos GmbH & Co. KG
+   Copyright (C) 2019-2024 Bareos GmbH & Co. KG
 
    This program is Free Software; you can redistribute it and/or
    modify it under the terms of version three of the GNU Affero General Public
@@ -207,3 +207,50 @@ TEST(fileindex_list, gap_list_duplicates_random_order)
   std::shuffle(fileIds.begin(), fileIds.end(), std::default_random_engine{});
   EXPECT_EQ(ToBsrStringLocal(fileIds), ToBsrStringBareos(fileIds));
 }
+
+TEST(fileindex_list, add_ranges)
+{
+  RestoreBootstrapRecord bsr;
+  RestoreBootstrapRecord* job1 = AddFindexRange(&bsr, kJobId_1, 1, 10);
+  EXPECT_EQ(job1, &bsr);
+  RestoreBootstrapRecord* job2 = AddFindexRange(&bsr, kJobId_2, 5, 5);
+  ASSERT_NE(job2, nullptr);
+  EXPECT_EQ(job2, bsr.next.get());
+  EXPECT_EQ(AddFindexRange(&bsr, kJobId_2, 7, 9), job2);
+
+  AddFindexRange(&bsr, kJobId_1, 11, 20); /* touches the previous one */
+  AddFindexRange(&bsr, kJobId_1, 30, 40);
+  AddFindexRange(&bsr, kJobId_1, 15, 32); /* bridges the gap */
+  AddFindexRange(&bsr, kJobId_1, 50, 50);
+  AddFindex(&bsr, kJobId_1, 0); /* ignored */
+
+  using Ranges = std::vector<std::pair<int32_t, int32_t>>;
+  EXPECT_EQ(job1->fi->GetRanges(), (Ranges{{1, 40}, {50, 50}}));
+  EXPECT_EQ(job2->fi->GetRanges(), (Ranges{{5, 5}, {7, 9}}));
+}
+
+TEST(fileindex_list, ranges_random_order)
+{
+  std::vector<std::pair<int, int>> ranges;
+  std::vector<int> fileIds;
+  std::default_random_engine engine{};
+  std::uniform_int_distribution<int> start(1, kFidCount);
+  std::uniform_int_distribution<int> length(0, 20);
+  for (int i = 0; i < kFidCount / 10; ++i) {
+    int first = start(engine);
+    int last = first + length(engine);
+    ranges.emplace_back(first, last);
+    for (int fid = first; fid <= last; ++fid) { fileIds.push_back(fid); }
+  }
+
+  RestoreBootstrapRecord bsr;
+  for (auto [first, last] : ranges) {
+    AddFindexRange(&bsr, kJobId_1, first, last);
+  }
+  uint32_t first_possible_file_index = 1;
+  uint32_t maxId = *std::max_element(fileIds.begin(), fileIds.end());
+  auto buffer = std::string{};
+  write_findex(bsr.fi.get(), first_possible_file_index, maxId, buffer);
+
+  EXPECT_EQ(ToBsrStringLocal(fileIds), buffer);
+}
@@ -26,6 +26,112 @@
 #  include "include/bareos.h"
 #endif
 
+#define NEED_JANSSON_NAMESPACE
 #include "lib/output_formatter.h"
 
+#include <string>
+#include <vector>
+
 TEST(output_formatter, constructor_destructor) {}
+
+#if HAVE_JANSSON
+static bool CollectMessages(void* ctx, const char* fmt, ...)
+{
+  auto* messages = static_cast<std::vector<std::string>*>(ctx);
+  va_list arg_ptr;
+  va_start(arg_ptr, fmt);
+  messages->push_back(va_arg(arg_ptr, const char*));
+  va_end(arg_ptr);
+  return true;
+}
+
+static std::string FormatJobs(bool stream, int rows, bool result)
+{
+  std::vector<std::string> messages;
+  OutputFormatter send(CollectMessages, &messages, nullptr, nullptr,
+                       API_MODE_JSON);
+  send.SetStreaming(stream);
+  send.AddLimitFilterTuple(rows);
+
+  send.ObjectKeyValue("before", "list");
+  send.ArrayStart("jobs");
+  for (int i = 0; i < rows; i++) {
+    send.ObjectStart();
+    send.ObjectKeyValue("jobid", i);
+    send.ObjectKeyValue("name", "backup \"quoted\"");
+    send.ObjectEnd();
+  }
+  send.ArrayEnd("jobs");
+  send.ObjectKeyValue("after", 1);
+  if (!result) {
+    PoolMem msg("something went wrong");
+    send.message(MSG_TYPE_ERROR, msg);
+  }
+  send.FinalizeResult(result);
+
+  std::string output;
+  for (auto& message : messages) { output += message; }
+  return output;
+}
+
+static json_t* Parse(const std::string& text)
+{
+  json_error_t error;
+  json_t* json = json_loads(text.c_str(), 0, &error);
+  EXPECT_NE(json, nullptr) << error.text << "\n" << text;
+  return json;
+}
+
+TEST(output_formatter, streaming_gives_same_result)
+{
+  json_t* expected = Parse(FormatJobs(false, 100, true));
+  json_t* streamed = Parse(FormatJobs(true, 100, true));
+
+  EXPECT_TRUE(json_equal(expected, streamed));
+
+  json_decref(expected);
+  json_decref(streamed);
+}
+
+TEST(output_formatter, streaming_sends_items_early)
+{
+  std::vector<std::string> messages;
+  OutputFormatter send(CollectMessages, &messages, nullptr, nullptr,
+                       API_MODE_JSON);
+  send.SetStreaming(true);
+  send.SetCompact(true);
+
+  send.ArrayStart("files");
+  for (int i = 0; messages.empty() && i < 100000; i++) {
+    send.ObjectStart();
+    send.ObjectKeyValue("filename", "/some/rather/long/path/to/a/file");
+    send.ObjectEnd();
+  }
+  EXPECT_FALSE(messages.empty());
+  send.ArrayEnd("files");
+  send.FinalizeResult(true);
+
+  std::string output;
+  for (auto& message : messages) { output += message; }
+  json_t* json = Parse(output);
+  EXPECT_TRUE(json_is_array(
+      json_object_get(json_object_get(json, "result"), "files")));
+  json_decref(json);
+}
+
+TEST(output_formatter, streaming_reports_errors)
+{
+  json_t* json = Parse(FormatJobs(true, 10, false));
+
+  EXPECT_EQ(json_array_size(
+                json_object_get(json_object_get(json, "result"), "jobs")),
+            10u);
+  json_t* error = json_object_get(json, "error");
+  ASSERT_NE(error, nullptr);
+  EXPECT_NE(json_object_get(json_object_get(json_object_get(error, "data"),
+                                            "messages"),
+                            MSG_TYPE_ERROR),
+            nullptr);
+  json_decref(json);
+}
+#endif
@@ -0,0 +1,172 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+#if defined(HAVE_MINGW)
+#  include "include/bareos.h"
+#  include "gtest/gtest.h"
+#else
+#  include "gtest/gtest.h"
+#  include "include/bareos.h"
+#endif
+
+#include "lib/bsock_tcp.h"
+#include "lib/token_bucket.h"
+
+#include <sys/socket.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using clock_type = TokenBucket::clock;
+
+TEST(token_bucket, unlimited_bucket_only_counts)
+{
+  TokenBucket bucket;
+  auto now = clock_type::now();
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(bucket.Reserve(1 << 20, now), clock_type::duration::zero());
+  }
+  EXPECT_EQ(bucket.GetBytes(), 100u << 20);
+}
+
+TEST(token_bucket, reservations_are_spaced_out)
+{
+  TokenBucket bucket(1000);
+  auto now = clock_type::now();
+
+  // the burst window allows 100ms worth of bytes right away
+  EXPECT_EQ(bucket.Reserve(100, now), clock_type::duration::zero());
+  EXPECT_EQ(bucket.Reserve(100, now), 100ms);
+  EXPECT_EQ(bucket.Reserve(100, now), 200ms);
+
+  // unused capacity is not saved up beyond the burst window
+  auto later = now + 10s;
+  EXPECT_EQ(bucket.Reserve(100, later), clock_type::duration::zero());
+  EXPECT_EQ(bucket.Reserve(100, later), 100ms);
+}
+
+TEST(token_bucket, parent_limits_all_children)
+{
+  TokenBucket parent(1000);
+  TokenBucket child1(0, &parent);
+  TokenBucket child2(1'000'000, &parent);
+  auto now = clock_type::now();
+
+  EXPECT_EQ(child1.Reserve(100, now), clock_type::duration::zero());
+  EXPECT_EQ(child2.Reserve(100, now), 100ms);
+  EXPECT_EQ(child1.Reserve(100, now), 200ms);
+
+  EXPECT_EQ(child1.GetBytes(), 200u);
+  EXPECT_EQ(child2.GetBytes(), 100u);
+  EXPECT_EQ(parent.GetBytes(), 300u);
+}
+
+TEST(token_bucket, child_limit_applies_below_parent)
+{
+  TokenBucket parent(1'000'000);
+  TokenBucket child(1000, &parent);
+  auto now = clock_type::now();
+
+  EXPECT_EQ(child.Reserve(100, now), clock_type::duration::zero());
+  EXPECT_EQ(child.Reserve(100, now), 100ms);
+}
+
+TEST(token_bucket, concurrent_senders_share_fairly)
+{
+  constexpr int kSenders = 3;
+  constexpr int kChunks = 100;
+  constexpr int kChunkSize = 4096;
+  constexpr int64_t kRate = 2 * 1024 * 1024;
+
+  TokenBucket daemon(kRate);
+  std::vector<std::unique_ptr<TokenBucket>> jobs;
+  for (int i = 0; i < kSenders; ++i) {
+    jobs.push_back(std::make_unique<TokenBucket>(0, &daemon));
+  }
+
+  std::atomic<bool> go{false};
+  auto start = clock_type::now();
+  std::vector<clock_type::duration> finished(kSenders);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kSenders; ++i) {
+    threads.emplace_back([&, i] {
+      while (!go) { std::this_thread::yield(); }
+      for (int j = 0; j < kChunks; ++j) { jobs[i]->Consume(kChunkSize); }
+      finished[i] = clock_type::now() - start;
+    });
+  }
+  /* Use up the burst first, otherwise the thread that happens to run first
+   * gets it all and finishes early. */
+  start = clock_type::now();
+  daemon.Reserve(kRate / 10, start);
+  go = true;
+  for (auto& t : threads) { t.join(); }
+
+  auto total = *std::max_element(finished.begin(), finished.end());
+  auto first = *std::min_element(finished.begin(), finished.end());
+  auto expected = std::chrono::duration<double>(
+      static_cast<double>(kSenders) * kChunks * kChunkSize / kRate);
+
+  EXPECT_GE(total, expected - TokenBucket::kBurstTime);
+  // nobody is starved: all senders are done at about the same time
+  EXPECT_GE(first, total * 3 / 4);
+  for (auto& job : jobs) {
+    EXPECT_EQ(job->GetBytes(), static_cast<uint64_t>(kChunks) * kChunkSize);
+  }
+}
+
+TEST(token_bucket, limits_socket_writes)
+{
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+  std::thread reader([fd = fds[1]] {
+    char buf[8192];
+    while (read(fd, buf, sizeof(buf)) > 0) {}
+  });
+
+  constexpr int64_t kRate = 1024 * 1024;
+  constexpr int kMessages = 64;
+  TokenBucket bucket(kRate);
+  {
+    BareosSocketTCP tcp;
+    BareosSocket& sock = tcp;
+    sock.fd_ = fds[0];
+    sock.SetBandwidthBucket(&bucket);
+
+    std::vector<char> data(8192, 'x');
+    auto start = clock_type::now();
+    for (int i = 0; i < kMessages; ++i) {
+      ASSERT_TRUE(sock.send(data.data(), data.size()));
+    }
+    auto elapsed = clock_type::now() - start;
+
+    // every message carries a 4 byte length header
+    EXPECT_EQ(bucket.GetBytes(), kMessages * (data.size() + 4));
+    EXPECT_GE(elapsed, std::chrono::duration<double>(
+                           static_cast<double>(bucket.GetBytes()) / kRate)
+                           - TokenBucket::kBurstTime);
+    sock.close();
+  }
+  reader.join();
+  close(fds[1]);
+}
@@ -0,0 +1,275 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+#if defined(HAVE_MINGW)
+#  include "include/bareos.h"
+#  include "gtest/gtest.h"
+#else
+#  include "gtest/gtest.h"
+#  include "include/bareos.h"
+#endif
+
+#include "dird/ua_reactor.h"
+
+#if defined(HAVE_SYS_EPOLL_H)
+#  include <poll.h>
+#  include <signal.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+
+#  include <atomic>
+#  include <chrono>
+#  include <memory>
+#  include <string>
+#  include <thread>
+#  include <vector>
+
+using namespace directordaemon;
+
+namespace {
+/* A line based session: "echo <text>" answers <text>, "prompt" asks for
+ * one more line and answers with it, "flood" sends more than the socket
+ * buffers take. */
+class LineConnection : public UaReactorConnection {
+ public:
+  LineConnection(int fd, std::atomic<int>& handled)
+      : fd_{fd}, handled_{handled}
+  {
+  }
+  ~LineConnection() { close(fd_); }
+
+  int GetFd() const override { return fd_; }
+
+  bool ReadAvailable() override
+  {
+    while (!closed_ && line_.find('\n') == std::string::npos) {
+      char c;
+      ssize_t n = recv(fd_, &c, 1, MSG_DONTWAIT);
+      if (n < 0 && errno == EAGAIN) { return false; }
+      if (n <= 0) {
+        closed_ = true;
+      } else {
+        line_ += c;
+      }
+    }
+    return true;
+  }
+
+  bool HandleInput() override
+  {
+    handled_++;
+    if (closed_) { return false; }
+    std::string command = line_.substr(0, line_.size() - 1);
+    line_.clear();
+
+    if (command.rfind("echo ", 0) == 0) {
+      Send(command.substr(5) + "\n");
+    } else if (command == "prompt") {
+      Send("?\n");
+      UaReactorParkWorker();
+      std::string answer;
+      char c;
+      while (recv(fd_, &c, 1, 0) == 1 && c != '\n') { answer += c; }
+      Send("answer " + answer + "\n");
+    } else if (command == "flood") {
+      Send(std::string(1024 * 1024, 'f') + "\n");
+    }
+    return true;
+  }
+
+  void Terminate() override { shutdown(fd_, SHUT_RDWR); }
+
+ private:
+  void Send(const std::string& data)
+  {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+      ssize_t n = send(fd_, data.data() + sent, data.size() - sent, 0);
+      if (n <= 0) { return; }
+      sent += n;
+    }
+  }
+
+  int fd_;
+  std::atomic<int>& handled_;
+  std::string line_;
+  bool closed_{false};
+};
+
+class UaReactorTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    struct sigaction sig = {};
+    sig.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sig, nullptr);
+  }
+
+  void TearDown() override
+  {
+    StopUaReactor();
+    for (int fd : clients_) { close(fd); }
+  }
+
+  // Returns the client end of a new session
+  int Connect()
+  {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) { return -1; }
+    if (!UaReactorAddConnection(new LineConnection(fds[0], handled_))) {
+      close(fds[0]);
+      close(fds[1]);
+      return -1;
+    }
+    clients_.push_back(fds[1]);
+    return fds[1];
+  }
+
+  static bool Send(int fd, const std::string& data)
+  {
+    return write(fd, data.data(), data.size())
+           == static_cast<ssize_t>(data.size());
+  }
+
+  // The next line from the director side, "timeout" if there is none
+  static std::string ReadLine(int fd, int timeout_ms = 5000)
+  {
+    std::string line;
+    char c;
+    struct pollfd pfd {
+      fd, POLLIN, 0
+    };
+    while (poll(&pfd, 1, timeout_ms) == 1 && read(fd, &c, 1) == 1) {
+      if (c == '\n') { return line; }
+      line += c;
+    }
+    return "timeout";
+  }
+
+  std::atomic<int> handled_{0};
+  std::vector<int> clients_;
+};
+}  // namespace
+
+TEST_F(UaReactorTest, StalledClientDoesNotOccupyAWorker)
+{
+  ASSERT_TRUE(StartUaReactor(1, 10));
+  int stalled = Connect();
+  int other = Connect();
+  ASSERT_GE(stalled, 0);
+  ASSERT_GE(other, 0);
+
+  // half a command is not passed to the only worker
+  ASSERT_TRUE(Send(stalled, "echo sta"));
+  ASSERT_TRUE(Send(other, "echo other\n"));
+  EXPECT_EQ(ReadLine(other), "other");
+  EXPECT_EQ(handled_, 1);
+
+  ASSERT_TRUE(Send(stalled, "lled\n"));
+  EXPECT_EQ(ReadLine(stalled), "stalled");
+  EXPECT_EQ(handled_, 2);
+}
+
+TEST_F(UaReactorTest, MoreDialogsThanWorkers)
+{
+  constexpr int workers = 2;
+  ASSERT_TRUE(StartUaReactor(workers, 2 * workers + 1));
+
+  std::vector<int> dialogs;
+  for (int i = 0; i < workers + 1; ++i) {
+    int fd = Connect();
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(Send(fd, "prompt\n"));
+    dialogs.push_back(fd);
+  }
+  // every dialog gets its prompt, and commands are still served
+  for (int fd : dialogs) { EXPECT_EQ(ReadLine(fd), "?"); }
+  int other = Connect();
+  ASSERT_TRUE(Send(other, "echo other\n"));
+  EXPECT_EQ(ReadLine(other), "other");
+
+  for (std::size_t i = 0; i < dialogs.size(); ++i) {
+    ASSERT_TRUE(Send(dialogs[i], std::to_string(i) + "\n"));
+    EXPECT_EQ(ReadLine(dialogs[i]), "answer " + std::to_string(i));
+  }
+
+  // the sessions go back to the event loop afterwards
+  for (int fd : dialogs) {
+    ASSERT_TRUE(Send(fd, "echo again\n"));
+    EXPECT_EQ(ReadLine(fd), "again");
+  }
+}
+
+TEST_F(UaReactorTest, ParkedWorkersAreCapped)
+{
+  ASSERT_TRUE(StartUaReactor(1, 2));
+  int first = Connect();
+  int second = Connect();
+  int other = Connect();
+  ASSERT_TRUE(Send(first, "prompt\n"));
+  EXPECT_EQ(ReadLine(first), "?");
+  ASSERT_TRUE(Send(second, "prompt\n"));
+  EXPECT_EQ(ReadLine(second), "?");
+
+  // the second dialog could not park, so it still holds the only worker
+  ASSERT_TRUE(Send(other, "echo other\n"));
+  EXPECT_EQ(ReadLine(other, 1000), "timeout");
+
+  ASSERT_TRUE(Send(second, "2\n"));
+  EXPECT_EQ(ReadLine(second), "answer 2");
+  EXPECT_EQ(ReadLine(other), "other");
+
+  ASSERT_TRUE(Send(first, "1\n"));
+  EXPECT_EQ(ReadLine(first), "answer 1");
+}
+
+TEST_F(UaReactorTest, SlowReaderDoesNotBlockOtherSessions)
+{
+  ASSERT_TRUE(StartUaReactor(1, 10));
+  int slow = Connect();
+  int other = Connect();
+  ASSERT_TRUE(Send(slow, "flood\n"));
+  // wait until the worker is stuck writing to the slow reader
+  while (handled_ == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  ASSERT_TRUE(Send(other, "echo other\n"));
+  EXPECT_EQ(ReadLine(other), "other");
+
+  EXPECT_EQ(ReadLine(slow).size(), 1024u * 1024);
+  ASSERT_TRUE(Send(slow, "echo done\n"));
+  EXPECT_EQ(ReadLine(slow), "done");
+}
+
+TEST_F(UaReactorTest, ClosedSessionsAreRemoved)
+{
+  ASSERT_TRUE(StartUaReactor(1, 10));
+  int fd = Connect();
+  ASSERT_TRUE(Send(fd, "echo x\n"));
+  EXPECT_EQ(ReadLine(fd), "x");
+  close(fd);
+  clients_.clear();
+  for (int i = 0; i < 500 && handled_ < 2; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(handled_, 2);
+}
+#endif
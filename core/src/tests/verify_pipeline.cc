@@ -0,0 +1,246 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+#if defined(HAVE_MINGW)
+#  include "include/bareos.h"
+#  include "gtest/gtest.h"
+#else
+#  include "gtest/gtest.h"
+#  include "include/bareos.h"
+#endif
+
+#include "include/jcr.h"
+#include "filed/verify_pipeline.h"
+#include "lib/bsock_tcp.h"
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace filedaemon;
+
+namespace {
+constexpr std::size_t num_workers = 2;
+constexpr int digest_stream = STREAM_MD5_DIGEST;
+
+/* The pipeline sends to one end of a socket pair, the test reads what the
+ * Director would get from the other one. The digest of a file is made up
+ * from its name, its file index tells how long it takes to compute. */
+class VerifyPipelineTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    struct sigaction sig = {};
+    sig.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sig, nullptr);
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    jcr_ = new_jcr(nullptr);
+    register_jcr(jcr_);
+    jcr_->setJobType(JT_VERIFY);
+    jcr_->dir_bsock = NewSocket(fds[0], "Director daemon");
+    dir_ = NewSocket(fds[1], "File daemon");
+  }
+
+  void TearDown() override
+  {
+    pipeline_.reset();
+    CloseDirector();
+    FreeJcr(jcr_);
+  }
+
+  static BareosSocket* NewSocket(int fd, const char* who)
+  {
+    BareosSocket* bs = new BareosSocketTCP;
+    bs->fd_ = fd;
+    bs->SetWho(strdup(who));
+    bs->SetHost(strdup("localhost"));
+    return bs;
+  }
+
+  void CloseDirector()
+  {
+    if (dir_) {
+      dir_->close();
+      delete dir_;
+      dir_ = nullptr;
+    }
+  }
+
+  void Start()
+  {
+    pipeline_.emplace(pool_, num_workers, [this](const DigestRequest& req) {
+      return Compute(req);
+    });
+  }
+
+  DigestResult Compute(const DigestRequest& req)
+  {
+    running_++;
+    gate_.wait();
+    std::this_thread::sleep_for(std::chrono::milliseconds(req.file_size));
+
+    DigestResult result;
+    result.digest = "digest-" + req.fname;
+    result.name = "MD5";
+    result.bytes_read = req.file_size;
+    if (req.fname.rfind("unreadable", 0) == 0) {
+      result.error = "Error reading file " + req.fname + "\n";
+    }
+    running_--;
+    return result;
+  }
+
+  bool Queue(int32_t file_index, const std::string& fname, bool digest)
+  {
+    DigestRequest req;
+    req.fname = fname;
+    req.stream = digest_stream;
+    req.file_size = 5 * (10 - file_index % 10);
+    return pipeline_->Queue(jcr_, file_index, "attributes " + fname,
+                            digest ? &req : nullptr);
+  }
+
+  static std::string DigestMessage(int32_t file_index, const std::string& fname)
+  {
+    return std::to_string(file_index) + " " + std::to_string(digest_stream)
+           + " digest-" + fname + " *MD5-" + std::to_string(file_index) + "*";
+  }
+
+  // Everything the Director got so far
+  std::vector<std::string> Received()
+  {
+    std::vector<std::string> messages;
+    while (dir_->WaitData(0, 100000) > 0 && dir_->recv() > 0) {
+      messages.emplace_back(dir_->msg, dir_->message_length);
+    }
+    return messages;
+  }
+
+  void OpenGate() { gate_promise_.set_value(); }
+
+  thread_pool pool_;
+  JobControlRecord* jcr_{nullptr};
+  BareosSocket* dir_{nullptr};
+  std::optional<VerifyPipeline> pipeline_;
+  std::atomic<int> running_{0};
+  std::promise<void> gate_promise_;
+  std::shared_future<void> gate_{gate_promise_.get_future().share()};
+};
+}  // namespace
+
+TEST_F(VerifyPipelineTest, DigestsFollowTheirAttributes)
+{
+  Start();
+  OpenGate();
+
+  // the later files are done first
+  std::vector<std::string> expected;
+  for (int32_t i = 1; i <= 8; ++i) {
+    std::string fname = "file" + std::to_string(i);
+    bool digest = i % 3 != 0;
+    ASSERT_TRUE(Queue(i, fname, digest));
+    expected.push_back("attributes " + fname);
+    if (digest) { expected.push_back(DigestMessage(i, fname)); }
+  }
+  ASSERT_TRUE(pipeline_->Flush(jcr_));
+
+  EXPECT_EQ(Received(), expected);
+  EXPECT_EQ(jcr_->JobErrors, 0u);
+}
+
+TEST_F(VerifyPipelineTest, SendsFinishedFilesWhileQueueing)
+{
+  Start();
+  OpenGate();
+
+  // not more than four files per worker wait for their digest
+  for (int32_t i = 1; i <= 20; ++i) {
+    ASSERT_TRUE(Queue(i, "file" + std::to_string(i), true));
+  }
+  EXPECT_GE(Received().size(), 2 * (20 - 4 * num_workers));
+}
+
+TEST_F(VerifyPipelineTest, ReadErrorsAreReportedWithTheDigest)
+{
+  Start();
+  OpenGate();
+
+  ASSERT_TRUE(Queue(1, "unreadable", true));
+  ASSERT_TRUE(Queue(2, "file2", true));
+  ASSERT_TRUE(pipeline_->Flush(jcr_));
+
+  // like a sequential verify, the digest of the data read is still sent
+  std::vector<std::string> expected{
+      "attributes unreadable", "Error reading file unreadable\n",
+      DigestMessage(1, "unreadable"), "attributes file2",
+      DigestMessage(2, "file2")};
+  EXPECT_EQ(Received(), expected);
+  EXPECT_EQ(jcr_->JobErrors, 1u);
+  EXPECT_EQ(jcr_->JobBytes, 5u * 9 + 5u * 8);
+  EXPECT_EQ(jcr_->ReadBytes, jcr_->JobBytes);
+}
+
+TEST_F(VerifyPipelineTest, StopsOnNetworkErrors)
+{
+  Start();
+  for (int32_t i = 1; i <= 4; ++i) {
+    ASSERT_TRUE(Queue(i, "file" + std::to_string(i), true));
+  }
+
+  CloseDirector();
+  EXPECT_FALSE(pipeline_->Flush(jcr_));
+
+  // the digests still being computed are waited for
+  OpenGate();
+  pipeline_.reset();
+  EXPECT_EQ(running_, 0);
+}
+
+TEST_F(VerifyPipelineTest, CanceledJobsSendNothingMore)
+{
+  Start();
+  for (int32_t i = 1; i <= 4; ++i) {
+    ASSERT_TRUE(Queue(i, "file" + std::to_string(i), true));
+  }
+  while (running_ < static_cast<int>(num_workers)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // the job is canceled while digests are computed and not flushed
+  std::thread open([this] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    OpenGate();
+  });
+  pipeline_.reset();
+  open.join();
+
+  EXPECT_EQ(running_, 0);
+  EXPECT_TRUE(Received().empty());
+}
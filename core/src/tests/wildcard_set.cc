@@ -0,0 +1,137 @@
+/*
+   BAREOS® - Backup Archiving REcovery Open Sourced
+
+   Copyright (C) 2024-2024 Bareos GmbH & Co. KG
+
+   This program is Free Software; you can redistribute it and/or
+   modify it under the terms of version three of the GNU Affero General Public
+   License as published by the Free Software Foundation and included
+   in the file LICENSE.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+*/
+#if defined(HAVE_MINGW)
+#  include "include/bareos.h"
+#  include "gtest/gtest.h"
+#else
+#  include "gtest/gtest.h"
+#  include "include/bareos.h"
+#endif
+
+#include "findlib/find.h"
+#include "findlib/wildcard_set.h"
+
+#include <string>
+#include <vector>
+
+static const std::vector<const char*> patterns{
+    "*.o",        "*.tmp",     "*.TXT",      "core",        "/tmp/*",
+    "/var/cache", "*~",        "*/.git",     "*.[ch]",      "/home/*/.cache",
+    "lost+found", "*",         "a?c",        "/srv/data*",  "*\\*",
+    "",           "*/cache/*", "/usr/lib64", "/usr/lib64*", "*ÄÖ"};
+
+static const std::vector<const char*> strings{
+    "",
+    "core",
+    "CORE",
+    "main.o",
+    "/src/main.o",
+    "/src/MAIN.O",
+    "/tmp/x",
+    "/tmp/sub/dir",
+    "/var/cache",
+    "/VAR/CACHE",
+    "file~",
+    "/repo/.git",
+    "/repo/sub/.git",
+    "x.c",
+    "/home/user/.cache",
+    "/home/a/b/.cache",
+    "lost+found",
+    "abc",
+    "a/c",
+    "/srv/data",
+    "/srv/data/more",
+    "star*",
+    "/a/cache/b",
+    "/usr/lib64",
+    "/usr/lib64/libc.so",
+    "readme.txt",
+    "readme.TXT",
+    "xäö",
+    "XÄÖ",
+    "xÄÖ"};
+
+static const char* MatchWithFnmatch(const std::vector<const char*>& list,
+                                    const char* str,
+                                    int flags)
+{
+  for (const char* pattern : list) {
+    if (fnmatch(pattern, str, flags) == 0) { return pattern; }
+  }
+  return nullptr;
+}
+
+static void ExpectSameAsFnmatch(int flags)
+{
+  WildcardSet set(patterns, flags);
+
+  for (const char* str : strings) {
+    bool expected = MatchWithFnmatch(patterns, str, flags) != nullptr;
+    const char* pattern = set.Match(str);
+    EXPECT_EQ(pattern != nullptr, expected)
+        << "string \"" << str << "\" flags " << flags;
+    if (pattern) {
+      EXPECT_EQ(fnmatch(pattern, str, flags), 0)
+          << "pattern \"" << pattern << "\" string \"" << str << "\"";
+    }
+  }
+}
+
+TEST(wildcard_set, same_result_as_fnmatch) { ExpectSameAsFnmatch(0); }
+
+TEST(wildcard_set, same_result_as_fnmatch_casefold)
+{
+  ExpectSameAsFnmatch(FNM_CASEFOLD);
+}
+
+TEST(wildcard_set, same_result_as_fnmatch_pathname)
+{
+  ExpectSameAsFnmatch(FNM_PATHNAME);
+}
+
+TEST(wildcard_set, same_result_as_fnmatch_casefold_pathname)
+{
+  ExpectSameAsFnmatch(FNM_CASEFOLD | FNM_PATHNAME);
+}
+
+TEST(wildcard_set, unsupported_flags_fall_back_to_fnmatch)
+{
+  ExpectSameAsFnmatch(FNM_PERIOD);
+}
+
+TEST(wildcard_set, single_pattern_lists)
+{
+  for (const char* pattern : patterns) {
+    WildcardSet set({pattern}, 0);
+    for (const char* str : strings) {
+      EXPECT_EQ(set.Match(str) != nullptr, fnmatch(pattern, str, 0) == 0)
+          << "pattern \"" << pattern << "\" string \"" << str << "\"";
+    }
+  }
+}
+
+TEST(wildcard_set, empty_set_matches_nothing)
+{
+  WildcardSet set;
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(set.Match("anything"), nullptr);
+}
@@ -33,6 +33,7 @@
 #  include "findlib/drivetype.h"
 #  include "findlib/fstype.h"
 #  include "win32/findlib/win32.h"
+#  include "findlib/wildcard_set.h"
 
 
 /**
@@ -387,6 +388,7 @@ bool exclude_win32_not_to_backup_registry_entries(JobControlRecord* jcr,
                 *d = '\0';
                 Dmsg1(100, "    ->  \"%s\"\n", destination.c_str());
                 fo->wild.append(strdup(destination.c_str()));
+                FreeCompiledWildcards(fo);
                 wild_count++;
               }
             }